@@ -0,0 +1,163 @@
+/*
+    Baseline of the microbenchmarks, see baseline.h
+*/
+
+#include <math.h>
+#include <inttypes.h>
+#include "baseline.h"
+
+/**
+ * @brief 95% confidence interval of the median of sorted samples
+ *
+ * The ranks of the bounds come from the normal approximation of the binomial distribution of the number of
+ * samples below the median: n/2 -/+ 1.96 * sqrt(n)/2
+ */
+void median_confidence_interval(const double sorted_samples[], int num_samples, double *low, double *high) {
+    double half_width = 1.96 * sqrt(num_samples) / 2;
+    int low_rank = (int)floor(num_samples / 2.0 - half_width);
+    int high_rank = (int)ceil(num_samples / 2.0 + half_width);
+    *low = sorted_samples[low_rank < 1 ? 0 : low_rank - 1];
+    *high = sorted_samples[high_rank > num_samples ? num_samples - 1 : high_rank - 1];
+}
+
+exit_t save_baseline(const char *file_name, const benchmark_result_t results[], size_t num_results, int repetitions) {
+    FILE *baseline_file = fopen(file_name, "w");
+    if(!baseline_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", file_name);
+    }
+    fprintf(baseline_file, "{\"version\": %d, \"repetitions\": %d, \"benchmarks\": [\n", BASELINE_VERSION, repetitions);
+    for(size_t i = 0; i < num_results; i++) {
+        fprintf(baseline_file, "{\"name\": ");
+        print_json_string(baseline_file, results[i].name);
+        fprintf(baseline_file, ", \"median_ns\": %.1f, \"ci_low_ns\": %.1f, \"ci_high_ns\": %.1f, \"peak_live_bytes\": %" PRIu64 "}%s\n",
+                results[i].median_ns, results[i].ci_low_ns, results[i].ci_high_ns, results[i].peak_live_bytes, i + 1 < num_results ? "," : "");
+    }
+    fprintf(baseline_file, "]}\n");
+    int write_error = ferror(baseline_file);
+    write_error |= fclose(baseline_file);
+    if(write_error) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't write file (%s)", file_name);
+    }
+    return success();
+}
+
+/**
+ * @brief Read a baseline written by save_baseline
+ *
+ * @param results array of results allocated by this function, to be released by the caller
+ */
+exit_t load_baseline(const char *file_name, benchmark_result_t **results, size_t *num_results) {
+    FILE *baseline_file = fopen(file_name, "r");
+    if(!baseline_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s), run make benchbaseline to create it", file_name);
+    }
+    char line[2 * BASELINE_NAME_LENGTH];
+    int version;
+    if(!fgets(line, sizeof(line), baseline_file) || sscanf(line, "{\"version\": %d,", &version) != 1) {
+        fclose(baseline_file);
+        return failure(EXIT_FAILURE, "ERROR: File (%s) is not a baseline of the benchmarks", file_name);
+    }
+    if(version != BASELINE_VERSION) {
+        fclose(baseline_file);
+        return failure(EXIT_FAILURE, "ERROR: Baseline (%s) has version %d, expected %d: run make benchbaseline again", file_name, version,
+                       BASELINE_VERSION);
+    }
+
+    size_t capacity = 16;
+    *results = malloc(capacity * sizeof(benchmark_result_t));
+    *num_results = 0;
+    if(!*results) {
+        fclose(baseline_file);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+    while(fgets(line, sizeof(line), baseline_file) && line[0] == '{') {
+        if(*num_results == capacity) {
+            capacity *= 2;
+            benchmark_result_t *resized_results = realloc(*results, capacity * sizeof(benchmark_result_t));
+            if(!resized_results) {
+                fclose(baseline_file);
+                free(*results);
+                *results = NULL;
+                return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+            }
+            *results = resized_results;
+        }
+        benchmark_result_t *result = &(*results)[*num_results];
+        //names of benchmarks do not contain quotes, so they are read back without unescaping
+        if(sscanf(line, "{\"name\": \"%255[^\"]\", \"median_ns\": %lf, \"ci_low_ns\": %lf, \"ci_high_ns\": %lf, \"peak_live_bytes\": %" SCNu64 "}",
+                  result->name, &result->median_ns, &result->ci_low_ns, &result->ci_high_ns, &result->peak_live_bytes) != 5) {
+            fclose(baseline_file);
+            free(*results);
+            *results = NULL;
+            return failure(EXIT_FAILURE, "ERROR: Malformed benchmark in baseline (%s): %s", file_name, line);
+        }
+        (*num_results)++;
+    }
+    fclose(baseline_file);
+    return success();
+}
+
+static const benchmark_result_t *find_result(const benchmark_result_t results[], size_t num_results, const char *name) {
+    for(size_t i = 0; i < num_results; i++) {
+        if(strcmp(results[i].name, name) == 0) {
+            return &results[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Print the difference of each benchmark with respect to the baseline
+ *
+ * @param time_tolerance largest slowdown of the median accepted, e.g. 0.1 for 10%
+ * @param memory_tolerance largest growth of the peak memory accepted
+ * @param baseline benchmarks expected to run, e.g. the ones of the baseline file that match the filters of the run
+ * @return true if no benchmark regressed and every benchmark of the baseline ran: one that is missing from the
+ * results (removed, renamed or failing) fails the check; a benchmark missing from the baseline is only reported
+ */
+bool check_baseline(FILE *stream, const benchmark_result_t baseline[], size_t num_baseline, const benchmark_result_t results[],
+                    size_t num_results, double time_tolerance, double memory_tolerance) {
+    bool passed = true;
+    fprintf(stream, "%-32s %12s %12s %8s %12s %12s %8s  %s\n", "benchmark", "base p50", "p50", "time", "base peak", "peak", "memory",
+            "status");
+    for(size_t i = 0; i < num_results; i++) {
+        const benchmark_result_t *result = &results[i];
+        const benchmark_result_t *base = find_result(baseline, num_baseline, result->name);
+        if(!base) {
+            fprintf(stream, "%-32s %12s %12.1f %8s %12s %12" PRIu64 " %8s  new\n", result->name, "-", result->median_ns, "-", "-",
+                    result->peak_live_bytes, "-");
+            continue;
+        }
+        double time_change = base->median_ns > 0 ? result->median_ns / base->median_ns - 1 : 0;
+        bool slower = time_change > time_tolerance && result->ci_low_ns > base->ci_high_ns;
+        bool faster = time_change < -time_tolerance && result->ci_high_ns < base->ci_low_ns;
+        bool memory_measured = base->peak_live_bytes > 0 && result->peak_live_bytes > 0;
+        double memory_change = memory_measured ? (double)result->peak_live_bytes / base->peak_live_bytes - 1 : 0;
+        bool more_memory = memory_change > memory_tolerance;
+
+        const char *status = "ok";
+        if(slower && more_memory) {
+            status = "REGRESSION (time, memory)";
+        }
+        else if(slower) {
+            status = "REGRESSION (time)";
+        }
+        else if(more_memory) {
+            status = "REGRESSION (memory)";
+        }
+        else if(faster) {
+            status = "faster";
+        }
+        passed = passed && !slower && !more_memory;
+        fprintf(stream, "%-32s %12.1f %12.1f %+7.1f%% %12" PRIu64 " %12" PRIu64 " %+7.1f%%  %s\n", result->name, base->median_ns,
+                result->median_ns, 100 * time_change, base->peak_live_bytes, result->peak_live_bytes, 100 * memory_change, status);
+    }
+    for(size_t i = 0; i < num_baseline; i++) {
+        if(!find_result(results, num_results, baseline[i].name)) {
+            fprintf(stream, "%-32s %12.1f %12s %8s %12" PRIu64 " %12s %8s  MISSING\n", baseline[i].name, baseline[i].median_ns, "-", "-",
+                    baseline[i].peak_live_bytes, "-", "-");
+            passed = false;
+        }
+    }
+    return passed;
+}
@@ -0,0 +1,41 @@
+#ifndef FAB_BENCH_BASELINE
+#define FAB_BENCH_BASELINE
+
+#include "../include/lc3.h"
+
+/*
+    Baseline of the microbenchmarks (make benchbaseline) and regression check against it (make benchcheck)
+
+    The baseline is a JSON file written by microbench, with the version of its format on the first line and a
+    benchmark per line, so that it can be read back line by line and reviewed in diffs:
+
+    {"version": 1, "repetitions": 100, "benchmarks": [
+    {"name": "split_tokens", "median_ns": 310.2, "ci_low_ns": 305.0, "ci_high_ns": 318.7, "peak_live_bytes": 1024},
+    ...
+    ]}
+
+    The confidence interval is the 95% interval of the median of the samples. A benchmark regresses when its
+    median is slower than the one of the baseline by more than the tolerance and the confidence intervals do not
+    overlap, so that noise alone does not fail the check. Peak memory is deterministic and compared whenever it
+    was measured in both runs. The times are measured with the allocation tracker disabled, so that its headers
+    and atomic counters are not part of them, and the peak memory in a pass of its own with the tracker enabled.
+    A benchmark of the baseline that is missing from the run, or whose workload failed, fails the check.
+*/
+#define BASELINE_VERSION 1
+#define BASELINE_NAME_LENGTH 256
+
+typedef struct {
+    char name[BASELINE_NAME_LENGTH];
+    double median_ns; /**< time per operation */
+    double ci_low_ns;
+    double ci_high_ns;
+    uint64_t peak_live_bytes; /**< highest memory alive during a run of the memory pass, 0 if memory was not measured */
+} benchmark_result_t;
+
+void median_confidence_interval(const double sorted_samples[], int num_samples, double *low, double *high);
+exit_t save_baseline(const char *file_name, const benchmark_result_t results[], size_t num_results, int repetitions);
+exit_t load_baseline(const char *file_name, benchmark_result_t **results, size_t *num_results);
+bool check_baseline(FILE *stream, const benchmark_result_t baseline[], size_t num_baseline, const benchmark_result_t results[],
+                    size_t num_results, double time_tolerance, double memory_tolerance);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+    Throughput of the formatting kernels of lc3objdump (see lc3objdump.h)
+
+    Formats the same random object words with each kernel supported by the CPU, in chunks of the size lc3objdump
+    reads at once, and reports the best throughput of several runs in GB/s of input and of output, and the speedup
+    with respect to the scalar code.
+
+    Usage: make dumpbench [BENCH_ARGS="[-r runs]"]
+
+    The tool is compiled with optimizations and without coverage instrumentation (see BENCH_CFLAGS in Makefile)
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "../include/lc3objdump.h"
+
+#define DEFAULT_RUNS 20
+#define INPUT_SIZE (8 * 1024 * 1024)
+#define CHUNK_SIZE (32 * 1024)
+#define MAX_OUTPUT_PER_BYTE 9 // binary text of a byte and half a new line, rounded up
+
+// the lengths formatted are accumulated here so that the compiler cannot discard the calls being measured
+static volatile size_t sink;
+
+static double elapsed_s(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Best time of `runs` formattings of the whole input
+ *
+ * @param output_size characters written by a run
+ */
+static double time_kernel(const unsigned char *input, char *output, int output_mode, format_kernel_t kernel, int runs, size_t *output_size) {
+    select_format(output_mode, kernel);
+    double best = 0;
+    for(int run = 0; run < runs; run++) {
+        size_t written = 0;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for(size_t i = 0; i < INPUT_SIZE; i += CHUNK_SIZE) {
+            written += format_words(input + i, CHUNK_SIZE, output);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        sink += written;
+        *output_size = written;
+        double time = elapsed_s(start, end);
+        if(run == 0 || time < best) {
+            best = time;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    int runs = DEFAULT_RUNS;
+    if(argc == 3 && strcmp(argv[1], "-r") == 0 && atoi(argv[2]) > 0) {
+        runs = atoi(argv[2]);
+    }
+    else if(argc != 1) {
+        printf("USAGE %s [-r runs]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    unsigned char *input = malloc(INPUT_SIZE);
+    char *output = malloc(CHUNK_SIZE * MAX_OUTPUT_PER_BYTE + FORMAT_OUTPUT_SLACK);
+    srand(1);
+    for(size_t i = 0; i < INPUT_SIZE; i++) {
+        input[i] = rand();
+    }
+
+    const struct {
+        const char *name;
+        int output_mode;
+    } modes[] = { { "dec", DEC_OUTPUT_MODE }, { "hex", HEX_OUTPUT_MODE }, { "bin", BIN_OUTPUT_MODE } };
+    printf("%-6s %-8s %12s %12s %9s\n", "mode", "kernel", "input GB/s", "output GB/s", "speedup");
+    for(size_t mode = 0; mode < sizeof(modes) / sizeof(modes[0]); mode++) {
+        double scalar_time = 0;
+        for(format_kernel_t kernel = SCALAR_KERNEL; kernel < NUM_FORMAT_KERNELS; kernel++) {
+            if(!format_kernel_supported(kernel) || (kernel != SCALAR_KERNEL && modes[mode].output_mode == DEC_OUTPUT_MODE)) {
+                continue;
+            }
+            size_t output_size = 0;
+            double time = time_kernel(input, output, modes[mode].output_mode, kernel, runs, &output_size);
+            if(kernel == SCALAR_KERNEL) {
+                scalar_time = time;
+            }
+            printf("%-6s %-8s %12.2f %12.2f %8.1fx\n", modes[mode].name, format_kernel_name(kernel), INPUT_SIZE / time / 1e9,
+                   output_size / time / 1e9, scalar_time / time);
+        }
+    }
+    free(input);
+    free(output);
+    return EXIT_SUCCESS;
+}
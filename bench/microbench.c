@@ -0,0 +1,557 @@
+/*
+    Microbenchmarks of the components of the assembler
+
+    Each benchmark runs a fixed workload: a few warm-up runs are discarded, then the workload is timed a number of
+    times and the distribution of the time per operation is reported (min, percentiles and max), so that
+    measurements of different versions of the code can be compared.
+
+    Usage: make bench [BENCH_ARGS="[-w warmup_runs] [-r repetitions] [--csv] [--no-counters] [name_filter...]"]
+
+    With --save-baseline FILE, the median time per operation of each benchmark, its confidence interval and the
+    peak memory of a run are saved as the baseline; with --check-baseline FILE they are compared with the
+    baseline and the program fails if a benchmark regressed by more than --tolerance percent (time, 10 by default)
+    or --memory-tolerance percent (peak memory, 5 by default), or if a benchmark of the baseline that matches the
+    filters did not run, see baseline.h. The peak memory is measured first, by a child process that runs each
+    benchmark with the allocation tracker enabled; the times are measured by this process, with the tracker
+    disabled (do not set LC3_MEMTRACK).
+
+    On Linux, performance counters are read around the timed runs (see perfcounters.h): the report adds the
+    instructions per cycle, the branch, L1 data cache and last-level cache misses per unit of work and the page
+    faults per run. The unit of work of the end-to-end benchmarks is a line of the source, the one of the other
+    benchmarks is an operation.
+
+    The assembler is compiled with optimizations and without coverage instrumentation (see BENCH_CFLAGS in Makefile)
+*/
+
+#include <dirent.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "../include/lc3.h"
+#include "perfcounters.h"
+#include "baseline.h"
+
+#define DEFAULT_WARMUP_RUNS 5
+#define DEFAULT_REPETITIONS 50
+#define DEFAULT_TIME_TOLERANCE 10
+#define DEFAULT_MEMORY_TOLERANCE 5
+#define MAX_ASM_FILES 100
+#define NUM_LABELS 4096
+#define NUM_WORDS 4096
+#define TESTFILES_DIR "test/testfiles"
+
+typedef struct benchmark {
+    const char *name;
+    void (*setup)(const struct benchmark *benchmark); /**< run before each timed run, not timed */
+    bool (*run)(const struct benchmark *benchmark); /**< false if the workload fails */
+    size_t ops_per_run;
+    const char *asm_file_name; /**< input of the end-to-end benchmarks */
+} benchmark_t;
+
+// the results are accumulated here so that the compiler cannot discard the calls being measured
+static volatile long sink;
+
+static const char *lines[] = {
+    "LOOP    ADD R1,R1,#-1     ; decrement counter\n",
+    "        LD R2,VALUE\n",
+    "        BRnzp LOOP\n",
+    "MSG     .STRINGZ \"hello, world\"\n",
+    "        .FILL x3000\n",
+    "        STR R0,R6,#-2\n",
+    "; comment line\n",
+    "        JSRR R3\n"
+};
+#define NUM_LINES (sizeof(lines) / sizeof(lines[0]))
+
+static const char *first_tokens[] = {
+    "ADD", ".ORIG", "LOOP", ";comment", ".FILL", "BRnzp", ".STRINGZ", "LD", "HALT", ".END", "JSR", "NOT", ".BLKW", "TRAP", "LABEL_1", "RET"
+};
+#define NUM_FIRST_TOKENS (sizeof(first_tokens) / sizeof(first_tokens[0]))
+
+static const char *opcodes[] = {
+    "ADD", "AND", "JMP", "JSR", "JSRR", "NOT", "RET", "LD", "ST", "LDI", "STI", "LEA", "BR", "BRnzp", "BRz", "LDR", "STR", "TRAP", "HALT", "PUTS"
+};
+#define NUM_OPCODES (sizeof(opcodes) / sizeof(opcodes[0]))
+
+static const char *offsets[] = { "#-12", "x1F", "LABEL_100", "#255", "LABEL_4000", "-256", "x0", "LABEL_7" };
+#define NUM_OFFSETS (sizeof(offsets) / sizeof(offsets[0]))
+
+static char label_names[2 * NUM_LABELS][16];
+static FILE *null_file;
+
+#define INNER_ITERATIONS 1000
+
+static double elapsed_ns(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+}
+
+static void no_setup(const benchmark_t __attribute__((unused)) *benchmark) {
+}
+
+static void clear_dict(const benchmark_t __attribute__((unused)) *benchmark) {
+    initialize();
+}
+
+static void fill_dict(const benchmark_t __attribute__((unused)) *benchmark) {
+    initialize();
+    for(int i = 0; i < NUM_LABELS; i++) {
+        add(label_names[i], i);
+    }
+}
+
+static bool run_split_tokens(const benchmark_t __attribute__((unused)) *benchmark) {
+    char buffer[100];
+    for(int i = 0; i < INNER_ITERATIONS; i++) {
+        for(size_t j = 0; j < NUM_LINES; j++) {
+            strcpy(buffer, lines[j]);
+            int num_tokens;
+            char **tokens = split_tokens(buffer, &num_tokens, " ,\n\t");
+            sink += num_tokens;
+            tracked_free(tokens);
+        }
+    }
+    return true;
+}
+
+static bool run_compute_line_type(const benchmark_t __attribute__((unused)) *benchmark) {
+    for(int i = 0; i < INNER_ITERATIONS; i++) {
+        for(size_t j = 0; j < NUM_FIRST_TOKENS; j++) {
+            sink += compute_line_type(first_tokens[j]);
+        }
+    }
+    return true;
+}
+
+static bool run_compute_opcode_type(const benchmark_t __attribute__((unused)) *benchmark) {
+    for(int i = 0; i < INNER_ITERATIONS; i++) {
+        for(size_t j = 0; j < NUM_OPCODES; j++) {
+            sink += compute_opcode_type(opcodes[j]);
+        }
+    }
+    return true;
+}
+
+static bool run_dict_add(const benchmark_t __attribute__((unused)) *benchmark) {
+    for(int i = 0; i < NUM_LABELS; i++) {
+        if(!add(label_names[i], i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool run_dict_lookup(const benchmark_t __attribute__((unused)) *benchmark) {
+    //half of the lookups miss
+    for(int i = 0; i < 2 * NUM_LABELS; i++) {
+        sink += lookup(label_names[i]) != NULL;
+    }
+    return true;
+}
+
+static bool run_parse_offset(const benchmark_t __attribute__((unused)) *benchmark) {
+    for(int i = 0; i < INNER_ITERATIONS; i++) {
+        for(size_t j = 0; j < NUM_OFFSETS; j++) {
+            long offset;
+            exit_t result = parse_offset((char *)offsets[j], -4096, 4095, 2048, 1, &offset, 13);
+            if(result.code) {
+                free_err(result);
+                return false;
+            }
+            sink += offset;
+        }
+    }
+    return true;
+}
+
+static bool run_write_machine_instruction(const benchmark_t __attribute__((unused)) *benchmark) {
+    for(int i = 0; i < NUM_WORDS; i++) {
+        if(write_machine_instruction((uint16_t)(i * 2654435761u), null_file)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool run_assemble(const benchmark_t *benchmark) {
+    exit_t result = assemble(benchmark->asm_file_name);
+    if(result.code) {
+        free_err(result);
+        return false;
+    }
+    return true;
+}
+
+static bool use_counters;
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/**
+ * @brief Nearest-rank percentile of sorted samples
+ */
+static double percentile(const double sorted_samples[], int num_samples, int p) {
+    int rank = (p * num_samples + 99) / 100;
+    return sorted_samples[rank > 0 ? rank - 1 : 0];
+}
+
+/**
+ * @brief Print the counters of a benchmark, after its times
+ *
+ * Counters that are not available are left empty (CSV) or reported as n/a
+ */
+static void print_counters(const counter_values_t *counter_values, double units, bool per_line, int repetitions, bool csv) {
+    const double *values = counter_values->values;
+    const bool *available = counter_values->available;
+    double derived[] = {
+        values[COUNTER_CYCLES] > 0 ? values[COUNTER_INSTRUCTIONS] / values[COUNTER_CYCLES] : 0,
+        values[COUNTER_BRANCH_MISSES] / units,
+        values[COUNTER_L1D_MISSES] / units,
+        values[COUNTER_LLC_MISSES] / units,
+        values[COUNTER_PAGE_FAULTS] / repetitions
+    };
+    bool derived_available[] = {
+        available[COUNTER_CYCLES] && available[COUNTER_INSTRUCTIONS], available[COUNTER_BRANCH_MISSES],
+        available[COUNTER_L1D_MISSES], available[COUNTER_LLC_MISSES], available[COUNTER_PAGE_FAULTS]
+    };
+    for(size_t i = 0; i < sizeof(derived) / sizeof(derived[0]); i++) {
+        if(csv) {
+            derived_available[i] ? printf(",%.3f", derived[i]) : printf(",");
+        }
+        else {
+            derived_available[i] ? printf(" %10.3f", derived[i]) : printf(" %10s", "n/a");
+        }
+    }
+    printf(csv ? ",%s" : " %5s", per_line ? "line" : "op");
+}
+
+/**
+ * @brief Time a benchmark and print a line of the report
+ *
+ * @param result median and confidence interval of the benchmark
+ * @return false if the workload failed, in which case nothing is reported
+ */
+static bool run_benchmark(const benchmark_t *benchmark, int warmup_runs, int repetitions, bool csv, benchmark_result_t *result) {
+    double *samples = malloc(repetitions * sizeof(double));
+    if(!samples) {
+        error_exit("failure to allocate memory", "");
+    }
+    for(int i = 0; i < warmup_runs; i++) {
+        benchmark->setup(benchmark);
+        if(!benchmark->run(benchmark)) {
+            free(samples);
+            return false;
+        }
+    }
+    size_t lines_read = 0;
+    reset_counters();
+    for(int i = 0; i < repetitions; i++) {
+        benchmark->setup(benchmark);
+        size_t lines_before = assembly_stats.lines;
+        struct timespec start, end;
+        enable_counters();
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool succeeded = benchmark->run(benchmark);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        disable_counters();
+        if(!succeeded) {
+            free(samples);
+            return false;
+        }
+        samples[i] = elapsed_ns(start, end) / benchmark->ops_per_run;
+        lines_read += assembly_stats.lines - lines_before;
+    }
+    qsort(samples, repetitions, sizeof(double), compare_doubles);
+    const char *format = csv ? "%s,%zu,%.1f,%.1f,%.1f,%.1f,%.1f" : "%-32s %8zu %12.1f %12.1f %12.1f %12.1f %12.1f";
+    printf(format, benchmark->name, benchmark->ops_per_run, samples[0], percentile(samples, repetitions, 50), percentile(samples, repetitions, 90),
+        percentile(samples, repetitions, 99), samples[repetitions - 1]);
+    if(use_counters) {
+        counter_values_t counter_values;
+        read_counters(&counter_values);
+        bool per_line = benchmark->asm_file_name && lines_read > 0;
+        double units = per_line ? lines_read : (double)benchmark->ops_per_run * repetitions;
+        print_counters(&counter_values, units, per_line, repetitions, csv);
+    }
+    printf("\n");
+
+    snprintf(result->name, sizeof(result->name), "%s", benchmark->name);
+    result->median_ns = percentile(samples, repetitions, 50);
+    median_confidence_interval(samples, repetitions, &result->ci_low_ns, &result->ci_high_ns);
+    free(samples);
+    return true;
+}
+
+static bool matches_filters(const char *name, const char *filters[], int num_filters) {
+    for(int i = 0; i < num_filters; i++) {
+        if(strstr(name, filters[i])) {
+            return true;
+        }
+    }
+    return num_filters == 0;
+}
+
+/**
+ * @brief Peak memory of a run of each benchmark that matches the filters, measured by a child process with the
+ * allocation tracker enabled, so that the tracker does not slow down the timed runs of this process
+ *
+ * Must be called before anything is allocated through the tracker, which is then enabled in the child only
+ *
+ * @param peaks peak live bytes of each benchmark, 0 for the ones filtered out or whose workload failed
+ * @return false if the peaks could not be measured
+ */
+static bool measure_peak_memory(const benchmark_t benchmarks[], size_t num_benchmarks, const char *filters[],
+                                int num_filters, int warmup_runs, uint64_t peaks[]) {
+    int peaks_pipe[2];
+    if(pipe(peaks_pipe) == -1) {
+        fprintf(stderr, "ERROR: Couldn't create the pipe of the memory pass: %d\n", errno);
+        return false;
+    }
+    fflush(NULL);
+    pid_t pid = fork();
+    if(pid == -1) {
+        fprintf(stderr, "ERROR: Couldn't start the memory pass: %d\n", errno);
+        close(peaks_pipe[0]);
+        close(peaks_pipe[1]);
+        return false;
+    }
+    if(pid == 0) {
+        close(peaks_pipe[0]);
+        if(!memtrack_enable()) {
+            _exit(EXIT_FAILURE);
+        }
+        for(size_t i = 0; i < num_benchmarks; i++) {
+            bool succeeded = matches_filters(benchmarks[i].name, filters, num_filters);
+            for(int run = 0; run < warmup_runs && succeeded; run++) {
+                benchmarks[i].setup(&benchmarks[i]);
+                succeeded = benchmarks[i].run(&benchmarks[i]);
+            }
+            if(succeeded) {
+                memtrack_reset_peaks();
+                benchmarks[i].setup(&benchmarks[i]);
+                succeeded = benchmarks[i].run(&benchmarks[i]);
+            }
+            peaks[i] = succeeded ? memtrack_peak_live_bytes() : 0;
+        }
+        const char *bytes = (const char *)peaks;
+        size_t size = num_benchmarks * sizeof(uint64_t);
+        while(size > 0) {
+            ssize_t written = write(peaks_pipe[1], bytes, size);
+            if(written <= 0) {
+                _exit(EXIT_FAILURE);
+            }
+            bytes += written;
+            size -= written;
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(peaks_pipe[1]);
+    char *bytes = (char *)peaks;
+    size_t size = num_benchmarks * sizeof(uint64_t);
+    ssize_t read_bytes;
+    while(size > 0 && (read_bytes = read(peaks_pipe[0], bytes, size)) > 0) {
+        bytes += read_bytes;
+        size -= read_bytes;
+    }
+    close(peaks_pipe[0]);
+    int status;
+    if(waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS || size > 0) {
+        fprintf(stderr, "ERROR: The memory pass failed, the allocation tracker must not be in use before it\n");
+        return false;
+    }
+    return true;
+}
+
+static int compare_strings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/**
+ * @brief Names of the assembly files used by the end-to-end benchmarks, in alphabetical order
+ */
+static size_t find_asm_files(char *asm_file_names[]) {
+    DIR *dir = opendir(TESTFILES_DIR);
+    if(!dir) {
+        error_exit("error %d while reading %s\n", errno, TESTFILES_DIR);
+    }
+    size_t num_files = 0;
+    struct dirent *entry;
+    while((entry = readdir(dir)) && num_files < MAX_ASM_FILES) {
+        size_t length = strlen(entry->d_name);
+        if(length > 4 && strcmp(entry->d_name + length - 4, ".asm") == 0) {
+            asm_file_names[num_files] = malloc(strlen(TESTFILES_DIR) + length + 2);
+            sprintf(asm_file_names[num_files++], "%s/%s", TESTFILES_DIR, entry->d_name);
+        }
+    }
+    closedir(dir);
+    qsort(asm_file_names, num_files, sizeof(char *), compare_strings);
+    return num_files;
+}
+
+int main(int argc, char const *argv[]) {
+    int warmup_runs = DEFAULT_WARMUP_RUNS;
+    int repetitions = DEFAULT_REPETITIONS;
+    bool csv = false;
+    bool counters = true;
+    const char *save_baseline_file_name = NULL;
+    const char *check_baseline_file_name = NULL;
+    double time_tolerance = DEFAULT_TIME_TOLERANCE;
+    double memory_tolerance = DEFAULT_MEMORY_TOLERANCE;
+    const char *filters[argc];
+    int num_filters = 0;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            warmup_runs = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repetitions = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--csv") == 0) {
+            csv = true;
+        }
+        else if(strcmp(argv[i], "--no-counters") == 0) {
+            counters = false;
+        }
+        else if(strcmp(argv[i], "--save-baseline") == 0 && i + 1 < argc) {
+            save_baseline_file_name = argv[++i];
+        }
+        else if(strcmp(argv[i], "--check-baseline") == 0 && i + 1 < argc) {
+            check_baseline_file_name = argv[++i];
+        }
+        else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            time_tolerance = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--memory-tolerance") == 0 && i + 1 < argc) {
+            memory_tolerance = atof(argv[++i]);
+        }
+        else {
+            filters[num_filters++] = argv[i];
+        }
+    }
+    if(warmup_runs < 0 || repetitions < 1 || time_tolerance < 0 || memory_tolerance < 0) {
+        printf("USAGE %s [-w warmup_runs] [-r repetitions] [--csv] [--no-counters] [--save-baseline FILE | --check-baseline FILE "
+            "[--tolerance PCT] [--memory-tolerance PCT]] [name_filter...]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    benchmark_result_t *baseline = NULL;
+    size_t num_baseline = 0;
+    if(check_baseline_file_name) {
+        exit_t result = load_baseline(check_baseline_file_name, &baseline, &num_baseline);
+        if(result.code) {
+            fprintf(stderr, "%s\n", result.desc);
+            free_err(result);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for(int i = 0; i < 2 * NUM_LABELS; i++) {
+        //labels from NUM_LABELS onwards are never added to the dictionary
+        snprintf(label_names[i], sizeof(label_names[i]), "LABEL_%d", i);
+    }
+    null_file = fopen("/dev/null", "wb");
+    if(!null_file) {
+        error_exit("error %d while opening /dev/null\n", errno);
+    }
+
+    benchmark_t benchmarks[8 + MAX_ASM_FILES] = {
+        { "split_tokens", no_setup, run_split_tokens, INNER_ITERATIONS * NUM_LINES, NULL },
+        { "compute_line_type", no_setup, run_compute_line_type, INNER_ITERATIONS * NUM_FIRST_TOKENS, NULL },
+        { "compute_opcode_type", no_setup, run_compute_opcode_type, INNER_ITERATIONS * NUM_OPCODES, NULL },
+        { "dict_add", clear_dict, run_dict_add, NUM_LABELS, NULL },
+        { "dict_lookup", fill_dict, run_dict_lookup, 2 * NUM_LABELS, NULL },
+        { "parse_offset", fill_dict, run_parse_offset, INNER_ITERATIONS * NUM_OFFSETS, NULL },
+        { "write_machine_instruction", no_setup, run_write_machine_instruction, NUM_WORDS, NULL }
+    };
+    size_t num_benchmarks = 7;
+    char *asm_file_names[MAX_ASM_FILES];
+    size_t num_asm_files = find_asm_files(asm_file_names);
+    char benchmark_names[MAX_ASM_FILES][300];
+    for(size_t i = 0; i < num_asm_files; i++) {
+        snprintf(benchmark_names[i], sizeof(benchmark_names[i]), "assemble/%s", asm_file_names[i] + strlen(TESTFILES_DIR) + 1);
+        benchmarks[num_benchmarks++] = (benchmark_t) { benchmark_names[i], clear_dict, run_assemble, 1, asm_file_names[i] };
+    }
+
+    int num_counters = counters ? open_counters() : 0;
+    use_counters = num_counters > 0;
+    if(counters && !use_counters) {
+        fprintf(stderr, "performance counters not available (%s), only times are reported\n", counters_error());
+    }
+    else if(counters && num_counters < NUM_COUNTERS) {
+        fprintf(stderr, "some performance counters not available (%s), they are reported as n/a\n", counters_error());
+    }
+    if(csv) {
+        printf("benchmark,ops_per_run,min_ns,p50_ns,p90_ns,p99_ns,max_ns%s\n",
+            use_counters ? ",ipc,branch_misses_per_unit,l1d_misses_per_unit,llc_misses_per_unit,page_faults_per_run,unit" : "");
+    }
+    else {
+        printf("%d warm-up runs, %d repetitions, time per operation in ns\n", warmup_runs, repetitions);
+        printf("%-32s %8s %12s %12s %12s %12s %12s", "benchmark", "ops/run", "min", "p50", "p90", "p99", "max");
+        if(use_counters) {
+            printf(" %10s %10s %10s %10s %10s %5s", "IPC", "br-miss/u", "L1d-miss/u", "LLC-miss/u", "faults/run", "unit");
+        }
+        printf("\n");
+    }
+    benchmark_result_t *results = malloc(num_benchmarks * sizeof(benchmark_result_t));
+    uint64_t *peaks = calloc(num_benchmarks, sizeof(uint64_t));
+    if(!results || !peaks) {
+        error_exit("failure to allocate memory", "");
+    }
+    if(save_baseline_file_name || check_baseline_file_name) {
+        //the tracker is enabled in the child only if nothing decided it before, in particular memtrack_enabled()
+        if(!measure_peak_memory(benchmarks, num_benchmarks, filters, num_filters, warmup_runs, peaks)) {
+            return EXIT_FAILURE;
+        }
+        if(memtrack_enabled()) {
+            fprintf(stderr, "ERROR: The times of the baseline are measured without the allocation tracker, unset LC3_MEMTRACK\n");
+            return EXIT_FAILURE;
+        }
+    }
+    size_t num_results = 0;
+    for(size_t i = 0; i < num_benchmarks; i++) {
+        if(!matches_filters(benchmarks[i].name, filters, num_filters)) {
+            continue;
+        }
+        //some test files are expected to fail, they are not benchmarked
+        if(run_benchmark(&benchmarks[i], warmup_runs, repetitions, csv, &results[num_results])) {
+            results[num_results++].peak_live_bytes = peaks[i];
+        }
+        else if(!csv) {
+            printf("%-32s %8s\n", benchmarks[i].name, "skipped (assembly error)");
+        }
+    }
+
+    int exit_code = EXIT_SUCCESS;
+    if(save_baseline_file_name) {
+        exit_t result = save_baseline(save_baseline_file_name, results, num_results, repetitions);
+        if(result.code) {
+            fprintf(stderr, "%s\n", result.desc);
+            free_err(result);
+            exit_code = EXIT_FAILURE;
+        }
+    }
+    if(check_baseline_file_name) {
+        //benchmarks filtered out of this run are not missing
+        size_t num_expected = 0;
+        for(size_t i = 0; i < num_baseline; i++) {
+            if(matches_filters(baseline[i].name, filters, num_filters)) {
+                baseline[num_expected++] = baseline[i];
+            }
+        }
+        num_baseline = num_expected;
+        printf("\ncomparison with %s (tolerance: time %.1f%%, memory %.1f%%)\n", check_baseline_file_name, time_tolerance, memory_tolerance);
+        if(!check_baseline(stdout, baseline, num_baseline, results, num_results, time_tolerance / 100, memory_tolerance / 100)) {
+            exit_code = EXIT_FAILURE;
+        }
+        free(baseline);
+    }
+    free(results);
+    free(peaks);
+
+    for(size_t i = 0; i < num_asm_files; i++) {
+        free(asm_file_names[i]);
+    }
+    fclose(null_file);
+    close_counters();
+    initialize();
+    return exit_code;
+}
@@ -0,0 +1,143 @@
+/*
+    Performance counters of the benchmark harness, see perfcounters.h
+
+    Each counter is opened on its own instead of as a group, so that a counter missing on a machine (e.g. the LLC
+    events of some virtual machines) does not make the others unavailable.
+*/
+
+#define _GNU_SOURCE // syscall
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "perfcounters.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+typedef struct {
+    uint32_t type;
+    uint64_t config;
+} counter_event_t;
+
+static const counter_event_t counter_events[NUM_COUNTERS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS }
+};
+
+static int counter_fds[NUM_COUNTERS] = { -1, -1, -1, -1, -1, -1 };
+static int open_errno;
+
+/**
+ * @brief Open the counters that are available
+ *
+ * @return int number of counters opened, 0 if none of them is available (see counters_error)
+ */
+int open_counters() {
+    int num_opened = 0;
+    for(int counter = 0; counter < NUM_COUNTERS; counter++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = counter_events[counter].type;
+        attr.config = counter_events[counter].config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        counter_fds[counter] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if(counter_fds[counter] == -1) {
+            open_errno = errno;
+        }
+        else {
+            num_opened++;
+        }
+    }
+    return num_opened;
+}
+
+void close_counters() {
+    for(int counter = 0; counter < NUM_COUNTERS; counter++) {
+        if(counter_fds[counter] != -1) {
+            close(counter_fds[counter]);
+            counter_fds[counter] = -1;
+        }
+    }
+}
+
+/**
+ * @brief Reason why the last counter that could not be opened is unavailable
+ */
+const char *counters_error() {
+    return strerror(open_errno);
+}
+
+static void control_counters(unsigned long request) {
+    for(int counter = 0; counter < NUM_COUNTERS; counter++) {
+        if(counter_fds[counter] != -1) {
+            ioctl(counter_fds[counter], request, 0);
+        }
+    }
+}
+
+void reset_counters() {
+    control_counters(PERF_EVENT_IOC_RESET);
+}
+
+void enable_counters() {
+    control_counters(PERF_EVENT_IOC_ENABLE);
+}
+
+void disable_counters() {
+    control_counters(PERF_EVENT_IOC_DISABLE);
+}
+
+void read_counters(counter_values_t *counter_values) {
+    for(int counter = 0; counter < NUM_COUNTERS; counter++) {
+        //value, time enabled, time running
+        uint64_t data[3];
+        counter_values->available[counter] = counter_fds[counter] != -1 && read(counter_fds[counter], data, sizeof(data)) == sizeof(data);
+        if(!counter_values->available[counter]) {
+            counter_values->values[counter] = 0;
+        }
+        else {
+            //a counter that never got to run while enabled (too many counters for the PMU) is not available
+            counter_values->available[counter] = data[2] > 0 || data[1] == 0;
+            counter_values->values[counter] = data[2] > 0 ? (double)data[0] * data[1] / data[2] : (double)data[0];
+        }
+    }
+}
+
+#else
+
+int open_counters() {
+    return 0;
+}
+
+void close_counters() {
+}
+
+const char *counters_error() {
+    return "performance counters are only read on Linux";
+}
+
+void reset_counters() {
+}
+
+void enable_counters() {
+}
+
+void disable_counters() {
+}
+
+void read_counters(counter_values_t *counter_values) {
+    memset(counter_values, 0, sizeof(*counter_values));
+}
+
+#endif
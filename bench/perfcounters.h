@@ -0,0 +1,32 @@
+#ifndef FAB_PERF_COUNTERS
+#define FAB_PERF_COUNTERS
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Hardware and software performance counters of the benchmark harness (Linux perf_event_open)
+
+    Counters only count this process in user space, and only while they are enabled, so that the setup of a
+    benchmark is not counted. Counters that cannot be opened (e.g. in a container without access to the PMU or
+    when kernel.perf_event_paranoid is too high) are reported as unavailable and the benchmarks are still timed.
+*/
+typedef enum {
+    COUNTER_CYCLES, COUNTER_INSTRUCTIONS, COUNTER_BRANCH_MISSES, COUNTER_L1D_MISSES, COUNTER_LLC_MISSES,
+    COUNTER_PAGE_FAULTS, NUM_COUNTERS
+} counter_t;
+
+typedef struct {
+    bool available[NUM_COUNTERS];
+    double values[NUM_COUNTERS]; /**< scaled up when the kernel multiplexes counters */
+} counter_values_t;
+
+int open_counters();
+void close_counters();
+const char *counters_error();
+void reset_counters();
+void enable_counters();
+void disable_counters();
+void read_counters(counter_values_t *counter_values);
+
+#endif
@@ -0,0 +1,161 @@
+/*
+    Scaling stress test of the assembler
+
+    Generates lookup-table programs of increasing size (up to the whole address space), assembles each of them
+    in a separate process and reports the assembly time and the peak resident set size.
+    Time per word should remain roughly constant as the size of the program grows.
+
+    A second set of programs is generated with lc3gen (see tools/lc3gen.c) to cover realistic and adversarial
+    workloads: many labels, forward references, data, comments and labels that collide in the symbol table.
+
+    Usage: make stress
+
+    The assembler is compiled with optimizations and without coverage instrumentation (see BENCH_CFLAGS in Makefile)
+*/
+
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "../include/lc3gen.h"
+
+#define STRESS_DIR "out/bench/programs"
+#define LABEL_EVERY 8 // words
+
+static const size_t program_sizes[] = { 1024, 8192, 32768, 65536 };
+
+typedef struct {
+    const char *name;
+    generator_options_t options;
+} workload_t;
+
+static const workload_t workloads[] = {
+    { "realistic", { .num_lines = 40000, .seed = 1, .label_density = 0.2, .forward_ratio = 0.5, .data_ratio = 0.1, .comment_ratio = 0.1, .branch_distance = 64 } },
+    { "labels", { .num_lines = 50000, .seed = 2, .label_density = 1, .forward_ratio = 0.5, .data_ratio = 0.1, .comment_ratio = 0.1, .branch_distance = 64 } },
+    { "forward", { .num_lines = 50000, .seed = 3, .label_density = 0.2, .forward_ratio = 1, .data_ratio = 0.1, .comment_ratio = 0.1, .branch_distance = 255 } },
+    { "data", { .num_lines = 20000, .seed = 4, .label_density = 0.2, .forward_ratio = 0.5, .data_ratio = 0.8, .comment_ratio = 0.1, .branch_distance = 64 } },
+    { "comments", { .num_lines = 200000, .seed = 5, .label_density = 0.2, .forward_ratio = 0.5, .data_ratio = 0.1, .comment_ratio = 0.9, .branch_distance = 64 } },
+    { "collisions", { .num_lines = 8192, .seed = 6, .label_density = 1, .forward_ratio = 0.5, .data_ratio = 0.1, .comment_ratio = 0.1, .branch_distance = 64, .collide = true } },
+};
+
+/**
+ * @brief Generate a program of `num_words` words starting at x0000
+ *
+ * Labels are defined every LABEL_EVERY words. The program mixes lookup-table entries (.FILL LABEL),
+ * operate instructions and PC-relative loads/branches to nearby labels (both backward and forward references)
+ */
+static void write_program(const char *asm_file_name, size_t num_words) {
+    FILE *asm_file = fopen(asm_file_name, "w");
+    if(!asm_file) {
+        error_exit("error %d while creating %s\n", errno, asm_file_name);
+    }
+    size_t num_labels = (num_words + LABEL_EVERY - 1) / LABEL_EVERY;
+    unsigned seed = 42;
+    fprintf(asm_file, "; generated program of %zu words\n    .ORIG x0000\n", num_words);
+    for(size_t i = 0; i < num_words; i++) {
+        if(i % LABEL_EVERY == 0) {
+            fprintf(asm_file, "L%zu", i / LABEL_EVERY);
+        }
+        //nearby label, at most 16 labels (128 words) away so that PCoffset9 is not exceeded
+        seed = seed * 1103515245 + 12345;
+        long nearby = (long)(i / LABEL_EVERY) + (long)((seed >> 16) % 33) - 16;
+        nearby = nearby < 0 ? 0 : (nearby >= (long)num_labels ? (long)num_labels - 1 : nearby);
+        switch(i % 4) {
+        case 0:
+            fprintf(asm_file, "    .FILL L%ld\n", (long)((seed >> 8) % num_labels));
+            break;
+        case 1:
+            fprintf(asm_file, "    ADD R1,R1,#1 ; counter\n");
+            break;
+        case 2:
+            fprintf(asm_file, "    LD R2,L%ld\n", nearby);
+            break;
+        default:
+            fprintf(asm_file, "    BRz L%ld\n", nearby);
+            break;
+        }
+    }
+    fprintf(asm_file, "    .END\n");
+    fclose(asm_file);
+}
+
+static double elapsed_ms(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+}
+
+static long peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes in MacOSX
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+/**
+ * @brief Assemble the given file and print a line of the report
+ *
+ * Each program is assembled by a new process so that peak RSS is not inherited from previous runs
+ */
+static int run_stress_case(const char *name, const char *asm_file_name, size_t num_words) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    exit_t result = assemble(asm_file_name);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if(result.code) {
+        printf("%s\n", result.desc);
+        return EXIT_FAILURE;
+    }
+    double time_ms = elapsed_ms(start, end);
+    printf("%-12s  %8zu  %10.2f  %12.1f  %12ld\n", name, num_words, time_ms, time_ms * 1e6 / num_words, peak_rss_kb());
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Assemble the given file in a new process
+ *
+ * Returns false if the program could not be assembled
+ */
+static bool run_in_child(const char *name, const char *asm_file_name, size_t num_words) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid == 0) {
+        exit(run_stress_case(name, asm_file_name, num_words));
+    }
+    int child_status;
+    return pid != -1 && waitpid(pid, &child_status, 0) != -1 && WIFEXITED(child_status) && !WEXITSTATUS(child_status);
+}
+
+int main() {
+    mkdir(STRESS_DIR, 0755);
+    printf("%-12s  %8s  %10s  %12s  %12s\n", "program", "words", "time (ms)", "ns/word", "peak RSS (KB)");
+    int status = EXIT_SUCCESS;
+    char asm_file_name[100];
+    for(size_t i = 0; i < sizeof(program_sizes) / sizeof(program_sizes[0]); i++) {
+        snprintf(asm_file_name, sizeof(asm_file_name), STRESS_DIR "/stress%zu.asm", program_sizes[i]);
+        write_program(asm_file_name, program_sizes[i]);
+        if(!run_in_child("table", asm_file_name, program_sizes[i])) {
+            status = EXIT_FAILURE;
+        }
+    }
+    for(size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        snprintf(asm_file_name, sizeof(asm_file_name), STRESS_DIR "/%s.asm", workloads[i].name);
+        FILE *asm_file = fopen(asm_file_name, "w");
+        if(!asm_file) {
+            error_exit("error %d while creating %s\n", errno, asm_file_name);
+        }
+        size_t num_words;
+        exit_t result = generate_program(asm_file, &workloads[i].options, &num_words);
+        fclose(asm_file);
+        if(result.code) {
+            printf("%s\n", result.desc);
+            free_err(result);
+            status = EXIT_FAILURE;
+        }
+        else if(!run_in_child(workloads[i].name, asm_file_name, num_words)) {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
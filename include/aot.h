@@ -0,0 +1,36 @@
+#ifndef FAB_AOT
+#define FAB_AOT
+
+#include "vm.h"
+
+/*
+    Ahead-of-time translation of an object image to a C program (lc3aot)
+
+    The basic blocks of the program are recovered statically from its entry point (its origin, or x0200 with an
+    operating system), the labels of its .sym file that are not operands of LD, ST, LDI or STI, the targets of
+    BR and JSR, and the return addresses of JSR, JSRR and traps. With an operating system, the service routines
+    of its trap vector table are translated too.
+
+    Every block becomes a `case` of a switch on the PC in the generated run function, and direct branches jump
+    to the C label of their target. Whatever the translated code cannot decide statically goes back to the
+    interpreter of vm.h, linked with the program:
+    - JMP, JSRR and RET dispatch on the switch, whose default runs the interpreter until it reaches a block
+    - traps, RTI, JMPT/RTT, device registers and accesses the MPR denies are run by the interpreter
+    - blocks whose words are changed by the program (self-modifying code) run in the interpreter
+    See aot_runtime.h, the runtime the generated program includes.
+
+    The images are embedded in the program, which takes the options of lc3vm but the object files and behaves
+    as lc3vm does on them: same input and output, instruction counts, errors and exit status. e.g.
+
+    ./lc3aot -o 2048.c test/testfiles/2048.obj
+    cc -O2 -Iinclude 2048.c src/vm.c src/util.c src/memtrack.c -o 2048
+*/
+
+typedef struct {
+    size_t blocks;
+    size_t instructions; /**< words translated to C */
+} aot_stats_t;
+
+exit_t aot_translate(const char *object_file_name, const char *os_file_name, FILE *output, aot_stats_t *stats);
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef FAB_AOT_RUNTIME
+#define FAB_AOT_RUNTIME
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <time.h>
+#include "vm.h"
+
+/*
+    Runtime of the C programs written by lc3aot (see aot.h), included by each of them after its tables:
+    - NUM_BLOCKS and `blocks`, the first and last address of every translated basic block, sorted
+    - `program_image` and, if an operating system was translated with it, `os_image`
+    and before the functions it translates: load_images and run.
+
+    run keeps the machine in locals (R0-R7, pc, the value the condition codes describe in `result`, and the
+    pages the machine may access in `access`) and needs `vm`, `memory`, `remaining` and `pointer` in scope for
+    the macros below. An instruction the translated code does not handle leaves through EXIT, which gives back
+    the instructions of the block not run and lets the interpreter run it at `interpret`.
+
+    Self-modification: the translated words are decoded by the machine when the program starts, so that every
+    store into them counts in vm_t.code_writes. A store of the translated code that changes a translated word
+    marks its block stale (code_written), and a stale block runs in the interpreter from then on. Stores of the
+    interpreter are not known one by one: when code_writes changed, all the translated words are compared
+    again (check_code).
+
+    main takes the options of lc3vm but the program: [-n max_instructions] [--stats].
+*/
+
+static vm_status_t run(vm_t *vm, uint64_t max_instructions);
+static void load_images(vm_t *vm);
+
+static bool stale[NUM_BLOCKS]; /**< a word of the block changed since it was translated */
+static uint16_t original[VM_ADDRESS_SPACE]; /**< memory when the program started */
+static uint64_t code_writes; /**< vm_t.code_writes when the translated words were last checked */
+static uint64_t interpreted_instructions;
+
+#define LOAD_STATE()                                                                                            \
+    do {                                                                                                        \
+        R0 = vm->registers[0], R1 = vm->registers[1], R2 = vm->registers[2], R3 = vm->registers[3];             \
+        R4 = vm->registers[4], R5 = vm->registers[5], R6 = vm->registers[6], R7 = vm->registers[7];             \
+        pc = vm->pc;                                                                                            \
+        result = vm->psr & VM_PSR_N ? -1 : vm->psr & VM_PSR_Z ? 0 : 1;                                          \
+        access = vm->psr & VM_PSR_SUPERVISOR ? 0xFFFF : vm->mpr;                                                \
+    } while(0)
+#define SAVE_STATE()                                                                                            \
+    do {                                                                                                        \
+        vm->registers[0] = R0, vm->registers[1] = R1, vm->registers[2] = R2, vm->registers[3] = R3;             \
+        vm->registers[4] = R4, vm->registers[5] = R5, vm->registers[6] = R6, vm->registers[7] = R7;             \
+        vm->pc = pc;                                                                                            \
+        vm->psr = (vm->psr & ~(VM_PSR_N | VM_PSR_Z | VM_PSR_P)) |                                               \
+                  (result < 0 ? VM_PSR_N : result == 0 ? VM_PSR_Z : VM_PSR_P);                                  \
+    } while(0)
+//the instruction at `address` is run by the interpreter, `skipped` instructions of the block are not run
+#define EXIT(skipped, address)    \
+    do {                          \
+        remaining += (skipped);   \
+        pc = (address);           \
+        goto interpret;           \
+    } while(0)
+//device registers and pages the MPR denies are left to the interpreter
+#define LOAD(target, address, skipped, instruction_address)                                \
+    do {                                                                                   \
+        uint16_t address_ = (address);                                                     \
+        if(address_ >= VM_DEVICES_START || !((access >> (address_ >> 12)) & 1)) {          \
+            EXIT(skipped, instruction_address);                                            \
+        }                                                                                  \
+        target = memory[address_];                                                         \
+    } while(0)
+#define STORE(address, value, skipped, instruction_address)                                \
+    do {                                                                                   \
+        uint16_t address_ = (address);                                                     \
+        if(address_ >= VM_DEVICES_START || !((access >> (address_ >> 12)) & 1)) {          \
+            EXIT(skipped, instruction_address);                                            \
+        }                                                                                  \
+        vm_write_memory(vm, address_, (value));                                            \
+        if(vm->code_writes != code_writes && code_written(vm, address_)) {                 \
+            remaining += (skipped) - 1;                                                    \
+            pc = (instruction_address) + 1;                                                \
+            goto dispatch;                                                                 \
+        }                                                                                  \
+    } while(0)
+
+/**
+ * @brief Index of the translated block that holds `address`, -1 if none
+ */
+static int find_block(uint16_t address) {
+    int low = 0, high = NUM_BLOCKS - 1;
+    while(low <= high) {
+        int middle = (low + high) / 2;
+        if(address < blocks[middle][0]) {
+            high = middle - 1;
+        }
+        else if(address > blocks[middle][1]) {
+            low = middle + 1;
+        }
+        else {
+            return middle;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Decode the words of the block, so that the machine counts the next store into any of them
+ */
+static void watch_block(vm_t *vm, int block) {
+    for(uint32_t address = blocks[block][0]; address <= blocks[block][1]; address++) {
+        vm_decoded_instruction(vm, address);
+    }
+}
+
+/**
+ * @brief Handle a store of the translated code that discarded a decoded instruction
+ *
+ * @return true if it changed a translated word, whose block is now stale
+ */
+static bool code_written(vm_t *vm, uint16_t address) {
+    code_writes = vm->code_writes;
+    int block = find_block(address);
+    if(block < 0 || stale[block]) {
+        return false;
+    }
+    if(vm->memory[address] != original[address]) {
+        stale[block] = true;
+        return true;
+    }
+    vm_decoded_instruction(vm, address);
+    return false;
+}
+
+/**
+ * @brief Mark stale the blocks changed by the interpreter since the last check
+ */
+static void check_code(vm_t *vm) {
+    code_writes = vm->code_writes;
+    for(int block = 0; block < NUM_BLOCKS; block++) {
+        for(uint32_t address = blocks[block][0]; address <= blocks[block][1] && !stale[block]; address++) {
+            stale[block] = vm->memory[address] != original[address];
+        }
+        if(!stale[block]) {
+            watch_block(vm, block);
+        }
+    }
+}
+
+static void print_usage(const char *program_name) {
+    fprintf(stderr, "USAGE %s [-n max_instructions] [--stats]\n", program_name);
+}
+
+int main(int argc, char const *argv[]) {
+    uint64_t max_instructions = VM_UNLIMITED;
+    bool stats = false;
+    for(int arg = 1; arg < argc; arg++) {
+        if(strcmp(argv[arg], "--stats") == 0) {
+            stats = true;
+        }
+        else if(strcmp(argv[arg], "-n") == 0 && arg + 1 < argc && isdigit((unsigned char)argv[arg + 1][0])) {
+            max_instructions = strtoull(argv[++arg], NULL, 10);
+        }
+        else {
+            print_usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    static vm_t vm;
+    vm_init(&vm);
+    load_images(&vm);
+    memcpy(original, vm.memory, sizeof(original));
+    for(int block = 0; block < NUM_BLOCKS; block++) {
+        watch_block(&vm, block);
+    }
+    code_writes = vm.code_writes;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    vm_status_t status = run(&vm, max_instructions);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fflush(stdout);
+
+    if(status != VM_HALTED) {
+        fprintf(stderr, "ERROR: %s at x%04X\n", vm_status_description(status), vm.pc);
+    }
+    if(stats) {
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        fprintf(stderr, "%" PRIu64 " instructions in %.3f s (%.1f MIPS)\n", vm.instructions, seconds,
+                seconds > 0 ? vm.instructions / seconds / 1e6 : 0.0);
+        fprintf(stderr, "%" PRIu64 " native, %" PRIu64 " interpreted\n", vm.instructions - interpreted_instructions,
+                interpreted_instructions);
+    }
+    return status == VM_HALTED ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef FAB_ARCHIVE
+#define FAB_ARCHIVE
+
+#include "util.h"
+
+#define ARCHIVE_MAGIC "LC3ARCH"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_EMPTY_BUCKET UINT32_MAX
+
+/*
+    Layout of a static library archive (.lib) created by lc3ar
+
+    - header
+    - member table: one entry per packed module
+    - symbol index: open-addressing hash table (linear probing) whose buckets contain
+      the position of an entry in the symbol table, or ARCHIVE_EMPTY_BUCKET
+    - symbol table: one entry per symbol name, defined by the first member that has a label with that name
+    - string table: NUL-terminated names of members and symbols
+    - member contents: .obj and .sym files of each module, copied verbatim
+
+    All offsets are relative to the beginning of the archive and all integers are stored with the byte order
+    of the machine that created the archive (identified by `byte_order`), so that the index can be used in place
+    after mapping the file into memory
+*/
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order; /**< always 0x01020304 when read with the right byte order */
+    uint32_t num_members;
+    uint32_t num_symbols;
+    uint32_t num_buckets; /**< power of 2, greater than num_symbols */
+    uint32_t members_offset;
+    uint32_t buckets_offset;
+    uint32_t symbols_offset;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+} archive_header_t;
+
+typedef struct {
+    uint32_t name_offset; /**< offset of the member name inside the string table */
+    uint32_t obj_offset;
+    uint32_t obj_size;
+    uint32_t sym_offset;
+    uint32_t sym_size;
+} archive_member_t;
+
+typedef struct {
+    uint32_t name_offset; /**< offset of the symbol name inside the string table */
+    uint32_t hash;
+    uint32_t member; /**< position of the defining member in the member table */
+    uint32_t address; /**< memory address of the symbol according to the .sym file of the member */
+} archive_symbol_t;
+
+/**
+ * Read-only view of an archive mapped into memory
+ */
+typedef struct {
+    const unsigned char *base;
+    size_t size;
+    const archive_header_t *header;
+    const archive_member_t *members;
+    const uint32_t *buckets;
+    const archive_symbol_t *symbols;
+    const char *strings;
+} archive_t;
+
+uint32_t archive_hash(const char *name);
+exit_t archive_create(const char *archive_file_name, const char *object_file_names[], size_t num_objects);
+exit_t archive_open(const char *archive_file_name, archive_t *archive);
+void archive_close(archive_t *archive);
+const archive_symbol_t *archive_lookup(const archive_t *archive, const char *name);
+const char *archive_member_name(const archive_t *archive, uint32_t member);
+exit_t archive_select_members(const archive_t *archive, const char *undefined_symbols[], size_t num_symbols, bool selected_members[]);
+
+#endif
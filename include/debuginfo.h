@@ -0,0 +1,86 @@
+#ifndef FAB_DEBUGINFO
+#define FAB_DEBUGINFO
+
+#include "lc3.h"
+
+#define DEBUGINFO_MAGIC "LC3DBG"
+#define DEBUGINFO_VERSION 1
+#define DEBUGINFO_CHECKPOINT_INTERVAL 32
+
+/*
+    Layout of a debug file (.dbg) generated by the assembler with -g
+
+    - header
+    - checkpoints: absolute values of every DEBUGINFO_CHECKPOINT_INTERVAL-th row of the line table, along with
+      the position of the row in the line table
+    - line table: rows (address, line, column) sorted by address; each row covers the addresses up to the next
+      row, and line 0 marks addresses without source (e.g. gaps between segments). Rows are delta-encoded with
+      respect to the previous row as LEB128 variable-length integers: address delta, line delta (zigzag encoded)
+      and column
+    - scopes: one entry per label sorted by address, covering the addresses up to the next label or the end of
+      the segment
+    - string table: NUL-terminated name of the source file and labels
+
+    All offsets are relative to the beginning of the file and all integers of fixed size are stored with the byte
+    order of the machine that created the file (identified by `byte_order`), so that the file can be used in place
+    after mapping it into memory
+*/
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order; /**< always 0x01020304 when read with the right byte order */
+    uint32_t num_rows;
+    uint32_t num_checkpoints;
+    uint32_t checkpoint_interval;
+    uint32_t checkpoints_offset;
+    uint32_t rows_offset;
+    uint32_t rows_size;
+    uint32_t num_scopes;
+    uint32_t scopes_offset;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+    uint32_t source_name_offset; /**< offset of the name of the assembly file inside the string table */
+} debuginfo_header_t;
+
+typedef struct {
+    uint32_t address;
+    uint32_t line;
+    uint32_t column;
+    uint32_t row_offset; /**< offset of the row inside the line table */
+} debuginfo_checkpoint_t;
+
+typedef struct {
+    uint32_t start; /**< address of the label */
+    uint32_t end; /**< address following the last word of the scope */
+    uint32_t name_offset; /**< offset of the label inside the string table */
+} debuginfo_scope_t;
+
+/**
+ * Source location of a memory address
+ */
+typedef struct {
+    uint32_t line;
+    uint32_t column; /**< 0 for words generated by the assembler (e.g. relaxed instructions) */
+} debuginfo_location_t;
+
+/**
+ * Read-only view of a debug file mapped into memory
+ */
+typedef struct {
+    const unsigned char *base;
+    size_t size;
+    const debuginfo_header_t *header;
+    const debuginfo_checkpoint_t *checkpoints;
+    const unsigned char *rows;
+    const debuginfo_scope_t *scopes;
+    const char *strings;
+} debuginfo_t;
+
+exit_t debuginfo_write(const char *debug_file_name, const char *assembly_file_name, linemetadata_t *tokenized_lines[]);
+exit_t debuginfo_open(const char *debug_file_name, debuginfo_t *debuginfo);
+void debuginfo_close(debuginfo_t *debuginfo);
+bool debuginfo_lookup(const debuginfo_t *debuginfo, memaddr_t address, debuginfo_location_t *location);
+const char *debuginfo_scope(const debuginfo_t *debuginfo, memaddr_t address);
+const char *debuginfo_source_name(const debuginfo_t *debuginfo);
+
+#endif
@@ -9,20 +9,40 @@
     - each key-val pair is stored in a node of a linked list
     - each linked list is pointed to by the element of an array
     - the array is indexed by the hash value of the keys
+    - the array starts with DICTSIZE elements and doubles its size whenever the number of
+      key-val pairs exceeds the number of elements, so that lists remain short
 */
 typedef struct node {
     struct node *next;
     char *key;
-    uint16_t val; //uint16_t is the range of LC3's memory address space
+    uint32_t val; //position of the label in the program during the assembly, LC3 memory address afterwards
 } node_t;
 
+/**
+ * Counters of the usage of the dictionary since the last call to reset_dict_stats,
+ * along with the distribution of the keys in the array
+ **/
+typedef struct {
+    uint64_t lookups;
+    uint64_t probes; /**< nodes compared with the key being looked up */
+    size_t keys;
+    size_t buckets; /**< elements of the array */
+    size_t used_buckets; /**< elements of the array whose linked list is not empty */
+    size_t longest_chain; /**< length of the longest linked list */
+} dict_stats_t;
+
+/**
+ * Returns the index of the element of the array whose linked list stores 'key'
+ **/
+unsigned hash(const char *s);
+
 /**
  * Adds a new key-val pair or update the value of an existing key
  *
  * Returns a pointer to the key-val pair created/modified or NULL if there is no
  * enough memory for a new entry
  **/
-node_t *add(const char *key, uint16_t val);
+node_t *add(const char *key, uint32_t val);
 
 /**
  *  Returns a pointer to key-val pair or NULL if 'key' is not found
@@ -48,6 +68,16 @@ bool delete(const char *key);
  **/
 void initialize();
 
+/**
+ * Returns the counters of the dictionary and computes the distribution of its keys
+ **/
+dict_stats_t get_dict_stats();
+
+/**
+ * Resets the counters of the dictionary
+ **/
+void reset_dict_stats();
+
 /**
  * Prints out the elements of the dictionary
  **/
@@ -0,0 +1,36 @@
+#ifndef FAB_DISASSEMBLER
+#define FAB_DISASSEMBLER
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define ADDRESS_SPACE_SIZE 65536
+#define MAX_SYMBOL_LENGTH 255 // longer names in the .sym file are truncated
+// address, word, label column and instruction whose target is a label
+#define MAX_DISASSEMBLED_LINE (16 + 2 * (MAX_SYMBOL_LENGTH + 1) + 32)
+
+/*
+    Disassembler of the asm output mode of lc3objdump, also used by lc3objdiff
+
+    Every word is printed on a line of its own with its address, its value, the label defined at its address (if
+    any) and the instruction it encodes, e.g.
+
+    x3000  4802                   JSR LABEL
+    x3001  1021                   ADD R0,R0,#1
+    x3002  F025                   HALT
+    x3003  1042  LABEL            ADD R0,R1,R2
+
+    Targets of PC-relative instructions are printed as the label defined at the target address or, if there is
+    none, as the offset (#n). Words that do not encode a valid instruction (including data) are printed as .FILL.
+
+    `symbols` maps every address to the label defined there, NULL if none; load_symbol_table fills it from a
+    .sym file written by the assembler, keeping the first label of each address.
+*/
+void build_decode_table();
+size_t disassemble_instruction(uint16_t word, uint16_t address, const char *const symbols[], char *output);
+size_t disassemble_words(const uint16_t words[], size_t num_words, uint16_t origin, const char *const symbols[], char *output);
+
+char *load_symbol_table(const char *symbol_file_name, const char *symbols[]);
+
+#endif
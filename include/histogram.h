@@ -0,0 +1,32 @@
+#ifndef FAB_HISTOGRAM
+#define FAB_HISTOGRAM
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Histogram of latencies with a bounded relative error (HDR-style)
+
+    Values are grouped by power of two, and each power of two is split into HISTOGRAM_SUB_BUCKETS / 2 buckets of
+    the same width, so a percentile is reported with a relative error below 2 / HISTOGRAM_SUB_BUCKETS (< 1.6%)
+    whatever its magnitude. Values from 0 to 2^HISTOGRAM_MAX_BITS - 1 are recorded, larger ones are recorded as the
+    largest value. The histogram has a fixed size and no pointers, so it can be copied as is between processes.
+*/
+#define HISTOGRAM_SUB_BUCKET_BITS 7
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_MAX_BITS 40 // 2^40 ns is more than 18 minutes
+#define HISTOGRAM_NUM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BUCKET_BITS + 2) * (HISTOGRAM_SUB_BUCKETS / 2))
+
+typedef struct {
+    uint64_t counts[HISTOGRAM_NUM_BUCKETS];
+    uint64_t total_count;
+    uint64_t min;
+    uint64_t max; /**< exact largest value recorded */
+} histogram_t;
+
+void histogram_init(histogram_t *histogram);
+void histogram_record(histogram_t *histogram, uint64_t value);
+void histogram_merge(histogram_t *histogram, const histogram_t *other);
+uint64_t histogram_percentile(const histogram_t *histogram, double percentile);
+
+#endif
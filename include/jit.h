@@ -0,0 +1,62 @@
+#ifndef FAB_JIT
+#define FAB_JIT
+
+#include "vm.h"
+
+/*
+    Basic-block JIT compiler from LC-3 to x86-64 for the virtual machine (see vm.h)
+
+    jit_run runs the machine as vm_run does, but counts how many times each basic block is entered from the
+    interpreter and, once a block has been entered `threshold` times, translates it to x86-64 code in an
+    executable buffer mapped with mmap. Translated blocks jump directly to each other (block chaining), and return
+    to the interpreter for what they do not handle: traps, RTI, JMPT/RTT, device registers, accesses that the MPR
+    denies, and stores into instructions (those that have been decoded). Any store that discards a decoded
+    instruction (vm_t.code_writes) flushes all translated code.
+
+    The instructions run by translated code are counted as by the interpreter, so jit_run stops after exactly
+    `max_instructions` instructions and the machine can be compared with one run by vm_run. With `step` set,
+    blocks are not chained and jit_run returns after each block, so that a test can compare the machine after
+    every block.
+
+    A jit_t translates the code of a single machine: it must be initialized again to run another one. Only
+    x86-64 is supported: jit_init fails on other architectures.
+*/
+#define JIT_DEFAULT_THRESHOLD 32
+#define JIT_MAX_BLOCK_INSTRUCTIONS 64
+#define JIT_CODE_SIZE (16 * 1024 * 1024)
+
+typedef struct {
+    uint64_t native_instructions;
+    uint64_t interpreted_instructions;
+    uint64_t blocks_compiled;
+    uint64_t flushes;
+} jit_stats_t;
+
+typedef struct {
+    uint16_t target;
+    uint32_t stub; /**< offset in the code buffer of the exit to patch once the target is translated */
+} jit_link_t;
+
+typedef struct {
+    unsigned char *code; /**< readable, writable and executable buffer of JIT_CODE_SIZE bytes */
+    size_t code_size;
+    size_t first_block; /**< offset of the first block, after the entry and exit code */
+    size_t exit_branch; /**< offset of the exit to a block that is not translated */
+    size_t exit_interpret; /**< offset of the exit to an instruction the interpreter must run */
+    unsigned char *entries[VM_ADDRESS_SPACE]; /**< translated block starting at each address, NULL if none */
+    uint16_t counts[VM_ADDRESS_SPACE]; /**< times each address was entered as a block from the interpreter */
+    jit_link_t *links;
+    size_t num_links;
+    size_t links_capacity;
+    unsigned threshold;
+    bool step;
+    const vm_t *vm;
+    uint64_t code_writes; /**< vm->code_writes when the translated code was last checked */
+    jit_stats_t stats;
+} jit_t;
+
+exit_t jit_init(jit_t *jit, unsigned threshold);
+void jit_release(jit_t *jit);
+vm_status_t jit_run(jit_t *jit, vm_t *vm, uint64_t max_instructions);
+
+#endif
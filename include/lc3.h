@@ -4,9 +4,12 @@
 #include "dict.h"
 
 #define ADDRESS_SPACE_CARDINALITY 65536
+#define MAX_NUM_SEGMENTS 1024
+// one slot per word of the program + one slot per .ORIG line + final NULL sentinel
+#define TOKENIZED_LINES_CAPACITY (ADDRESS_SPACE_CARDINALITY + MAX_NUM_SEGMENTS + 1)
 
 typedef enum {
-    ORIG_DIRECTIVE, END_DIRECTIVE, OPCODE, LABEL, COMMENT, BLANK_LINE, FILL_DIRECTIVE, BLKW_DIRECTIVE, STRINGZ_DIRECTIVE
+    ORIG_DIRECTIVE, END_DIRECTIVE, OPCODE, LABEL, COMMENT, BLANK_LINE, FILL_DIRECTIVE, BLKW_DIRECTIVE, STRINGZ_DIRECTIVE, STRINGP_DIRECTIVE
 } linetype_t;
 
 typedef enum {
@@ -20,10 +23,103 @@ typedef struct linemetadata {
     int num_tokens;
     bool is_label_line; /**< flag to identify lines that begin with a label */
     int line_number; /**< line number inside the assembly file */
+    int column; /**< column of the instruction or directive inside the line, 0 for lines generated by the assembler */
     int instruction_location; /**< instruction position inside the assembly file */
     uint16_t machine_instruction; /**< binary representation of the instruction contained by the line */
 } linemetadata_t;
 
+/**
+ * Block of consecutive memory locations starting at the address given by a .ORIG directive
+ **/
+typedef struct segment {
+    memaddr_t origin; /**< memory address given by .ORIG */
+    int orig_slot; /**< position of the .ORIG line in `tokenized_lines` */
+    int num_words; /**< number of words of the segment (.ORIG line not included) */
+    int line_number; /**< line number of the .ORIG directive */
+} segment_t;
+
+/**
+ * Options of the assembly process; all optional passes are disabled by default
+ **/
+typedef struct options {
+    bool dce; /**< remove unreachable code and unreferenced data */
+    bool optimize; /**< run the peephole optimizer */
+    bool relax; /**< rewrite instructions whose label is out of the range of their PC offset */
+    int relax_register; /**< scratch register used to relax branches, -1 if none */
+    bool stringp_report; /**< report the memory saved by .STRINGP directives */
+    bool debug_info; /**< write a debug file (.dbg) mapping addresses to source lines */
+    bool analyze; /**< report the basic blocks, loops and cost of each subroutine in JSON format */
+    int memory_access_cycles; /**< cycles per memory access in the cost model of the analysis */
+    bool stats; /**< report the time spent in each phase and the counters of the assembly in JSON format */
+    bool latency; /**< time each phase even without statistics, for the latency report of a batch */
+    FILE *report; /**< stream where optional passes report their rewrites, NULL to disable the report */
+    FILE *analysis_json; /**< stream of the JSON report of the analysis, apart from the rewrites so that it can be parsed */
+    FILE *stats_json; /**< stream of the JSON statistics of each file, apart from the reports so that it can be parsed */
+} options_t;
+
+/**
+ * Options of the assembly of a batch of files
+ **/
+typedef struct batch_options {
+    int num_workers; /**< number of processes assembling files at the same time, 1 to assemble them in this process */
+    const char *trace_file_name; /**< file where the Chrome trace of the assemblies is written, NULL for no trace */
+    bool latency; /**< report the distribution of the latency of the files and of each phase at the end */
+    int num_slowest_files; /**< number of slowest files named in the latency report, at most MAX_SLOWEST_FILES */
+} batch_options_t;
+
+#define MAX_SLOWEST_FILES 100
+
+/**
+ * Phases of the assembly process timed by --stats, --trace and --latency
+ **/
+typedef enum {
+    PHASE_LEXICAL_ANALYSIS, PHASE_DCE, PHASE_PEEPHOLE, PHASE_RELAXATION, PHASE_SYNTAX_ANALYSIS, PHASE_REPORTS,
+    PHASE_DEBUG_INFO, PHASE_SYMBOL_TABLE, PHASE_OBJECT_FILE, NUM_PHASES
+} phase_t;
+
+/**
+ * Time spent in each phase of the assembly of a file and counters of the work done
+ **/
+typedef struct stats {
+    uint64_t phase_ns[NUM_PHASES]; /**< monotonic time spent in each phase, 0 for the phases that did not run */
+    uint64_t total_ns;
+    size_t lines; /**< lines read from the assembly file */
+    size_t tokens;
+    size_t words; /**< words of the program written to the object file */
+    size_t bytes_written; /**< size of the files generated (.obj, .sym and .dbg) */
+    uint64_t allocations; /**< allocations made by the assembly, as counted by memtrack (0 if tracking is disabled) */
+    dict_stats_t dict;
+} stats_t;
+
+extern stats_t assembly_stats;
+
+/**
+ * Replacement of the line stored in a slot of `tokenized_lines` by a sequence of lines (possibly empty)
+ **/
+typedef struct slot_rewrite {
+    bool rewritten; /**< false if the line is kept */
+    linemetadata_t **lines; /**< lines replacing the original one */
+    int num_lines;
+} slot_rewrite_t;
+
+/*
+    Programs made of a single segment are written in the classic object format:
+    the origin of the segment followed by its words.
+
+    Programs made of several segments are written in a segmented object format, so that there is no need to
+    fill the gaps between segments with zeros. All values are 16-bit big-endian words:
+    - SEGMENTED_OBJ_MAGIC1, SEGMENTED_OBJ_MAGIC2
+    - number of segments (n)
+    - n segment descriptors: origin, number of words
+    - words of each segment, in the same order as the descriptors
+
+    Readers tell the formats apart by the magic words, so a single segment at origin SEGMENTED_OBJ_MAGIC1 whose
+    first word is SEGMENTED_OBJ_MAGIC2 is written in the segmented format too: its classic image would be
+    indistinguishable from a segmented object.
+*/
+#define SEGMENTED_OBJ_MAGIC1 0x4C33 // "L3"
+#define SEGMENTED_OBJ_MAGIC2 0x5347 // "SG"
+
 exit_t parse_add(linemetadata_t *line_metadata);
 exit_t parse_and(linemetadata_t *line_metadata);
 exit_t parse_not(linemetadata_t *line_metadata);
@@ -38,21 +134,57 @@ exit_t parse_trap(linemetadata_t *line_metadata);
 exit_t parse_orig(linemetadata_t *line_metadata);
 exit_t parse_fill(linemetadata_t *line_metadata, memaddr_t address_origin);
 exit_t parse_blkw(linemetadata_t *line_metadata);
-exit_t parse_stringz(linemetadata_t *line_metadata, linemetadata_t *tokenized_lines[], memaddr_t *instruction_offset);
+exit_t parse_stringz(linemetadata_t *line_metadata, linemetadata_t *tokenized_lines[], size_t *instruction_offset);
+exit_t parse_stringp(linemetadata_t *line_metadata, linemetadata_t *tokenized_lines[], size_t *instruction_offset);
+void report_stringp_savings(linemetadata_t *tokenized_lines[], FILE *report);
 
 exit_t serialize_symbol_table(FILE *symbol_table_file, memaddr_t address_origin);
+int write_machine_instruction(uint16_t machine_instr, FILE *destination_file);
 exit_t assemble(const char *assembly_file_name);
+exit_t assemble_with_options(const char *assembly_file_name, const options_t *options);
+int assemble_files(const char *assembly_file_names[], int num_files, const options_t *options, const batch_options_t *batch_options);
 exit_t do_lexical_analysis(FILE *assembly_file, linemetadata_t *tokenized_lines[]);
 exit_t do_syntax_analysis(linemetadata_t *tokenized_lines[]);
 
-exit_t is_valid_lc3integer(char *token, int16_t *imm, uint16_t line_counter);
+exit_t compute_segments(linemetadata_t *tokenized_lines[]);
+void clear_segments();
+size_t get_num_segments();
+const segment_t *get_segment(size_t i);
+memaddr_t slot_address(int slot, memaddr_t address_origin);
+long segment_displacement(int from_slot, int to_slot);
+
+size_t count_slots(linemetadata_t *tokenized_lines[]);
+linemetadata_t *new_line(const char *text, int line_number);
+void compute_slot_map(const slot_rewrite_t rewrites[], size_t num_slots, size_t slot_map[]);
+exit_t check_numeric_offsets(linemetadata_t *tokenized_lines[], const size_t slot_map[]);
+exit_t apply_slot_rewrites(linemetadata_t *tokenized_lines[], slot_rewrite_t rewrites[], const size_t slot_map[]);
+void free_slot_rewrites(slot_rewrite_t rewrites[], size_t num_slots);
+void print_line_tokens(FILE *stream, const linemetadata_t *line_metadata);
+exit_t relax(linemetadata_t *tokenized_lines[], const options_t *options);
+exit_t peephole_optimize(linemetadata_t *tokenized_lines[], const options_t *options);
+exit_t eliminate_dead_code(linemetadata_t *tokenized_lines[], const options_t *options);
+exit_t analyze_program(linemetadata_t *tokenized_lines[], const char *assembly_file_name, const options_t *options);
+
+const char *phase_name(phase_t phase);
+uint64_t monotonic_ns();
+void reset_stats();
+void count_allocations();
+void add_written_bytes(const char *file_name);
+void write_stats_json(FILE *stream, const char *assembly_file_name, const exit_t *result);
+
+exit_t is_valid_lc3integer(char *token, int16_t *imm, int line_counter);
 int parse_register(char *token);
-exit_t parse_imm5(char *str, long *imm5, uint16_t line_counter);
-exit_t parse_memory_address(char *str, long *n, uint16_t line_counter);
-exit_t parse_offset(char* value, int lower_bound, int upper_bound, uint16_t instruction_number, uint16_t line_counter, long *offset, int num_bits);
-exit_t parse_trapvector(char *token,  long *trapvector, uint16_t line_counter);
+exit_t parse_imm5(char *str, long *imm5, int line_counter);
+exit_t parse_memory_address(char *str, long *n, int line_counter);
+bool numeric_offset(const char *token, long *offset);
+exit_t label_offset(const char *label, int instruction_number, int line_counter, long *offset);
+int pc_relative_operand(const linemetadata_t *line_metadata, int *num_bits);
+int branch_condition_codes(opcode_t opcode);
+exit_t parse_offset(char* value, int lower_bound, int upper_bound, int instruction_number, int line_counter, long *offset, int num_bits);
+exit_t parse_trapvector(char *token,  long *trapvector, int line_counter);
 linetype_t compute_line_type(const char *first_token);
 opcode_t compute_opcode_type(const char *opcode);
+void print_json_string(FILE *stream, const char *value);
 void free_line_metadata(linemetadata_t *line_metadata);
 void free_tokenized_lines(linemetadata_t *tokenized_lines[]);
 
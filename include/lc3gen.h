@@ -0,0 +1,31 @@
+#ifndef FAB_LC3GEN
+#define FAB_LC3GEN
+
+#include <inttypes.h>
+#include "lc3.h"
+
+#define GENERATOR_MAX_BRANCH_DISTANCE 255 // largest distance reachable by PCoffset9 in both directions
+
+/*
+    Parameters of the synthetic programs generated by lc3gen
+
+    Ratios are probabilities between 0 and 1 applied independently to every generated line, so the same seed
+    and parameters always produce the same program
+*/
+typedef struct {
+    size_t num_lines; /**< number of lines between .ORIG and .END */
+    uint64_t seed;
+    double label_density; /**< share of instruction/data lines that define a label */
+    double forward_ratio; /**< share of label references pointing to a label defined later in the program */
+    double data_ratio; /**< share of lines that are .STRINGZ, .BLKW or .FILL directives */
+    double comment_ratio; /**< share of lines that only contain a comment */
+    int branch_distance; /**< maximum distance in words between a PC-relative instruction and its label */
+    bool collide; /**< all labels have the same hash value, so they end up in the same bucket of the symbol table */
+} generator_options_t;
+
+#define GENERATOR_DEFAULT_OPTIONS { .num_lines = 1000, .seed = 1, .label_density = 0.2, .forward_ratio = 0.5, \
+    .data_ratio = 0.1, .comment_ratio = 0.1, .branch_distance = 64, .collide = false }
+
+exit_t generate_program(FILE *asm_file, const generator_options_t *options, size_t *num_words);
+
+#endif
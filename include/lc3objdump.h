@@ -0,0 +1,36 @@
+#ifndef FAB_LC3OBJDUMP
+#define FAB_LC3OBJDUMP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "disassembler.h"
+
+#define DEC_OUTPUT_MODE 0
+#define BIN_OUTPUT_MODE 1
+#define HEX_OUTPUT_MODE 2
+#define ASM_OUTPUT_MODE 3
+
+/*
+    Formatting of the dec, hex and bin output modes
+
+    The hex and bin modes have vector kernels, selected at run time among the ones supported by the CPU
+    (fastest_format_kernel). They store whole vectors, so they may write up to FORMAT_OUTPUT_SLACK characters
+    past the text they format.
+*/
+#define FORMAT_OUTPUT_SLACK 16
+
+typedef enum {
+    SCALAR_KERNEL,
+    SSE2_KERNEL,
+    AVX2_KERNEL,
+    NUM_FORMAT_KERNELS
+} format_kernel_t;
+
+bool format_kernel_supported(format_kernel_t kernel);
+format_kernel_t fastest_format_kernel();
+const char *format_kernel_name(format_kernel_t kernel);
+void select_format(int output_mode, format_kernel_t kernel);
+size_t format_words(const unsigned char *bytes, size_t num_bytes, char *output);
+
+#endif
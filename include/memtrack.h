@@ -0,0 +1,47 @@
+#ifndef FAB_MEMORY_TRACKER
+#define FAB_MEMORY_TRACKER
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+    Allocation tracker
+
+    Memory allocated by the assembler is attributed to a category. Tracking is enabled at build time
+    (-DFAB_MEMTRACK) or at run time (environment variable LC3_MEMTRACK=1); the decision is made on the first
+    allocation and holds for the rest of the process. When it is enabled that way, the calls, bytes and peak live
+    bytes of each category are printed to stderr at exit. memtrack_enable turns it on before the first allocation
+    without that report, for programs that read the counters themselves (lc3as --stats=json).
+
+    Blocks returned by tracked_malloc/tracked_calloc/tracked_realloc/tracked_strdup must be released with
+    tracked_free (and resized with tracked_realloc), as they are preceded by a header when tracking is enabled.
+    Memory allocated by other means (e.g. getline buffers or error descriptions, which callers release with free)
+    is accounted for with memtrack_account.
+*/
+typedef enum {
+    MEM_TOKENS, MEM_LINES, MEM_SYMBOLS, MEM_DIAGNOSTICS, MEM_IO_BUFFERS, NUM_MEM_CATEGORIES
+} memcategory_t;
+
+typedef struct {
+    uint64_t calls; /**< allocations, including the ones resizing a block */
+    uint64_t bytes; /**< bytes requested by the allocations */
+    uint64_t live_bytes;
+    uint64_t peak_live_bytes;
+} memcategory_stats_t;
+
+bool memtrack_enabled();
+bool memtrack_enable();
+void *tracked_malloc(size_t size, memcategory_t category);
+void *tracked_calloc(size_t count, size_t size, memcategory_t category);
+void *tracked_realloc(void *ptr, size_t size, memcategory_t category);
+char *tracked_strdup(const char *str, memcategory_t category);
+void tracked_free(void *ptr);
+void memtrack_account(memcategory_t category, long bytes);
+memcategory_stats_t memtrack_category_stats(memcategory_t category);
+uint64_t memtrack_calls();
+uint64_t memtrack_peak_live_bytes();
+void memtrack_reset_peaks();
+void memtrack_report(FILE *stream);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef FAB_OBJDIFF
+#define FAB_OBJDIFF
+
+#include "util.h"
+#include "disassembler.h"
+
+/*
+    Comparison of object files generated by the assembler (lc3objdiff)
+
+    Both files are mapped into memory and scanned in blocks with memcmp, so that identical objects cost little
+    more than reading them. Each differing word is reported with its address, the nearest label at or before it
+    (from the .sym file next to each object) and the instruction it decodes to on both sides, e.g.
+
+    test/testfiles/t1.expected.obj test/testfiles/t1.obj: 1 word differs
+      x3001 LOOP+1       expected 1021 ADD R0,R0,#1             actual 1022 ADD R0,R0,#2
+
+    Words are compared by their position in the files; header words of the object formats (origin, segment
+    descriptors) are reported as such. Words present on a single side are reported as missing on the other.
+    Labels of the expected object are taken from the .sym file of the actual object if it has none.
+*/
+#define DEFAULT_MAX_REPORTED_DIFFERENCES 10
+
+exit_t diff_objects(const char *expected_file_name, const char *actual_file_name, size_t max_reported, FILE *report,
+                    size_t *num_differences);
+exit_t diff_directories(const char *expected_dir_name, const char *actual_dir_name, size_t max_reported, FILE *report,
+                        size_t *num_differing_files);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef FAB_TRACE
+#define FAB_TRACE
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "util.h"
+
+/*
+    Trace of a batch of assemblies in the Chrome trace-event format (chrome://tracing, https://ui.perfetto.dev)
+
+    Each worker records a complete event ("ph": "X") for every file it assembles and for every phase of the
+    assembly. Events are stored in a buffer owned by the worker and written to a file of its own
+    (<trace file>.<worker>) when the buffer is full and when tracing stops. trace_merge then gathers the files of
+    all workers into the trace file, where each worker is shown as a thread.
+*/
+#define TRACE_BUFFER_CAPACITY 4096 // events buffered by a worker before they are written
+
+exit_t trace_start(const char *trace_file_name, int worker);
+bool tracing();
+void trace_span(const char *category, const char *name, uint64_t start_ns, uint64_t end_ns);
+exit_t trace_stop();
+exit_t trace_merge(const char *trace_file_name, int num_workers);
+
+#endif
@@ -12,6 +12,7 @@
 #include <errno.h>
 #include <assert.h>
 #include <unistd.h>
+#include "memtrack.h"
 
 #define ERR_DESC_LENGTH 300
 #define MAX_NUM_TOKENS 200
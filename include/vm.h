@@ -0,0 +1,127 @@
+#ifndef FAB_VM
+#define FAB_VM
+
+#include "util.h"
+
+/*
+    Virtual machine that runs the object files written by the assembler (lc3vm)
+
+    The machine implements the whole instruction set, including JMPT and RTT, with the privilege model of the
+    simulator whose operating system is test/testfiles/lc3os.asm:
+    - PSR[15] is set in supervisor mode, which is the mode the machine starts in
+    - TRAP saves the PC in R7, jumps to the service routine of the trap vector table and enters supervisor mode
+    - JMPT and RTT jump (to BaseR and R7) and return to user mode
+    - RTI pops PC and PSR from the stack pointed by R6; executing it in user mode is a privilege violation
+    - in user mode, memory can only be accessed in the 4K pages whose bit is set in the memory protection
+      register (MPR); accessing any other address is an access violation
+    LEA sets the condition codes, as in the second edition of the specification.
+
+    If the trap vector table has no service routine for a vector (its entry is zero, e.g. no operating system was
+    loaded), the machine runs the service routines of GETC, OUT, PUTS, IN, PUTSP and HALT itself.
+
+    Devices are mapped from VM_DEVICES_START: the keyboard (KBSR, KBDR) reads from `io.read_char`, the display
+    (DSR, DDR) writes to `io.write_char`, and clearing bit 15 of the machine control register (MCR) halts the
+    machine. Reading the keyboard status once the input is exhausted stops the machine, as a program polling it
+    would never finish.
+
+    Instructions are decoded once, the first time they are run, into `decoded`: the handler that runs them and
+    their operands, with offsets sign-extended and PC-relative addresses already computed. The pages of
+    VM_DECODED_PAGE_SIZE words that hold decoded instructions are marked in `decoded_pages`, and a store into
+    one of them discards the decoded instruction at that address, so self-modifying programs see their changes.
+    Memory written from outside the machine once it has run must be written with vm_write_memory.
+*/
+#define VM_ADDRESS_SPACE 65536
+#define VM_NUM_REGISTERS 8
+#define VM_DEVICES_START 0xFE00
+#define VM_KBSR 0xFE00
+#define VM_KBDR 0xFE02
+#define VM_DSR 0xFE04
+#define VM_DDR 0xFE06
+#define VM_MPR 0xFE12
+#define VM_PSR 0xFFFC
+#define VM_MCR 0xFFFE
+#define VM_OS_START 0x0200 // entry point of lc3os.asm
+#define VM_PSR_SUPERVISOR 0x8000
+#define VM_PSR_N 4
+#define VM_PSR_Z 2
+#define VM_PSR_P 1
+#define VM_UNLIMITED UINT64_MAX
+#define VM_DECODED_PAGE_SIZE 64
+#define VM_NUM_DECODED_PAGES (VM_ADDRESS_SPACE / VM_DECODED_PAGE_SIZE)
+
+typedef enum {
+    VM_RUNNING, /**< only seen by the service routines of the machine */
+    VM_HALTED,
+    VM_LIMIT_REACHED, /**< the machine can be run again from where it stopped */
+    VM_INPUT_EXHAUSTED,
+    VM_ILLEGAL_OPCODE,
+    VM_PRIVILEGE_VIOLATION,
+    VM_ACCESS_VIOLATION,
+    VM_INVALID_TRAP /**< trap vector without service routine, neither in memory nor in the machine */
+} vm_status_t;
+
+typedef struct {
+    int (*read_char)(void *context); /**< next character of the input, EOF at its end */
+    void (*write_char)(int c, void *context);
+    void *context;
+} vm_io_t;
+
+//how vm_run runs a decoded instruction: opcode specialized by addressing mode
+typedef enum {
+    VM_DO_DECODE,
+    VM_DO_BR,
+    VM_DO_BR_ALWAYS,
+    VM_DO_BR_NEVER,
+    VM_DO_ADD_REGISTER,
+    VM_DO_ADD_IMMEDIATE,
+    VM_DO_LD,
+    VM_DO_ST,
+    VM_DO_JSR,
+    VM_DO_JSRR,
+    VM_DO_AND_REGISTER,
+    VM_DO_AND_IMMEDIATE,
+    VM_DO_LDR,
+    VM_DO_STR,
+    VM_DO_RTI,
+    VM_DO_NOT,
+    VM_DO_LDI,
+    VM_DO_STI,
+    VM_DO_JMP,
+    VM_DO_JMPT,
+    VM_DO_RESERVED,
+    VM_DO_LEA,
+    VM_DO_TRAP,
+    VM_NUM_HANDLERS
+} vm_handler_t;
+
+typedef struct {
+    uint8_t handler; /**< vm_handler_t, VM_DO_DECODE until the instruction is decoded */
+    uint8_t dr; /**< DR, SR of stores, or nzp of BR */
+    uint8_t sr1; /**< SR1 or BaseR */
+    uint8_t sr2;
+    uint16_t operand; /**< immediate, offset6, address computed from the PC, or trap vector */
+} vm_decoded_t;
+
+typedef struct {
+    uint16_t memory[VM_ADDRESS_SPACE];
+    vm_decoded_t decoded[VM_ADDRESS_SPACE];
+    uint64_t decoded_pages[VM_NUM_DECODED_PAGES / 64];
+    uint16_t registers[VM_NUM_REGISTERS];
+    uint16_t pc; /**< address of the faulting instruction if the machine stopped on an error */
+    uint16_t psr; /**< privilege (bit 15) and condition codes (bits 2-0) */
+    uint16_t mpr;
+    vm_io_t io;
+    int pending_char; /**< character read to answer KBSR and not yet read from KBDR, EOF if none */
+    uint64_t instructions; /**< executed since vm_init */
+    uint64_t code_writes; /**< stores that discarded a decoded instruction */
+} vm_t;
+
+void vm_init(vm_t *vm);
+exit_t vm_load_image(vm_t *vm, const unsigned char *bytes, size_t size, uint16_t *origin);
+exit_t vm_load_object(vm_t *vm, const char *file_name, uint16_t *origin);
+void vm_write_memory(vm_t *vm, uint16_t address, uint16_t value);
+const vm_decoded_t *vm_decoded_instruction(vm_t *vm, uint16_t address);
+vm_status_t vm_run(vm_t *vm, uint64_t max_instructions);
+const char *vm_status_description(vm_status_t status);
+
+#endif
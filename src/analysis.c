@@ -0,0 +1,669 @@
+/**
+ * @file analysis.c
+ * @brief Static estimation of the cost of the subroutines of a program (--analyze)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The analysis works on the encoded program, once the syntax analysis has filled in the machine instructions.
+ *
+ * Basic blocks start at the first word of each segment, at the targets of branches and calls and after any
+ * instruction transferring control (BR, JMP, RET, JSR, JSRR, RTI, TRAP x25). A subroutine is made of the blocks
+ * reachable from its entry point without following calls; entry points are the start of each segment and the
+ * targets of JSR. Calls (JSR, JSRR, TRAP) are counted as one instruction of the caller, the cost of the callee is
+ * reported separately.
+ *
+ * A depth-first search of each subroutine identifies the back edges; without them, the blocks form a DAG whose
+ * shortest and longest paths give the best and worst case of the subroutine when no loop is repeated. Each back
+ * edge defines a natural loop, whose cost per iteration is computed in the same way.
+ *
+ * Cost model: every instruction takes 1 cycle plus `memory_access_cycles` per memory access, the fetch of the
+ * instruction included (e.g. LDI performs 3 accesses). Indirect jumps (JMP Rn with n != 7) end the subroutine,
+ * as their target is not known statically.
+ */
+
+#include "../include/lc3.h"
+
+typedef enum {
+    FALL_THROUGH, CONDITIONAL_BRANCH, UNCONDITIONAL_BRANCH, CALL, INDIRECT_CALL, INDIRECT_JUMP, RETURN, STOP
+} transfer_t;
+
+// reason why a block ends a subroutine, indexed by transfer_t
+static const char *exit_names[] = { "data", NULL, NULL, "data", "data", "indirect", "ret", "halt" };
+
+typedef struct basic_block {
+    size_t first_slot;
+    size_t last_slot;
+    int num_instructions;
+    long cycles;
+    size_t successors[2];
+    int num_successors;
+    const char *exit; /**< reason why the block ends the subroutine, NULL if it does not */
+    size_t callee; /**< block called by the last instruction, SIZE_MAX if none */
+} basic_block_t;
+
+typedef struct path_cost {
+    long instructions;
+    long cycles;
+} path_cost_t;
+
+typedef struct loop {
+    size_t header;
+    size_t *body;
+    size_t body_size;
+    int depth;
+} loop_t;
+
+typedef struct program_cfg {
+    linemetadata_t **tokenized_lines;
+    size_t num_slots;
+    memaddr_t origin;
+    int memory_access_cycles;
+    basic_block_t *blocks;
+    size_t num_blocks;
+    size_t *block_of_slot; /**< SIZE_MAX for words that are not instructions */
+    long *slot_of_address;
+    const char **label_of_slot;
+} program_cfg_t;
+
+/**
+ * @brief Scratch arrays of the analysis of one subroutine, indexed by block
+ */
+typedef struct subroutine_scratch {
+    int *color; /**< 0: not visited, 1: on the DFS stack, 2: done */
+    bool *back_edge; /**< 2 entries per block, one per successor */
+    size_t *order; /**< blocks in reverse postorder */
+    size_t num_blocks;
+    size_t *stack;
+    int *next_successor;
+    path_cost_t *best;
+    path_cost_t *worst;
+    bool *in_region;
+    int *loop_depth;
+} subroutine_scratch_t;
+
+/**
+ * @brief Entry blocks of the subroutines found so far, in the order they are reported
+ */
+typedef struct entry_queue {
+    size_t *entries;
+    size_t num_entries;
+    bool *is_entry;
+} entry_queue_t;
+
+static void enqueue_entry(entry_queue_t *queue, size_t block) {
+    if(!queue->is_entry[block]) {
+        queue->is_entry[block] = true;
+        queue->entries[queue->num_entries++] = block;
+    }
+}
+
+static bool is_instruction_slot(const program_cfg_t *cfg, size_t slot) {
+    linemetadata_t *line_metadata = slot < cfg->num_slots ? cfg->tokenized_lines[slot] : NULL;
+    return line_metadata && line_metadata->tokens && compute_line_type(line_metadata->tokens[0]) == OPCODE;
+}
+
+static long sign_extend(uint16_t value, int num_bits) {
+    long mask = 1L << (num_bits - 1);
+    value &= (1 << num_bits) - 1;
+    return (value ^ mask) - mask;
+}
+
+/**
+ * @brief Kind of transfer of control performed by an encoded instruction
+ *
+ * @param word encoded instruction
+ * @param offset PC offset of branches and JSR
+ */
+static transfer_t decode_transfer(uint16_t word, long *offset) {
+    switch(word >> 12) {
+    case 0x0: {
+        int condition_codes = (word >> 9) & 0x7;
+        *offset = sign_extend(word, 9);
+        return condition_codes == 0 ? FALL_THROUGH : (condition_codes == 0x7 ? UNCONDITIONAL_BRANCH : CONDITIONAL_BRANCH);
+    }
+    case 0x4:
+        *offset = sign_extend(word, 11);
+        return (word & 0x0800) ? CALL : INDIRECT_CALL;
+    case 0xC:
+        return ((word >> 6) & 0x7) == 7 ? RETURN : INDIRECT_JUMP;
+    case 0x8:
+        return RETURN;
+    case 0xF:
+        return (word & 0xFF) == 0x25 ? STOP : FALL_THROUGH;
+    default:
+        return FALL_THROUGH;
+    }
+}
+
+static long instruction_cycles(uint16_t word, int memory_access_cycles) {
+    int memory_accesses = 1;
+    switch(word >> 12) {
+    case 0x2: case 0x3: case 0x6: case 0x7: case 0xF: //LD, ST, LDR, STR, TRAP (vector table)
+        memory_accesses += 1;
+        break;
+    case 0xA: case 0xB: //LDI, STI
+        memory_accesses += 2;
+        break;
+    }
+    return 1 + (long)memory_accesses * memory_access_cycles;
+}
+
+/**
+ * @brief Slot of the instruction at the target of a PC-relative transfer, -1 if the target is not an instruction
+ */
+static long target_slot(const program_cfg_t *cfg, size_t slot, long offset) {
+    memaddr_t target_address = (slot_address(slot, cfg->origin) + 1 + offset) & 0xFFFF;
+    long target = cfg->slot_of_address[target_address];
+    return target != -1 && is_instruction_slot(cfg, target) ? target : -1;
+}
+
+/**
+ * @brief Split the instructions of the program into basic blocks and link them
+ */
+static exit_t build_blocks(program_cfg_t *cfg) {
+    size_t num_slots = cfg->num_slots;
+    bool *is_leader = calloc(num_slots + 1, sizeof(bool));
+    if(!is_leader) {
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+    for(size_t slot = 1; slot < num_slots; slot++) {
+        if(!is_instruction_slot(cfg, slot)) {
+            continue;
+        }
+        long offset = 0;
+        transfer_t transfer = decode_transfer(cfg->tokenized_lines[slot]->machine_instruction, &offset);
+        if(!is_instruction_slot(cfg, slot - 1)) {
+            is_leader[slot] = true;
+        }
+        if(transfer != FALL_THROUGH) {
+            is_leader[slot + 1] = true;
+        }
+        long target;
+        if((transfer == CONDITIONAL_BRANCH || transfer == UNCONDITIONAL_BRANCH || transfer == CALL) && (target = target_slot(cfg, slot, offset)) != -1) {
+            is_leader[target] = true;
+        }
+    }
+
+    cfg->num_blocks = 0;
+    for(size_t slot = 1; slot < num_slots; slot++) {
+        if(!is_instruction_slot(cfg, slot)) {
+            continue;
+        }
+        if(is_leader[slot]) {
+            cfg->blocks[cfg->num_blocks++] = (basic_block_t) { .first_slot = slot, .callee = SIZE_MAX };
+        }
+        basic_block_t *block = &cfg->blocks[cfg->num_blocks - 1];
+        block->last_slot = slot;
+        block->num_instructions++;
+        block->cycles += instruction_cycles(cfg->tokenized_lines[slot]->machine_instruction, cfg->memory_access_cycles);
+        cfg->block_of_slot[slot] = cfg->num_blocks - 1;
+    }
+    free(is_leader);
+
+    for(size_t i = 0; i < cfg->num_blocks; i++) {
+        basic_block_t *block = &cfg->blocks[i];
+        size_t last_slot = block->last_slot;
+        long offset = 0;
+        transfer_t transfer = decode_transfer(cfg->tokenized_lines[last_slot]->machine_instruction, &offset);
+        long target = -1;
+        if(transfer == CONDITIONAL_BRANCH || transfer == UNCONDITIONAL_BRANCH || transfer == CALL) {
+            target = target_slot(cfg, last_slot, offset);
+        }
+        if(transfer == CALL && target != -1) {
+            block->callee = cfg->block_of_slot[target];
+        }
+        if(transfer == CONDITIONAL_BRANCH || transfer == UNCONDITIONAL_BRANCH) {
+            if(target == -1) {
+                //the branch leaves the code, but a conditional one still falls through to the next instruction
+                block->exit = exit_names[FALL_THROUGH];
+            }
+            else {
+                block->successors[block->num_successors++] = cfg->block_of_slot[target];
+            }
+        }
+        if(transfer == INDIRECT_JUMP || transfer == RETURN || transfer == STOP) {
+            block->exit = exit_names[transfer];
+        }
+        else if(transfer != UNCONDITIONAL_BRANCH) {
+            if(is_instruction_slot(cfg, last_slot + 1)) {
+                size_t following = cfg->block_of_slot[last_slot + 1];
+                if(block->num_successors == 0 || block->successors[0] != following) {
+                    block->successors[block->num_successors++] = following;
+                }
+            }
+            else {
+                block->exit = exit_names[FALL_THROUGH];
+            }
+        }
+    }
+    return success();
+}
+
+/**
+ * @brief Depth-first search of the blocks of a subroutine, recording back edges and the reverse postorder
+ */
+static void visit_subroutine(const program_cfg_t *cfg, size_t entry, subroutine_scratch_t *scratch) {
+    size_t stack_size = 0;
+    size_t num_done = 0;
+    scratch->stack[stack_size++] = entry;
+    scratch->color[entry] = 1;
+    scratch->next_successor[entry] = 0;
+    //postorder is written from the end of `order`, then moved to the beginning
+    size_t *postorder = scratch->order + cfg->num_blocks;
+    while(stack_size > 0) {
+        size_t block = scratch->stack[stack_size - 1];
+        const basic_block_t *basic_block = &cfg->blocks[block];
+        if(scratch->next_successor[block] == basic_block->num_successors) {
+            scratch->color[block] = 2;
+            *--postorder = block;
+            num_done++;
+            stack_size--;
+            continue;
+        }
+        int i = scratch->next_successor[block]++;
+        size_t successor = basic_block->successors[i];
+        if(scratch->color[successor] == 1) {
+            scratch->back_edge[2 * block + i] = true;
+        }
+        else if(scratch->color[successor] == 0) {
+            scratch->color[successor] = 1;
+            scratch->next_successor[successor] = 0;
+            scratch->stack[stack_size++] = successor;
+        }
+    }
+    memmove(scratch->order, postorder, num_done * sizeof(size_t));
+    scratch->num_blocks = num_done;
+}
+
+/**
+ * @brief Best and worst cost of the paths starting at `source` that do not follow back edges
+ *
+ * Only the blocks in `scratch->in_region` are considered; the costs of the paths ending at each block are left in
+ * `scratch->best` and `scratch->worst` (-1 if the block cannot be reached)
+ */
+static void compute_path_costs(const program_cfg_t *cfg, size_t source, subroutine_scratch_t *scratch) {
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        size_t block = scratch->order[i];
+        scratch->best[block] = (path_cost_t) { -1, -1 };
+        scratch->worst[block] = (path_cost_t) { -1, -1 };
+    }
+    scratch->best[source] = scratch->worst[source] = (path_cost_t) { cfg->blocks[source].num_instructions, cfg->blocks[source].cycles };
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        size_t block = scratch->order[i];
+        if(scratch->best[block].instructions == -1) {
+            continue;
+        }
+        const basic_block_t *basic_block = &cfg->blocks[block];
+        for(int j = 0; j < basic_block->num_successors; j++) {
+            size_t successor = basic_block->successors[j];
+            if(scratch->back_edge[2 * block + j] || !scratch->in_region[successor]) {
+                continue;
+            }
+            path_cost_t *best = &scratch->best[successor];
+            path_cost_t *worst = &scratch->worst[successor];
+            long instructions = cfg->blocks[successor].num_instructions;
+            long cycles = cfg->blocks[successor].cycles;
+            if(best->instructions == -1 || scratch->best[block].instructions + instructions < best->instructions) {
+                best->instructions = scratch->best[block].instructions + instructions;
+            }
+            if(best->cycles == -1 || scratch->best[block].cycles + cycles < best->cycles) {
+                best->cycles = scratch->best[block].cycles + cycles;
+            }
+            if(scratch->worst[block].instructions + instructions > worst->instructions) {
+                worst->instructions = scratch->worst[block].instructions + instructions;
+            }
+            if(scratch->worst[block].cycles + cycles > worst->cycles) {
+                worst->cycles = scratch->worst[block].cycles + cycles;
+            }
+        }
+    }
+}
+
+static void merge_path_cost(path_cost_t *best, path_cost_t *worst, const path_cost_t *path_best, const path_cost_t *path_worst) {
+    if(path_best->instructions == -1) {
+        return;
+    }
+    if(best->instructions == -1 || path_best->instructions < best->instructions) {
+        best->instructions = path_best->instructions;
+    }
+    if(best->cycles == -1 || path_best->cycles < best->cycles) {
+        best->cycles = path_best->cycles;
+    }
+    if(path_worst->instructions > worst->instructions) {
+        worst->instructions = path_worst->instructions;
+    }
+    if(path_worst->cycles > worst->cycles) {
+        worst->cycles = path_worst->cycles;
+    }
+}
+
+static void print_path_cost(FILE *report, const char *name, const path_cost_t *cost) {
+    if(cost->instructions == -1) {
+        fprintf(report, "\"%s\": null", name);
+    }
+    else {
+        fprintf(report, "\"%s\": {\"instructions\": %ld, \"cycles\": %ld}", name, cost->instructions, cost->cycles);
+    }
+}
+
+static void print_block_name(FILE *report, const program_cfg_t *cfg, size_t block) {
+    size_t slot = cfg->blocks[block].first_slot;
+    if(cfg->label_of_slot[slot]) {
+        print_json_string(report, cfg->label_of_slot[slot]);
+    }
+    else {
+        fprintf(report, "\"x%.4X\"", slot_address(slot, cfg->origin));
+    }
+}
+
+/**
+ * @brief Find the natural loops of the subroutine visited last, merging the loops sharing the same header
+ */
+static exit_t find_loops(const program_cfg_t *cfg, subroutine_scratch_t *scratch, loop_t **loops, size_t *num_loops) {
+    *loops = NULL;
+    *num_loops = 0;
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        size_t header = scratch->order[i];
+        //tails of the back edges to this header
+        size_t stack_size = 0;
+        for(size_t j = 0; j < scratch->num_blocks; j++) {
+            size_t block = scratch->order[j];
+            for(int k = 0; k < cfg->blocks[block].num_successors; k++) {
+                if(scratch->back_edge[2 * block + k] && cfg->blocks[block].successors[k] == header) {
+                    scratch->stack[stack_size++] = block;
+                }
+            }
+        }
+        if(stack_size == 0) {
+            continue;
+        }
+        loop_t *resized_loops = realloc(*loops, (*num_loops + 1) * sizeof(loop_t));
+        if(!resized_loops) {
+            return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+        }
+        *loops = resized_loops;
+        loop_t *loop = &(*loops)[(*num_loops)++];
+        *loop = (loop_t) { .header = header, .body = malloc(scratch->num_blocks * sizeof(size_t)), .body_size = 0, .depth = 0 };
+        if(!loop->body) {
+            return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+        }
+
+        //blocks reaching the tails without going through the header
+        for(size_t j = 0; j < scratch->num_blocks; j++) {
+            scratch->in_region[scratch->order[j]] = false;
+        }
+        scratch->in_region[header] = true;
+        loop->body[loop->body_size++] = header;
+        for(size_t j = 0; j < stack_size; j++) {
+            if(!scratch->in_region[scratch->stack[j]]) {
+                scratch->in_region[scratch->stack[j]] = true;
+                loop->body[loop->body_size++] = scratch->stack[j];
+            }
+        }
+        for(bool changed = true; changed;) {
+            changed = false;
+            for(size_t j = 0; j < scratch->num_blocks; j++) {
+                size_t block = scratch->order[j];
+                if(scratch->in_region[block]) {
+                    continue;
+                }
+                for(int k = 0; k < cfg->blocks[block].num_successors; k++) {
+                    size_t successor = cfg->blocks[block].successors[k];
+                    if(scratch->in_region[successor] && successor != header) {
+                        scratch->in_region[block] = true;
+                        loop->body[loop->body_size++] = block;
+                        changed = true;
+                        break;
+                    }
+                    //a block jumping straight to the header is part of the loop only if it is a tail
+                }
+            }
+        }
+    }
+
+    //nesting depth: number of loops containing the header of the loop
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        scratch->loop_depth[scratch->order[i]] = 0;
+    }
+    for(size_t i = 0; i < *num_loops; i++) {
+        for(size_t j = 0; j < (*loops)[i].body_size; j++) {
+            scratch->loop_depth[(*loops)[i].body[j]]++;
+        }
+    }
+    for(size_t i = 0; i < *num_loops; i++) {
+        (*loops)[i].depth = scratch->loop_depth[(*loops)[i].header];
+    }
+    return success();
+}
+
+static void free_loops(loop_t *loops, size_t num_loops) {
+    for(size_t i = 0; i < num_loops; i++) {
+        free(loops[i].body);
+    }
+    free(loops);
+}
+
+/**
+ * @brief Cost of one iteration of a loop: paths from the header to the tails of its back edges
+ */
+static void loop_iteration_cost(const program_cfg_t *cfg, const loop_t *loop, subroutine_scratch_t *scratch, path_cost_t *best, path_cost_t *worst) {
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        scratch->in_region[scratch->order[i]] = false;
+    }
+    for(size_t i = 0; i < loop->body_size; i++) {
+        scratch->in_region[loop->body[i]] = true;
+    }
+    compute_path_costs(cfg, loop->header, scratch);
+    *best = *worst = (path_cost_t) { -1, -1 };
+    for(size_t i = 0; i < loop->body_size; i++) {
+        size_t block = loop->body[i];
+        for(int k = 0; k < cfg->blocks[block].num_successors; k++) {
+            if(scratch->back_edge[2 * block + k] && cfg->blocks[block].successors[k] == loop->header) {
+                merge_path_cost(best, worst, &scratch->best[block], &scratch->worst[block]);
+            }
+        }
+    }
+}
+
+static exit_t report_subroutine(const program_cfg_t *cfg, size_t entry, subroutine_scratch_t *scratch, entry_queue_t *queue, FILE *report) {
+    visit_subroutine(cfg, entry, scratch);
+    loop_t *loops;
+    size_t num_loops;
+    exit_t result = find_loops(cfg, scratch, &loops, &num_loops);
+    if(result.code) {
+        free_loops(loops, num_loops);
+        return result;
+    }
+
+    const basic_block_t *entry_block = &cfg->blocks[entry];
+    fprintf(report, "%s\n    {\n      \"name\": ", entry == queue->entries[0] ? "" : ",");
+    print_block_name(report, cfg, entry);
+    fprintf(report, ",\n      \"address\": \"x%.4X\",\n      \"line\": %d,\n", slot_address(entry_block->first_slot, cfg->origin),
+        cfg->tokenized_lines[entry_block->first_slot]->line_number);
+
+    //whole subroutine
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        scratch->in_region[scratch->order[i]] = true;
+    }
+    compute_path_costs(cfg, entry, scratch);
+    path_cost_t best = { -1, -1 }, worst = { -1, -1 };
+    long num_instructions = 0;
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        size_t block = scratch->order[i];
+        num_instructions += cfg->blocks[block].num_instructions;
+        if(cfg->blocks[block].exit) {
+            merge_path_cost(&best, &worst, &scratch->best[block], &scratch->worst[block]);
+        }
+    }
+    fprintf(report, "      \"instructions\": %ld,\n      \"loop_free\": %s,\n      ", num_instructions, num_loops == 0 ? "true" : "false");
+    print_path_cost(report, "best", &best);
+    fprintf(report, ",\n      ");
+    print_path_cost(report, "worst", &worst);
+
+    fprintf(report, ",\n      \"calls\": [");
+    bool first_call = true;
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        const basic_block_t *basic_block = &cfg->blocks[scratch->order[i]];
+        if(basic_block->callee != SIZE_MAX) {
+            fprintf(report, "%s", first_call ? "" : ", ");
+            print_block_name(report, cfg, basic_block->callee);
+            first_call = false;
+            enqueue_entry(queue, basic_block->callee);
+        }
+    }
+
+    fprintf(report, "],\n      \"loops\": [");
+    for(size_t i = 0; i < num_loops; i++) {
+        path_cost_t iteration_best, iteration_worst;
+        loop_iteration_cost(cfg, &loops[i], scratch, &iteration_best, &iteration_worst);
+        size_t header_slot = cfg->blocks[loops[i].header].first_slot;
+        fprintf(report, "%s\n        {\"header\": \"x%.4X\", \"line\": %d, \"depth\": %d, \"blocks\": %zu, \"iteration\": {", i == 0 ? "" : ",",
+            slot_address(header_slot, cfg->origin), cfg->tokenized_lines[header_slot]->line_number, loops[i].depth, loops[i].body_size);
+        print_path_cost(report, "best", &iteration_best);
+        fprintf(report, ", ");
+        print_path_cost(report, "worst", &iteration_worst);
+        fprintf(report, "}}");
+    }
+    fprintf(report, "%s],\n      \"blocks\": [", num_loops == 0 ? "" : "\n      ");
+
+    //blocks in address order
+    for(size_t i = 0, num_printed = 0; i < cfg->num_blocks && num_printed < scratch->num_blocks; i++) {
+        if(scratch->color[i] != 2) {
+            continue;
+        }
+        const basic_block_t *basic_block = &cfg->blocks[i];
+        fprintf(report, "%s\n        {\"address\": \"x%.4X\", \"line\": %d, \"instructions\": %d, \"cycles\": %ld, \"loop_depth\": %d, \"successors\": [",
+            num_printed == 0 ? "" : ",", slot_address(basic_block->first_slot, cfg->origin), cfg->tokenized_lines[basic_block->first_slot]->line_number,
+            basic_block->num_instructions, basic_block->cycles, scratch->loop_depth[i]);
+        for(int k = 0; k < basic_block->num_successors; k++) {
+            fprintf(report, "%s\"x%.4X\"", k == 0 ? "" : ", ", slot_address(cfg->blocks[basic_block->successors[k]].first_slot, cfg->origin));
+        }
+        fprintf(report, "]");
+        if(basic_block->exit) {
+            fprintf(report, ", \"exit\": \"%s\"", basic_block->exit);
+        }
+        fprintf(report, "}");
+        num_printed++;
+    }
+    fprintf(report, "\n      ]\n    }");
+
+    //reset the scratch arrays for the next subroutine
+    for(size_t i = 0; i < scratch->num_blocks; i++) {
+        size_t block = scratch->order[i];
+        scratch->color[block] = 0;
+        scratch->back_edge[2 * block] = scratch->back_edge[2 * block + 1] = false;
+        scratch->in_region[block] = false;
+    }
+    free_loops(loops, num_loops);
+    return success();
+}
+
+static void free_cfg(program_cfg_t *cfg, subroutine_scratch_t *scratch) {
+    free(cfg->blocks);
+    free(cfg->block_of_slot);
+    free(cfg->slot_of_address);
+    free(cfg->label_of_slot);
+    free(scratch->color);
+    free(scratch->back_edge);
+    free(scratch->order);
+    free(scratch->stack);
+    free(scratch->next_successor);
+    free(scratch->best);
+    free(scratch->worst);
+    free(scratch->in_region);
+    free(scratch->loop_depth);
+}
+
+/**
+ * @brief Report in JSON format the basic blocks, loops and best/worst-case cost of each subroutine of the program
+ *
+ * Must be run after the syntax analysis
+ *
+ * @param tokenized_lines
+ * @param assembly_file_name
+ * @param options cost model and stream of the report (`analysis_json`)
+ * @return exit_t
+ */
+exit_t analyze_program(linemetadata_t *tokenized_lines[], const char *assembly_file_name, const options_t *options) {
+    exit_t result;
+    if((result = compute_segments(tokenized_lines)).code) {
+        return result;
+    }
+    size_t num_slots = count_slots(tokenized_lines);
+    program_cfg_t cfg = {
+        .tokenized_lines = tokenized_lines,
+        .num_slots = num_slots,
+        .origin = tokenized_lines[0]->machine_instruction,
+        .memory_access_cycles = options->memory_access_cycles,
+        .blocks = malloc(num_slots * sizeof(basic_block_t)),
+        .block_of_slot = malloc((num_slots + 1) * sizeof(size_t)),
+        .slot_of_address = malloc(ADDRESS_SPACE_CARDINALITY * sizeof(long)),
+        .label_of_slot = calloc(num_slots + 1, sizeof(char *))
+    };
+    subroutine_scratch_t scratch = {
+        .color = calloc(num_slots, sizeof(int)),
+        .back_edge = calloc(2 * num_slots, sizeof(bool)),
+        .order = malloc(num_slots * sizeof(size_t)),
+        .stack = malloc(num_slots * sizeof(size_t)),
+        .next_successor = malloc(num_slots * sizeof(int)),
+        .best = malloc(num_slots * sizeof(path_cost_t)),
+        .worst = malloc(num_slots * sizeof(path_cost_t)),
+        .in_region = calloc(num_slots, sizeof(bool)),
+        .loop_depth = calloc(num_slots, sizeof(int))
+    };
+    entry_queue_t queue = { .entries = malloc(num_slots * sizeof(size_t)), .num_entries = 0, .is_entry = calloc(num_slots, sizeof(bool)) };
+    if(!cfg.blocks || !cfg.block_of_slot || !cfg.slot_of_address || !cfg.label_of_slot || !scratch.color || !scratch.back_edge || !scratch.order
+        || !scratch.stack || !scratch.next_successor || !scratch.best || !scratch.worst || !scratch.in_region || !scratch.loop_depth || !queue.entries || !queue.is_entry) {
+        free_cfg(&cfg, &scratch);
+        free(queue.entries);
+        free(queue.is_entry);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+    for(long address = 0; address < ADDRESS_SPACE_CARDINALITY; address++) {
+        cfg.slot_of_address[address] = -1;
+    }
+    for(size_t slot = 0; slot <= num_slots; slot++) {
+        cfg.block_of_slot[slot] = SIZE_MAX;
+    }
+    for(size_t slot = 0; slot < num_slots; slot++) {
+        if(!tokenized_lines[slot]->tokens || compute_line_type(tokenized_lines[slot]->tokens[0]) != ORIG_DIRECTIVE) {
+            cfg.slot_of_address[slot_address(slot, cfg.origin)] = slot;
+        }
+    }
+    for(node_t *node = next(true); node; node = next(false)) {
+        if(node->val < num_slots && !cfg.label_of_slot[node->val]) {
+            cfg.label_of_slot[node->val] = node->key;
+        }
+    }
+    if((result = build_blocks(&cfg)).code) {
+        free_cfg(&cfg, &scratch);
+        free(queue.entries);
+        free(queue.is_entry);
+        return result;
+    }
+
+    //entry points: start of each segment, then the subroutines called from the ones already found
+    for(size_t i = 0; i < get_num_segments(); i++) {
+        size_t first_word = get_segment(i)->orig_slot + 1;
+        if(first_word < num_slots && cfg.block_of_slot[first_word] != SIZE_MAX) {
+            enqueue_entry(&queue, cfg.block_of_slot[first_word]);
+        }
+    }
+
+    FILE *report = options->analysis_json;
+    fprintf(report, "{\n  \"file\": ");
+    print_json_string(report, assembly_file_name);
+    fprintf(report, ",\n  \"cost_model\": {\"cycles_per_instruction\": 1, \"cycles_per_memory_access\": %d},\n  \"subroutines\": [", cfg.memory_access_cycles);
+    for(size_t i = 0; i < queue.num_entries && !result.code; i++) {
+        result = report_subroutine(&cfg, queue.entries[i], &scratch, &queue, report);
+    }
+    fprintf(report, "\n  ]\n}\n");
+
+    free_cfg(&cfg, &scratch);
+    free(queue.entries);
+    free(queue.is_entry);
+    return result;
+}
@@ -0,0 +1,478 @@
+/**
+ * @file aot.c
+ * @brief Ahead-of-time translation of object images to C (lc3aot)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The images are loaded into a vm_t, so that instructions are translated from the form the interpreter decodes
+ * them to (vm_decoded_instruction), with PC-relative addresses already computed. Only the words loaded from the
+ * images are translated: the traversal stops at the end of a segment, as memory around it would decode to
+ * NOPs up to the end of the address space.
+ *
+ * A block ends at any instruction that changes the flow (BR but BR with no condition codes, JSR, JSRR, JMP,
+ * RTI, TRAP, and the reserved opcode) and before every leader, so each translated word belongs to a single
+ * block. The generated C counts instructions per block, and relies on the C compiler to remove the jumps to
+ * the block that follows and the checks of constant addresses.
+ */
+
+#include "../include/lc3.h"
+#include "../include/aot.h"
+#include "../include/disassembler.h"
+
+#define OBJ_EXTENSION ".obj"
+#define HALT_VECTOR 0x25
+#define NUM_TRAP_VECTORS 0x100
+#define IMAGE_BYTES_PER_LINE 16
+
+typedef struct {
+    vm_t vm; /**< images loaded and decoded by the machine */
+    bool loaded[VM_ADDRESS_SPACE];
+    bool reached[VM_ADDRESS_SPACE]; /**< translated */
+    bool leader[VM_ADDRESS_SPACE]; /**< first word of a block, if reached */
+    bool data[VM_ADDRESS_SPACE]; /**< operand of LD, ST, LDI or STI, not a root even if it has a label */
+    bool jumped_to[VM_ADDRESS_SPACE]; /**< block whose C label is the target of a goto */
+    uint16_t pending[VM_ADDRESS_SPACE];
+    size_t num_pending;
+    const char *symbols[VM_ADDRESS_SPACE];
+    uint16_t block_starts[VM_ADDRESS_SPACE];
+    uint16_t block_ends[VM_ADDRESS_SPACE];
+    size_t num_blocks;
+} translation_t;
+
+static uint16_t image_word(const unsigned char *bytes, size_t index) {
+    return bytes[2 * index] << 8 | bytes[2 * index + 1];
+}
+
+/**
+ * @brief Mark the words the image loads (vm_load_image has already checked its format)
+ */
+static void mark_loaded(translation_t *t, const unsigned char *bytes, size_t size) {
+    size_t num_words = size / 2;
+    if(num_words < 3 || image_word(bytes, 0) != SEGMENTED_OBJ_MAGIC1 || image_word(bytes, 1) != SEGMENTED_OBJ_MAGIC2) {
+        for(size_t i = 1; i < num_words; i++) {
+            t->loaded[image_word(bytes, 0) + i - 1] = true;
+        }
+        return;
+    }
+    size_t num_segments = image_word(bytes, 2);
+    for(size_t segment = 0; segment < num_segments; segment++) {
+        uint16_t origin = image_word(bytes, 3 + 2 * segment);
+        for(size_t i = 0; i < image_word(bytes, 4 + 2 * segment); i++) {
+            t->loaded[origin + i] = true;
+        }
+    }
+}
+
+/**
+ * @brief Labels of the object, from the .sym file next to it (none if there is no such file)
+ *
+ * @return char* storage of the names, to be released by the caller
+ */
+static char *load_object_symbols(translation_t *t, const char *file_name) {
+    static const char *symbols[VM_ADDRESS_SPACE];
+    size_t length = strlen(file_name);
+    char symbol_file_name[length + strlen(".sym") + 1];
+    strcpy(symbol_file_name, file_name);
+    if(length >= strlen(OBJ_EXTENSION) && strcmp(symbol_file_name + length - strlen(OBJ_EXTENSION), OBJ_EXTENSION) == 0) {
+        length -= strlen(OBJ_EXTENSION);
+    }
+    strcpy(symbol_file_name + length, ".sym");
+    char *names = load_symbol_table(symbol_file_name, symbols);
+    for(int address = 0; names && address < VM_ADDRESS_SPACE; address++) {
+        if(symbols[address]) {
+            t->symbols[address] = symbols[address];
+        }
+    }
+    return names;
+}
+
+/**
+ * @brief Read an object file, load it into the machine and mark the words it loads
+ */
+static exit_t load_object(translation_t *t, const char *file_name, unsigned char *bytes, size_t *size,
+                          uint16_t *origin) {
+    FILE *object_file = fopen(file_name, "rb");
+    if(!object_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", file_name);
+    }
+    *size = fread(bytes, 1, 2 * (VM_ADDRESS_SPACE + 3 + 2 * MAX_NUM_SEGMENTS) + 1, object_file);
+    bool read_error = ferror(object_file);
+    fclose(object_file);
+    if(read_error || *size > 2 * (VM_ADDRESS_SPACE + 3 + 2 * MAX_NUM_SEGMENTS)) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read object (%s)", file_name);
+    }
+    exit_t result = vm_load_image(&t->vm, bytes, *size, origin);
+    if(result.code) {
+        return result;
+    }
+    mark_loaded(t, bytes, *size);
+    return success();
+}
+
+static void add_leader(translation_t *t, uint16_t address) {
+    if(!t->leader[address]) {
+        t->leader[address] = true;
+        t->pending[t->num_pending++] = address;
+    }
+}
+
+/**
+ * @brief Whether the instruction is the last of its block
+ */
+static bool ends_block(const vm_decoded_t *decoded) {
+    switch(decoded->handler) {
+    case VM_DO_BR:
+    case VM_DO_BR_ALWAYS:
+    case VM_DO_JSR:
+    case VM_DO_JSRR:
+    case VM_DO_JMP:
+    case VM_DO_JMPT:
+    case VM_DO_RTI:
+    case VM_DO_RESERVED:
+    case VM_DO_TRAP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Reach the code that runs from the pending leaders, adding the leaders it branches to
+ */
+static void traverse(translation_t *t) {
+    while(t->num_pending) {
+        uint32_t address = t->pending[--t->num_pending];
+        for(; address < VM_ADDRESS_SPACE && t->loaded[address] && !t->reached[address]; address++) {
+            t->reached[address] = true;
+            const vm_decoded_t *decoded = vm_decoded_instruction(&t->vm, address);
+            uint16_t next = address + 1;
+            switch(decoded->handler) {
+            case VM_DO_BR:
+                add_leader(t, decoded->operand);
+                add_leader(t, next);
+                break;
+            case VM_DO_BR_ALWAYS:
+                add_leader(t, decoded->operand);
+                break;
+            case VM_DO_JSR:
+                add_leader(t, decoded->operand);
+                add_leader(t, next);
+                break;
+            case VM_DO_JSRR:
+                add_leader(t, next);
+                break;
+            case VM_DO_TRAP:
+                if(decoded->operand != HALT_VECTOR) {
+                    add_leader(t, next);
+                }
+                break;
+            case VM_DO_LD:
+            case VM_DO_ST:
+            case VM_DO_LDI:
+            case VM_DO_STI:
+                t->data[decoded->operand] = true;
+                break;
+            default:
+                break;
+            }
+            if(ends_block(decoded)) {
+                break;
+            }
+        }
+    }
+}
+
+static void find_blocks(translation_t *t) {
+    bool open = false;
+    for(uint32_t address = 0; address < VM_ADDRESS_SPACE; address++) {
+        if(!t->reached[address]) {
+            open = false;
+            continue;
+        }
+        if(!open || t->leader[address]) {
+            t->block_starts[t->num_blocks++] = address;
+        }
+        t->block_ends[t->num_blocks - 1] = address;
+        open = !ends_block(vm_decoded_instruction(&t->vm, address));
+    }
+}
+
+static void add_jump(translation_t *t, uint16_t target) {
+    if(t->reached[target] && t->leader[target]) {
+        t->jumped_to[target] = true;
+    }
+}
+
+/**
+ * @brief Mark the blocks that the translated code jumps to directly (write_goto)
+ */
+static void find_jumps(translation_t *t) {
+    for(size_t block = 0; block < t->num_blocks; block++) {
+        const vm_decoded_t *last = vm_decoded_instruction(&t->vm, t->block_ends[block]);
+        switch(last->handler) {
+        case VM_DO_BR:
+            add_jump(t, last->operand);
+            add_jump(t, t->block_ends[block] + 1);
+            break;
+        case VM_DO_BR_ALWAYS:
+        case VM_DO_JSR:
+            add_jump(t, last->operand);
+            break;
+        default:
+            if(!ends_block(last)) {
+                add_jump(t, t->block_ends[block] + 1);
+            }
+            break;
+        }
+    }
+}
+
+static void write_image(FILE *output, const char *name, const unsigned char *bytes, size_t size) {
+    fprintf(output, "static const unsigned char %s[] = {", name);
+    for(size_t i = 0; i < size; i++) {
+        fprintf(output, "%s0x%02X,", i % IMAGE_BYTES_PER_LINE ? " " : "\n    ", bytes[i]);
+    }
+    fprintf(output, "\n};\n");
+}
+
+/**
+ * @brief Jump to the block at `target`, or to the interpreter if it was not translated
+ */
+static void write_goto(const translation_t *t, FILE *output, uint16_t target, int indent) {
+    if(t->jumped_to[target]) {
+        fprintf(output, "%*sgoto L%04X;\n", indent, "", target);
+    }
+    else {
+        fprintf(output, "%*spc = 0x%04X;\n%*sgoto interpret;\n", indent, "", target, indent, "");
+    }
+}
+
+static void write_instruction(translation_t *t, FILE *output, uint16_t address, size_t skipped) {
+    const vm_decoded_t *d = vm_decoded_instruction(&t->vm, address);
+    uint16_t next = address + 1;
+    char text[MAX_DISASSEMBLED_LINE];
+    text[disassemble_instruction(t->vm.memory[address], address, t->symbols, text)] = '\0';
+    fprintf(output, "        // x%04X %s\n", address, text);
+    switch(d->handler) {
+    case VM_DO_BR: {
+        static const char *const conditions[8] = {
+            "0", "result > 0", "result == 0", "result >= 0", "result < 0", "result != 0", "result <= 0", "1"
+        };
+        fprintf(output, "        if(%s) {\n", conditions[d->dr]);
+        write_goto(t, output, d->operand, 12);
+        fprintf(output, "        }\n");
+        write_goto(t, output, next, 8);
+        break;
+    }
+    case VM_DO_BR_ALWAYS:
+        write_goto(t, output, d->operand, 8);
+        break;
+    case VM_DO_BR_NEVER:
+        break;
+    case VM_DO_ADD_REGISTER:
+        fprintf(output, "        result = R%d = R%d + R%d;\n", d->dr, d->sr1, d->sr2);
+        break;
+    case VM_DO_ADD_IMMEDIATE:
+        fprintf(output, "        result = R%d = R%d + 0x%04X;\n", d->dr, d->sr1, d->operand);
+        break;
+    case VM_DO_AND_REGISTER:
+        fprintf(output, "        result = R%d = R%d & R%d;\n", d->dr, d->sr1, d->sr2);
+        break;
+    case VM_DO_AND_IMMEDIATE:
+        fprintf(output, "        result = R%d = R%d & 0x%04X;\n", d->dr, d->sr1, d->operand);
+        break;
+    case VM_DO_NOT:
+        fprintf(output, "        result = R%d = ~R%d;\n", d->dr, d->sr1);
+        break;
+    case VM_DO_LEA:
+        fprintf(output, "        result = R%d = 0x%04X;\n", d->dr, d->operand);
+        break;
+    case VM_DO_LD:
+        fprintf(output, "        LOAD(R%d, 0x%04X, %zu, 0x%04X);\n", d->dr, d->operand, skipped, address);
+        fprintf(output, "        result = R%d;\n", d->dr);
+        break;
+    case VM_DO_LDR:
+        fprintf(output, "        LOAD(R%d, R%d + 0x%04X, %zu, 0x%04X);\n", d->dr, d->sr1, d->operand, skipped, address);
+        fprintf(output, "        result = R%d;\n", d->dr);
+        break;
+    case VM_DO_LDI:
+        fprintf(output, "        LOAD(pointer, 0x%04X, %zu, 0x%04X);\n", d->operand, skipped, address);
+        fprintf(output, "        LOAD(R%d, pointer, %zu, 0x%04X);\n", d->dr, skipped, address);
+        fprintf(output, "        result = R%d;\n", d->dr);
+        break;
+    case VM_DO_ST:
+        fprintf(output, "        STORE(0x%04X, R%d, %zu, 0x%04X);\n", d->operand, d->dr, skipped, address);
+        break;
+    case VM_DO_STR:
+        fprintf(output, "        STORE(R%d + 0x%04X, R%d, %zu, 0x%04X);\n", d->sr1, d->operand, d->dr, skipped, address);
+        break;
+    case VM_DO_STI:
+        fprintf(output, "        LOAD(pointer, 0x%04X, %zu, 0x%04X);\n", d->operand, skipped, address);
+        fprintf(output, "        STORE(pointer, R%d, %zu, 0x%04X);\n", d->dr, skipped, address);
+        break;
+    case VM_DO_JSR:
+        fprintf(output, "        R7 = 0x%04X;\n", next);
+        write_goto(t, output, d->operand, 8);
+        break;
+    case VM_DO_JSRR:
+        fprintf(output, "        pc = R%d;\n        R7 = 0x%04X;\n        goto dispatch;\n", d->sr1, next);
+        break;
+    case VM_DO_JMP:
+        fprintf(output, "        pc = R%d;\n        goto dispatch;\n", d->sr1);
+        break;
+    default: //TRAP, RTI, JMPT and the reserved opcode
+        fprintf(output, "        EXIT(%zu, 0x%04X);\n", skipped, address);
+        break;
+    }
+}
+
+static void write_block(translation_t *t, FILE *output, size_t block) {
+    uint16_t start = t->block_starts[block], end = t->block_ends[block];
+    size_t num_instructions = end - start + 1;
+    fprintf(output, "    case 0x%04X:", start);
+    if(t->jumped_to[start]) {
+        fprintf(output, " L%04X:", start);
+    }
+    fprintf(output, "%s%s\n", t->symbols[start] ? " // " : "", t->symbols[start] ? t->symbols[start] : "");
+    fprintf(output, "        if(stale[%zu] || remaining < %zu) {\n", block, num_instructions);
+    fprintf(output, "            pc = 0x%04X;\n            goto interpret;\n        }\n", start);
+    fprintf(output, "        remaining -= %zu;\n", num_instructions);
+    for(uint32_t address = start; address <= end; address++) {
+        write_instruction(t, output, address, end - address + 1);
+    }
+    if(!ends_block(vm_decoded_instruction(&t->vm, end))) {
+        write_goto(t, output, end + 1, 8);
+    }
+}
+
+static void write_run(translation_t *t, FILE *output) {
+    bool pointer = false;
+    for(size_t block = 0; block < t->num_blocks; block++) {
+        for(uint32_t address = t->block_starts[block]; address <= t->block_ends[block]; address++) {
+            uint8_t handler = vm_decoded_instruction(&t->vm, address)->handler;
+            pointer = pointer || handler == VM_DO_LDI || handler == VM_DO_STI;
+        }
+    }
+    fprintf(output, "\nstatic vm_status_t run(vm_t *vm, uint64_t max_instructions) {\n"
+                    "    uint16_t *memory = vm->memory;\n"
+                    "    uint16_t R0, R1, R2, R3, R4, R5, R6, R7, pc, access%s;\n"
+                    "    int16_t result;\n"
+                    "    uint64_t remaining = max_instructions, interpreted = 0, before;\n"
+                    "    vm_status_t status;\n\n"
+                    "    LOAD_STATE();\n"
+                    "dispatch:\n"
+                    "    switch(pc) {\n", pointer ? ", pointer" : "");
+    for(size_t block = 0; block < t->num_blocks; block++) {
+        write_block(t, output, block);
+    }
+    fprintf(output, "    default:\n"
+                    "        goto interpret;\n"
+                    "    }\n\n"
+                    "interpret:\n"
+                    "    SAVE_STATE();\n"
+                    "    if(!remaining) {\n"
+                    "        status = VM_LIMIT_REACHED;\n"
+                    "        goto stop;\n"
+                    "    }\n"
+                    "    before = vm->instructions;\n"
+                    "    status = vm_run(vm, 1);\n"
+                    "    remaining -= vm->instructions - before;\n"
+                    "    interpreted += vm->instructions - before;\n"
+                    "    if(status != VM_LIMIT_REACHED) {\n"
+                    "        goto stop;\n"
+                    "    }\n"
+                    "    if(vm->code_writes != code_writes) {\n"
+                    "        check_code(vm);\n"
+                    "    }\n"
+                    "    LOAD_STATE();\n"
+                    "    goto dispatch;\n"
+                    "stop:\n"
+                    "    vm->instructions += max_instructions - remaining - interpreted;\n"
+                    "    interpreted_instructions += interpreted;\n"
+                    "    return status;\n"
+                    "}\n");
+}
+
+/**
+ * @brief Translate an object file, and optionally the operating system it runs on, to a C program (see aot.h)
+ *
+ * @param os_file_name NULL to run the program without an operating system
+ * @param output C source of the program
+ * @param stats blocks and instructions translated
+ * @return exit_t
+ */
+exit_t aot_translate(const char *object_file_name, const char *os_file_name, FILE *output, aot_stats_t *stats) {
+    static translation_t translation;
+    static unsigned char program_bytes[2 * (VM_ADDRESS_SPACE + 3 + 2 * MAX_NUM_SEGMENTS) + 1];
+    static unsigned char os_bytes[sizeof(program_bytes)];
+    translation_t *t = &translation;
+    memset(t, 0, sizeof(*t));
+    vm_init(&t->vm);
+    size_t program_size, os_size = 0;
+    uint16_t origin, os_origin;
+    exit_t result;
+    if(os_file_name && (result = load_object(t, os_file_name, os_bytes, &os_size, &os_origin)).code) {
+        return result;
+    }
+    if((result = load_object(t, object_file_name, program_bytes, &program_size, &origin)).code) {
+        return result;
+    }
+
+    add_leader(t, os_file_name ? VM_OS_START : origin);
+    for(int vector = 0; os_file_name && vector < NUM_TRAP_VECTORS; vector++) {
+        if(t->loaded[vector] && t->vm.memory[vector]) {
+            add_leader(t, t->vm.memory[vector]);
+        }
+    }
+    traverse(t);
+    char *os_names = os_file_name ? load_object_symbols(t, os_file_name) : NULL;
+    char *names = load_object_symbols(t, object_file_name);
+    for(int address = 0; address < VM_ADDRESS_SPACE; address++) {
+        if(t->symbols[address] && t->loaded[address] && !t->data[address]) {
+            add_leader(t, address);
+        }
+    }
+    traverse(t);
+    find_blocks(t);
+    find_jumps(t);
+    if(!t->num_blocks) {
+        free(os_names);
+        free(names);
+        return failure(EXIT_FAILURE, "ERROR: No instructions to translate in %s", object_file_name);
+    }
+
+    build_decode_table();
+    fprintf(output, "// Generated by lc3aot from %s%s%s, see include/aot.h\n", object_file_name,
+            os_file_name ? " and " : "", os_file_name ? os_file_name : "");
+    fprintf(output, "// cc -O2 -Iinclude program.c src/vm.c src/util.c src/memtrack.c -o program\n\n");
+    fprintf(output, "#define NUM_BLOCKS %zu\n\n", t->num_blocks);
+    fprintf(output, "#include <stdint.h>\n\nstatic const uint16_t blocks[NUM_BLOCKS][2] = {");
+    for(size_t block = 0; block < t->num_blocks; block++) {
+        fprintf(output, "%s{ 0x%04X, 0x%04X },", block % 4 ? " " : "\n    ", t->block_starts[block], t->block_ends[block]);
+    }
+    fprintf(output, "\n};\n\n#include \"aot_runtime.h\"\n\n");
+    write_image(output, "program_image", program_bytes, program_size);
+    if(os_file_name) {
+        write_image(output, "os_image", os_bytes, os_size);
+    }
+    fprintf(output, "\n//the images were checked by lc3aot\nstatic void load_images(vm_t *vm) {\n"
+                    "    uint16_t origin;\n");
+    if(os_file_name) {
+        fprintf(output, "    vm_load_image(vm, os_image, sizeof(os_image), &origin);\n");
+    }
+    fprintf(output, "    vm_load_image(vm, program_image, sizeof(program_image), &origin);\n"
+                    "    vm->pc = 0x%04X;\n}\n", os_file_name ? VM_OS_START : origin);
+    write_run(t, output);
+
+    stats->blocks = t->num_blocks;
+    stats->instructions = 0;
+    for(size_t block = 0; block < t->num_blocks; block++) {
+        stats->instructions += t->block_ends[block] - t->block_starts[block] + 1;
+    }
+    free(os_names);
+    free(names);
+    return success();
+}
@@ -0,0 +1,471 @@
+/**
+ * @file archive.c
+ * @brief static library archives of assembled modules with a prebuilt symbol index
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * A module is the pair of files (.obj and .sym) generated by the assembler for the same .asm file.
+ * All the symbols listed in the .sym file of a module are indexed, as the assembler does not tell exported labels
+ * from local ones. Local labels such as LOOP or DONE are common to many modules, so when several members define
+ * the same name the index keeps the first one, in the order the modules were packed.
+ *
+ * archive_open validates every offset, size and index of the tables against the size of the file before any of
+ * them is used, as lookups read the mapped file in place.
+ *
+ * The symbol index is an open-addressing hash table that is written to disk already built, so that
+ * looking up a symbol after mapping the archive into memory (`archive_open`) does not require any parsing:
+ * hash the name, probe the buckets and compare the candidate names stored in the string table.
+ * Only the members defining the symbols being looked up are ever touched.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/archive.h"
+
+#define BYTE_ORDER_MARK 0x01020304
+
+typedef struct {
+    char *name;
+    unsigned char *obj;
+    size_t obj_size;
+    unsigned char *sym;
+    size_t sym_size;
+} module_t;
+
+typedef struct {
+    char *name;
+    uint32_t member;
+    uint32_t address;
+} module_symbol_t;
+
+/**
+ * @brief FNV-1a hash of the given symbol name
+ */
+uint32_t archive_hash(const char *name) {
+    uint32_t hash = 2166136261u;
+    for(; *name != '\0'; name++) {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static exit_t read_whole_file(const char *file_name, unsigned char **content, size_t *size) {
+    FILE *file = fopen(file_name, "rb");
+    if(!file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", file_name);
+    }
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    rewind(file);
+    *content = malloc(file_size > 0 ? file_size : 1);
+    if(!*content) {
+        fclose(file);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when reading file (%s)", file_name);
+    }
+    *size = fread(*content, 1, file_size, file);
+    fclose(file);
+    if(*size != (size_t)file_size) {
+        free(*content);
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", file_name);
+    }
+    return success();
+}
+
+/**
+ * @brief Extract the symbols serialized by `serialize_symbol_table` in the .sym file of a module
+ */
+static exit_t read_module_symbols(const module_t *module, uint32_t member, module_symbol_t **symbols, size_t *num_symbols, size_t *capacity) {
+    char *content = strndup((const char *)module->sym, module->sym_size);
+    if(!content) {
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when reading symbols of %s", module->name);
+    }
+
+    char *saveptr = NULL;
+    for(char *line = strtok_r(content, "\n", &saveptr); line; line = strtok_r(NULL, "\n", &saveptr)) {
+        char name[256];
+        unsigned int address;
+        //header lines do not match the format of a symbol entry
+        if(sscanf(line, "//\t%255s %x", name, &address) != 2 || strcmp(name, "Symbol") == 0 || name[0] == '-') {
+            continue;
+        }
+        if(*num_symbols == *capacity) {
+            *capacity = *capacity ? 2 * *capacity : 64;
+            module_symbol_t *resized_symbols = realloc(*symbols, *capacity * sizeof(module_symbol_t));
+            if(!resized_symbols) {
+                free(content);
+                return failure(EXIT_FAILURE, "ERROR: Out of memory error when reading symbols of %s", module->name);
+            }
+            *symbols = resized_symbols;
+        }
+        if(!((*symbols)[*num_symbols].name = strdup(name))) {
+            free(content);
+            return failure(EXIT_FAILURE, "ERROR: Out of memory error when reading symbols of %s", module->name);
+        }
+        (*symbols)[*num_symbols].member = member;
+        (*symbols)[*num_symbols].address = address;
+        (*num_symbols)++;
+    }
+    free(content);
+    return success();
+}
+
+static exit_t load_module(const char *object_file_name, module_t *module) {
+    size_t name_length = strlen(object_file_name);
+    if(name_length < 4 || strcmp(object_file_name + name_length - 4, ".obj") != 0) {
+        return failure(EXIT_FAILURE, "ERROR: Object file must have .obj suffix ('%s')", object_file_name);
+    }
+
+    char symbol_table_file_name[name_length + 1];
+    strcpy(symbol_table_file_name, object_file_name);
+    strcpy(symbol_table_file_name + name_length - 4, ".sym");
+
+    const char *base_name = strrchr(object_file_name, '/');
+    if(!(module->name = strdup(base_name ? base_name + 1 : object_file_name))) {
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when reading module (%s)", object_file_name);
+    }
+
+    exit_t result = read_whole_file(object_file_name, &module->obj, &module->obj_size);
+    if(result.code) {
+        return result;
+    }
+    return read_whole_file(symbol_table_file_name, &module->sym, &module->sym_size);
+}
+
+static void free_modules(module_t *modules, size_t num_modules, module_symbol_t *symbols, size_t num_symbols) {
+    for(size_t i = 0; i < num_modules; i++) {
+        free(modules[i].name);
+        free(modules[i].obj);
+        free(modules[i].sym);
+    }
+    free(modules);
+    for(size_t i = 0; i < num_symbols; i++) {
+        free(symbols[i].name);
+    }
+    free(symbols);
+}
+
+/**
+ * @brief Hash table of the symbols, keeping the first definition of each name
+ *
+ * @param buckets filled with positions in `symbols`, or ARCHIVE_EMPTY_BUCKET
+ * @param indexed set for the symbols that are kept
+ * @return uint32_t number of symbols kept
+ */
+static uint32_t index_symbols(const module_symbol_t *symbols, size_t num_symbols, uint32_t *buckets, uint32_t num_buckets, bool indexed[]) {
+    uint32_t num_indexed = 0;
+    for(uint32_t i = 0; i < num_buckets; i++) {
+        buckets[i] = ARCHIVE_EMPTY_BUCKET;
+    }
+    for(size_t i = 0; i < num_symbols; i++) {
+        uint32_t bucket = archive_hash(symbols[i].name) & (num_buckets - 1);
+        while(buckets[bucket] != ARCHIVE_EMPTY_BUCKET && strcmp(symbols[buckets[bucket]].name, symbols[i].name) != 0) {
+            bucket = (bucket + 1) & (num_buckets - 1);
+        }
+        indexed[i] = buckets[bucket] == ARCHIVE_EMPTY_BUCKET;
+        if(indexed[i]) {
+            buckets[bucket] = i;
+            num_indexed++;
+        }
+    }
+    return num_indexed;
+}
+
+static exit_t write_archive(FILE *archive_file, const module_t *modules, size_t num_modules, const module_symbol_t *symbols, size_t num_symbols) {
+    //load factor of the index <= 0.5
+    uint32_t num_buckets = 16;
+    while(num_buckets < 2 * num_symbols) {
+        num_buckets <<= 1;
+    }
+
+    //the string table can hold the names of all the symbols, including those not indexed
+    size_t strings_capacity = 1;
+    for(size_t i = 0; i < num_modules; i++) {
+        strings_capacity += strlen(modules[i].name) + 1;
+    }
+    for(size_t i = 0; i < num_symbols; i++) {
+        strings_capacity += strlen(symbols[i].name) + 1;
+    }
+    archive_member_t *members = calloc(num_modules ? num_modules : 1, sizeof(archive_member_t));
+    uint32_t *buckets = malloc(num_buckets * sizeof(uint32_t));
+    archive_symbol_t *table = calloc(num_symbols ? num_symbols : 1, sizeof(archive_symbol_t));
+    uint32_t *positions = malloc((num_symbols ? num_symbols : 1) * sizeof(uint32_t));
+    bool *indexed = malloc(num_symbols ? num_symbols : 1);
+    char *strings = malloc(strings_capacity);
+    if(!members || !buckets || !table || !positions || !indexed || !strings) {
+        free(members);
+        free(buckets);
+        free(table);
+        free(positions);
+        free(indexed);
+        free(strings);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when building archive index%s", "");
+    }
+    uint32_t num_indexed = index_symbols(symbols, num_symbols, buckets, num_buckets, indexed);
+
+    uint32_t strings_size = 0;
+    for(size_t i = 0; i < num_modules; i++) {
+        strings_size += strlen(modules[i].name) + 1;
+    }
+    for(size_t i = 0; i < num_symbols; i++) {
+        strings_size += indexed[i] ? strlen(symbols[i].name) + 1 : 0;
+    }
+
+    archive_header_t header = { .magic = ARCHIVE_MAGIC, .version = ARCHIVE_VERSION, .byte_order = BYTE_ORDER_MARK };
+    header.num_members = num_modules;
+    header.num_symbols = num_indexed;
+    header.num_buckets = num_buckets;
+    header.members_offset = sizeof(archive_header_t);
+    header.buckets_offset = header.members_offset + num_modules * sizeof(archive_member_t);
+    header.symbols_offset = header.buckets_offset + num_buckets * sizeof(uint32_t);
+    header.strings_offset = header.symbols_offset + num_indexed * sizeof(archive_symbol_t);
+    header.strings_size = strings_size;
+
+    uint32_t string_offset = 0;
+    uint32_t data_offset = header.strings_offset + strings_size;
+    for(size_t i = 0; i < num_modules; i++) {
+        members[i].name_offset = string_offset;
+        strcpy(strings + string_offset, modules[i].name);
+        string_offset += strlen(modules[i].name) + 1;
+        members[i].obj_offset = data_offset;
+        members[i].obj_size = modules[i].obj_size;
+        data_offset += modules[i].obj_size;
+        members[i].sym_offset = data_offset;
+        members[i].sym_size = modules[i].sym_size;
+        data_offset += modules[i].sym_size;
+    }
+
+    uint32_t num_written = 0;
+    for(size_t i = 0; i < num_symbols; i++) {
+        if(!indexed[i]) {
+            continue;
+        }
+        positions[i] = num_written;
+        archive_symbol_t *symbol = &table[num_written++];
+        symbol->name_offset = string_offset;
+        strcpy(strings + string_offset, symbols[i].name);
+        string_offset += strlen(symbols[i].name) + 1;
+        symbol->hash = archive_hash(symbols[i].name);
+        symbol->member = symbols[i].member;
+        symbol->address = symbols[i].address;
+    }
+    //buckets point to the symbol table of the archive, without the names defined again by later members
+    for(uint32_t i = 0; i < num_buckets; i++) {
+        if(buckets[i] != ARCHIVE_EMPTY_BUCKET) {
+            buckets[i] = positions[buckets[i]];
+        }
+    }
+
+    bool written = fwrite(&header, sizeof(header), 1, archive_file) == 1
+        && fwrite(members, sizeof(archive_member_t), num_modules, archive_file) == num_modules
+        && fwrite(buckets, sizeof(uint32_t), num_buckets, archive_file) == num_buckets
+        && fwrite(table, sizeof(archive_symbol_t), num_indexed, archive_file) == num_indexed
+        && fwrite(strings, 1, strings_size, archive_file) == strings_size;
+    for(size_t i = 0; written && i < num_modules; i++) {
+        written = fwrite(modules[i].obj, 1, modules[i].obj_size, archive_file) == modules[i].obj_size
+            && fwrite(modules[i].sym, 1, modules[i].sym_size, archive_file) == modules[i].sym_size;
+    }
+
+    free(members);
+    free(buckets);
+    free(table);
+    free(positions);
+    free(indexed);
+    free(strings);
+    if(!written) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't write archive: %d", errno);
+    }
+    return success();
+}
+
+/**
+ * @brief Pack the given modules into a new archive
+ *
+ * The .sym file of each module is expected to be next to its .obj file. A symbol defined by more than one
+ * module is indexed with the first module that defines it.
+ *
+ * @param archive_file_name archive to be created (overwritten if it already exists)
+ * @param object_file_names .obj files of the modules to be packed
+ * @param num_objects
+ * @return exit_t
+ */
+exit_t archive_create(const char *archive_file_name, const char *object_file_names[], size_t num_objects) {
+    module_t *modules = calloc(num_objects ? num_objects : 1, sizeof(module_t));
+    module_symbol_t *symbols = NULL;
+    size_t num_symbols = 0, symbols_capacity = 0;
+    exit_t result = success();
+    if(!modules) {
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when creating archive (%s)", archive_file_name);
+    }
+
+    for(size_t i = 0; i < num_objects && !result.code; i++) {
+        if(!(result = load_module(object_file_names[i], &modules[i])).code) {
+            result = read_module_symbols(&modules[i], i, &symbols, &num_symbols, &symbols_capacity);
+        }
+    }
+
+    if(!result.code) {
+        FILE *archive_file = fopen(archive_file_name, "wb");
+        if(!archive_file) {
+            result = failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", archive_file_name);
+        }
+        else {
+            result = write_archive(archive_file, modules, num_objects, symbols, num_symbols);
+            fclose(archive_file);
+        }
+    }
+
+    free_modules(modules, num_objects, symbols, num_symbols);
+    return result;
+}
+
+/**
+ * @brief Whether `count` entries of `entry_size` bytes starting at `offset` are inside a file of `size` bytes
+ */
+static bool table_fits(size_t size, uint32_t offset, uint32_t count, size_t entry_size) {
+    return offset <= size && (uint64_t)count * entry_size <= size - offset;
+}
+
+/**
+ * @brief Check every offset, size and index the lookups follow, so that a corrupt archive is never read out of
+ * the mapping
+ *
+ * @param archive base, size and header of the mapped file
+ */
+static bool valid_archive(archive_t *archive) {
+    const archive_header_t *header = archive->header;
+    size_t size = archive->size;
+    //the tables of 32-bit integers are used in place
+    bool aligned = header->members_offset % sizeof(uint32_t) == 0 && header->buckets_offset % sizeof(uint32_t) == 0
+        && header->symbols_offset % sizeof(uint32_t) == 0;
+    //lookups mask hashes with num_buckets - 1 and stop at an empty bucket
+    if(memcmp(header->magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || header->version != ARCHIVE_VERSION || header->byte_order != BYTE_ORDER_MARK
+        || !aligned || header->num_buckets == 0 || (header->num_buckets & (header->num_buckets - 1)) != 0
+        || !table_fits(size, header->members_offset, header->num_members, sizeof(archive_member_t))
+        || !table_fits(size, header->buckets_offset, header->num_buckets, sizeof(uint32_t))
+        || !table_fits(size, header->symbols_offset, header->num_symbols, sizeof(archive_symbol_t))
+        || !table_fits(size, header->strings_offset, header->strings_size, 1)) {
+        return false;
+    }
+    archive->members = (const archive_member_t *)(archive->base + header->members_offset);
+    archive->buckets = (const uint32_t *)(archive->base + header->buckets_offset);
+    archive->symbols = (const archive_symbol_t *)(archive->base + header->symbols_offset);
+    archive->strings = (const char *)(archive->base + header->strings_offset);
+
+    //names are read with string functions: the table must end with the terminator of its last name
+    if(header->strings_size == 0 || archive->strings[header->strings_size - 1] != '\0') {
+        return false;
+    }
+    for(uint32_t i = 0; i < header->num_members; i++) {
+        const archive_member_t *member = &archive->members[i];
+        if(member->name_offset >= header->strings_size || !table_fits(size, member->obj_offset, member->obj_size, 1)
+            || !table_fits(size, member->sym_offset, member->sym_size, 1)) {
+            return false;
+        }
+    }
+    for(uint32_t i = 0; i < header->num_symbols; i++) {
+        const archive_symbol_t *symbol = &archive->symbols[i];
+        if(symbol->name_offset >= header->strings_size || symbol->member >= header->num_members) {
+            return false;
+        }
+    }
+    bool empty_bucket = false;
+    for(uint32_t i = 0; i < header->num_buckets; i++) {
+        if(archive->buckets[i] != ARCHIVE_EMPTY_BUCKET && archive->buckets[i] >= header->num_symbols) {
+            return false;
+        }
+        empty_bucket |= archive->buckets[i] == ARCHIVE_EMPTY_BUCKET;
+    }
+    return empty_bucket;
+}
+
+/**
+ * @brief Map an archive into memory and validate it
+ *
+ * No parsing takes place: the tables of `archive` point directly into the mapped file, once their bounds and the
+ * offsets and indexes they hold have been checked against the size of the file
+ *
+ * @param archive_file_name
+ * @param archive view of the archive; it must be released with `archive_close`
+ * @return exit_t
+ */
+exit_t archive_open(const char *archive_file_name, archive_t *archive) {
+    int fd = open(archive_file_name, O_RDONLY);
+    if(fd == -1) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", archive_file_name);
+    }
+    struct stat file_status;
+    if(fstat(fd, &file_status) == -1 || (size_t)file_status.st_size < sizeof(archive_header_t)) {
+        close(fd);
+        return failure(EXIT_FAILURE, "ERROR: Invalid archive (%s)", archive_file_name);
+    }
+
+    void *base = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't map file (%s): %d", archive_file_name, errno);
+    }
+
+    size_t size = file_status.st_size;
+    archive_t view = { .base = base, .size = size, .header = base };
+    if(!valid_archive(&view)) {
+        munmap(base, size);
+        return failure(EXIT_FAILURE, "ERROR: Invalid archive (%s)", archive_file_name);
+    }
+
+    *archive = view;
+    return success();
+}
+
+void archive_close(archive_t *archive) {
+    if(archive->base) {
+        munmap((void *)archive->base, archive->size);
+        archive->base = NULL;
+    }
+}
+
+/**
+ *  Returns the index entry of the given symbol or NULL if no member of the archive defines it
+ **/
+const archive_symbol_t *archive_lookup(const archive_t *archive, const char *name) {
+    uint32_t hash = archive_hash(name);
+    uint32_t mask = archive->header->num_buckets - 1;
+    for(uint32_t bucket = hash & mask; archive->buckets[bucket] != ARCHIVE_EMPTY_BUCKET; bucket = (bucket + 1) & mask) {
+        const archive_symbol_t *symbol = &archive->symbols[archive->buckets[bucket]];
+        if(symbol->hash == hash && strcmp(archive->strings + symbol->name_offset, name) == 0) {
+            return symbol;
+        }
+    }
+    return NULL;
+}
+
+const char *archive_member_name(const archive_t *archive, uint32_t member) {
+    return archive->strings + archive->members[member].name_offset;
+}
+
+/**
+ * @brief Determine the members that must be pulled in to resolve the given undefined symbols
+ *
+ * @param archive
+ * @param undefined_symbols symbols not defined by the modules being linked
+ * @param num_symbols
+ * @param selected_members array with one flag per member, set to true for each member needed
+ * @return exit_t error if some symbol is not defined by any member
+ */
+exit_t archive_select_members(const archive_t *archive, const char *undefined_symbols[], size_t num_symbols, bool selected_members[]) {
+    for(uint32_t i = 0; i < archive->header->num_members; i++) {
+        selected_members[i] = false;
+    }
+    for(size_t i = 0; i < num_symbols; i++) {
+        const archive_symbol_t *symbol = archive_lookup(archive, undefined_symbols[i]);
+        if(!symbol) {
+            return failure(EXIT_FAILURE, "ERROR: Undefined symbol ('%s')", undefined_symbols[i]);
+        }
+        selected_members[symbol->member] = true;
+    }
+    return success();
+}
@@ -16,8 +16,10 @@
  */
 
 #include "../include/lc3.h"
+#include "../include/debuginfo.h"
+#include "../include/trace.h"
 
-static int write_machine_instruction(uint16_t machine_instr, FILE *destination_file) {
+int write_machine_instruction(uint16_t machine_instr, FILE *destination_file) {
     char *bytes = (char *)&machine_instr;
     //swap bytes (because of little-endian representation)
     char byte = bytes[0];
@@ -43,7 +45,7 @@ exit_t serialize_symbol_table(FILE *destination_file, memaddr_t address_origin)
     }
     node_t *node = next(true);
     while(node) {
-        memaddr_t label_address = node->val - 1 + address_origin;
+        memaddr_t label_address = slot_address(node->val, address_origin);
         add(node->key, label_address);
         if((num_chars_written = fprintf(destination_file, "//	%s             %hx\n", node->key, label_address) < 0)) {
             return failure(EXIT_FAILURE, "error when writing serialized symbol table to file: %d", errno);
@@ -53,6 +55,78 @@ exit_t serialize_symbol_table(FILE *destination_file, memaddr_t address_origin)
     return success();
 }
 
+static exit_t write_symbol_table_file(const char *symbol_table_file_name, memaddr_t address_origin) {
+    FILE *symbol_table_file = fopen(symbol_table_file_name, "w");
+    if(!symbol_table_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", symbol_table_file_name);
+    }
+
+    exit_t result = serialize_symbol_table(symbol_table_file, address_origin);
+    fclose(symbol_table_file);
+    return result;
+}
+
+/**
+ * @brief Write the words of a program made of several segments (or of a single segment that can't be written in
+ * the classic format) in the segmented object format
+ *
+ * Only the words of each segment are written, the gaps between segments are not represented in the file
+ */
+static int write_segments(linemetadata_t *tokenized_lines[], FILE *object_file) {
+    size_t num_segments = get_num_segments();
+    if(write_machine_instruction(SEGMENTED_OBJ_MAGIC1, object_file) || write_machine_instruction(SEGMENTED_OBJ_MAGIC2, object_file)
+        || write_machine_instruction(num_segments, object_file)) {
+        return EXIT_FAILURE;
+    }
+    for(size_t i = 0; i < num_segments; i++) {
+        const segment_t *segment = get_segment(i);
+        if(write_machine_instruction(segment->origin, object_file) || write_machine_instruction(segment->num_words, object_file)) {
+            return EXIT_FAILURE;
+        }
+    }
+    for(size_t i = 0; i < num_segments; i++) {
+        const segment_t *segment = get_segment(i);
+        assembly_stats.words += segment->num_words;
+        for(int slot = segment->orig_slot + 1; slot <= segment->orig_slot + segment->num_words; slot++) {
+            if(write_machine_instruction(tokenized_lines[slot]->machine_instruction, object_file)) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+static exit_t write_object_file(const char *object_file_name, linemetadata_t *tokenized_lines[]) {
+    FILE *object_file = fopen(object_file_name, "w");
+    if(!object_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", object_file_name);
+    }
+
+    int write_error = EXIT_SUCCESS;
+    //a classic image starting with the magic words would be read back as a segmented object
+    bool ambiguous_image = tokenized_lines[1] && tokenized_lines[0]->machine_instruction == SEGMENTED_OBJ_MAGIC1
+                           && tokenized_lines[1]->machine_instruction == SEGMENTED_OBJ_MAGIC2;
+    if(get_num_segments() > 1 || ambiguous_image) {
+        write_error = write_segments(tokenized_lines, object_file);
+    }
+    else {
+        //classic format: the .ORIG line provides the first word (origin)
+        linemetadata_t *line_metadata;
+        size_t address_offset = 0;
+        while(!write_error && (line_metadata = tokenized_lines[address_offset])) {
+            write_error = write_machine_instruction(line_metadata->machine_instruction, object_file);
+            address_offset++;
+        }
+        assembly_stats.words += address_offset - 1;
+    }
+    fclose(object_file);
+
+    if(write_error) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't write file (%s)", object_file_name);
+    }
+    return success();
+}
+
 static exit_t sym_obj_file_names(char *symbol_table_file_name, char *object_file_name, const char *assembly_file_name) {
     char *assemby_file_name_dup = strdup(assembly_file_name);
     char *file_extension = split_by_last_delimiter(assemby_file_name_dup, '.');
@@ -73,8 +147,46 @@ static exit_t sym_obj_file_names(char *symbol_table_file_name, char *object_file
     return success();
 }
 
-
+/**
+ * @brief Assemble the given file with the default options
+ */
 exit_t assemble(const char *assembly_file_name) {
+    options_t options = { .dce = false, .optimize = false, .relax = false, .relax_register = -1, .stringp_report = false, .debug_info = false, .analyze = false, .memory_access_cycles = 1, .stats = false, .latency = false, .report = NULL, .analysis_json = NULL, .stats_json = NULL };
+    return assemble_with_options(assembly_file_name, &options);
+}
+
+/**
+ * @brief Whether the phases of the assembly are timed: for the statistics, the trace or the latency report
+ */
+static bool timed(const options_t *options) {
+    return options->stats || options->latency || tracing();
+}
+
+/**
+ * @brief Add the time elapsed since `phase_start` to the given phase, if the assembly is timed
+ */
+static void end_phase(const options_t *options, phase_t phase, uint64_t *phase_start) {
+    if(timed(options)) {
+        uint64_t now = monotonic_ns();
+        assembly_stats.phase_ns[phase] += now - *phase_start;
+        trace_span("phase", phase_name(phase), *phase_start, now);
+        *phase_start = now;
+    }
+}
+
+/**
+ * @brief Free the lines of the program and the array holding them
+ *
+ * The array is allocated with malloc, as callers of the lexer provide their own (see free_tokenized_lines), and its
+ * memory is accounted for separately
+ */
+static void release_tokenized_lines(linemetadata_t *tokenized_lines[]) {
+    free_tokenized_lines(tokenized_lines);
+    memtrack_account(MEM_LINES, -(long)(TOKENIZED_LINES_CAPACITY * sizeof(linemetadata_t *)));
+}
+
+static exit_t run_phases(const char *assembly_file_name, const options_t *options) {
+    uint64_t phase_start = timed(options) ? monotonic_ns() : 0;
     //determine .sym and .obj file names
     char symbol_table_file_name[strlen(assembly_file_name) + strlen(".sym") + 1];
     char object_file_name[strlen(assembly_file_name) + strlen(".obj") + 1];
@@ -85,74 +197,258 @@ exit_t assemble(const char *assembly_file_name) {
     }
 
     //assembly file processing
-    linemetadata_t **tokenized_lines = malloc(ADDRESS_SPACE_CARDINALITY * sizeof(linemetadata_t *));
-    for(size_t i = 0; i < ADDRESS_SPACE_CARDINALITY; i++) {
+    linemetadata_t **tokenized_lines = malloc(TOKENIZED_LINES_CAPACITY * sizeof(linemetadata_t *));
+    memtrack_account(MEM_LINES, TOKENIZED_LINES_CAPACITY * sizeof(linemetadata_t *));
+    for(size_t i = 0; i < TOKENIZED_LINES_CAPACITY; i++) {
         //setting sentinel values
         tokenized_lines[i] = NULL;
     }
 
     FILE *assembly_file = fopen(assembly_file_name, "r");
     if(!assembly_file) {
+        release_tokenized_lines(tokenized_lines);
         return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", assembly_file_name);
     }
 
     result = do_lexical_analysis(assembly_file, tokenized_lines);
     fclose(assembly_file);
     if(result.code) {
-        free_tokenized_lines(tokenized_lines);
+        release_tokenized_lines(tokenized_lines);
         return result;
     }
+    end_phase(options, PHASE_LEXICAL_ANALYSIS, &phase_start);
 
-    if((result = do_syntax_analysis(tokenized_lines)).code) {
-        free_tokenized_lines(tokenized_lines);
-        return result;
+    if(options->dce) {
+        if((result = eliminate_dead_code(tokenized_lines, options)).code) {
+            release_tokenized_lines(tokenized_lines);
+            clear_segments();
+            return result;
+        }
+        end_phase(options, PHASE_DCE, &phase_start);
     }
 
-    //symbol table update
-    FILE *symbol_table_file = fopen(symbol_table_file_name, "w");
-    if(!symbol_table_file) {
-        free_tokenized_lines(tokenized_lines);
-        return failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", symbol_table_file_name);
+    if(options->optimize) {
+        if((result = peephole_optimize(tokenized_lines, options)).code) {
+            release_tokenized_lines(tokenized_lines);
+            clear_segments();
+            return result;
+        }
+        end_phase(options, PHASE_PEEPHOLE, &phase_start);
     }
 
-    result = serialize_symbol_table(symbol_table_file, tokenized_lines[0]->machine_instruction);
-    fclose(symbol_table_file);
-    if(result.code) {
-        free_tokenized_lines(tokenized_lines);
+    if(options->relax) {
+        if((result = relax(tokenized_lines, options)).code) {
+            release_tokenized_lines(tokenized_lines);
+            clear_segments();
+            return result;
+        }
+        end_phase(options, PHASE_RELAXATION, &phase_start);
+    }
+
+    if((result = do_syntax_analysis(tokenized_lines)).code) {
+        release_tokenized_lines(tokenized_lines);
+        clear_segments();
         return result;
     }
+    end_phase(options, PHASE_SYNTAX_ANALYSIS, &phase_start);
 
-    //object file
-    FILE *object_file = fopen(object_file_name, "w");
-    if(!object_file) {
-        free_tokenized_lines(tokenized_lines);
-        return failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", object_file_name);
+    if(options->stringp_report && options->report) {
+        report_stringp_savings(tokenized_lines, options->report);
+        end_phase(options, PHASE_REPORTS, &phase_start);
     }
 
-    linemetadata_t *line_metadata;
-    memaddr_t address_offset = 0;
-    while((line_metadata = tokenized_lines[address_offset])) {
-        if(write_machine_instruction(line_metadata->machine_instruction, object_file)) {
-            fclose(object_file);
-            return failure(EXIT_FAILURE, "ERROR: Couldn't write file (%s)", object_file_name);
+    if(options->analyze && options->analysis_json) {
+        if((result = analyze_program(tokenized_lines, assembly_file_name, options)).code) {
+            release_tokenized_lines(tokenized_lines);
+            clear_segments();
+            return result;
         }
-        free_line_metadata(line_metadata);
-        address_offset++;
+        end_phase(options, PHASE_REPORTS, &phase_start);
     }
-    fclose(object_file);
 
-    return success();
+    if(options->debug_info) {
+        //.dbg
+        char debug_file_name[strlen(object_file_name) + 1];
+        strcpy(debug_file_name, object_file_name);
+        strcpy(debug_file_name + strlen(debug_file_name) - strlen("obj"), "dbg");
+        if((result = debuginfo_write(debug_file_name, assembly_file_name, tokenized_lines)).code) {
+            release_tokenized_lines(tokenized_lines);
+            clear_segments();
+            return result;
+        }
+        end_phase(options, PHASE_DEBUG_INFO, &phase_start);
+        if(options->stats) {
+            add_written_bytes(debug_file_name);
+        }
+    }
+
+    result = write_symbol_table_file(symbol_table_file_name, tokenized_lines[0]->machine_instruction);
+    end_phase(options, PHASE_SYMBOL_TABLE, &phase_start);
+    if(!result.code) {
+        result = write_object_file(object_file_name, tokenized_lines);
+        end_phase(options, PHASE_OBJECT_FILE, &phase_start);
+    }
+    if(!result.code && options->stats) {
+        add_written_bytes(symbol_table_file_name);
+        add_written_bytes(object_file_name);
+    }
+    release_tokenized_lines(tokenized_lines);
+    clear_segments();
+    return result;
+}
+
+/**
+ * @brief Assemble the given file, generating the corresponding .sym and .obj files
+ *
+ * @param assembly_file_name
+ * @param options optional passes to run
+ * @return exit_t
+ */
+exit_t assemble_with_options(const char *assembly_file_name, const options_t *options) {
+    if(!timed(options)) {
+        return run_phases(assembly_file_name, options);
+    }
+
+    reset_stats();
+    uint64_t start = monotonic_ns();
+    exit_t result = run_phases(assembly_file_name, options);
+    uint64_t end = monotonic_ns();
+    assembly_stats.total_ns = end - start;
+    count_allocations();
+    trace_span("file", assembly_file_name, start, end);
+    if(options->stats && options->stats_json) {
+        write_stats_json(options->stats_json, assembly_file_name, &result);
+    }
+    return result;
 }
 
 #ifdef FAB_MAIN
+#define DEFAULT_SLOWEST_FILES 10
+
+static void print_usage(const char *program_name) {
+    printf("USAGE %s [-O] [-g] [--dce] [--relax[=Rn]] [--stringp-report] [--analyze[=N]] [--stats=json | --stats-json=FILE] [-j N] [--trace=FILE] [--latency[=N]] file.asm...\n", program_name);
+    printf("      -O          run the peephole optimizer\n");
+    printf("      -g          write a debug file (.dbg) mapping addresses to source lines and labels\n");
+    printf("      --dce       remove code that is never executed and data that is never referenced\n");
+    printf("      --relax     rewrite instructions whose label is out of the range of their PC offset\n");
+    printf("      --relax=Rn  same as --relax, using Rn as scratch register to relax branches\n");
+    printf("      --stringp-report  report the memory saved by .STRINGP directives\n");
+    printf("      --analyze   report basic blocks, loops and best/worst-case cost of each subroutine in JSON format, on the standard output\n");
+    printf("      --analyze=N same as --analyze, counting N cycles per memory access (default 1)\n");
+    printf("      --stats=json  report the time spent in each phase and the counters of the assembly of each file in JSON format, on the standard output\n");
+    printf("      --stats-json=FILE  same as --stats=json, writing the report to FILE\n");
+    printf("      -j N        assemble N files at the same time, each one in a worker process\n");
+    printf("      --trace=FILE  write a Chrome trace of the assembly of each file and of its phases, by worker\n");
+    printf("      --latency   report the percentiles of the time spent in each file and phase, and the %d slowest files\n", DEFAULT_SLOWEST_FILES);
+    printf("      --latency=N same as --latency, naming the N slowest files (at most %d)\n", MAX_SLOWEST_FILES);
+}
+
 int main(int argc, char const *argv[]) {
-    exit_t result = assemble(argv[1]);
-    if(result.code) {
-        printf("\n\n==========================================\n");
-        printf("%s\n", result.desc);
-        printf("==========================================\n\n");
+    options_t options = { .dce = false, .optimize = false, .relax = false, .relax_register = -1, .stringp_report = false, .debug_info = false, .analyze = false, .memory_access_cycles = 1, .stats = false, .latency = false, .report = stderr, .analysis_json = stdout, .stats_json = NULL };
+    const char *assembly_file_names[argc];
+    const char *stats_file_name = NULL;
+    int num_files = 0;
+    batch_options_t batch_options = { .num_workers = 1, .trace_file_name = NULL, .latency = false, .num_slowest_files = 0 };
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-O") == 0) {
+            options.optimize = true;
+        }
+        else if(strcmp(argv[i], "-g") == 0) {
+            options.debug_info = true;
+        }
+        else if(strcmp(argv[i], "--dce") == 0) {
+            options.dce = true;
+        }
+        else if(strcmp(argv[i], "--relax") == 0) {
+            options.relax = true;
+        }
+        else if(strncmp(argv[i], "--relax=", strlen("--relax=")) == 0) {
+            options.relax = true;
+            if((options.relax_register = parse_register((char *)argv[i] + strlen("--relax="))) == -1) {
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strcmp(argv[i], "--analyze") == 0) {
+            options.analyze = true;
+        }
+        else if(strncmp(argv[i], "--analyze=", strlen("--analyze=")) == 0) {
+            options.analyze = true;
+            char *end;
+            long memory_access_cycles = strtol(argv[i] + strlen("--analyze="), &end, 10);
+            if(*end != '\0' || end == argv[i] + strlen("--analyze=") || memory_access_cycles < 0 || memory_access_cycles > 1000) {
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            options.memory_access_cycles = (int)memory_access_cycles;
+        }
+        else if(strcmp(argv[i], "--stringp-report") == 0) {
+            options.stringp_report = true;
+        }
+        else if(strcmp(argv[i], "--stats=json") == 0) {
+            options.stats = true;
+            stats_file_name = NULL;
+        }
+        else if(strncmp(argv[i], "--stats-json=", strlen("--stats-json=")) == 0 && argv[i][strlen("--stats-json=")]) {
+            options.stats = true;
+            stats_file_name = argv[i] + strlen("--stats-json=");
+        }
+        else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            batch_options.num_workers = atoi(argv[++i]);
+            if(batch_options.num_workers < 1) {
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(strncmp(argv[i], "--trace=", strlen("--trace=")) == 0 && argv[i][strlen("--trace=")]) {
+            batch_options.trace_file_name = argv[i] + strlen("--trace=");
+        }
+        else if(strcmp(argv[i], "--latency") == 0) {
+            batch_options.latency = true;
+            batch_options.num_slowest_files = DEFAULT_SLOWEST_FILES;
+        }
+        else if(strncmp(argv[i], "--latency=", strlen("--latency=")) == 0) {
+            batch_options.latency = true;
+            batch_options.num_slowest_files = atoi(argv[i] + strlen("--latency="));
+            if(batch_options.num_slowest_files < 0 || batch_options.num_slowest_files > MAX_SLOWEST_FILES) {
+                print_usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if(argv[i][0] == '-') {
+            print_usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        else {
+            assembly_file_names[num_files++] = argv[i];
+        }
+    }
+    if(!num_files) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if(options.stats) {
+        //both reports are parsed line by line, so they cannot share a stream
+        if(options.analyze && !stats_file_name) {
+            fprintf(stderr, "ERROR: --analyze and --stats=json both write to the standard output, use --stats-json=FILE\n");
+            exit(EXIT_FAILURE);
+        }
+        options.stats_json = stats_file_name ? fopen(stats_file_name, "w") : stdout;
+        if(!options.stats_json) {
+            fprintf(stderr, "ERROR: Couldn't write file (%s)\n", stats_file_name);
+            exit(EXIT_FAILURE);
+        }
+        //the allocations of each file are counted by the tracker, enabled before anything is allocated
+        memtrack_enable();
+    }
+
+    options.latency = batch_options.latency;
+    int exit_code = assemble_files(assembly_file_names, num_files, &options, &batch_options);
+    if(stats_file_name) {
+        fclose(options.stats_json);
     }
-    return result.code;
+    return exit_code;
 }
 #endif
 
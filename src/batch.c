@@ -0,0 +1,364 @@
+/**
+ * @file batch.c
+ * @brief Assembly of a batch of files, optionally by several workers (-j), traced (--trace) and with a latency report (--latency)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The symbol table, the segments and the description of the last error are global, so a worker is a process
+ * rather than a thread: each one assembles files with its own copy of that state.
+ *
+ * Files are handed out through a pipe holding their indexes: a worker reads the next index when it is done with
+ * a file, so a few large files do not keep the other workers idle. Indexes are written as ints, which are smaller
+ * than PIPE_BUF, so a read never gets part of an index.
+ *
+ * For the latency report, each worker records the latency of its files in histograms of its own, which it sends
+ * to the parent through a pipe of its own when it is done; the parent merges them. Histograms have a fixed size,
+ * so the report of a batch costs the same whatever its number of files.
+ */
+
+#include <inttypes.h>
+#include <sys/wait.h>
+#include "../include/lc3.h"
+#include "../include/trace.h"
+#include "../include/histogram.h"
+
+typedef struct {
+    int file_index;
+    uint64_t total_ns;
+} file_latency_t;
+
+/**
+ * Latency of the files assembled by a worker (or by all of them, once merged)
+ **/
+typedef struct {
+    histogram_t total;
+    histogram_t phases[NUM_PHASES];
+    int num_slowest;
+    file_latency_t slowest[MAX_SLOWEST_FILES]; /**< slowest first */
+} latency_t;
+
+static void init_latency(latency_t *latency) {
+    histogram_init(&latency->total);
+    for(int phase = 0; phase < NUM_PHASES; phase++) {
+        histogram_init(&latency->phases[phase]);
+    }
+    latency->num_slowest = 0;
+}
+
+/**
+ * @brief Keep the given file if it is one of the `num_slowest_files` slowest ones
+ */
+static void add_slowest(latency_t *latency, file_latency_t file_latency, int num_slowest_files) {
+    int position = latency->num_slowest;
+    while(position > 0 && latency->slowest[position - 1].total_ns < file_latency.total_ns) {
+        position--;
+    }
+    if(position >= num_slowest_files) {
+        return;
+    }
+    int last = latency->num_slowest < num_slowest_files ? latency->num_slowest : num_slowest_files - 1;
+    memmove(&latency->slowest[position + 1], &latency->slowest[position], (last - position) * sizeof(file_latency_t));
+    latency->slowest[position] = file_latency;
+    if(latency->num_slowest < num_slowest_files) {
+        latency->num_slowest++;
+    }
+}
+
+/**
+ * @brief Record the times of the file just assembled (see assembly_stats), including the ones that failed
+ */
+static void record_latency(latency_t *latency, int file_index, int num_slowest_files) {
+    histogram_record(&latency->total, assembly_stats.total_ns);
+    for(int phase = 0; phase < NUM_PHASES; phase++) {
+        //phases that did not run are not part of the distribution
+        if(assembly_stats.phase_ns[phase]) {
+            histogram_record(&latency->phases[phase], assembly_stats.phase_ns[phase]);
+        }
+    }
+    add_slowest(latency, (file_latency_t) { .file_index = file_index, .total_ns = assembly_stats.total_ns }, num_slowest_files);
+}
+
+static void merge_latency(latency_t *latency, const latency_t *other, int num_slowest_files) {
+    histogram_merge(&latency->total, &other->total);
+    for(int phase = 0; phase < NUM_PHASES; phase++) {
+        histogram_merge(&latency->phases[phase], &other->phases[phase]);
+    }
+    for(int i = 0; i < other->num_slowest; i++) {
+        add_slowest(latency, other->slowest[i], num_slowest_files);
+    }
+}
+
+static void print_percentiles(FILE *stream, const char *name, const histogram_t *histogram) {
+    fprintf(stream, "%-20s %8" PRIu64, name, histogram->total_count);
+    const double percentiles[] = { 50, 90, 99, 99.9 };
+    for(size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        fprintf(stream, " %12.1f", histogram_percentile(histogram, percentiles[i]) / 1000.0);
+    }
+    fprintf(stream, " %12.1f\n", histogram->max / 1000.0);
+}
+
+static void print_latency_report(FILE *stream, const latency_t *latency, const char *assembly_file_names[]) {
+    fprintf(stream, "\n%-20s %8s %12s %12s %12s %12s %12s\n", "latency (us)", "count", "p50", "p90", "p99", "p99.9", "max");
+    print_percentiles(stream, "file", &latency->total);
+    for(int phase = 0; phase < NUM_PHASES; phase++) {
+        if(latency->phases[phase].total_count) {
+            print_percentiles(stream, phase_name(phase), &latency->phases[phase]);
+        }
+    }
+    if(latency->num_slowest) {
+        fprintf(stream, "\nslowest files (us)\n");
+    }
+    for(int i = 0; i < latency->num_slowest; i++) {
+        fprintf(stream, "%12.1f  %s\n", latency->slowest[i].total_ns / 1000.0, assembly_file_names[latency->slowest[i].file_index]);
+    }
+}
+
+static int assemble_file(const char *assembly_file_name, const options_t *options) {
+    initialize();
+    exit_t result = assemble_with_options(assembly_file_name, options);
+    if(result.code) {
+        fprintf(stderr, "\n\n==========================================\n");
+        fprintf(stderr, "%s\n", result.desc);
+        fprintf(stderr, "==========================================\n\n");
+        free_err(result);
+    }
+    return result.code;
+}
+
+/**
+ * @brief Assemble the files whose indexes are read from the given pipe until it is empty
+ *
+ * @return int exit code of the last file that could not be assembled, EXIT_SUCCESS if all of them were
+ */
+static int run_worker(int index_pipe, const char *assembly_file_names[], const options_t *options,
+                      const batch_options_t *batch_options, latency_t *latency) {
+    int exit_code = EXIT_SUCCESS;
+    int file_index;
+    while(read(index_pipe, &file_index, sizeof(file_index)) == sizeof(file_index)) {
+        int code = assemble_file(assembly_file_names[file_index], options);
+        if(code) {
+            exit_code = code;
+        }
+        if(batch_options->latency) {
+            record_latency(latency, file_index, batch_options->num_slowest_files);
+        }
+        //the output of a file is written at once (the JSON reports too), so it is not interleaved with the output of other workers
+        fflush(NULL);
+    }
+    return exit_code;
+}
+
+static int start_tracing(const char *trace_file_name, int worker) {
+    if(!trace_file_name) {
+        return EXIT_SUCCESS;
+    }
+    exit_t result = trace_start(trace_file_name, worker);
+    if(result.code) {
+        fprintf(stderr, "%s\n", result.desc);
+        free_err(result);
+    }
+    return result.code;
+}
+
+static int stop_tracing() {
+    exit_t result = trace_stop();
+    if(result.code) {
+        fprintf(stderr, "%s\n", result.desc);
+        free_err(result);
+    }
+    return result.code;
+}
+
+static int assemble_sequentially(const char *assembly_file_names[], int num_files, const options_t *options,
+                                 const batch_options_t *batch_options, latency_t *latency) {
+    int exit_code = EXIT_SUCCESS;
+    for(int i = 0; i < num_files; i++) {
+        int code = assemble_file(assembly_file_names[i], options);
+        if(code) {
+            exit_code = code;
+        }
+        if(batch_options->latency) {
+            record_latency(latency, i, batch_options->num_slowest_files);
+        }
+    }
+    return exit_code;
+}
+
+static bool write_all(int fd, const void *buffer, size_t size) {
+    const char *bytes = buffer;
+    while(size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if(written <= 0) {
+            return false;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void *buffer, size_t size) {
+    char *bytes = buffer;
+    while(size > 0) {
+        ssize_t num_read = read(fd, bytes, size);
+        if(num_read <= 0) {
+            return false;
+        }
+        bytes += num_read;
+        size -= num_read;
+    }
+    return true;
+}
+
+static void close_pipes(int pipes[][2], int num_pipes) {
+    for(int i = 0; i < num_pipes; i++) {
+        close(pipes[i][0]);
+        close(pipes[i][1]);
+    }
+}
+
+static int assemble_in_parallel(const char *assembly_file_names[], int num_files, const options_t *options,
+                                const batch_options_t *batch_options, latency_t *latency) {
+    int num_workers = batch_options->num_workers;
+    int index_pipe[2];
+    //latency of the files assembled by each worker
+    int latency_pipes[num_workers][2];
+    if(pipe(index_pipe)) {
+        fprintf(stderr, "ERROR: Couldn't create the pipe of the workers: %d\n", errno);
+        return EXIT_FAILURE;
+    }
+    for(int i = 0; batch_options->latency && i < num_workers; i++) {
+        if(pipe(latency_pipes[i])) {
+            fprintf(stderr, "ERROR: Couldn't create the pipe of the workers: %d\n", errno);
+            close_pipes(latency_pipes, i);
+            close(index_pipe[0]);
+            close(index_pipe[1]);
+            return EXIT_FAILURE;
+        }
+    }
+    //buffered output (of every stream) would otherwise be written by the parent and by every worker
+    fflush(NULL);
+
+    int exit_code = EXIT_SUCCESS;
+    int num_started = 0;
+    for(; num_started < num_workers; num_started++) {
+        pid_t pid = fork();
+        if(pid == -1) {
+            fprintf(stderr, "ERROR: Couldn't start worker %d: %d\n", num_started, errno);
+            exit_code = EXIT_FAILURE;
+            break;
+        }
+        if(pid == 0) {
+            close(index_pipe[1]);
+            int latency_fd = -1;
+            if(batch_options->latency) {
+                //only the write end of its own pipe is kept, so that the parent sees the end of the pipe of a worker that dies
+                latency_fd = dup(latency_pipes[num_started][1]);
+                close_pipes(latency_pipes, num_workers);
+                init_latency(latency);
+            }
+            int worker_exit_code = start_tracing(batch_options->trace_file_name, num_started);
+            int code = run_worker(index_pipe[0], assembly_file_names, options, batch_options, latency);
+            worker_exit_code = code ? code : worker_exit_code;
+            code = stop_tracing();
+            if(latency_fd != -1) {
+                write_all(latency_fd, latency, sizeof(latency_t));
+                close(latency_fd);
+            }
+            initialize();
+            exit(worker_exit_code ? worker_exit_code : code);
+        }
+    }
+    close(index_pipe[0]);
+    for(int i = 0; num_started > 0 && i < num_files; i++) {
+        if(write(index_pipe[1], &i, sizeof(i)) != sizeof(i)) {
+            fprintf(stderr, "ERROR: Couldn't hand out file (%s) to the workers: %d\n", assembly_file_names[i], errno);
+            exit_code = EXIT_FAILURE;
+            break;
+        }
+    }
+    close(index_pipe[1]);
+
+    if(batch_options->latency) {
+        for(int i = 0; i < num_workers; i++) {
+            close(latency_pipes[i][1]);
+        }
+        latency_t *worker_latency = malloc(sizeof(latency_t));
+        for(int i = 0; i < num_started; i++) {
+            if(read_all(latency_pipes[i][0], worker_latency, sizeof(latency_t))) {
+                merge_latency(latency, worker_latency, batch_options->num_slowest_files);
+            }
+            else {
+                fprintf(stderr, "ERROR: Couldn't read the latency of the files of worker %d\n", i);
+            }
+        }
+        free(worker_latency);
+        for(int i = 0; i < num_workers; i++) {
+            close(latency_pipes[i][0]);
+        }
+    }
+
+    int status;
+    while(wait(&status) > 0) {
+        if(!WIFEXITED(status)) {
+            exit_code = EXIT_FAILURE;
+        }
+        else if(WEXITSTATUS(status)) {
+            exit_code = WEXITSTATUS(status);
+        }
+    }
+    return exit_code;
+}
+
+/**
+ * @brief Assemble the given files, each one with its own symbol table
+ *
+ * @return int exit code of the last file that could not be assembled, EXIT_SUCCESS if all of them were
+ */
+int assemble_files(const char *assembly_file_names[], int num_files, const options_t *options, const batch_options_t *batch_options) {
+    batch_options_t batch = *batch_options;
+    if(batch.num_workers > num_files) {
+        batch.num_workers = num_files;
+    }
+    if(batch.num_slowest_files > MAX_SLOWEST_FILES) {
+        batch.num_slowest_files = MAX_SLOWEST_FILES;
+    }
+    options_t assembly_options = *options;
+    assembly_options.latency = assembly_options.latency || batch.latency;
+    latency_t *latency = NULL;
+    if(batch.latency) {
+        latency = malloc(sizeof(latency_t));
+        init_latency(latency);
+    }
+
+    int exit_code;
+    if(batch.num_workers <= 1) {
+        batch.num_workers = 1;
+        int trace_exit_code = start_tracing(batch.trace_file_name, 0);
+        exit_code = assemble_sequentially(assembly_file_names, num_files, &assembly_options, &batch, latency);
+        trace_exit_code |= stop_tracing();
+        exit_code = exit_code ? exit_code : trace_exit_code;
+    }
+    else {
+        exit_code = assemble_in_parallel(assembly_file_names, num_files, &assembly_options, &batch, latency);
+    }
+    //release the symbol table, so that the memory still alive at exit reveals leaks (LC3_MEMTRACK=1)
+    initialize();
+
+    if(batch.trace_file_name) {
+        exit_t result = trace_merge(batch.trace_file_name, batch.num_workers);
+        if(result.code) {
+            fprintf(stderr, "%s\n", result.desc);
+            free_err(result);
+            exit_code = exit_code ? exit_code : result.code;
+        }
+    }
+    if(latency) {
+        print_latency_report(options->report ? options->report : stdout, latency, assembly_file_names);
+        free(latency);
+    }
+    return exit_code;
+}
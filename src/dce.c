@@ -0,0 +1,306 @@
+/**
+ * @file dce.c
+ * @brief Elimination of unreachable code and unreferenced data (--dce)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The program is split into regions: a region starts at the first word of a segment or at a word pointed to by a
+ * label, and ends right before the next region. Regions are the nodes of a graph whose edges are:
+ * - references to labels: BR/JSR targets, operands of LD/ST/LDI/STI/LEA and .FILL LABEL
+ * - fall-through: a region containing instructions continues into the next region unless its last line is
+ *   an unconditional transfer of control (BR, JMP, RET, RTT, RTI, HALT)
+ *
+ * Regions reachable from the start of each segment are kept; the rest of the program is removed and the remaining
+ * words are moved together, as done by the other passes that rewrite `tokenized_lines`.
+ *
+ * Addresses held in registers are handled conservatively. They can only come from a label whose address is taken
+ * (LEA, .FILL LABEL or data loaded from such a word):
+ * - an indirect jump (JMP/JSRR) lands on such a label, which is already reached through the reference edges
+ * - an access through a register (LDR/STR, LDI/STI) may index past such a label: a data region whose address is
+ *   taken keeps the data regions following it alive, up to the next region containing instructions, as an array
+ *   may have labels on its elements
+ * Besides, words spanned by an offset given as a number are never moved, so the regions containing them are roots
+ * too.
+ */
+
+#include "../include/lc3.h"
+
+typedef struct dce_graph {
+    size_t num_slots;
+    size_t num_regions;
+    size_t *region_starts; /**< first slot of each region, plus the sentinel `num_slots` */
+    size_t *region_of_slot; /**< region each slot belongs to, `num_regions` for .ORIG lines */
+    bool *reachable;
+    bool *address_taken; /**< reached through a label whose address is taken */
+    size_t *worklist;
+    size_t worklist_size;
+} dce_graph_t;
+
+static bool is_unconditional_transfer(const linemetadata_t *line_metadata) {
+    switch(compute_opcode_type(line_metadata->tokens[0])) {
+    case BR: case BRnzp: case JMP: case JMPT: case RET: case RTT: case RTI: case HALT:
+        return true;
+    case TRAP: {
+        long trapvector;
+        return line_metadata->num_tokens > 1 && numeric_offset(line_metadata->tokens[1], &trapvector) && trapvector == 0x25;
+    }
+    default:
+        return false;
+    }
+}
+
+static void mark_reachable(dce_graph_t *graph, size_t region, bool address_taken) {
+    if(region >= graph->num_regions) {
+        return;
+    }
+    //a region reached again through a label whose address is taken is visited again to keep the data after it
+    if(!graph->reachable[region] || (address_taken && !graph->address_taken[region])) {
+        graph->reachable[region] = true;
+        graph->address_taken[region] |= address_taken;
+        graph->worklist[graph->worklist_size++] = region;
+    }
+}
+
+static void mark_label_reachable(dce_graph_t *graph, const char *label, bool address_taken) {
+    long value;
+    if(numeric_offset(label, &value)) {
+        return;
+    }
+    node_t *node = lookup(label);
+    if(node && node->val < graph->num_slots) {
+        mark_reachable(graph, graph->region_of_slot[node->val], address_taken);
+    }
+}
+
+static bool has_instructions(linemetadata_t *tokenized_lines[], const dce_graph_t *graph, size_t region) {
+    for(size_t slot = graph->region_starts[region]; slot < graph->region_starts[region + 1]; slot++) {
+        if(tokenized_lines[slot]->tokens && compute_line_type(tokenized_lines[slot]->tokens[0]) == OPCODE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Follow the edges leaving a region
+ */
+static void visit_region(linemetadata_t *tokenized_lines[], dce_graph_t *graph, size_t region) {
+    const linemetadata_t *last_instruction = NULL;
+    const linemetadata_t *last_line = NULL;
+    for(size_t slot = graph->region_starts[region]; slot < graph->region_starts[region + 1]; slot++) {
+        const linemetadata_t *line_metadata = tokenized_lines[slot];
+        last_line = line_metadata;
+        if(!line_metadata->tokens) {
+            continue;
+        }
+        linetype_t line_type = compute_line_type(line_metadata->tokens[0]);
+        if(line_type == FILL_DIRECTIVE && line_metadata->num_tokens > 1) {
+            mark_label_reachable(graph, line_metadata->tokens[1], true);
+        }
+        else if(line_type == OPCODE) {
+            int num_bits;
+            int operand = pc_relative_operand(line_metadata, &num_bits);
+            if(operand != -1) {
+                mark_label_reachable(graph, line_metadata->tokens[operand], compute_opcode_type(line_metadata->tokens[0]) == LEA);
+            }
+            last_instruction = line_metadata;
+        }
+    }
+    //regions made only of data do not fall through, but the data after an array may be reached through its address
+    size_t next_slot = graph->region_starts[region + 1];
+    bool next_in_segment = next_slot < graph->num_slots && graph->region_of_slot[next_slot - 1] == region;
+    if(last_instruction && !(last_line == last_instruction && is_unconditional_transfer(last_instruction))) {
+        mark_reachable(graph, region + 1, false);
+    }
+    else if(!last_instruction && graph->address_taken[region] && next_in_segment && !has_instructions(tokenized_lines, graph, region + 1)) {
+        mark_reachable(graph, region + 1, true);
+    }
+}
+
+/**
+ * @brief Split the program into regions
+ */
+static exit_t build_regions(linemetadata_t *tokenized_lines[], dce_graph_t *graph) {
+    size_t num_slots = graph->num_slots;
+    bool *is_region_start = calloc(num_slots, sizeof(bool));
+    graph->region_starts = malloc((num_slots + 1) * sizeof(size_t));
+    graph->region_of_slot = malloc(num_slots * sizeof(size_t));
+    if(!is_region_start || !graph->region_starts || !graph->region_of_slot) {
+        free(is_region_start);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+    for(node_t *node = next(true); node; node = next(false)) {
+        if(node->val < num_slots) {
+            is_region_start[node->val] = true;
+        }
+    }
+
+    //.ORIG lines are not part of any region
+    graph->num_regions = 0;
+    bool orig_line = false;
+    for(size_t slot = 0; slot < num_slots; slot++) {
+        orig_line = tokenized_lines[slot]->tokens && compute_line_type(tokenized_lines[slot]->tokens[0]) == ORIG_DIRECTIVE;
+        if(orig_line) {
+            graph->region_of_slot[slot] = SIZE_MAX;
+            continue;
+        }
+        bool first_word_of_segment = slot > 0 && graph->region_of_slot[slot - 1] == SIZE_MAX;
+        if(is_region_start[slot] || first_word_of_segment) {
+            graph->region_starts[graph->num_regions++] = slot;
+        }
+        graph->region_of_slot[slot] = graph->num_regions - 1;
+    }
+    graph->region_starts[graph->num_regions] = num_slots;
+    for(size_t slot = 0; slot < num_slots; slot++) {
+        if(graph->region_of_slot[slot] == SIZE_MAX) {
+            graph->region_of_slot[slot] = graph->num_regions;
+        }
+    }
+    free(is_region_start);
+    return success();
+}
+
+/**
+ * @brief Mark the regions containing words spanned by offsets given as numbers, which must not be moved
+ */
+static void mark_numeric_offset_spans(linemetadata_t *tokenized_lines[], dce_graph_t *graph) {
+    long num_slots = graph->num_slots;
+    for(long slot = 0; slot < num_slots; slot++) {
+        int num_bits;
+        int operand = pc_relative_operand(tokenized_lines[slot], &num_bits);
+        long offset;
+        if(operand == -1 || !numeric_offset(tokenized_lines[slot]->tokens[operand], &offset)) {
+            continue;
+        }
+        long target = slot + 1 + offset;
+        long first = target < slot ? target : slot;
+        long last = target < slot ? slot : target;
+        for(long spanned = first < 0 ? 0 : first; spanned <= last && spanned < num_slots; spanned++) {
+            mark_reachable(graph, graph->region_of_slot[spanned], false);
+        }
+    }
+}
+
+static void report_removed_region(linemetadata_t *tokenized_lines[], const dce_graph_t *graph, size_t region, FILE *report) {
+    size_t first = graph->region_starts[region];
+    size_t last = graph->region_starts[region + 1] - 1;
+    int first_line = tokenized_lines[first]->line_number;
+    int last_line = tokenized_lines[last]->line_number;
+    if(first_line == last_line) {
+        fprintf(report, "dce (line %d): ", first_line);
+    }
+    else {
+        fprintf(report, "dce (lines %d-%d): ", first_line, last_line);
+    }
+    fprintf(report, "%zu words removed (%s)\n", last - first + 1, has_instructions(tokenized_lines, graph, region) ? "unreachable code" : "unreferenced data");
+}
+
+/**
+ * @brief Delete from the symbol table the labels of the removed regions
+ */
+static void delete_removed_labels(const dce_graph_t *graph) {
+    size_t num_labels = 0;
+    for(node_t *node = next(true); node; node = next(false)) {
+        num_labels++;
+    }
+    char **removed_labels = malloc(num_labels * sizeof(char *));
+    size_t num_removed_labels = 0;
+    for(node_t *node = next(true); node && removed_labels; node = next(false)) {
+        if(node->val < graph->num_slots && graph->region_of_slot[node->val] < graph->num_regions && !graph->reachable[graph->region_of_slot[node->val]]) {
+            removed_labels[num_removed_labels++] = strdup(node->key);
+        }
+    }
+    for(size_t i = 0; i < num_removed_labels; i++) {
+        delete(removed_labels[i]);
+        free(removed_labels[i]);
+    }
+    free(removed_labels);
+}
+
+static void free_graph(dce_graph_t *graph) {
+    free(graph->region_starts);
+    free(graph->region_of_slot);
+    free(graph->reachable);
+    free(graph->address_taken);
+    free(graph->worklist);
+}
+
+/**
+ * @brief Remove the regions of the program that are not reachable from the start of any segment
+ *
+ * Must be run after the lexical analysis and before the syntax analysis
+ *
+ * @param tokenized_lines
+ * @param options
+ * @return exit_t
+ */
+exit_t eliminate_dead_code(linemetadata_t *tokenized_lines[], const options_t *options) {
+    exit_t result;
+    if((result = compute_segments(tokenized_lines)).code) {
+        return result;
+    }
+    dce_graph_t graph = { .num_slots = count_slots(tokenized_lines) };
+    if((result = build_regions(tokenized_lines, &graph)).code) {
+        free_graph(&graph);
+        return result;
+    }
+    graph.reachable = calloc(graph.num_regions, sizeof(bool));
+    graph.address_taken = calloc(graph.num_regions, sizeof(bool));
+    //each region is pushed at most twice: when reached and when its address is found to be taken
+    graph.worklist = malloc(2 * graph.num_regions * sizeof(size_t));
+    if(!graph.reachable || !graph.address_taken || !graph.worklist) {
+        free_graph(&graph);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+
+    //roots: start of each segment and regions that cannot be moved
+    for(size_t i = 0; i < get_num_segments(); i++) {
+        size_t first_word = get_segment(i)->orig_slot + 1;
+        if(first_word < graph.num_slots) {
+            mark_reachable(&graph, graph.region_of_slot[first_word], false);
+        }
+    }
+    mark_numeric_offset_spans(tokenized_lines, &graph);
+    while(graph.worklist_size > 0) {
+        visit_region(tokenized_lines, &graph, graph.worklist[--graph.worklist_size]);
+    }
+
+    slot_rewrite_t *rewrites = calloc(graph.num_slots, sizeof(slot_rewrite_t));
+    size_t *slot_map = malloc((graph.num_slots + 1) * sizeof(size_t));
+    if(!rewrites || !slot_map) {
+        free(rewrites);
+        free(slot_map);
+        free_graph(&graph);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+    size_t num_removed_words = 0;
+    for(size_t region = 0; region < graph.num_regions; region++) {
+        if(graph.reachable[region]) {
+            continue;
+        }
+        if(options->report) {
+            report_removed_region(tokenized_lines, &graph, region, options->report);
+        }
+        for(size_t slot = graph.region_starts[region]; slot < graph.region_starts[region + 1]; slot++) {
+            rewrites[slot].rewritten = true;
+            num_removed_words++;
+        }
+    }
+
+    result = success();
+    if(num_removed_words > 0) {
+        delete_removed_labels(&graph);
+        compute_slot_map(rewrites, graph.num_slots, slot_map);
+        result = apply_slot_rewrites(tokenized_lines, rewrites, slot_map);
+        if(options->report) {
+            fprintf(options->report, "dce: %zu words removed\n", num_removed_words);
+        }
+    }
+    free_slot_rewrites(rewrites, graph.num_slots);
+    free(slot_map);
+    free_graph(&graph);
+    return result;
+}
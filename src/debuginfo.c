@@ -0,0 +1,402 @@
+/**
+ * @file debuginfo.c
+ * @brief debug files mapping memory addresses back to source lines and label scopes (-g)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The line table only stores a row where the source location changes, so that the words generated by a single
+ * line (.BLKW, .STRINGZ...) take one row, and rows are delta-encoded as variable-length integers: most rows take
+ * 3 bytes. Decoding a row requires decoding all the previous ones, so the absolute values of every
+ * DEBUGINFO_CHECKPOINT_INTERVAL-th row are stored in a table of fixed-size entries. Looking up an address is a
+ * binary search of the checkpoints followed by decoding at most DEBUGINFO_CHECKPOINT_INTERVAL rows.
+ *
+ * Scopes are looked up with a binary search as well. Neither lookup requires any parsing after mapping the file
+ * into memory (`debuginfo_open`).
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/debuginfo.h"
+
+#define BYTE_ORDER_MARK 0x01020304
+// longest LEB128 encoding of a 32-bit value
+#define MAX_ROW_SIZE 15
+
+typedef struct {
+    const char *name;
+    uint32_t address;
+} label_address_t;
+
+static size_t encode_uleb128(uint32_t value, unsigned char *buffer) {
+    size_t size = 0;
+    do {
+        unsigned char byte = value & 0x7F;
+        value >>= 7;
+        buffer[size++] = value ? byte | 0x80 : byte;
+    } while(value);
+    return size;
+}
+
+/**
+ * @brief Decode a LEB128 integer, never reading past `end` (a truncated integer ends there)
+ */
+static uint32_t decode_uleb128(const unsigned char **buffer, const unsigned char *end) {
+    uint32_t value = 0;
+    int shift = 0;
+    unsigned char byte = 0x80;
+    while((byte & 0x80) && shift < 35 && *buffer < end) {
+        byte = *(*buffer)++;
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+    }
+    return value;
+}
+
+static uint32_t zigzag_encode(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t zigzag_decode(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static int compare_label_addresses(const void *a, const void *b) {
+    const label_address_t *label_a = a;
+    const label_address_t *label_b = b;
+    if(label_a->address != label_b->address) {
+        return label_a->address < label_b->address ? -1 : 1;
+    }
+    return strcmp(label_a->name, label_b->name);
+}
+
+/**
+ * @brief Address following the last word of the segment containing the given address
+ *
+ * A label placed right before .END gets the address following the last word of its segment, its scope is empty
+ */
+static uint32_t segment_end(uint32_t address) {
+    for(size_t i = 0; i < get_num_segments(); i++) {
+        const segment_t *segment = get_segment(i);
+        if(address >= segment->origin && address < (uint32_t)segment->origin + segment->num_words) {
+            return segment->origin + segment->num_words;
+        }
+    }
+    return address;
+}
+
+/**
+ * @brief Build the line table: source location of each address, then one row per change of location
+ */
+static exit_t build_rows(linemetadata_t *tokenized_lines[], unsigned char **rows, uint32_t *rows_size, debuginfo_checkpoint_t **checkpoints,
+    uint32_t *num_checkpoints, uint32_t *num_rows) {
+    memaddr_t address_origin = tokenized_lines[0]->machine_instruction;
+    uint32_t *lines = calloc(ADDRESS_SPACE_CARDINALITY, sizeof(uint32_t));
+    uint32_t *columns = calloc(ADDRESS_SPACE_CARDINALITY, sizeof(uint32_t));
+    //one row per address at most
+    *rows = malloc(ADDRESS_SPACE_CARDINALITY * MAX_ROW_SIZE);
+    *checkpoints = malloc((ADDRESS_SPACE_CARDINALITY / DEBUGINFO_CHECKPOINT_INTERVAL + 1) * sizeof(debuginfo_checkpoint_t));
+    if(!lines || !columns || !*rows || !*checkpoints) {
+        free(lines);
+        free(columns);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when building debug information%s", "");
+    }
+    for(size_t slot = 1; tokenized_lines[slot]; slot++) {
+        linemetadata_t *line_metadata = tokenized_lines[slot];
+        if(line_metadata->tokens && compute_line_type(line_metadata->tokens[0]) == ORIG_DIRECTIVE) {
+            continue;
+        }
+        memaddr_t address = slot_address(slot, address_origin);
+        lines[address] = line_metadata->line_number;
+        columns[address] = line_metadata->column;
+    }
+
+    uint32_t previous_address = 0, previous_line = 0, previous_column = 0;
+    *rows_size = 0;
+    *num_rows = 0;
+    *num_checkpoints = 0;
+    for(uint32_t address = 0; address < ADDRESS_SPACE_CARDINALITY; address++) {
+        uint32_t line = lines[address];
+        uint32_t column = columns[address];
+        //rows are only needed where the location changes, addresses before the first row have no source
+        if(*num_rows == 0 ? line == 0 : line == previous_line && column == previous_column) {
+            continue;
+        }
+        if(*num_rows % DEBUGINFO_CHECKPOINT_INTERVAL == 0) {
+            (*checkpoints)[(*num_checkpoints)++] = (debuginfo_checkpoint_t) { .address = address, .line = line, .column = column, .row_offset = *rows_size };
+        }
+        *rows_size += encode_uleb128(address - previous_address, *rows + *rows_size);
+        *rows_size += encode_uleb128(zigzag_encode((int32_t)line - (int32_t)previous_line), *rows + *rows_size);
+        *rows_size += encode_uleb128(column, *rows + *rows_size);
+        (*num_rows)++;
+        previous_address = address;
+        previous_line = line;
+        previous_column = column;
+    }
+    free(lines);
+    free(columns);
+    return success();
+}
+
+/**
+ * @brief Build the scopes: one per label, covering the addresses up to the next label or the end of the segment
+ */
+static exit_t build_scopes(memaddr_t address_origin, debuginfo_scope_t **scopes, uint32_t *num_scopes, char **strings, uint32_t *strings_size,
+    const char *assembly_file_name) {
+    size_t num_labels = 0;
+    *strings_size = strlen(assembly_file_name) + 1;
+    for(node_t *node = next(true); node; node = next(false)) {
+        num_labels++;
+        *strings_size += strlen(node->key) + 1;
+    }
+    label_address_t *labels = malloc((num_labels ? num_labels : 1) * sizeof(label_address_t));
+    *scopes = malloc((num_labels ? num_labels : 1) * sizeof(debuginfo_scope_t));
+    *strings = malloc(*strings_size);
+    if(!labels || !*scopes || !*strings) {
+        free(labels);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when building debug information%s", "");
+    }
+    size_t i = 0;
+    for(node_t *node = next(true); node; node = next(false)) {
+        labels[i++] = (label_address_t) { .name = node->key, .address = slot_address(node->val, address_origin) };
+    }
+    qsort(labels, num_labels, sizeof(label_address_t), compare_label_addresses);
+
+    strcpy(*strings, assembly_file_name);
+    uint32_t string_offset = strlen(assembly_file_name) + 1;
+    for(i = 0; i < num_labels; i++) {
+        uint32_t end = segment_end(labels[i].address);
+        for(size_t j = i + 1; j < num_labels; j++) {
+            if(labels[j].address > labels[i].address) {
+                end = labels[j].address < end ? labels[j].address : end;
+                break;
+            }
+        }
+        (*scopes)[i] = (debuginfo_scope_t) { .start = labels[i].address, .end = end, .name_offset = string_offset };
+        strcpy(*strings + string_offset, labels[i].name);
+        string_offset += strlen(labels[i].name) + 1;
+    }
+    *num_scopes = num_labels;
+    free(labels);
+    return success();
+}
+
+/**
+ * @brief Write the debug file of an assembled program
+ *
+ * Must be run after the syntax analysis, while the symbol table still contains slots of `tokenized_lines`
+ *
+ * @param debug_file_name file to be created (overwritten if it already exists)
+ * @param assembly_file_name name of the source file recorded in the debug file
+ * @param tokenized_lines
+ * @return exit_t
+ */
+exit_t debuginfo_write(const char *debug_file_name, const char *assembly_file_name, linemetadata_t *tokenized_lines[]) {
+    exit_t result;
+    if((result = compute_segments(tokenized_lines)).code) {
+        return result;
+    }
+    debuginfo_header_t header = { .magic = DEBUGINFO_MAGIC, .version = DEBUGINFO_VERSION, .byte_order = BYTE_ORDER_MARK,
+        .checkpoint_interval = DEBUGINFO_CHECKPOINT_INTERVAL };
+    unsigned char *rows = NULL;
+    debuginfo_checkpoint_t *checkpoints = NULL;
+    debuginfo_scope_t *scopes = NULL;
+    char *strings = NULL;
+    if(!(result = build_rows(tokenized_lines, &rows, &header.rows_size, &checkpoints, &header.num_checkpoints, &header.num_rows)).code) {
+        result = build_scopes(tokenized_lines[0]->machine_instruction, &scopes, &header.num_scopes, &strings, &header.strings_size, assembly_file_name);
+    }
+    if(result.code) {
+        free(rows);
+        free(checkpoints);
+        free(scopes);
+        free(strings);
+        return result;
+    }
+
+    header.checkpoints_offset = sizeof(debuginfo_header_t);
+    header.scopes_offset = header.checkpoints_offset + header.num_checkpoints * sizeof(debuginfo_checkpoint_t);
+    header.strings_offset = header.scopes_offset + header.num_scopes * sizeof(debuginfo_scope_t);
+    header.source_name_offset = 0;
+    //variable-length rows go last so that fixed-size entries stay aligned
+    header.rows_offset = header.strings_offset + header.strings_size;
+
+    FILE *debug_file = fopen(debug_file_name, "wb");
+    if(!debug_file) {
+        result = failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", debug_file_name);
+    }
+    else {
+        bool written = fwrite(&header, sizeof(header), 1, debug_file) == 1
+            && fwrite(checkpoints, sizeof(debuginfo_checkpoint_t), header.num_checkpoints, debug_file) == header.num_checkpoints
+            && fwrite(scopes, sizeof(debuginfo_scope_t), header.num_scopes, debug_file) == header.num_scopes
+            && fwrite(strings, 1, header.strings_size, debug_file) == header.strings_size
+            && fwrite(rows, 1, header.rows_size, debug_file) == header.rows_size;
+        if(fclose(debug_file) != 0 || !written) {
+            result = failure(EXIT_FAILURE, "ERROR: Couldn't write debug file: %d", errno);
+        }
+    }
+    free(rows);
+    free(checkpoints);
+    free(scopes);
+    free(strings);
+    return result;
+}
+
+/**
+ * @brief Check the tables of a mapped debug file and every offset the lookups follow, so that a corrupt file is
+ * never read out of the mapping
+ *
+ * @param debuginfo base, size and header of the mapped file
+ */
+static bool valid_debuginfo(debuginfo_t *debuginfo) {
+    const debuginfo_header_t *header = debuginfo->header;
+    size_t size = debuginfo->size;
+    //the tables of fixed-size entries are used in place
+    bool aligned = header->checkpoints_offset % sizeof(uint32_t) == 0 && header->scopes_offset % sizeof(uint32_t) == 0;
+    if(memcmp(header->magic, DEBUGINFO_MAGIC, sizeof(DEBUGINFO_MAGIC)) != 0 || header->version != DEBUGINFO_VERSION || header->byte_order != BYTE_ORDER_MARK
+        || !aligned || header->checkpoint_interval == 0 || header->rows_offset > size || header->rows_size > size - header->rows_offset
+        || header->strings_offset > size || header->strings_size > size - header->strings_offset
+        || header->checkpoints_offset > header->scopes_offset || header->scopes_offset > header->strings_offset
+        || header->num_checkpoints > (header->scopes_offset - header->checkpoints_offset) / sizeof(debuginfo_checkpoint_t)
+        || header->num_scopes > (header->strings_offset - header->scopes_offset) / sizeof(debuginfo_scope_t)) {
+        return false;
+    }
+    debuginfo->checkpoints = (const debuginfo_checkpoint_t *)(debuginfo->base + header->checkpoints_offset);
+    debuginfo->rows = debuginfo->base + header->rows_offset;
+    debuginfo->scopes = (const debuginfo_scope_t *)(debuginfo->base + header->scopes_offset);
+    debuginfo->strings = (const char *)(debuginfo->base + header->strings_offset);
+
+    //names are read with string functions: the table must end with the terminator of its last name
+    if(header->strings_size == 0 || debuginfo->strings[header->strings_size - 1] != '\0' || header->source_name_offset >= header->strings_size) {
+        return false;
+    }
+    for(uint32_t i = 0; i < header->num_checkpoints; i++) {
+        if(debuginfo->checkpoints[i].row_offset >= header->rows_size) {
+            return false;
+        }
+    }
+    for(uint32_t i = 0; i < header->num_scopes; i++) {
+        if(debuginfo->scopes[i].name_offset >= header->strings_size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Map a debug file into memory and validate it
+ *
+ * @param debug_file_name
+ * @param debuginfo view of the debug file; it must be released with `debuginfo_close`
+ * @return exit_t
+ */
+exit_t debuginfo_open(const char *debug_file_name, debuginfo_t *debuginfo) {
+    int fd = open(debug_file_name, O_RDONLY);
+    if(fd == -1) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", debug_file_name);
+    }
+    struct stat file_status;
+    if(fstat(fd, &file_status) == -1 || (size_t)file_status.st_size < sizeof(debuginfo_header_t)) {
+        close(fd);
+        return failure(EXIT_FAILURE, "ERROR: Invalid debug file (%s)", debug_file_name);
+    }
+
+    void *base = mmap(NULL, file_status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(base == MAP_FAILED) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't map file (%s): %d", debug_file_name, errno);
+    }
+
+    size_t size = file_status.st_size;
+    debuginfo_t view = { .base = base, .size = size, .header = base };
+    if(!valid_debuginfo(&view)) {
+        munmap(base, size);
+        return failure(EXIT_FAILURE, "ERROR: Invalid debug file (%s)", debug_file_name);
+    }
+    *debuginfo = view;
+    return success();
+}
+
+void debuginfo_close(debuginfo_t *debuginfo) {
+    if(debuginfo->base) {
+        munmap((void *)debuginfo->base, debuginfo->size);
+        debuginfo->base = NULL;
+    }
+}
+
+/**
+ * @brief Find the source location of the word stored at the given address
+ *
+ * @return false if the address does not hold any word of the program
+ */
+bool debuginfo_lookup(const debuginfo_t *debuginfo, memaddr_t address, debuginfo_location_t *location) {
+    const debuginfo_header_t *header = debuginfo->header;
+    //last checkpoint whose address is not greater than the given one
+    uint32_t low = 0, high = header->num_checkpoints;
+    while(low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if(debuginfo->checkpoints[mid].address <= address) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    if(low == 0) {
+        return false;
+    }
+    const debuginfo_checkpoint_t *checkpoint = &debuginfo->checkpoints[low - 1];
+    uint32_t row_address = checkpoint->address, line = checkpoint->line, column = checkpoint->column;
+
+    //decode the rows following the checkpoint, the first one is the checkpoint itself
+    const unsigned char *row = debuginfo->rows + checkpoint->row_offset;
+    const unsigned char *rows_end = debuginfo->rows + header->rows_size;
+    uint32_t first_row = (low - 1) * header->checkpoint_interval;
+    decode_uleb128(&row, rows_end);
+    decode_uleb128(&row, rows_end);
+    decode_uleb128(&row, rows_end);
+    for(uint32_t i = first_row + 1; i < header->num_rows && row < rows_end; i++) {
+        const unsigned char *next_row = row;
+        uint32_t next_address = row_address + decode_uleb128(&next_row, rows_end);
+        if(next_address > address) {
+            break;
+        }
+        row_address = next_address;
+        line += zigzag_decode(decode_uleb128(&next_row, rows_end));
+        column = decode_uleb128(&next_row, rows_end);
+        row = next_row;
+    }
+    if(line == 0) {
+        return false;
+    }
+    location->line = line;
+    location->column = column;
+    return true;
+}
+
+/**
+ * @brief Label whose scope contains the given address, NULL if there is none
+ */
+const char *debuginfo_scope(const debuginfo_t *debuginfo, memaddr_t address) {
+    //last scope starting at or before the given address
+    uint32_t low = 0, high = debuginfo->header->num_scopes;
+    while(low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if(debuginfo->scopes[mid].start <= address) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    if(low == 0 || address >= debuginfo->scopes[low - 1].end) {
+        return NULL;
+    }
+    return debuginfo->strings + debuginfo->scopes[low - 1].name_offset;
+}
+
+const char *debuginfo_source_name(const debuginfo_t *debuginfo) {
+    return debuginfo->strings + debuginfo->header->source_name_offset;
+}
@@ -2,34 +2,78 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include "../include/dict.h"
+#include "../include/memtrack.h"
 
-static node_t *dict[DICTSIZE];
+static node_t *initial_dict[DICTSIZE];
+static node_t **dict = initial_dict;
+static size_t dict_size = DICTSIZE;
+static size_t num_entries = 0;
+static dict_stats_t counters;
 
 unsigned hash(const char *s) {
     unsigned hashval;
     for(hashval = 0; *s != '\0'; s++)
         hashval = *s + 31 * hashval;
-    return hashval % DICTSIZE;
+    return hashval % dict_size;
+}
+
+/**
+ * Doubles the number of elements of the array and redistributes the existing nodes.
+ * If there is no enough memory, the dictionary keeps working with longer lists
+ **/
+static void grow() {
+    size_t old_size = dict_size;
+    node_t **old_dict = dict;
+    node_t **new_dict = tracked_calloc(2 * old_size, sizeof(node_t *), MEM_SYMBOLS);
+    if(new_dict == NULL)
+        return;
+
+    dict = new_dict;
+    dict_size = 2 * old_size;
+    for(size_t i = 0; i < old_size; i++) {
+        node_t *np = old_dict[i];
+        while(np != NULL) {
+            node_t *next_np = np->next;
+            unsigned hashval = hash(np->key);
+            np->next = dict[hashval];
+            dict[hashval] = np;
+            np = next_np;
+        }
+    }
+    if(old_dict != initial_dict)
+        tracked_free(old_dict);
+    else
+        memset(initial_dict, 0, sizeof(initial_dict));
 }
 
 node_t *lookup(const char *key) {
     node_t *np;
+    uint64_t probes = 0;
 
     for(np = dict[hash(key)]; np != NULL; np = np->next) {
+        probes++;
         if(strcmp(np->key, key) == 0)
-            return np;
+            break;
     }
-    return NULL;
+    counters.lookups++;
+    counters.probes += probes;
+    return np;
 }
 
-node_t *add(const char *key, uint16_t val) {
+node_t *add(const char *key, uint32_t val) {
     node_t *np;
     unsigned hashval;
 
     if((np = lookup(key)) == NULL) {
-        np = malloc(sizeof(*np));
-        if(np == NULL || (np->key = strdup(key)) == NULL)
+        if(num_entries >= dict_size)
+            grow();
+
+        np = tracked_malloc(sizeof(*np), MEM_SYMBOLS);
+        if(np == NULL || (np->key = tracked_strdup(key, MEM_SYMBOLS)) == NULL) {
+            tracked_free(np);
             return NULL;
+        }
+        num_entries++;
 
         //adding new node to the front of the linked list
         hashval = hash(key);
@@ -57,8 +101,9 @@ bool delete(const char *key) {
             else {
                 prev->next = curr->next;
             }
-            free((void *)curr->key);
-            free((void *)curr);
+            tracked_free((void *)curr->key);
+            tracked_free((void *)curr);
+            num_entries--;
             return true;
         }
     }
@@ -69,19 +114,44 @@ bool delete(const char *key) {
 void print() {
     node_t *np;
 
-    for(size_t i = 0; i < DICTSIZE; i++) {
+    for(size_t i = 0; i < dict_size; i++) {
         int has_elements = 0;
         for(np = dict[i]; np != NULL; np = np->next) {
             has_elements = 1;
             if(np == dict[i])
                 printf("%zu ", i);
-            printf("- (%s,%hu) ", np->key, np->val);
+            printf("- (%s,%u) ", np->key, np->val);
         }
         if(has_elements)
             printf("\n");
     }
 }
 
+dict_stats_t get_dict_stats() {
+    dict_stats_t stats = counters;
+    stats.keys = num_entries;
+    stats.buckets = dict_size;
+    stats.used_buckets = 0;
+    stats.longest_chain = 0;
+    for(size_t i = 0; i < dict_size; i++) {
+        size_t chain_length = 0;
+        for(node_t *np = dict[i]; np != NULL; np = np->next) {
+            chain_length++;
+        }
+        if(chain_length) {
+            stats.used_buckets++;
+        }
+        if(chain_length > stats.longest_chain) {
+            stats.longest_chain = chain_length;
+        }
+    }
+    return stats;
+}
+
+void reset_dict_stats() {
+    memset(&counters, 0, sizeof(counters));
+}
+
 node_t *next(bool reset) {
     node_t *result = NULL;
     static size_t i = 0;
@@ -92,7 +162,7 @@ node_t *next(bool reset) {
         current = dict[0];
     }
 
-    while(current == NULL && i < DICTSIZE - 1) {
+    while(current == NULL && i < dict_size - 1) {
         i++;
         current = dict[i];
     }
@@ -110,4 +180,10 @@ void initialize() {
         delete(node->key);
         node = next(false);
     }
+    //back to the initial array so that the order of the elements does not depend on previous usage
+    if(dict != initial_dict) {
+        tracked_free(dict);
+        dict = initial_dict;
+        dict_size = DICTSIZE;
+    }
 }
@@ -40,6 +40,7 @@ exit_t parse_orig(linemetadata_t *line_metadata) {
  *
  * @param line_metadata
  * @param address_origin if `n` is a label, then `address_origin` is needed to work out the final memory address
+ * (programs with several segments take the origin of the segment containing the label instead)
  * @return exit_t
  */
 exit_t parse_fill(linemetadata_t *line_metadata, memaddr_t address_origin) {
@@ -71,7 +72,7 @@ exit_t parse_fill(linemetadata_t *line_metadata, memaddr_t address_origin) {
         if(!node) {
             return failure(EXIT_FAILURE, "ERROR (line %d): Symbol not found ('%s')", line_metadata->line_number, token);
         }
-        numeric_value = node->val - 1 + address_origin;
+        numeric_value = slot_address(node->val, address_origin);
     }
 
     //validate numeric value range
@@ -210,7 +211,7 @@ static exit_t interpret_escape_sequences(linemetadata_t *line_metadata) {
  * @param instruction_offset 
  * @return exit_t 
  */
-exit_t parse_stringz(linemetadata_t *line_metadata, linemetadata_t *tokenized_lines[], memaddr_t *instruction_offset) {
+exit_t parse_stringz(linemetadata_t *line_metadata, linemetadata_t *tokenized_lines[], size_t *instruction_offset) {
     if(line_metadata->num_tokens < 2) {
         return failure(EXIT_FAILURE, "ERROR (line %d): Bad string", line_metadata->line_number);
     }
@@ -220,27 +221,106 @@ exit_t parse_stringz(linemetadata_t *line_metadata, linemetadata_t *tokenized_li
         return result;
     }
     char *str_literal = line_metadata->tokens[1];
-    for(size_t i = 0; i < strlen(str_literal); i++) {
-        linemetadata_t *stringz_line_metadata = malloc(sizeof(linemetadata_t));
+    size_t str_literal_length = strlen(str_literal);
+    if(*instruction_offset + str_literal_length + 1 >= TOKENIZED_LINES_CAPACITY) {
+        return failure(EXIT_FAILURE, "ERROR (line %d): Program exceeds the address space", line_metadata->line_number);
+    }
+    //final '\0' included
+    for(size_t i = 0; i <= str_literal_length; i++) {
+        linemetadata_t *stringz_line_metadata = tracked_malloc(sizeof(linemetadata_t), MEM_LINES);
         if(!stringz_line_metadata) {
             return failure(EXIT_FAILURE, "ERROR (line %d): Out of memory error", line_metadata->line_number);
         }
         stringz_line_metadata->tokens = NULL;
         stringz_line_metadata->line = NULL;
-        stringz_line_metadata->machine_instruction = str_literal[i];
+        stringz_line_metadata->line_number = line_metadata->line_number;
+        stringz_line_metadata->column = line_metadata->column;
+        stringz_line_metadata->instruction_location = *instruction_offset;
+        stringz_line_metadata->machine_instruction = i < str_literal_length ? str_literal[i] : 0;
         tokenized_lines[*instruction_offset] = stringz_line_metadata;
         (*instruction_offset)++;
     }
-    //final '\0'
-    linemetadata_t *stringz_line_metadata = malloc(sizeof(linemetadata_t));
-    if(!stringz_line_metadata) {
-        return failure(EXIT_FAILURE, "ERROR (line %d): Out of memory error", line_metadata->line_number);
+
+    return success();
+}
+
+/**
+ * @brief parse .STRINGP directive
+ *
+ * The characters of the operand of .STRINGP are packed two per word, in the layout expected by the PUTSP trap:
+ * the first character in bits [7:0] and the second one in bits [15:8]. If the string has an odd number of characters,
+ * bits [15:8] of the last word are x00. The string is terminated by a x0000 word.
+ *
+ * Therefore the directive is expanded into ⌈n/2⌉ + 1 words, where n is the length of the corresponding string.
+ *
+ * Unlike .STRINGZ, the directive line is kept in the slot of the first word, so that the memory saved
+ * with respect to .STRINGZ can be reported afterwards (see `report_stringp_savings`).
+ *
+ * @param line_metadata
+ * @param tokenized_lines
+ * @param instruction_offset
+ * @return exit_t
+ */
+exit_t parse_stringp(linemetadata_t *line_metadata, linemetadata_t *tokenized_lines[], size_t *instruction_offset) {
+    if(line_metadata->num_tokens < 2) {
+        return failure(EXIT_FAILURE, "ERROR (line %d): Bad string", line_metadata->line_number);
+    }
+
+    exit_t result = interpret_escape_sequences(line_metadata);
+    if(result.code) {
+        return result;
+    }
+    unsigned char *str_literal = (unsigned char *)line_metadata->tokens[1];
+    size_t str_literal_length = strlen(line_metadata->tokens[1]);
+    size_t num_words = (str_literal_length + 1) / 2 + 1;
+    if(*instruction_offset + num_words >= TOKENIZED_LINES_CAPACITY) {
+        return failure(EXIT_FAILURE, "ERROR (line %d): Program exceeds the address space", line_metadata->line_number);
+    }
+    //final x0000 included
+    for(size_t i = 0; i < num_words; i++) {
+        linemetadata_t *stringp_line_metadata = line_metadata;
+        if(i > 0) {
+            stringp_line_metadata = tracked_malloc(sizeof(linemetadata_t), MEM_LINES);
+            if(!stringp_line_metadata) {
+                return failure(EXIT_FAILURE, "ERROR (line %d): Out of memory error", line_metadata->line_number);
+            }
+            stringp_line_metadata->tokens = NULL;
+            stringp_line_metadata->line = NULL;
+            stringp_line_metadata->line_number = line_metadata->line_number;
+            stringp_line_metadata->column = line_metadata->column;
+        }
+        uint16_t low_byte = 2 * i < str_literal_length ? str_literal[2 * i] : 0;
+        uint16_t high_byte = 2 * i + 1 < str_literal_length ? str_literal[2 * i + 1] : 0;
+        stringp_line_metadata->instruction_location = *instruction_offset;
+        stringp_line_metadata->machine_instruction = high_byte << 8 | low_byte;
+        tokenized_lines[*instruction_offset] = stringp_line_metadata;
+        (*instruction_offset)++;
     }
-    stringz_line_metadata->tokens = NULL;
-    stringz_line_metadata->line = NULL;
-    stringz_line_metadata->machine_instruction = 0;
-    tokenized_lines[*instruction_offset] = stringz_line_metadata;
-    (*instruction_offset)++;
 
     return success();
 }
+
+/**
+ * @brief Report the number of words saved by each .STRINGP directive with respect to the equivalent .STRINGZ
+ *
+ * @param tokenized_lines
+ * @param report
+ */
+void report_stringp_savings(linemetadata_t *tokenized_lines[], FILE *report) {
+    size_t total_packed_words = 0, total_unpacked_words = 0;
+    linemetadata_t *line_metadata;
+    for(size_t slot = 0; (line_metadata = tokenized_lines[slot]); slot++) {
+        if(!line_metadata->tokens || compute_line_type(line_metadata->tokens[0]) != STRINGP_DIRECTIVE) {
+            continue;
+        }
+        //escape sequences have already been interpreted
+        size_t str_literal_length = strlen(line_metadata->tokens[1]);
+        size_t packed_words = (str_literal_length + 1) / 2 + 1;
+        size_t unpacked_words = str_literal_length + 1;
+        fprintf(report, "stringp (line %d): %zu characters in %zu words instead of %zu, %zu words saved\n",
+            line_metadata->line_number, str_literal_length, packed_words, unpacked_words, unpacked_words - packed_words);
+        total_packed_words += packed_words;
+        total_unpacked_words += unpacked_words;
+    }
+    fprintf(report, "stringp: %zu words instead of %zu, %zu words saved\n", total_packed_words, total_unpacked_words, total_unpacked_words - total_packed_words);
+}
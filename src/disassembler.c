@@ -0,0 +1,267 @@
+/**
+ * @file disassembler.c
+ * @brief Table-driven disassembler of LC3 words, shared by lc3objdump and lc3objdiff
+ * @version 0.1
+ * @date 2026-10-19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/disassembler.h"
+
+#define LABEL_COLUMN_WIDTH 16
+#define DECODED_TEXT_SIZE 16
+
+/*
+    Every possible word is decoded once into its text (decode_table), so disassembling a word is a lookup and a
+    copy. The text of PC-relative instructions stops before their target, which depends on the address of the word
+    and is appended when the word is disassembled.
+*/
+typedef struct {
+    char text[DECODED_TEXT_SIZE];
+    uint8_t length;
+    bool pc_relative;
+    int16_t offset; /**< offset of the target with respect to the incremented PC */
+} decoded_word_t;
+
+static decoded_word_t decode_table[ADDRESS_SPACE_SIZE];
+static const char hex_digits[] = "0123456789ABCDEF";
+static const char *br_mnemonics[8] = { NULL, "BRp", "BRz", "BRzp", "BRn", "BRnp", "BRnz", "BRnzp" };
+static const char *trap_aliases[] = { "GETC", "OUT", "PUTS", "IN", "PUTSP", "HALT" };
+#define FIRST_TRAP_ALIAS 0x20
+
+static int sign_extend(uint16_t value, int num_bits) {
+    int sign_bit = 1 << (num_bits - 1);
+    value &= (1 << num_bits) - 1;
+    return (value ^ sign_bit) - sign_bit;
+}
+
+static void decode_fill(uint16_t word, decoded_word_t *decoded) {
+    snprintf(decoded->text, DECODED_TEXT_SIZE, ".FILL x%04X", word);
+}
+
+static void decode_br(uint16_t word, decoded_word_t *decoded) {
+    int condition_codes = (word >> 9) & 7;
+    if(!condition_codes) {
+        decode_fill(word, decoded);
+        return;
+    }
+    snprintf(decoded->text, DECODED_TEXT_SIZE, "%s ", br_mnemonics[condition_codes]);
+    decoded->pc_relative = true;
+    decoded->offset = sign_extend(word, 9);
+}
+
+static void decode_operate(uint16_t word, decoded_word_t *decoded) {
+    const char *mnemonic = word >> 12 == 1 ? "ADD" : "AND";
+    int dr = (word >> 9) & 7, sr1 = (word >> 6) & 7;
+    if(word & 0x20) {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, "%s R%d,R%d,#%d", mnemonic, dr, sr1, sign_extend(word, 5));
+    }
+    else if(word & 0x18) {
+        decode_fill(word, decoded);
+    }
+    else {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, "%s R%d,R%d,R%d", mnemonic, dr, sr1, word & 7);
+    }
+}
+
+static void decode_pc_relative(uint16_t word, decoded_word_t *decoded) {
+    static const char *mnemonics[16] = { [2] = "LD", [3] = "ST", [10] = "LDI", [11] = "STI", [14] = "LEA" };
+    snprintf(decoded->text, DECODED_TEXT_SIZE, "%s R%d,", mnemonics[word >> 12], (word >> 9) & 7);
+    decoded->pc_relative = true;
+    decoded->offset = sign_extend(word, 9);
+}
+
+static void decode_jsr(uint16_t word, decoded_word_t *decoded) {
+    if(word & 0x800) {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, "JSR ");
+        decoded->pc_relative = true;
+        decoded->offset = sign_extend(word, 11);
+    }
+    else if(word & 0x63f) {
+        decode_fill(word, decoded);
+    }
+    else {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, "JSRR R%d", (word >> 6) & 7);
+    }
+}
+
+static void decode_base_offset(uint16_t word, decoded_word_t *decoded) {
+    snprintf(decoded->text, DECODED_TEXT_SIZE, "%s R%d,R%d,#%d", word >> 12 == 6 ? "LDR" : "STR", (word >> 9) & 7, (word >> 6) & 7,
+             sign_extend(word, 6));
+}
+
+static void decode_rti(uint16_t word, decoded_word_t *decoded) {
+    if(word & 0xfff) {
+        decode_fill(word, decoded);
+        return;
+    }
+    snprintf(decoded->text, DECODED_TEXT_SIZE, "RTI");
+}
+
+static void decode_not(uint16_t word, decoded_word_t *decoded) {
+    if((word & 0x3f) != 0x3f) {
+        decode_fill(word, decoded);
+        return;
+    }
+    snprintf(decoded->text, DECODED_TEXT_SIZE, "NOT R%d,R%d", (word >> 9) & 7, (word >> 6) & 7);
+}
+
+static void decode_jmp(uint16_t word, decoded_word_t *decoded) {
+    int base_register = (word >> 6) & 7;
+    bool privileged = (word & 0x3f) == 1; //JMPT and RTT
+    if((word & 0xe00) || ((word & 0x3f) && !privileged)) {
+        decode_fill(word, decoded);
+    }
+    else if(base_register == 7) {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, privileged ? "RTT" : "RET");
+    }
+    else {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, "%s R%d", privileged ? "JMPT" : "JMP", base_register);
+    }
+}
+
+static void decode_trap(uint16_t word, decoded_word_t *decoded) {
+    int vector = word & 0xff;
+    if(word & 0xf00) {
+        decode_fill(word, decoded);
+    }
+    else if(vector >= FIRST_TRAP_ALIAS && vector < FIRST_TRAP_ALIAS + (int)(sizeof(trap_aliases) / sizeof(trap_aliases[0]))) {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, "%s", trap_aliases[vector - FIRST_TRAP_ALIAS]);
+    }
+    else {
+        snprintf(decoded->text, DECODED_TEXT_SIZE, "TRAP x%02X", vector);
+    }
+}
+
+/**
+ * @brief Decode every possible word; must be called before disassembling, further calls do nothing
+ */
+void build_decode_table() {
+    static bool built = false;
+    if(built) {
+        return;
+    }
+    built = true;
+    //decoder of each opcode (bits [15:12]); opcode 1101 is reserved
+    static void (*const decoders[16])(uint16_t, decoded_word_t *) = {
+        decode_br, decode_operate, decode_pc_relative, decode_pc_relative, decode_jsr, decode_operate, decode_base_offset,
+        decode_base_offset, decode_rti, decode_not, decode_pc_relative, decode_pc_relative, decode_jmp, decode_fill,
+        decode_pc_relative, decode_trap
+    };
+    for(int word = 0; word < ADDRESS_SPACE_SIZE; word++) {
+        decoded_word_t *decoded = &decode_table[word];
+        memset(decoded, 0, sizeof(*decoded));
+        decoders[word >> 12](word, decoded);
+        decoded->length = strlen(decoded->text);
+    }
+}
+
+static char *append_hex_word(char *next, uint16_t word) {
+    next[0] = hex_digits[word >> 12];
+    next[1] = hex_digits[(word >> 8) & 0xf];
+    next[2] = hex_digits[(word >> 4) & 0xf];
+    next[3] = hex_digits[word & 0xf];
+    return next + 4;
+}
+
+static char *append_string(char *next, const char *str) {
+    size_t length = strlen(str);
+    memcpy(next, str, length);
+    return next + length;
+}
+
+/**
+ * @brief Write the instruction encoded by `word` at `address`, without a new line
+ *
+ * @param output buffer of at least MAX_DISASSEMBLED_LINE characters
+ * @return size_t number of characters written to `output`
+ */
+size_t disassemble_instruction(uint16_t word, uint16_t address, const char *const symbols[], char *output) {
+    const decoded_word_t *decoded = &decode_table[word];
+    char *next = output;
+    memcpy(next, decoded->text, decoded->length);
+    next += decoded->length;
+    if(decoded->pc_relative) {
+        uint16_t target = address + 1 + decoded->offset;
+        if(symbols[target]) {
+            next = append_string(next, symbols[target]);
+        }
+        else {
+            next += sprintf(next, "#%d", decoded->offset);
+        }
+    }
+    return next - output;
+}
+
+/**
+ * @brief Disassemble consecutive words stored from address `origin`, see disassembler.h
+ *
+ * @param output buffer of at least num_words * MAX_DISASSEMBLED_LINE characters
+ * @return size_t number of characters written to `output`
+ */
+size_t disassemble_words(const uint16_t words[], size_t num_words, uint16_t origin, const char *const symbols[], char *output) {
+    char *next = output;
+    for(size_t i = 0; i < num_words; i++) {
+        uint16_t address = origin + i;
+        *next++ = 'x';
+        next = append_hex_word(next, address);
+        *next++ = ' ';
+        *next++ = ' ';
+        next = append_hex_word(next, words[i]);
+        *next++ = ' ';
+        *next++ = ' ';
+        const char *label = symbols[address] ? symbols[address] : "";
+        char *label_start = next;
+        next = append_string(next, label);
+        while(next - label_start < LABEL_COLUMN_WIDTH) {
+            *next++ = ' ';
+        }
+        *next++ = ' ';
+        next += disassemble_instruction(words[i], address, symbols, next);
+        *next++ = '\n';
+    }
+    return next - output;
+}
+
+/**
+ * @brief Read the labels of a symbol table written by the assembler, indexed by their address
+ *
+ * @return char* storage of the names, to be released by the caller; NULL if there is no symbol table
+ */
+char *load_symbol_table(const char *symbol_file_name, const char *symbols[]) {
+    FILE *symbol_file = fopen(symbol_file_name, "r");
+    if(!symbol_file) {
+        return NULL;
+    }
+    size_t capacity = 4096, size = 0;
+    char *names = malloc(capacity);
+    char line[2 * MAX_SYMBOL_LENGTH];
+    //addresses first, as names may be moved when their storage grows
+    static size_t name_offsets[ADDRESS_SPACE_SIZE];
+    static bool defined[ADDRESS_SPACE_SIZE];
+    memset(defined, 0, sizeof(defined));
+    char name[MAX_SYMBOL_LENGTH + 1];
+    unsigned int address;
+    while(fgets(line, sizeof(line), symbol_file)) {
+        //header lines do not match: "//\tSymbol Name       Page Address"
+        if(sscanf(line, "//\t%255s %x", name, &address) != 2 || address >= ADDRESS_SPACE_SIZE || defined[address]) {
+            continue;
+        }
+        size_t length = strlen(name) + 1;
+        if(size + length > capacity) {
+            capacity *= 2;
+            names = realloc(names, capacity);
+        }
+        memcpy(names + size, name, length);
+        name_offsets[address] = size;
+        defined[address] = true;
+        size += length;
+    }
+    fclose(symbol_file);
+    for(int i = 0; i < ADDRESS_SPACE_SIZE; i++) {
+        symbols[i] = defined[i] ? names + name_offsets[i] : NULL;
+    }
+    return names;
+}
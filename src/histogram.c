@@ -0,0 +1,110 @@
+/**
+ * @file histogram.c
+ * @brief Latency histograms with a bounded relative error (--latency)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * With S = HISTOGRAM_SUB_BUCKETS, values below S have a bucket each. A larger value whose highest bit is the bit b
+ * is shifted right by m = b - log2(S) + 1 bits, which leaves a number between S/2 and S - 1: the bucket of the
+ * value is m * S/2 plus that number, and it covers 2^m values. This is the layout of HdrHistogram with a single
+ * array of counts.
+ */
+
+#include <string.h>
+#include "../include/histogram.h"
+
+#define HISTOGRAM_MAX_VALUE ((UINT64_C(1) << HISTOGRAM_MAX_BITS) - 1)
+
+void histogram_init(histogram_t *histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->min = UINT64_MAX;
+}
+
+static int highest_bit(uint64_t value) {
+    int bit = 0;
+    while(value >>= 1) {
+        bit++;
+    }
+    return bit;
+}
+
+static int bucket_index(uint64_t value) {
+    if(value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+    int shift = highest_bit(value) - HISTOGRAM_SUB_BUCKET_BITS + 1;
+    return shift * (HISTOGRAM_SUB_BUCKETS / 2) + (int)(value >> shift);
+}
+
+/**
+ * @brief Largest value recorded in the given bucket
+ */
+static uint64_t bucket_highest_value(int index) {
+    if(index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+    int shift = index / (HISTOGRAM_SUB_BUCKETS / 2) - 1;
+    uint64_t sub_bucket = index - shift * (HISTOGRAM_SUB_BUCKETS / 2);
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void histogram_record(histogram_t *histogram, uint64_t value) {
+    if(value < histogram->min) {
+        histogram->min = value;
+    }
+    if(value > histogram->max) {
+        histogram->max = value;
+    }
+    histogram->counts[bucket_index(value > HISTOGRAM_MAX_VALUE ? HISTOGRAM_MAX_VALUE : value)]++;
+    histogram->total_count++;
+}
+
+/**
+ * @brief Add the values recorded in `other` to `histogram`
+ */
+void histogram_merge(histogram_t *histogram, const histogram_t *other) {
+    for(int i = 0; i < HISTOGRAM_NUM_BUCKETS; i++) {
+        histogram->counts[i] += other->counts[i];
+    }
+    histogram->total_count += other->total_count;
+    if(other->min < histogram->min) {
+        histogram->min = other->min;
+    }
+    if(other->max > histogram->max) {
+        histogram->max = other->max;
+    }
+}
+
+/**
+ * @brief Smallest value such that `percentile` percent of the values recorded are lower or equal (nearest rank)
+ *
+ * The value is the highest one of its bucket, capped to the largest value recorded; 0 if the histogram is empty
+ */
+uint64_t histogram_percentile(const histogram_t *histogram, double percentile) {
+    if(histogram->total_count == 0) {
+        return 0;
+    }
+    double exact_rank = percentile / 100 * histogram->total_count;
+    uint64_t rank = (uint64_t)exact_rank;
+    if(rank < exact_rank) {
+        rank++;
+    }
+    if(rank < 1) {
+        rank = 1;
+    }
+    if(rank > histogram->total_count) {
+        rank = histogram->total_count;
+    }
+    uint64_t count = 0;
+    for(int i = 0; i < HISTOGRAM_NUM_BUCKETS; i++) {
+        count += histogram->counts[i];
+        if(count >= rank) {
+            uint64_t value = bucket_highest_value(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
@@ -0,0 +1,757 @@
+/**
+ * @file jit.c
+ * @brief Basic-block JIT compiler from LC-3 to x86-64 (lc3vm --jit)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * Translated code keeps the machine in x86-64 registers: R0-R7 in r8-r15 (only their low 16 bits are
+ * significant), the value the condition codes describe in bx, the instructions it may still run in rsi, the
+ * vm_t in rdi (its memory is at offset 0, so the word at address A is [rdi + A*2]) and the jit_frame_t in rbp.
+ * The entry code, at the start of the buffer, loads them from vm_t and the frame and jumps to a block; the exit
+ * code stores them back and returns to jit_run.
+ *
+ * A block first subtracts its number of instructions from rsi and leaves to the interpreter if it would run
+ * more instructions than allowed. Any instruction that needs the interpreter (a device register, an access the
+ * MPR denies, a store into a decoded instruction) leaves through a side exit that gives back the instructions
+ * not run, so the interpreter runs it as if the block had stopped just before it. Blocks end with a branch,
+ * whose exits are either a jump to the translated target or, until the target is translated, a stub that
+ * leaves to jit_run and that is patched into a jump (jit_link_t) when the target is translated. JMP and JSRR
+ * look the target up in `entries`, so returns from subroutines stay in translated code.
+ *
+ * Instructions are translated from their decoded form (vm_decoded_instruction), whose PC-relative addresses are
+ * already computed.
+ */
+
+#define _DEFAULT_SOURCE // MAP_ANON
+#include <stddef.h>
+#include <sys/mman.h>
+#include "../include/jit.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define JIT_SUPPORTED
+#endif
+
+#define NEVER_TRANSLATED UINT16_MAX
+#define MAX_BLOCK_CODE (JIT_MAX_BLOCK_INSTRUCTIONS * 128 + 256) // bytes of the largest block
+#define PAGE_BITS 12
+#define ALL_PAGES 0xFFFF
+#define CONDITION_CODES (VM_PSR_N | VM_PSR_Z | VM_PSR_P)
+
+typedef enum {
+    EXIT_BRANCH, /**< to an address without translated block */
+    EXIT_INTERPRET /**< to an instruction that the interpreter must run */
+} exit_reason_t;
+
+/**
+ * @brief State shared by jit_run and translated code
+ */
+typedef struct {
+    int64_t budget; /**< instructions that may still be run */
+    uint32_t exit_pc;
+    uint32_t exit_reason;
+    uint32_t access; /**< pages that the program can access */
+    uint16_t result; /**< value that the condition codes describe */
+} jit_frame_t;
+
+typedef void (*entry_code_t)(vm_t *vm, jit_frame_t *frame, const unsigned char *block);
+
+_Static_assert(offsetof(vm_t, memory) == 0, "translated code addresses memory from the vm_t");
+_Static_assert(sizeof(vm_decoded_t) == 6 && offsetof(vm_decoded_t, handler) == 0,
+               "translated stores check the handler of decoded words");
+
+static bool is_translatable(const vm_decoded_t *decoded) {
+    switch(decoded->handler) {
+    case VM_DO_LD:
+    case VM_DO_ST:
+    case VM_DO_LDI:
+    case VM_DO_STI: //devices are left to the interpreter
+        return decoded->operand < VM_DEVICES_START;
+    case VM_DO_DECODE:
+    case VM_DO_RTI:
+    case VM_DO_JMPT:
+    case VM_DO_RESERVED:
+    case VM_DO_TRAP:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static bool ends_block(const vm_decoded_t *decoded) {
+    switch(decoded->handler) {
+    case VM_DO_BR:
+    case VM_DO_BR_ALWAYS:
+    case VM_DO_JSR:
+    case VM_DO_JSRR:
+    case VM_DO_JMP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Instructions of the block that starts at `start` that can be translated
+ *
+ * The block ends with its first branch, before its first instruction that cannot be translated, or after
+ * JIT_MAX_BLOCK_INSTRUCTIONS instructions. Returns 0 if the first instruction cannot be translated.
+ */
+static int block_extent(vm_t *vm, uint16_t start, const vm_decoded_t *instructions[]) {
+    int num_instructions = 0;
+    for(uint32_t address = start; num_instructions < JIT_MAX_BLOCK_INSTRUCTIONS && address < VM_DEVICES_START; address++) {
+        const vm_decoded_t *decoded = vm_decoded_instruction(vm, address);
+        if(!is_translatable(decoded)) {
+            break;
+        }
+        instructions[num_instructions++] = decoded;
+        if(ends_block(decoded)) {
+            break;
+        }
+    }
+    return num_instructions;
+}
+
+static int16_t condition_codes_value(uint16_t psr) {
+    return psr & VM_PSR_N ? -1 : psr & VM_PSR_Z ? 0 : 1;
+}
+
+static uint16_t condition_codes(int16_t value) {
+    return value < 0 ? VM_PSR_N : value == 0 ? VM_PSR_Z : VM_PSR_P;
+}
+
+#ifdef JIT_SUPPORTED
+
+/*
+    x86-64 encoding
+*/
+
+typedef enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8 } x86_register_t;
+#define LC3_REGISTER(r) (R8 + (r))
+
+typedef enum { CC_B = 2, CC_AE = 3, CC_E = 4, CC_NE = 5, CC_S = 8, CC_NS = 9, CC_L = 0xC, CC_LE = 0xE, CC_G = 0xF } x86_condition_t;
+
+typedef enum { ALU_ADD = 0x01, ALU_AND = 0x21, ALU_MOV = 0x89 } x86_alu_t; // opcodes of op r/m32, r32
+
+#define MODRM(mod, reg, rm) ((mod) << 6 | ((reg) & 7) << 3 | ((rm) & 7))
+#define SIB_RDI_RAX_2 0x47 // [rdi + rax*2]
+#define SIB_RDI_RCX_2 0x4F // [rdi + rcx*2]
+#define FRAME_FIELD(field) ((uint8_t)offsetof(jit_frame_t, field))
+#define VM_FIELD(field) ((uint32_t)offsetof(vm_t, field))
+
+typedef struct {
+    unsigned char *p;
+    struct {
+        unsigned char *rel32;
+        int instruction;
+    } side_exits[JIT_MAX_BLOCK_INSTRUCTIONS * 4 + 1]; //STI has 4, the block 1 more for its budget
+    int num_side_exits;
+} emitter_t;
+
+static void emit8(emitter_t *e, uint8_t byte) {
+    *e->p++ = byte;
+}
+
+static void emit32(emitter_t *e, uint32_t value) {
+    memcpy(e->p, &value, sizeof(value));
+    e->p += sizeof(value);
+}
+
+static void emit64(emitter_t *e, uint64_t value) {
+    memcpy(e->p, &value, sizeof(value));
+    e->p += sizeof(value);
+}
+
+static void patch_rel32(unsigned char *rel32, const unsigned char *target) {
+    int32_t offset = (int32_t)(target - (rel32 + 4));
+    memcpy(rel32, &offset, sizeof(offset));
+}
+
+static void emit_rex(emitter_t *e, bool wide, int reg, int rm) {
+    uint8_t rex = 0x40 | wide << 3 | (reg >= 8) << 2 | (rm >= 8);
+    if(rex != 0x40) {
+        emit8(e, rex);
+    }
+}
+
+/**
+ * @brief op rm, reg (32 bits)
+ */
+static void emit_alu(emitter_t *e, x86_alu_t opcode, int rm, int reg) {
+    emit_rex(e, false, reg, rm);
+    emit8(e, opcode);
+    emit8(e, MODRM(3, reg, rm));
+}
+
+/**
+ * @brief op rm, imm (32 bits, ALU_ADD or ALU_AND)
+ */
+static void emit_alu_immediate(emitter_t *e, x86_alu_t opcode, int rm, int32_t immediate) {
+    int extension = opcode == ALU_ADD ? 0 : 4;
+    emit_rex(e, false, 0, rm);
+    if(immediate >= INT8_MIN && immediate <= INT8_MAX) {
+        emit8(e, 0x83);
+        emit8(e, MODRM(3, extension, rm));
+        emit8(e, (uint8_t)immediate);
+    }
+    else {
+        emit8(e, 0x81);
+        emit8(e, MODRM(3, extension, rm));
+        emit32(e, immediate);
+    }
+}
+
+static void emit_mov_immediate(emitter_t *e, int reg, uint32_t immediate) {
+    emit_rex(e, false, 0, reg);
+    emit8(e, 0xB8 + (reg & 7));
+    emit32(e, immediate);
+}
+
+static void emit_not(emitter_t *e, int reg) {
+    emit_rex(e, false, 0, reg);
+    emit8(e, 0xF7);
+    emit8(e, MODRM(3, 2, reg));
+}
+
+/**
+ * @brief movzx eax, ax
+ */
+static void emit_zero_extend_eax(emitter_t *e) {
+    emit8(e, 0x0F);
+    emit8(e, 0xB7);
+    emit8(e, MODRM(3, RAX, RAX));
+}
+
+/**
+ * @brief movzx reg, word [rdi + disp32]
+ */
+static void emit_load_vm_word(emitter_t *e, int reg, uint32_t displacement) {
+    emit_rex(e, false, reg, 0);
+    emit8(e, 0x0F);
+    emit8(e, 0xB7);
+    emit8(e, MODRM(2, reg, RDI));
+    emit32(e, displacement);
+}
+
+/**
+ * @brief mov word [rdi + disp32], reg
+ */
+static void emit_store_vm_word(emitter_t *e, int reg, uint32_t displacement) {
+    emit8(e, 0x66);
+    emit_rex(e, false, reg, 0);
+    emit8(e, 0x89);
+    emit8(e, MODRM(2, reg, RDI));
+    emit32(e, displacement);
+}
+
+/**
+ * @brief movzx reg, word [rdi + rax*2]
+ */
+static void emit_load_memory(emitter_t *e, int reg) {
+    emit_rex(e, false, reg, 0);
+    emit8(e, 0x0F);
+    emit8(e, 0xB7);
+    emit8(e, MODRM(0, reg, RSP)); //a SIB byte follows
+    emit8(e, SIB_RDI_RAX_2);
+}
+
+/**
+ * @brief mov word [rdi + rax*2], reg
+ */
+static void emit_store_memory(emitter_t *e, int reg) {
+    emit8(e, 0x66);
+    emit_rex(e, false, reg, 0);
+    emit8(e, 0x89);
+    emit8(e, MODRM(0, reg, RSP));
+    emit8(e, SIB_RDI_RAX_2);
+}
+
+/**
+ * @brief mov dword [rbp + field], immediate
+ */
+static void emit_store_frame_immediate(emitter_t *e, uint8_t field, uint32_t immediate) {
+    emit8(e, 0xC7);
+    emit8(e, MODRM(1, 0, RBP));
+    emit8(e, field);
+    emit32(e, immediate);
+}
+
+static void emit_jump(emitter_t *e, const unsigned char *target) {
+    emit8(e, 0xE9);
+    emit32(e, 0);
+    patch_rel32(e->p - 4, target);
+}
+
+/**
+ * @brief Conditional jump whose target is patched later; returns the address of its rel32
+ */
+static unsigned char *emit_jcc(emitter_t *e, x86_condition_t condition) {
+    emit8(e, 0x0F);
+    emit8(e, 0x80 + condition);
+    emit32(e, 0);
+    return e->p - 4;
+}
+
+/**
+ * @brief Conditional jump to the side exit of instruction `instruction` of the block
+ */
+static void emit_side_exit_jcc(emitter_t *e, x86_condition_t condition, int instruction) {
+    e->side_exits[e->num_side_exits].rel32 = emit_jcc(e, condition);
+    e->side_exits[e->num_side_exits].instruction = instruction;
+    e->num_side_exits++;
+}
+
+/**
+ * @brief Set bx, whose sign gives the condition codes, to the value written to `reg`
+ */
+static void emit_set_result(emitter_t *e, int reg) {
+    emit_alu(e, ALU_MOV, RBX, reg);
+}
+
+/*
+    Translation
+*/
+
+static void add_link(jit_t *jit, uint16_t target, const unsigned char *stub) {
+    if(jit->num_links == jit->links_capacity) {
+        jit->links_capacity = jit->links_capacity ? 2 * jit->links_capacity : 1024;
+        jit->links = realloc(jit->links, jit->links_capacity * sizeof(jit_link_t));
+        if(!jit->links) {
+            error_exit("failure to allocate memory", "");
+        }
+    }
+    jit->links[jit->num_links++] = (jit_link_t){ target, (uint32_t)(stub - jit->code) };
+}
+
+/**
+ * @brief Patch the exits that wait for the block at `target` into jumps to it
+ */
+static void resolve_links(jit_t *jit, uint16_t target) {
+    for(size_t i = 0; i < jit->num_links;) {
+        if(jit->links[i].target != target) {
+            i++;
+            continue;
+        }
+        emitter_t patch = { .p = jit->code + jit->links[i].stub };
+        emit_jump(&patch, jit->entries[target]);
+        jit->links[i] = jit->links[--jit->num_links];
+    }
+}
+
+/**
+ * @brief Leave the block for `target`: jump to its translation, or to jit_run until it is translated
+ */
+static void emit_exit_to(jit_t *jit, emitter_t *e, uint16_t target) {
+    if(jit->entries[target] && !jit->step) {
+        emit_jump(e, jit->entries[target]);
+        return;
+    }
+    if(!jit->step) {
+        add_link(jit, target, e->p);
+    }
+    emit_store_frame_immediate(e, FRAME_FIELD(exit_pc), target);
+    emit_jump(e, jit->code + jit->exit_branch);
+}
+
+/**
+ * @brief Leave the block for the address in eax, looked up in `entries`
+ */
+static void emit_indirect_exit(jit_t *jit, emitter_t *e) {
+    emit_zero_extend_eax(e);
+    unsigned char *not_translated = NULL;
+    if(!jit->step) {
+        emit8(e, 0x48); //mov rdx, entries
+        emit8(e, 0xBA);
+        emit64(e, (uint64_t)(uintptr_t)jit->entries);
+        emit8(e, 0x48); //mov rdx, [rdx + rax*8]
+        emit8(e, 0x8B);
+        emit8(e, MODRM(0, RDX, RSP));
+        emit8(e, 3 << 6 | RAX << 3 | RDX);
+        emit8(e, 0x48); //test rdx, rdx
+        emit8(e, 0x85);
+        emit8(e, MODRM(3, RDX, RDX));
+        not_translated = emit_jcc(e, CC_E);
+        emit8(e, 0xFF); //jmp rdx
+        emit8(e, MODRM(3, 4, RDX));
+        patch_rel32(not_translated, e->p);
+    }
+    emit8(e, 0x89); //mov [rbp + exit_pc], eax
+    emit8(e, MODRM(1, RAX, RBP));
+    emit8(e, FRAME_FIELD(exit_pc));
+    emit_jump(e, jit->code + jit->exit_branch);
+}
+
+/**
+ * @brief Leave the block if the program cannot access the page of the constant `address`
+ */
+static void emit_static_access_check(emitter_t *e, uint16_t address, int instruction) {
+    emit8(e, 0xF7); //test dword [rbp + access], page bit
+    emit8(e, MODRM(1, 0, RBP));
+    emit8(e, FRAME_FIELD(access));
+    emit32(e, 1u << (address >> PAGE_BITS));
+    emit_side_exit_jcc(e, CC_E, instruction);
+}
+
+/**
+ * @brief Leave the block if the address in eax is a device register or the program cannot access its page, or,
+ * for a store, if it holds a decoded instruction
+ */
+static void emit_dynamic_access_check(emitter_t *e, bool store, int instruction) {
+    emit8(e, 0x3D); //cmp eax, VM_DEVICES_START
+    emit32(e, VM_DEVICES_START);
+    emit_side_exit_jcc(e, CC_AE, instruction);
+    emit_alu(e, ALU_MOV, RCX, RAX);
+    emit8(e, 0xC1); //shr ecx, PAGE_BITS
+    emit8(e, MODRM(3, 5, RCX));
+    emit8(e, PAGE_BITS);
+    emit8(e, 0x8B); //mov edx, [rbp + access]
+    emit8(e, MODRM(1, RDX, RBP));
+    emit8(e, FRAME_FIELD(access));
+    emit8(e, 0x0F); //bt edx, ecx
+    emit8(e, 0xA3);
+    emit8(e, MODRM(3, RCX, RDX));
+    emit_side_exit_jcc(e, CC_AE, instruction); //CF clear
+    if(store) {
+        emit8(e, 0x8D); //lea ecx, [rax + rax*2]
+        emit8(e, MODRM(0, RCX, RSP));
+        emit8(e, 1 << 6 | RAX << 3 | RAX);
+        emit8(e, 0x80); //cmp byte [rdi + rcx*2 + decoded], VM_DO_DECODE
+        emit8(e, MODRM(2, 7, RSP));
+        emit8(e, SIB_RDI_RCX_2);
+        emit32(e, VM_FIELD(decoded));
+        emit8(e, VM_DO_DECODE);
+        emit_side_exit_jcc(e, CC_NE, instruction);
+    }
+}
+
+/**
+ * @brief Leave the block if the constant `address` holds a decoded instruction
+ */
+static void emit_static_code_check(emitter_t *e, uint16_t address, int instruction) {
+    emit8(e, 0x80); //cmp byte [rdi + decoded + address*6], VM_DO_DECODE
+    emit8(e, MODRM(2, 7, RDI));
+    emit32(e, VM_FIELD(decoded) + address * sizeof(vm_decoded_t));
+    emit8(e, VM_DO_DECODE);
+    emit_side_exit_jcc(e, CC_NE, instruction);
+}
+
+/**
+ * @brief eax = R[base] + offset (16 bits)
+ */
+static void emit_base_plus_offset(emitter_t *e, const vm_decoded_t *decoded) {
+    emit_alu(e, ALU_MOV, RAX, LC3_REGISTER(decoded->sr1));
+    emit_alu_immediate(e, ALU_ADD, RAX, (int16_t)decoded->operand);
+    emit_zero_extend_eax(e);
+}
+
+static void emit_branch(jit_t *jit, emitter_t *e, const vm_decoded_t *decoded, uint16_t next_pc) {
+    static const x86_condition_t taken[8] = { 0, CC_G, CC_E, CC_NS, CC_S, CC_NE, CC_LE, 0 }; //by nzp
+    emit8(e, 0x66); //test bx, bx
+    emit8(e, 0x85);
+    emit8(e, MODRM(3, RBX, RBX));
+    unsigned char *taken_exit = emit_jcc(e, taken[decoded->dr]);
+    emit_exit_to(jit, e, next_pc);
+    patch_rel32(taken_exit, e->p);
+    emit_exit_to(jit, e, decoded->operand);
+}
+
+static void emit_instruction(jit_t *jit, emitter_t *e, const vm_decoded_t *decoded, uint16_t address, int instruction) {
+    int dr = LC3_REGISTER(decoded->dr);
+    uint16_t next_pc = address + 1;
+    switch(decoded->handler) {
+    case VM_DO_ADD_REGISTER:
+    case VM_DO_AND_REGISTER:
+        emit_alu(e, ALU_MOV, RAX, LC3_REGISTER(decoded->sr1));
+        emit_alu(e, decoded->handler == VM_DO_ADD_REGISTER ? ALU_ADD : ALU_AND, RAX, LC3_REGISTER(decoded->sr2));
+        emit_alu(e, ALU_MOV, dr, RAX);
+        emit_set_result(e, RAX);
+        break;
+    case VM_DO_ADD_IMMEDIATE:
+    case VM_DO_AND_IMMEDIATE:
+        emit_alu(e, ALU_MOV, RAX, LC3_REGISTER(decoded->sr1));
+        emit_alu_immediate(e, decoded->handler == VM_DO_ADD_IMMEDIATE ? ALU_ADD : ALU_AND, RAX, (int16_t)decoded->operand);
+        emit_alu(e, ALU_MOV, dr, RAX);
+        emit_set_result(e, RAX);
+        break;
+    case VM_DO_NOT:
+        emit_alu(e, ALU_MOV, RAX, LC3_REGISTER(decoded->sr1));
+        emit_not(e, RAX);
+        emit_alu(e, ALU_MOV, dr, RAX);
+        emit_set_result(e, RAX);
+        break;
+    case VM_DO_LEA:
+        emit_mov_immediate(e, dr, decoded->operand);
+        emit_set_result(e, dr);
+        break;
+    case VM_DO_LD:
+        emit_static_access_check(e, decoded->operand, instruction);
+        emit_load_vm_word(e, dr, decoded->operand * 2);
+        emit_set_result(e, dr);
+        break;
+    case VM_DO_ST:
+        emit_static_access_check(e, decoded->operand, instruction);
+        emit_static_code_check(e, decoded->operand, instruction);
+        emit_store_vm_word(e, dr, decoded->operand * 2);
+        break;
+    case VM_DO_LDR:
+        emit_base_plus_offset(e, decoded);
+        emit_dynamic_access_check(e, false, instruction);
+        emit_load_memory(e, dr);
+        emit_set_result(e, dr);
+        break;
+    case VM_DO_STR:
+        emit_base_plus_offset(e, decoded);
+        emit_dynamic_access_check(e, true, instruction);
+        emit_store_memory(e, dr);
+        break;
+    case VM_DO_LDI:
+    case VM_DO_STI:
+        emit_static_access_check(e, decoded->operand, instruction);
+        emit_load_vm_word(e, RAX, decoded->operand * 2);
+        emit_dynamic_access_check(e, decoded->handler == VM_DO_STI, instruction);
+        if(decoded->handler == VM_DO_LDI) {
+            emit_load_memory(e, dr);
+            emit_set_result(e, dr);
+        }
+        else {
+            emit_store_memory(e, dr);
+        }
+        break;
+    case VM_DO_BR:
+        emit_branch(jit, e, decoded, next_pc);
+        break;
+    case VM_DO_BR_ALWAYS:
+        emit_exit_to(jit, e, decoded->operand);
+        break;
+    case VM_DO_JSR:
+        emit_mov_immediate(e, LC3_REGISTER(7), next_pc);
+        emit_exit_to(jit, e, decoded->operand);
+        break;
+    case VM_DO_JSRR:
+    case VM_DO_JMP:
+        emit_alu(e, ALU_MOV, RAX, LC3_REGISTER(decoded->sr1)); //before R7 is written by JSRR
+        if(decoded->handler == VM_DO_JSRR) {
+            emit_mov_immediate(e, LC3_REGISTER(7), next_pc);
+        }
+        emit_indirect_exit(jit, e);
+        break;
+    default: //VM_DO_BR_NEVER
+        break;
+    }
+}
+
+/**
+ * @brief Exits that give back the instructions of the block not run and leave to the interpreter
+ */
+static void emit_side_exits(jit_t *jit, emitter_t *e, uint16_t start, int num_instructions) {
+    unsigned char *stubs[JIT_MAX_BLOCK_INSTRUCTIONS] = { NULL };
+    for(int i = 0; i < e->num_side_exits; i++) {
+        int instruction = e->side_exits[i].instruction;
+        if(!stubs[instruction]) {
+            stubs[instruction] = e->p;
+            emit8(e, 0x48); //add rsi, instructions not run
+            emit8(e, 0x81);
+            emit8(e, MODRM(3, 0, RSI));
+            emit32(e, num_instructions - instruction);
+            emit_store_frame_immediate(e, FRAME_FIELD(exit_pc), (uint16_t)(start + instruction));
+            emit_jump(e, jit->code + jit->exit_interpret);
+        }
+        patch_rel32(e->side_exits[i].rel32, stubs[instruction]);
+    }
+}
+
+static void emit_entry_and_exits(jit_t *jit) {
+    emitter_t e = { .p = jit->code };
+    static const uint8_t saved_registers[] = { RBX, RBP, 12, 13, 14, 15 };
+
+    //entry(vm = rdi, frame = rsi, block = rdx)
+    for(size_t i = 0; i < sizeof(saved_registers); i++) {
+        emit_rex(&e, false, 0, saved_registers[i]);
+        emit8(&e, 0x50 + (saved_registers[i] & 7)); //push
+    }
+    emit8(&e, 0x48); //mov rbp, rsi
+    emit8(&e, 0x89);
+    emit8(&e, MODRM(3, RSI, RBP));
+    for(int r = 0; r < VM_NUM_REGISTERS; r++) {
+        emit_load_vm_word(&e, LC3_REGISTER(r), VM_FIELD(registers) + 2 * r);
+    }
+    emit8(&e, 0x0F); //movzx ebx, word [rbp + result]
+    emit8(&e, 0xB7);
+    emit8(&e, MODRM(1, RBX, RBP));
+    emit8(&e, FRAME_FIELD(result));
+    emit8(&e, 0x48); //mov rsi, [rbp + budget]
+    emit8(&e, 0x8B);
+    emit8(&e, MODRM(1, RSI, RBP));
+    emit8(&e, FRAME_FIELD(budget));
+    emit8(&e, 0xFF); //jmp rdx
+    emit8(&e, MODRM(3, 4, RDX));
+
+    jit->exit_branch = e.p - jit->code;
+    emit_store_frame_immediate(&e, FRAME_FIELD(exit_reason), EXIT_BRANCH);
+    unsigned char *to_common_exit = e.p;
+    emit_jump(&e, e.p);
+    jit->exit_interpret = e.p - jit->code;
+    emit_store_frame_immediate(&e, FRAME_FIELD(exit_reason), EXIT_INTERPRET);
+    patch_rel32(to_common_exit + 1, e.p);
+    for(int r = 0; r < VM_NUM_REGISTERS; r++) {
+        emit_store_vm_word(&e, LC3_REGISTER(r), VM_FIELD(registers) + 2 * r);
+    }
+    emit8(&e, 0x66); //mov [rbp + result], bx
+    emit8(&e, 0x89);
+    emit8(&e, MODRM(1, RBX, RBP));
+    emit8(&e, FRAME_FIELD(result));
+    emit8(&e, 0x48); //mov [rbp + budget], rsi
+    emit8(&e, 0x89);
+    emit8(&e, MODRM(1, RSI, RBP));
+    emit8(&e, FRAME_FIELD(budget));
+    for(size_t i = sizeof(saved_registers); i-- > 0;) {
+        emit_rex(&e, false, 0, saved_registers[i]);
+        emit8(&e, 0x58 + (saved_registers[i] & 7)); //pop
+    }
+    emit8(&e, 0xC3); //ret
+    jit->first_block = jit->code_size = e.p - jit->code;
+}
+
+static void flush(jit_t *jit) {
+    memset(jit->entries, 0, sizeof(jit->entries));
+    memset(jit->counts, 0, sizeof(jit->counts));
+    jit->num_links = 0;
+    if(jit->code_size > jit->first_block) {
+        jit->code_size = jit->first_block;
+        jit->stats.flushes++;
+    }
+}
+
+/**
+ * @brief Translate the block that starts at `start`; NULL if its first instruction cannot be translated
+ */
+static unsigned char *translate_block(jit_t *jit, vm_t *vm, uint16_t start) {
+    const vm_decoded_t *instructions[JIT_MAX_BLOCK_INSTRUCTIONS];
+    int num_instructions = block_extent(vm, start, instructions);
+    if(num_instructions == 0) {
+        return NULL;
+    }
+    if(jit->code_size + MAX_BLOCK_CODE > JIT_CODE_SIZE) {
+        flush(jit);
+    }
+
+    static emitter_t e;
+    e.p = jit->code + jit->code_size;
+    e.num_side_exits = 0;
+    unsigned char *block = e.p;
+    emit8(&e, 0x48); //sub rsi, num_instructions
+    emit8(&e, 0x81);
+    emit8(&e, MODRM(3, 5, RSI));
+    emit32(&e, num_instructions);
+    emit_side_exit_jcc(&e, CC_L, 0);
+    for(int i = 0; i < num_instructions; i++) {
+        emit_instruction(jit, &e, instructions[i], start + i, i);
+    }
+    if(!ends_block(instructions[num_instructions - 1])) {
+        emit_exit_to(jit, &e, start + num_instructions);
+    }
+    emit_side_exits(jit, &e, start, num_instructions);
+
+    jit->code_size = e.p - jit->code;
+    jit->entries[start] = block;
+    if(!jit->step) {
+        resolve_links(jit, start);
+    }
+    jit->stats.blocks_compiled++;
+    return block;
+}
+
+#endif
+
+/**
+ * @brief Map the code buffer; `threshold` is the number of times a block runs before it is translated
+ */
+exit_t jit_init(jit_t *jit, unsigned threshold) {
+    memset(jit, 0, sizeof(*jit));
+    jit->threshold = threshold == 0 ? 1 : threshold < NEVER_TRANSLATED ? threshold : NEVER_TRANSLATED - 1;
+#ifdef JIT_SUPPORTED
+    jit->code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANON, -1, 0);
+    if(jit->code == MAP_FAILED) {
+        jit->code = NULL;
+        return failure(EXIT_FAILURE, "ERROR: Couldn't map the code buffer of the JIT (%s)", strerror(errno));
+    }
+    emit_entry_and_exits(jit);
+    return success();
+#else
+    return failure(EXIT_FAILURE, "ERROR: The JIT only generates %s code", "x86-64");
+#endif
+}
+
+void jit_release(jit_t *jit) {
+    if(jit->code) {
+        munmap(jit->code, JIT_CODE_SIZE);
+        jit->code = NULL;
+    }
+    free(jit->links);
+    jit->links = NULL;
+}
+
+/**
+ * @brief Run the machine as vm_run, translating its hot blocks
+ */
+vm_status_t jit_run(jit_t *jit, vm_t *vm, uint64_t max_instructions) {
+    uint64_t remaining = max_instructions;
+    const vm_decoded_t *instructions[JIT_MAX_BLOCK_INSTRUCTIONS];
+    for(;;) {
+#ifdef JIT_SUPPORTED
+        if(vm != jit->vm || vm->code_writes != jit->code_writes) {
+            flush(jit);
+            jit->vm = vm;
+            jit->code_writes = vm->code_writes;
+        }
+        if(remaining == 0) {
+            return VM_LIMIT_REACHED;
+        }
+        unsigned char *block = jit->entries[vm->pc];
+        if(!block && jit->counts[vm->pc] != NEVER_TRANSLATED && ++jit->counts[vm->pc] >= jit->threshold) {
+            if(!(block = translate_block(jit, vm, vm->pc))) {
+                jit->counts[vm->pc] = NEVER_TRANSLATED;
+            }
+        }
+        if(block) {
+            jit_frame_t frame = {
+                .budget = remaining > INT64_MAX ? INT64_MAX : (int64_t)remaining,
+                .access = vm->psr & VM_PSR_SUPERVISOR ? ALL_PAGES : vm->mpr,
+                .result = condition_codes_value(vm->psr)
+            };
+            int64_t budget = frame.budget;
+            entry_code_t entry_code;
+            unsigned char *entry = jit->code;
+            memcpy(&entry_code, &entry, sizeof(entry_code));
+            entry_code(vm, &frame, block);
+
+            uint64_t executed = budget - frame.budget;
+            remaining -= executed;
+            vm->instructions += executed;
+            jit->stats.native_instructions += executed;
+            vm->pc = frame.exit_pc;
+            vm->psr = (vm->psr & ~CONDITION_CODES) | condition_codes(frame.result);
+            if(jit->step && executed) {
+                return VM_LIMIT_REACHED;
+            }
+            if(frame.exit_reason == EXIT_BRANCH) {
+                continue;
+            }
+        }
+#endif
+        if(remaining == 0) {
+            return VM_LIMIT_REACHED;
+        }
+        //the interpreter runs the block, or a single instruction that cannot be translated
+        uint64_t num_instructions = block_extent(vm, vm->pc, instructions);
+        uint64_t before = vm->instructions;
+        vm_status_t status = vm_run(vm, num_instructions == 0 ? 1 : num_instructions < remaining ? num_instructions : remaining);
+        remaining -= vm->instructions - before;
+        jit->stats.interpreted_instructions += vm->instructions - before;
+        if(status != VM_LIMIT_REACHED || jit->step) {
+            return status;
+        }
+    }
+}
@@ -0,0 +1,169 @@
+/**
+ * @file layout.c
+ * @brief rewriting of `tokenized_lines` by the passes that change the number of words of a program
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The symbol table stores slots of `tokenized_lines`, so inserting or removing words shifts the slot of every
+ * label placed after them.
+ *
+ * The rewrites of a pass are collected first (one entry per slot) and then applied in a single sweep that builds
+ * the new array of lines and remaps the labels with the map from old slots to new slots. This way, each pass is
+ * linear in the size of the program regardless of the number of rewrites.
+ */
+
+#include "../include/lc3.h"
+
+size_t count_slots(linemetadata_t *tokenized_lines[]) {
+    size_t num_slots = 0;
+    while(tokenized_lines[num_slots]) {
+        num_slots++;
+    }
+    return num_slots;
+}
+
+/**
+ * @brief Create the metadata of a line generated by the assembler, as if it had been read from the assembly file
+ *
+ * @param text instruction or directive, e.g. "LD R1,#1"
+ * @param line_number line of the assembly file the new line derives from
+ * @return linemetadata_t* NULL if there is not enough memory
+ */
+linemetadata_t *new_line(const char *text, int line_number) {
+    linemetadata_t *line_metadata = tracked_malloc(sizeof(linemetadata_t), MEM_LINES);
+    if(!line_metadata) {
+        return NULL;
+    }
+    line_metadata->line = tracked_strdup(text, MEM_LINES);
+    line_metadata->tokens = split_tokens(line_metadata->line, &line_metadata->num_tokens, " ,\n\t");
+    line_metadata->is_label_line = false;
+    line_metadata->line_number = line_number;
+    line_metadata->column = 0;
+    line_metadata->instruction_location = 0;
+    line_metadata->machine_instruction = 0;
+    return line_metadata;
+}
+
+/**
+ * @brief Compute the slot each line will be moved to once the rewrites are applied
+ *
+ * The slot of a removed line is mapped to the slot of the next line that is kept, so that a label pointing to
+ * a removed line ends up pointing to the following word.
+ *
+ * @param rewrites one entry per slot
+ * @param num_slots number of slots of the program
+ * @param slot_map array with `num_slots + 1` elements; the last element is the new number of slots
+ */
+void compute_slot_map(const slot_rewrite_t rewrites[], size_t num_slots, size_t slot_map[]) {
+    size_t new_slot = 0;
+    for(size_t slot = 0; slot < num_slots; slot++) {
+        slot_map[slot] = new_slot;
+        new_slot += rewrites[slot].rewritten ? (size_t)rewrites[slot].num_lines : 1;
+    }
+    slot_map[num_slots] = new_slot;
+}
+
+/**
+ * @brief Check that PC offsets given as numbers still point to the same word after the rewrites
+ *
+ * Only labels are remapped when the program is rewritten, so a numeric offset spanning a rewritten line would
+ * silently point to a different word
+ */
+exit_t check_numeric_offsets(linemetadata_t *tokenized_lines[], const size_t slot_map[]) {
+    long num_slots = count_slots(tokenized_lines);
+    for(long slot = 0; slot < num_slots; slot++) {
+        int num_bits;
+        int operand = pc_relative_operand(tokenized_lines[slot], &num_bits);
+        long offset;
+        if(operand == -1 || !numeric_offset(tokenized_lines[slot]->tokens[operand], &offset)) {
+            continue;
+        }
+        long target = slot + 1 + offset;
+        if(target < 0 || target > num_slots || segment_displacement(slot, target) != 0) {
+            continue;
+        }
+        if((long)slot_map[target] - (long)slot_map[slot + 1] != offset) {
+            return failure(EXIT_FAILURE, "ERROR (line %d): Offset %s cannot be preserved when rewriting the program, use a label instead", tokenized_lines[slot]->line_number, tokenized_lines[slot]->tokens[operand]);
+        }
+    }
+    return success();
+}
+
+/**
+ * @brief Replace the lines of `tokenized_lines` according to the given rewrites and remap the labels
+ *
+ * Ownership of the new lines is transferred to `tokenized_lines` and the replaced lines are freed.
+ * Nothing is modified if the rewritten program does not fit in `tokenized_lines`.
+ *
+ * @param tokenized_lines
+ * @param rewrites one entry per slot
+ * @param slot_map map computed by `compute_slot_map`
+ * @return exit_t
+ */
+exit_t apply_slot_rewrites(linemetadata_t *tokenized_lines[], slot_rewrite_t rewrites[], const size_t slot_map[]) {
+    size_t num_slots = count_slots(tokenized_lines);
+    size_t new_num_slots = slot_map[num_slots];
+    if(new_num_slots >= TOKENIZED_LINES_CAPACITY) {
+        return failure(EXIT_FAILURE, "ERROR (line %d): Program exceeds the address space", tokenized_lines[num_slots - 1]->line_number);
+    }
+    linemetadata_t **new_lines = malloc((new_num_slots + 1) * sizeof(linemetadata_t *));
+    if(!new_lines) {
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+
+    size_t new_slot = 0;
+    for(size_t slot = 0; slot < num_slots; slot++) {
+        if(!rewrites[slot].rewritten) {
+            new_lines[new_slot++] = tokenized_lines[slot];
+            continue;
+        }
+        for(int i = 0; i < rewrites[slot].num_lines; i++) {
+            new_lines[new_slot++] = rewrites[slot].lines[i];
+        }
+        free_line_metadata(tokenized_lines[slot]);
+        free(rewrites[slot].lines);
+        rewrites[slot].lines = NULL;
+        rewrites[slot].num_lines = 0;
+    }
+
+    for(size_t slot = 0; slot < new_num_slots; slot++) {
+        new_lines[slot]->instruction_location = slot;
+        tokenized_lines[slot] = new_lines[slot];
+    }
+    //sentinel values
+    for(size_t slot = new_num_slots; slot <= num_slots; slot++) {
+        tokenized_lines[slot] = NULL;
+    }
+    free(new_lines);
+
+    node_t *node = next(true);
+    while(node) {
+        if(node->val <= num_slots) {
+            node->val = slot_map[node->val];
+        }
+        node = next(false);
+    }
+    return success();
+}
+
+void free_slot_rewrites(slot_rewrite_t rewrites[], size_t num_slots) {
+    for(size_t slot = 0; slot < num_slots; slot++) {
+        for(int i = 0; i < rewrites[slot].num_lines; i++) {
+            free_line_metadata(rewrites[slot].lines[i]);
+        }
+        free(rewrites[slot].lines);
+    }
+    free(rewrites);
+}
+
+/**
+ * @brief Print the tokens of a line as an instruction, e.g. "LD R1,LABEL", leaving out comments
+ */
+void print_line_tokens(FILE *stream, const linemetadata_t *line_metadata) {
+    for(int i = 0; i < line_metadata->num_tokens && line_metadata->tokens[i][0] != ';'; i++) {
+        fprintf(stream, "%s%s", i == 0 ? "" : (i == 1 ? " " : ","), line_metadata->tokens[i]);
+    }
+}
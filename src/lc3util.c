@@ -43,7 +43,7 @@ int parse_register(char *str) {
     return -1;
 }
 
-static exit_t parse_numeric_value(char *token, long *imm, uint16_t line_counter) {
+static exit_t parse_numeric_value(char *token, long *imm, int line_counter) {
     char first_ch = *token;
     char *value_to_check;
     int base;
@@ -66,7 +66,7 @@ static exit_t parse_numeric_value(char *token, long *imm, uint16_t line_counter)
     return success();
 }
 
-exit_t is_valid_lc3integer(char *token, int16_t *imm, uint16_t line_counter) {
+exit_t is_valid_lc3integer(char *token, int16_t *imm, int line_counter) {
     long tmp;
     exit_t result = parse_numeric_value(token, &tmp, line_counter);
     if(result.code) {
@@ -86,7 +86,7 @@ exit_t is_valid_lc3integer(char *token, int16_t *imm, uint16_t line_counter) {
  * @param imm5 immediate value resulting of transforming str
  * @return int 0 if parsing is successful, else 1 (errdesc is set with error details)
  */
-exit_t parse_imm5(char *str, long *imm5, uint16_t line_counter) {
+exit_t parse_imm5(char *str, long *imm5, int line_counter) {
     exit_t result = parse_numeric_value(str, imm5, line_counter);
     if(result.code) {
         return result;
@@ -100,7 +100,7 @@ exit_t parse_imm5(char *str, long *imm5, uint16_t line_counter) {
     return success();
 }
 
-exit_t parse_memory_address(char *str, long *n, uint16_t line_counter) {
+exit_t parse_memory_address(char *str, long *n, int line_counter) {
     exit_t result = parse_numeric_value(str, n, line_counter);
     if(result.code) {
         return result;
@@ -114,10 +114,16 @@ exit_t parse_memory_address(char *str, long *n, uint16_t line_counter) {
     return success();
 }
 
-exit_t parse_offset(char *token, int lower_bound, int upper_bound, uint16_t instruction_number, uint16_t line_counter, long *offset, int num_bits) {
-
+/**
+ * @brief Value of a PC-relative operand given as a number
+ *
+ * @param token operand as written in the assembly file
+ * @param offset numeric value of the operand
+ * @return bool false if the operand is not a number (i.e. it is a label)
+ */
+bool numeric_offset(const char *token, long *offset) {
     char first_ch = *token;
-    char *value_to_check;
+    const char *value_to_check;
     int base;
     if(first_ch == '#') { //decimal literal
         value_to_check = token + 1;
@@ -131,15 +137,40 @@ exit_t parse_offset(char *token, int lower_bound, int upper_bound, uint16_t inst
         value_to_check = token;
         base = 10;
     }
+    return strtolong((char *)value_to_check, offset, base);
+}
+
+/**
+ * @brief Offset from the instruction in the given slot to the word pointed to by a label
+ *
+ * @param label
+ * @param instruction_number slot of the instruction in `tokenized_lines`
+ * @param line_counter line number of the instruction
+ * @param offset distance in memory between the incremented PC and the label
+ * @return exit_t
+ */
+exit_t label_offset(const char *label, int instruction_number, int line_counter, long *offset) {
+    //transform label into offset by retrieving the memory location corresponding to the label from symbol table
+    node_t *node = lookup(label);
+    if(!node) {
+        return failure(EXIT_FAILURE, "ERROR (line %d): Symbol not found ('%s')", line_counter, label);
+    }
+    *offset = (long)node->val - instruction_number - 1;
+    if(get_num_segments() > 1) {
+        //label and instruction may be in different segments; offsets wrap around the address space
+        *offset = (int16_t)(*offset + segment_displacement(instruction_number, node->val));
+    }
+    return success();
+}
+
+exit_t parse_offset(char *token, int lower_bound, int upper_bound, int instruction_number, int line_counter, long *offset, int num_bits) {
 
     //is value a label or a number?
-    if(!strtolong(value_to_check, offset, base)) {
-        //transform label into offset by retrieving the memory location corresponding to the label from symbol table
-        node_t *node = lookup(token);
-        if(!node) {
-            return failure(EXIT_FAILURE, "ERROR (line %d): Symbol not found ('%s')", line_counter, token);
+    if(!numeric_offset(token, offset)) {
+        exit_t result = label_offset(token, instruction_number, line_counter, offset);
+        if(result.code) {
+            return result;
         }
-        *offset = node->val - instruction_number - 1;
     }
 
 
@@ -157,7 +188,38 @@ exit_t parse_offset(char *token, int lower_bound, int upper_bound, uint16_t inst
     return success();
 }
 
-exit_t parse_trapvector(char *token, long *trapvector, uint16_t line_counter) {
+/**
+ * @brief Index of the token holding the PC-relative operand (label or offset) of an instruction
+ *
+ * @param line_metadata
+ * @param num_bits size of the PCoffset field of the instruction
+ * @return int index of the operand or -1 if the line is not an instruction with a PC-relative operand
+ */
+int pc_relative_operand(const linemetadata_t *line_metadata, int *num_bits) {
+    if(!line_metadata->tokens || compute_line_type(line_metadata->tokens[0]) != OPCODE) {
+        return -1;
+    }
+    int operand;
+    switch(compute_opcode_type(line_metadata->tokens[0])) {
+    case JSR:
+        *num_bits = 11;
+        operand = 1;
+        break;
+    case BR: case BRn: case BRz: case BRp: case BRnz: case BRnp: case BRzp: case BRnzp:
+        *num_bits = 9;
+        operand = 1;
+        break;
+    case LD: case ST: case LDI: case STI: case LEA:
+        *num_bits = 9;
+        operand = 2;
+        break;
+    default:
+        return -1;
+    }
+    return operand < line_metadata->num_tokens ? operand : -1;
+}
+
+exit_t parse_trapvector(char *token, long *trapvector, int line_counter) {
 
     exit_t result = parse_numeric_value(token, trapvector, line_counter);
     if(result.code) {
@@ -172,6 +234,32 @@ exit_t parse_trapvector(char *token, long *trapvector, uint16_t line_counter) {
     return success();
 }
 
+/**
+ * @brief Condition codes (nzp) tested by a branch instruction
+ *
+ * @param opcode any of the BR opcodes
+ * @return int 3-bit value: n = 4, z = 2, p = 1
+ */
+int branch_condition_codes(opcode_t opcode) {
+    switch(opcode) {
+    case BRn:
+        return 4;
+    case BRz:
+        return 2;
+    case BRp:
+        return 1;
+    case BRnz:
+        return 6;
+    case BRnp:
+        return 5;
+    case BRzp:
+        return 3;
+    default:
+        //BR, BRnzp
+        return 7;
+    }
+}
+
 /**
  * @brief Determine the type of a line based on the value of the first token
  *
@@ -235,6 +323,9 @@ linetype_t compute_line_type(const char *first_token) {
     else if(strcmp(first_token, ".STRINGZ") == 0) {
         result = STRINGZ_DIRECTIVE;
     }
+    else if(strcmp(first_token, ".STRINGP") == 0) {
+        result = STRINGP_DIRECTIVE;
+    }
     else if(first_token[0] == ';') {
         result = COMMENT;
     }
@@ -357,22 +448,36 @@ opcode_t compute_opcode_type(const char *opcode) {
     return result;
 }
 
+/**
+ * @brief Write `value` as a JSON string literal, escaping quotes and backslashes
+ */
+void print_json_string(FILE *stream, const char *value) {
+    fputc('"', stream);
+    for(const char *ch = value; *ch; ch++) {
+        if(*ch == '"' || *ch == '\\') {
+            fputc('\\', stream);
+        }
+        fputc(*ch, stream);
+    }
+    fputc('"', stream);
+}
+
 void free_line_metadata(linemetadata_t *line_metadata) {
     if(line_metadata->tokens) {
         if(line_metadata->is_label_line) {
-            free(line_metadata->tokens - 1);
+            tracked_free(line_metadata->tokens - 1);
         }
         else {
-            free(line_metadata->tokens);
+            tracked_free(line_metadata->tokens);
         }
-        free(line_metadata->line);
+        tracked_free(line_metadata->line);
     }
-    free(line_metadata);
+    tracked_free(line_metadata);
 }
 
 void free_tokenized_lines(linemetadata_t **tokenized_lines) {
     linemetadata_t *line_metadata;
-    memaddr_t address_offset = 0;
+    size_t address_offset = 0;
     while((line_metadata = tokenized_lines[address_offset++])) {
         free_line_metadata(line_metadata);
     }
@@ -10,13 +10,21 @@
 
 static void free_tokens(char **tokens, bool is_label_line) {
     if(is_label_line) {
-        free(tokens - 1);
+        tracked_free(tokens - 1);
     }
     else {
-        free(tokens);
+        tracked_free(tokens);
     }
 }
 
+/**
+ * @brief Release the buffer allocated by getline, whose capacity (`size`) is accounted for as an I/O buffer
+ */
+static void free_line_buffer(char *buffer, size_t size) {
+    memtrack_account(MEM_IO_BUFFERS, -(long)size);
+    free(buffer);
+}
+
 /**
  * @brief do the lexical analysis of the asm file
  *
@@ -30,6 +38,9 @@ static void free_tokens(char **tokens, bool is_label_line) {
  * Actual memory locations will be determined during syntax/semantic analysis by adding the previous offsets to the reference
  * memory address given by .ORIG.
  *
+ * A program may consist of several segments (.ORIG ... .END). The words of all segments are stored consecutively in
+ * `tokenized_lines`, each segment being preceded by its .ORIG line. Anything between .END and the next .ORIG is ignored.
+ *
  * @param assembly_file handle to the asm file
  * @param tokenized_lines array to store line metadata generated by the lexer
  * @return exit_t
@@ -40,27 +51,47 @@ exit_t do_lexical_analysis(FILE *assembly_file, linemetadata_t *tokenized_lines[
     char *resusable_line = NULL;
     size_t len = 0; //length of the current line
 
-    memaddr_t instruction_offset = 0; //real memory location = instruction offset + address given by .ORIG
+    size_t instruction_offset = 0; //real memory location = instruction offset + address given by .ORIG
     int line_counter = 0; //current line number in the assembly file
+    bool end_found = false; //lines after .END are ignored until a new segment begins
 
     errno = 0;
     ssize_t read;
+    size_t accounted_len = 0; //capacity of the buffer allocated by getline
     while((read = getline(&resusable_line, &len, assembly_file)) != -1) {
+        if(len != accounted_len) {
+            memtrack_account(MEM_IO_BUFFERS, (long)len - (long)accounted_len);
+            accounted_len = len;
+        }
         // printf("%s", resusable_line);
         bool is_label_line = false;
         line_counter++;
+        assembly_stats.lines++;
 
-        char *line = strdup(resusable_line);
+        char *line = tracked_strdup(resusable_line, MEM_LINES);
         int num_tokens = 0;
         char **tokens = split_tokens(line, &num_tokens, " ,\n\t");
+        assembly_stats.tokens += num_tokens;
         if(num_tokens == 0) {
-            free(line);
+            tracked_free(line);
             continue;
         }
 
         linetype_t line_type = compute_line_type(tokens[0]);
+        if(end_found) {
+            linetype_t first_non_label_type = line_type == LABEL && num_tokens > 1 ? compute_line_type(tokens[1]) : line_type;
+            if(first_non_label_type != ORIG_DIRECTIVE) {
+                tracked_free(line);
+                tracked_free(tokens);
+                continue;
+            }
+            end_found = false;
+        }
+
         if(line_type == LABEL) {
-            add(tokens[0], instruction_offset);
+            //a label on a .ORIG line names the first word of the new segment, which follows the slot of the .ORIG line
+            bool orig_label = num_tokens > 1 && compute_line_type(tokens[1]) == ORIG_DIRECTIVE;
+            add(tokens[0], instruction_offset + (orig_label ? 1 : 0));
             if(num_tokens > 1) {
                 //continue processing the rest of the line as there are more elements after the label
                 tokens++;
@@ -69,26 +100,34 @@ exit_t do_lexical_analysis(FILE *assembly_file, linemetadata_t *tokenized_lines[
                 line_type = compute_line_type(tokens[0]);
             }
             else {
-                free(line);
-                free(tokens);
+                tracked_free(line);
+                tracked_free(tokens);
                 continue;
             }
         }
 
         if(line_type == END_DIRECTIVE) {
-            free(line);
+            tracked_free(line);
             free_tokens(tokens, is_label_line);
-            //stop reading file
-            break;
+            //ignore the rest of the file unless there are more segments
+            end_found = true;
+            continue;
         }
         else if(line_type == COMMENT || line_type == BLANK_LINE) {
-            free(line);
+            tracked_free(line);
             free_tokens(tokens, is_label_line);
             //ignore line
             continue;
         }
 
-        linemetadata_t *line_metadata = malloc(sizeof(linemetadata_t));
+        if(instruction_offset + 1 >= TOKENIZED_LINES_CAPACITY) {
+            tracked_free(line);
+            free_tokens(tokens, is_label_line);
+            free_line_buffer(resusable_line, accounted_len);
+            return failure(EXIT_FAILURE, "ERROR (line %d): Program exceeds the address space", line_counter);
+        }
+
+        linemetadata_t *line_metadata = tracked_malloc(sizeof(linemetadata_t), MEM_LINES);
         if(!line_metadata) {
             //out of memory error
         }
@@ -97,23 +136,36 @@ exit_t do_lexical_analysis(FILE *assembly_file, linemetadata_t *tokenized_lines[
         line_metadata->is_label_line = is_label_line;
         line_metadata->line = line;
         line_metadata->line_number = line_counter;
+        line_metadata->column = tokens[0] - line + 1;
         line_metadata->instruction_location = instruction_offset;
         tokenized_lines[instruction_offset] = line_metadata;
 
         if(line_type == BLKW_DIRECTIVE) {
             exit_t result = parse_blkw(line_metadata);
             if(result.code) {
+                free_line_buffer(resusable_line, accounted_len);
                 return result;
             }
 
             uint16_t blkw_operand = line_metadata->machine_instruction;
+            if(instruction_offset + blkw_operand >= TOKENIZED_LINES_CAPACITY) {
+                free_line_buffer(resusable_line, accounted_len);
+                return failure(EXIT_FAILURE, "ERROR (line %d): Program exceeds the address space", line_counter);
+            }
+            //the directive is replaced with the words it expands into
+            int column = line_metadata->column;
+            tokenized_lines[instruction_offset] = NULL;
+            free_line_metadata(line_metadata);
             for(size_t i = 0; i < blkw_operand; i++) {
-                linemetadata_t *blkw_line_metadata = malloc(sizeof(linemetadata_t));
+                linemetadata_t *blkw_line_metadata = tracked_malloc(sizeof(linemetadata_t), MEM_LINES);
                 if(!blkw_line_metadata) {
                     //out of memory error
                 }
                 blkw_line_metadata->tokens = NULL;
                 blkw_line_metadata->line = NULL;
+                blkw_line_metadata->line_number = line_counter;
+                blkw_line_metadata->column = column;
+                blkw_line_metadata->instruction_location = instruction_offset;
                 blkw_line_metadata->machine_instruction = 0;
                 tokenized_lines[instruction_offset] = blkw_line_metadata;
                 instruction_offset++;
@@ -122,6 +174,17 @@ exit_t do_lexical_analysis(FILE *assembly_file, linemetadata_t *tokenized_lines[
         else if(line_type == STRINGZ_DIRECTIVE) {
             exit_t result = parse_stringz(line_metadata, tokenized_lines, &instruction_offset);
             if(result.code) {
+                free_line_buffer(resusable_line, accounted_len);
+                return result;
+            }
+            //the directive has been replaced with the words it expands into
+            free_line_metadata(line_metadata);
+        }
+        else if(line_type == STRINGP_DIRECTIVE) {
+            //the directive keeps the slot of the first word it expands into
+            exit_t result = parse_stringp(line_metadata, tokenized_lines, &instruction_offset);
+            if(result.code) {
+                free_line_buffer(resusable_line, accounted_len);
                 return result;
             }
         }
@@ -130,7 +193,7 @@ exit_t do_lexical_analysis(FILE *assembly_file, linemetadata_t *tokenized_lines[
         }
     }
 
-    free(resusable_line);
+    free_line_buffer(resusable_line, accounted_len);
     //check if getline resulted in error
     if(read == -1 && errno) {
         return failure(EXIT_FAILURE, "getLine error %d\n", errno);
@@ -0,0 +1,230 @@
+/**
+ * @file memtrack.c
+ * @brief Allocation tracker: calls, bytes and peak live bytes per category of memory
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * When tracking is enabled, every tracked block is preceded by a header with its size and category, so that
+ * tracked_free knows what to subtract from the live bytes. When it is disabled, the tracked functions are the plain
+ * functions of the C library plus a test of a flag.
+ *
+ * Counters are atomic so that they remain correct if several files are assembled at the same time.
+ */
+
+#include <stdatomic.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include "../include/util.h"
+
+typedef union {
+    struct {
+        size_t size;
+        memcategory_t category;
+    } block;
+    max_align_t alignment; //the memory following the header must be suitably aligned for any type
+} header_t;
+
+typedef struct {
+    atomic_uint_least64_t calls;
+    atomic_uint_least64_t bytes;
+    atomic_uint_least64_t live_bytes;
+    atomic_uint_least64_t peak_live_bytes;
+} counters_t;
+
+static const char *category_names[NUM_MEM_CATEGORIES] = { "tokens", "lines", "symbols", "diagnostics", "I/O buffers" };
+static counters_t counters[NUM_MEM_CATEGORIES];
+static atomic_uint_least64_t live_bytes;
+static atomic_uint_least64_t peak_live_bytes;
+static int enabled = -1; //unknown until the first allocation
+
+static void report_at_exit() {
+    memtrack_report(stderr);
+}
+
+bool memtrack_enabled() {
+    if(enabled == -1) {
+#ifdef FAB_MEMTRACK
+        enabled = 1;
+#else
+        const char *value = getenv("LC3_MEMTRACK");
+        enabled = value && strcmp(value, "") != 0 && strcmp(value, "0") != 0;
+#endif
+        if(enabled) {
+            atexit(report_at_exit);
+        }
+    }
+    return enabled;
+}
+
+/**
+ * @brief Enable tracking, without the report at exit, unless the first allocation already decided otherwise
+ *
+ * @return bool whether tracking is enabled
+ */
+bool memtrack_enable() {
+    if(enabled == -1) {
+        enabled = 1;
+    }
+    return enabled;
+}
+
+static void update_peak(atomic_uint_least64_t *peak, uint64_t value) {
+    uint64_t current_peak = atomic_load_explicit(peak, memory_order_relaxed);
+    while(value > current_peak && !atomic_compare_exchange_weak_explicit(peak, &current_peak, value, memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static void add_live_bytes(memcategory_t category, uint64_t bytes) {
+    counters_t *category_counters = &counters[category];
+    update_peak(&category_counters->peak_live_bytes, atomic_fetch_add_explicit(&category_counters->live_bytes, bytes, memory_order_relaxed) + bytes);
+    update_peak(&peak_live_bytes, atomic_fetch_add_explicit(&live_bytes, bytes, memory_order_relaxed) + bytes);
+}
+
+static void subtract_live_bytes(memcategory_t category, uint64_t bytes) {
+    atomic_fetch_sub_explicit(&counters[category].live_bytes, bytes, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&live_bytes, bytes, memory_order_relaxed);
+}
+
+/**
+ * @brief Account for `bytes` bytes of the given category allocated (positive) or released (negative) by other means
+ */
+void memtrack_account(memcategory_t category, long bytes) {
+    if(!memtrack_enabled() || bytes == 0) {
+        return;
+    }
+    if(bytes > 0) {
+        atomic_fetch_add_explicit(&counters[category].calls, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters[category].bytes, bytes, memory_order_relaxed);
+        add_live_bytes(category, bytes);
+    }
+    else {
+        subtract_live_bytes(category, -bytes);
+    }
+}
+
+static void *track_block(header_t *header, size_t size, memcategory_t category) {
+    if(!header) {
+        return NULL;
+    }
+    header->block.size = size;
+    header->block.category = category;
+    memtrack_account(category, size);
+    return header + 1;
+}
+
+void *tracked_malloc(size_t size, memcategory_t category) {
+    if(!memtrack_enabled()) {
+        return malloc(size);
+    }
+    return track_block(malloc(sizeof(header_t) + size), size, category);
+}
+
+void *tracked_calloc(size_t count, size_t size, memcategory_t category) {
+    if(!memtrack_enabled()) {
+        return calloc(count, size);
+    }
+    if(size && count > (SIZE_MAX - sizeof(header_t)) / size) {
+        return NULL;
+    }
+    return track_block(calloc(1, sizeof(header_t) + count * size), count * size, category);
+}
+
+void *tracked_realloc(void *ptr, size_t size, memcategory_t category) {
+    if(!memtrack_enabled()) {
+        return realloc(ptr, size);
+    }
+    if(!ptr) {
+        return tracked_malloc(size, category);
+    }
+    header_t *header = (header_t *)ptr - 1;
+    size_t old_size = header->block.size;
+    memcategory_t old_category = header->block.category;
+    header_t *resized_header = realloc(header, sizeof(header_t) + size);
+    if(!resized_header) {
+        return NULL;
+    }
+    subtract_live_bytes(old_category, old_size);
+    return track_block(resized_header, size, category);
+}
+
+char *tracked_strdup(const char *str, memcategory_t category) {
+    size_t size = strlen(str) + 1;
+    char *copy = tracked_malloc(size, category);
+    if(copy) {
+        memcpy(copy, str, size);
+    }
+    return copy;
+}
+
+void tracked_free(void *ptr) {
+    if(!ptr) {
+        return;
+    }
+    if(!memtrack_enabled()) {
+        free(ptr);
+        return;
+    }
+    header_t *header = (header_t *)ptr - 1;
+    subtract_live_bytes(header->block.category, header->block.size);
+    free(header);
+}
+
+memcategory_stats_t memtrack_category_stats(memcategory_t category) {
+    return (memcategory_stats_t) {
+        .calls = atomic_load(&counters[category].calls),
+        .bytes = atomic_load(&counters[category].bytes),
+        .live_bytes = atomic_load(&counters[category].live_bytes),
+        .peak_live_bytes = atomic_load(&counters[category].peak_live_bytes)
+    };
+}
+
+/**
+ * @brief Allocations of all the categories, including the ones resizing a block
+ */
+uint64_t memtrack_calls() {
+    uint64_t calls = 0;
+    for(int category = 0; category < NUM_MEM_CATEGORIES; category++) {
+        calls += atomic_load(&counters[category].calls);
+    }
+    return calls;
+}
+
+/**
+ * @brief Highest number of bytes alive at the same time, all categories together
+ */
+uint64_t memtrack_peak_live_bytes() {
+    return atomic_load(&peak_live_bytes);
+}
+
+/**
+ * @brief Start measuring the peaks again from the bytes alive now, e.g. to measure the peak of a part of a program
+ */
+void memtrack_reset_peaks() {
+    for(int category = 0; category < NUM_MEM_CATEGORIES; category++) {
+        atomic_store(&counters[category].peak_live_bytes, atomic_load(&counters[category].live_bytes));
+    }
+    atomic_store(&peak_live_bytes, atomic_load(&live_bytes));
+}
+
+/**
+ * @brief Print the calls, bytes, peak live bytes and bytes still alive of each category
+ *
+ * The peak of the total is lower than the sum of the peaks of the categories unless all of them peak at the same time
+ */
+void memtrack_report(FILE *stream) {
+    fprintf(stream, "%-12s  %10s  %12s  %12s  %12s\n", "memory", "calls", "bytes", "peak live", "live at exit");
+    memcategory_stats_t total = { 0 };
+    for(int category = 0; category < NUM_MEM_CATEGORIES; category++) {
+        memcategory_stats_t category_stats = memtrack_category_stats(category);
+        fprintf(stream, "%-12s  %10" PRIu64 "  %12" PRIu64 "  %12" PRIu64 "  %12" PRIu64 "\n", category_names[category],
+                category_stats.calls, category_stats.bytes, category_stats.peak_live_bytes, category_stats.live_bytes);
+        total.calls += category_stats.calls;
+        total.bytes += category_stats.bytes;
+        total.live_bytes += category_stats.live_bytes;
+    }
+    fprintf(stream, "%-12s  %10" PRIu64 "  %12" PRIu64 "  %12" PRIu64 "  %12" PRIu64 "\n", "total", total.calls, total.bytes,
+            memtrack_peak_live_bytes(), total.live_bytes);
+}
@@ -0,0 +1,360 @@
+/**
+ * @file objdiff.c
+ * @brief Comparison of object files with symbolic context (lc3objdiff)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The common part of both files is skipped SCAN_BLOCK_SIZE bytes at a time with memcmp, then 8 bytes at a time,
+ * until the first differing byte, which gives the differing word. Symbol tables are only read once a difference
+ * has been found, so that comparing thousands of identical pairs does not parse any .sym file.
+ */
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../include/lc3.h"
+#include "../include/objdiff.h"
+
+#define SCAN_BLOCK_SIZE 256
+#define LOCATION_COLUMN_WIDTH 18
+#define INSTRUCTION_COLUMN_WIDTH 24
+#define EXPECTED_SUFFIX ".expected.obj"
+#define OBJ_EXTENSION ".obj"
+
+/**
+ * Object file mapped into memory, with the position of its words in the address space
+ */
+typedef struct {
+    const char *file_name;
+    const unsigned char *bytes; /**< NULL if the file is empty */
+    size_t size;
+    size_t num_words;
+    size_t num_header_words; /**< words before the first word of the program */
+    bool segmented;
+    const char **symbols; /**< labels by address, loaded with the first difference */
+    char *symbol_names;
+} object_image_t;
+
+static uint16_t word_at(const object_image_t *image, size_t index) {
+    return image->bytes[2 * index] << 8 | image->bytes[2 * index + 1];
+}
+
+static exit_t map_object(const char *file_name, object_image_t *image) {
+    memset(image, 0, sizeof(*image));
+    image->file_name = file_name;
+    int fd = open(file_name, O_RDONLY);
+    if(fd == -1) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", file_name);
+    }
+    struct stat file_status;
+    if(fstat(fd, &file_status) == -1) {
+        close(fd);
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", file_name);
+    }
+    image->size = file_status.st_size;
+    if(image->size > 0) {
+        void *bytes = mmap(NULL, image->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(bytes == MAP_FAILED) {
+            close(fd);
+            return failure(EXIT_FAILURE, "ERROR: Couldn't map file (%s): %d", file_name, errno);
+        }
+        image->bytes = bytes;
+    }
+    close(fd);
+
+    image->num_words = image->size / 2;
+    image->num_header_words = image->num_words > 0 ? 1 : 0;
+    if(image->num_words >= 3 && word_at(image, 0) == SEGMENTED_OBJ_MAGIC1 && word_at(image, 1) == SEGMENTED_OBJ_MAGIC2
+        && 3 + 2 * (size_t)word_at(image, 2) <= image->num_words) {
+        image->segmented = true;
+        image->num_header_words = 3 + 2 * (size_t)word_at(image, 2);
+    }
+    return success();
+}
+
+static void unmap_object(object_image_t *image) {
+    if(image->bytes) {
+        munmap((void *)image->bytes, image->size);
+    }
+    free(image->symbols);
+    free(image->symbol_names);
+}
+
+/**
+ * @brief Labels of the object, from the .sym file next to it (none if there is no such file)
+ */
+static void load_object_symbols(object_image_t *image) {
+    image->symbols = calloc(ADDRESS_SPACE_SIZE, sizeof(char *));
+    size_t length = strlen(image->file_name);
+    char symbol_file_name[length + strlen(".sym") + 1];
+    strcpy(symbol_file_name, image->file_name);
+    if(length >= strlen(OBJ_EXTENSION) && strcmp(symbol_file_name + length - strlen(OBJ_EXTENSION), OBJ_EXTENSION) == 0) {
+        length -= strlen(OBJ_EXTENSION);
+    }
+    strcpy(symbol_file_name + length, ".sym");
+    image->symbol_names = load_symbol_table(symbol_file_name, image->symbols);
+}
+
+/**
+ * @brief Address of the word at position `index` of the file
+ *
+ * @return false if the word belongs to the header of the object format
+ */
+static bool address_of(const object_image_t *image, size_t index, uint16_t *address) {
+    if(index < image->num_header_words) {
+        return false;
+    }
+    if(!image->segmented) {
+        *address = word_at(image, 0) + (index - 1);
+        return true;
+    }
+    //segments are stored in the order of their descriptors
+    size_t first_word = image->num_header_words;
+    for(size_t segment = 0; segment < word_at(image, 2); segment++) {
+        size_t segment_words = word_at(image, 4 + 2 * segment);
+        if(index < first_word + segment_words) {
+            *address = word_at(image, 3 + 2 * segment) + (index - first_word);
+            return true;
+        }
+        first_word += segment_words;
+    }
+    return false; //words past the last segment do not belong to the program
+}
+
+/**
+ * @brief Position of the first differing byte of `a` and `b` from `from`, `size` if there is none
+ */
+static size_t next_difference(const unsigned char *a, const unsigned char *b, size_t from, size_t size) {
+    size_t i = from;
+    while(i + SCAN_BLOCK_SIZE <= size && memcmp(a + i, b + i, SCAN_BLOCK_SIZE) == 0) {
+        i += SCAN_BLOCK_SIZE;
+    }
+    for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t a_bytes, b_bytes;
+        memcpy(&a_bytes, a + i, sizeof(a_bytes));
+        memcpy(&b_bytes, b + i, sizeof(b_bytes));
+        if(a_bytes != b_bytes) {
+            break;
+        }
+    }
+    while(i < size && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * @brief Nearest label at or before `address`, as LABEL or LABEL+offset; empty if there is none
+ */
+static void format_label(const char *const symbols[], uint16_t address, char *text) {
+    for(int label_address = address; label_address >= 0; label_address--) {
+        if(symbols[label_address]) {
+            if(label_address == address) {
+                sprintf(text, "%s", symbols[label_address]);
+            }
+            else {
+                sprintf(text, "%s+%d", symbols[label_address], address - label_address);
+            }
+            return;
+        }
+    }
+    text[0] = '\0';
+}
+
+/**
+ * @brief Print the word at position `index` of one side of the comparison: its value and its instruction
+ *
+ * @param width of the instruction column, 0 for the last column
+ */
+static void print_word(FILE *report, const char *side, object_image_t *image, size_t index, int width) {
+    uint16_t address;
+    if(index >= image->num_words) {
+        fprintf(report, "%s %-4s %-*s", side, "-", width, "(missing)");
+        return;
+    }
+    char instruction[MAX_DISASSEMBLED_LINE];
+    if(address_of(image, index, &address)) {
+        instruction[disassemble_instruction(word_at(image, index), address, image->symbols, instruction)] = '\0';
+    }
+    else {
+        sprintf(instruction, "(header)");
+    }
+    fprintf(report, "%s %04X %-*s", side, word_at(image, index), width, instruction);
+}
+
+static void print_difference(FILE *report, object_image_t *expected, object_image_t *actual, size_t index) {
+    //the location is the one of the expected word, or of the actual one if the expected object is shorter
+    object_image_t *located = index < expected->num_words ? expected : actual;
+    uint16_t address;
+    char location[LOCATION_COLUMN_WIDTH + MAX_SYMBOL_LENGTH + 16];
+    if(address_of(located, index, &address)) {
+        char label[MAX_SYMBOL_LENGTH + 8];
+        format_label(located->symbols, address, label);
+        sprintf(location, "x%04X %s", address, label);
+    }
+    else {
+        sprintf(location, "header word %zu", index);
+    }
+    fprintf(report, "  %-*s ", LOCATION_COLUMN_WIDTH, location);
+    print_word(report, "expected", expected, index, INSTRUCTION_COLUMN_WIDTH);
+    fprintf(report, " ");
+    print_word(report, "actual", actual, index, 0);
+    fprintf(report, "\n");
+}
+
+/**
+ * @brief Compare two object files and report their differing words
+ *
+ * Nothing is reported if the objects are identical.
+ *
+ * @param max_reported largest number of differences printed, the others are only counted
+ * @param num_differences number of differing words, including the words present on a single side
+ * @return exit_t
+ */
+exit_t diff_objects(const char *expected_file_name, const char *actual_file_name, size_t max_reported, FILE *report,
+                    size_t *num_differences) {
+    object_image_t expected, actual;
+    exit_t result = map_object(expected_file_name, &expected);
+    if(result.code) {
+        return result;
+    }
+    if((result = map_object(actual_file_name, &actual)).code) {
+        unmap_object(&expected);
+        return result;
+    }
+
+    *num_differences = 0;
+    size_t common_size = expected.size < actual.size ? expected.size : actual.size;
+    size_t common_words = common_size / 2;
+    size_t longest_words = expected.num_words > actual.num_words ? expected.num_words : actual.num_words;
+    //differing words of the common part, then the words of the longest object
+    size_t *differing_words = malloc((max_reported + 1) * sizeof(size_t));
+    size_t position = 0;
+    while((position = next_difference(expected.bytes, actual.bytes, position, 2 * common_words)) < 2 * common_words) {
+        if(*num_differences < max_reported) {
+            differing_words[*num_differences] = position / 2;
+        }
+        (*num_differences)++;
+        position = (position / 2 + 1) * 2;
+    }
+    for(size_t index = common_words; index < longest_words; index++) {
+        if(*num_differences < max_reported) {
+            differing_words[*num_differences] = index;
+        }
+        (*num_differences)++;
+    }
+    bool odd_byte_differs = expected.size % 2 != actual.size % 2
+                            || (expected.size % 2 && expected.bytes[expected.size - 1] != actual.bytes[actual.size - 1]);
+
+    if(*num_differences || odd_byte_differs) {
+        fprintf(report, "%s %s: %zu word%s differ%s\n", expected_file_name, actual_file_name, *num_differences,
+                *num_differences == 1 ? "" : "s", *num_differences == 1 ? "s" : "");
+        size_t num_reported = *num_differences < max_reported ? *num_differences : max_reported;
+        build_decode_table();
+        load_object_symbols(&expected);
+        load_object_symbols(&actual);
+        if(!expected.symbol_names) {
+            //the names belong to the actual object, which is released with the expected one
+            memcpy(expected.symbols, actual.symbols, ADDRESS_SPACE_SIZE * sizeof(char *));
+        }
+        for(size_t i = 0; i < num_reported; i++) {
+            print_difference(report, &expected, &actual, differing_words[i]);
+        }
+        if(*num_differences > num_reported) {
+            fprintf(report, "  ... %zu more\n", *num_differences - num_reported);
+        }
+        if(expected.size != actual.size) {
+            fprintf(report, "  size: expected %zu bytes, actual %zu bytes\n", expected.size, actual.size);
+        }
+        if(odd_byte_differs && !*num_differences) {
+            (*num_differences)++; //a trailing byte is not a word, but the objects differ
+        }
+    }
+
+    free(differing_words);
+    unmap_object(&expected);
+    unmap_object(&actual);
+    return success();
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool has_suffix(const char *name, const char *suffix) {
+    size_t length = strlen(name);
+    return length >= strlen(suffix) && strcmp(name + length - strlen(suffix), suffix) == 0;
+}
+
+/**
+ * @brief Compare the objects of `expected_dir_name` with the ones of the same name in `actual_dir_name`
+ *
+ * An expected object named NAME.expected.obj is compared with NAME.obj. If both directories are the same, only
+ * the NAME.expected.obj files are compared, which is the layout of test/testfiles.
+ *
+ * @param num_differing_files pairs that differ, including expected objects without an actual one
+ * @return exit_t
+ */
+exit_t diff_directories(const char *expected_dir_name, const char *actual_dir_name, size_t max_reported, FILE *report,
+                        size_t *num_differing_files) {
+    struct stat expected_status, actual_status;
+    if(stat(expected_dir_name, &expected_status) == -1 || stat(actual_dir_name, &actual_status) == -1) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read directory (%s or %s)", expected_dir_name, actual_dir_name);
+    }
+    bool same_dir = expected_status.st_dev == actual_status.st_dev && expected_status.st_ino == actual_status.st_ino;
+    DIR *expected_dir = opendir(expected_dir_name);
+    if(!expected_dir) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read directory (%s)", expected_dir_name);
+    }
+    size_t num_names = 0, capacity = 64;
+    char **names = malloc(capacity * sizeof(char *));
+    struct dirent *entry;
+    while((entry = readdir(expected_dir))) {
+        if(!has_suffix(entry->d_name, same_dir ? EXPECTED_SUFFIX : OBJ_EXTENSION)) {
+            continue;
+        }
+        if(num_names == capacity) {
+            capacity *= 2;
+            names = realloc(names, capacity * sizeof(char *));
+        }
+        names[num_names++] = strdup(entry->d_name);
+    }
+    closedir(expected_dir);
+    qsort(names, num_names, sizeof(char *), compare_names);
+
+    exit_t result = success();
+    *num_differing_files = 0;
+    for(size_t i = 0; i < num_names && !result.code; i++) {
+        size_t length = strlen(names[i]);
+        char actual_name[length + 1];
+        strcpy(actual_name, names[i]);
+        if(has_suffix(actual_name, EXPECTED_SUFFIX)) {
+            strcpy(actual_name + length - strlen(EXPECTED_SUFFIX), OBJ_EXTENSION);
+        }
+        char expected_path[strlen(expected_dir_name) + length + 2], actual_path[strlen(actual_dir_name) + length + 2];
+        sprintf(expected_path, "%s/%s", expected_dir_name, names[i]);
+        sprintf(actual_path, "%s/%s", actual_dir_name, actual_name);
+        if(access(actual_path, F_OK) == -1) {
+            fprintf(report, "%s: missing\n", actual_path);
+            (*num_differing_files)++;
+            continue;
+        }
+        size_t num_differences;
+        result = diff_objects(expected_path, actual_path, max_reported, report, &num_differences);
+        *num_differing_files += !result.code && num_differences > 0;
+    }
+    if(!result.code) {
+        fprintf(report, "%zu pair%s compared, %zu differ%s\n", num_names, num_names == 1 ? "" : "s", *num_differing_files,
+                *num_differing_files == 1 ? "s" : "");
+    }
+
+    for(size_t i = 0; i < num_names; i++) {
+        free(names[i]);
+    }
+    free(names);
+    return result;
+}
@@ -5,14 +5,14 @@ exit_t do_syntax_analysis(linemetadata_t *tokenized_lines[]) {
 
     exit_t result;
 
-    //1st instruction must be .ORIG
-    linemetadata_t *line_metadata = tokenized_lines[0];
-    if((result = parse_orig(line_metadata)).code) {
+    //1st instruction must be .ORIG, any other .ORIG starts a new segment
+    if((result = compute_segments(tokenized_lines)).code) {
         return result;
     }
-    memaddr_t origin = line_metadata->machine_instruction;
+    memaddr_t origin = tokenized_lines[0]->machine_instruction;
 
-    memaddr_t address_offset = 1;
+    linemetadata_t *line_metadata;
+    size_t address_offset = 1;
     while((line_metadata = tokenized_lines[address_offset])) {
         if(!line_metadata->tokens) {
             //instruction has already been parsed
@@ -20,7 +20,15 @@ exit_t do_syntax_analysis(linemetadata_t *tokenized_lines[]) {
             continue;
         }
         linetype_t line_type = compute_line_type(line_metadata->tokens[0]);
-        if(line_type == LABEL) {
+        if(line_type == ORIG_DIRECTIVE) {
+            //already parsed when computing the segments
+            result = success();
+        }
+        else if(line_type == STRINGP_DIRECTIVE) {
+            //already expanded by the lexer
+            result = success();
+        }
+        else if(line_type == LABEL) {
             //two labels in the same line is disallowed 
             return failure(EXIT_FAILURE, "ERROR (line %d): Invalid opcode ('%s')", line_metadata->line_number, line_metadata->tokens[0]);
         }
@@ -0,0 +1,373 @@
+/**
+ * @file peephole.c
+ * @brief Peephole optimizer (-O)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The optimizer works on the instructions of `tokenized_lines` before they are encoded, so that the symbol table
+ * is used to follow labels and the rewritten lines are encoded by the parser as any other line.
+ *
+ * Rewrites:
+ * - branch threading: a branch to an unconditional branch (or to a branch taken under a superset of its condition
+ *   codes) is redirected to the final target
+ * - branches to the next instruction are removed
+ * - `ADD Rx,Rx,#0` is removed when the condition codes are already set from Rx by the previous instruction
+ *   (and no label points to the ADD) or when they are overwritten by the next instruction
+ * - a load of the value just loaded from or stored into the same label is removed or replaced with a register copy
+ * - a conditional branch over an unconditional branch (`BRn SKIP`, `BR ELSE`, `SKIP ...`) is inverted to branch
+ *   to the target of the unconditional one (`BRzp ELSE`), which is removed
+ * - a constant built after `AND Rx,Rx,#0` by a run of `ADD Rx,Rx,#imm` and `NOT Rx,Rx` (e.g. the negation of
+ *   a constant) is folded into a single `ADD Rx,Rx,#imm` when it fits in 5 bits
+ *
+ * Rewrites of a pass look at the neighbours of a line, so the line following a rewritten line is not considered
+ * until the next pass. Passes are repeated until no more rewrites are found.
+ *
+ * Removing instructions moves the words after them. Labels are remapped, but offsets given as numbers are not,
+ * so the words spanned by a numeric offset (e.g. `BRnz #1`) and the word it points to are never removed.
+ */
+
+#include "../include/lc3.h"
+
+#define MAX_THREADING_HOPS 16
+#define MAX_OPTIMIZED_LINE_LENGTH 100
+
+static const char *br_mnemonics[8] = { NULL, "BRp", "BRz", "BRzp", "BRn", "BRnp", "BRnz", "BRnzp" };
+
+typedef struct peephole_stats {
+    int num_rewritten;
+    int num_removed;
+} peephole_stats_t;
+
+static bool is_instruction(const linemetadata_t *line_metadata) {
+    return line_metadata && line_metadata->tokens && compute_line_type(line_metadata->tokens[0]) == OPCODE;
+}
+
+static bool is_branch(opcode_t opcode) {
+    return opcode == BR || opcode == BRn || opcode == BRz || opcode == BRp || opcode == BRnz || opcode == BRnp || opcode == BRzp || opcode == BRnzp;
+}
+
+/**
+ * @brief Register whose value sets the condition codes after executing the instruction, or -1 if the instruction does not set them
+ */
+static int condition_codes_register(const linemetadata_t *line_metadata) {
+    if(!is_instruction(line_metadata) || line_metadata->num_tokens < 2) {
+        return -1;
+    }
+    switch(compute_opcode_type(line_metadata->tokens[0])) {
+    case ADD: case AND: case NOT: case LD: case LDI: case LDR:
+        return parse_register(line_metadata->tokens[1]);
+    default:
+        return -1;
+    }
+}
+
+/**
+ * @brief Label operand of a PC-relative instruction, or NULL if the operand is a number or an undefined label
+ */
+static const char *label_operand(const linemetadata_t *line_metadata) {
+    int num_bits;
+    int operand = pc_relative_operand(line_metadata, &num_bits);
+    long offset;
+    if(operand == -1 || numeric_offset(line_metadata->tokens[operand], &offset) || !lookup(line_metadata->tokens[operand])) {
+        return NULL;
+    }
+    return line_metadata->tokens[operand];
+}
+
+static bool is_zero(const char *token) {
+    long value;
+    return numeric_offset(token, &value) && value == 0;
+}
+
+/**
+ * @brief Record the rewrite of a line (or its removal if `text` is NULL) and report it
+ */
+static exit_t rewrite_line(linemetadata_t *line_metadata, const char *text, const char *reason, slot_rewrite_t *rewrite, peephole_stats_t *stats, FILE *report) {
+    rewrite->rewritten = true;
+    if(text) {
+        rewrite->lines = malloc(sizeof(linemetadata_t *));
+        if(!rewrite->lines || !(rewrite->lines[0] = new_line(text, line_metadata->line_number))) {
+            return failure(EXIT_FAILURE, "ERROR (line %d): Out of memory error", line_metadata->line_number);
+        }
+        rewrite->num_lines = 1;
+        stats->num_rewritten++;
+    }
+    else {
+        stats->num_removed++;
+    }
+    if(report) {
+        fprintf(report, "peephole (line %d): ", line_metadata->line_number);
+        print_line_tokens(report, line_metadata);
+        fprintf(report, " -> %s (%s)\n", text ? text : "removed", reason);
+    }
+    return success();
+}
+
+/**
+ * @brief Follow the chain of branches starting at the target of the given branch
+ *
+ * @return const char* label of the final target, which is within range of the branch
+ */
+static const char *thread_branch(linemetadata_t *tokenized_lines[], size_t num_slots, size_t slot) {
+    linemetadata_t *line_metadata = tokenized_lines[slot];
+    int condition_codes = branch_condition_codes(compute_opcode_type(line_metadata->tokens[0]));
+    const char *label = line_metadata->tokens[1];
+    for(int hop = 0; hop < MAX_THREADING_HOPS; hop++) {
+        size_t target_slot = lookup(label)->val;
+        if(target_slot >= num_slots || target_slot == slot) {
+            break;
+        }
+        linemetadata_t *target = tokenized_lines[target_slot];
+        if(!is_instruction(target) || !is_branch(compute_opcode_type(target->tokens[0]))) {
+            break;
+        }
+        const char *next_label = label_operand(target);
+        //the target branch must be taken whenever the first one is taken
+        if(!next_label || (condition_codes & ~branch_condition_codes(compute_opcode_type(target->tokens[0])))) {
+            break;
+        }
+        long offset;
+        if(label_offset(next_label, slot, line_metadata->line_number, &offset).code || offset < -256 || offset > 255) {
+            break;
+        }
+        label = next_label;
+    }
+    return label;
+}
+
+/**
+ * @brief Whether the line is `OPCODE Rx,Rx...` on the given register
+ */
+static bool updates_register(const linemetadata_t *line_metadata, opcode_t opcode, int reg, int num_tokens) {
+    return is_instruction(line_metadata) && line_metadata->num_tokens == num_tokens && compute_opcode_type(line_metadata->tokens[0]) == opcode
+        && parse_register(line_metadata->tokens[1]) == reg && parse_register(line_metadata->tokens[2]) == reg;
+}
+
+/**
+ * @brief Find the longest run of `ADD Rx,Rx,#imm` and `NOT Rx,Rx` after `AND Rx,Rx,#0` in `slot` leaving in Rx a
+ * constant that fits in the immediate of a single ADD
+ *
+ * @return size_t last slot of the run, `slot` if there is no run of at least two instructions to fold
+ */
+static size_t constant_run(linemetadata_t *tokenized_lines[], size_t num_slots, size_t slot, const bool label_targets[],
+    const bool pinned_slots[], int16_t *constant) {
+    int reg = parse_register(tokenized_lines[slot]->tokens[1]);
+    int16_t value = 0;
+    size_t last = slot;
+    for(size_t run = slot + 1; run < num_slots && !label_targets[run] && !pinned_slots[run]; run++) {
+        long immediate;
+        if(updates_register(tokenized_lines[run], NOT, reg, 3)) {
+            value = ~value;
+        }
+        else if(updates_register(tokenized_lines[run], ADD, reg, 4) && numeric_offset(tokenized_lines[run]->tokens[3], &immediate)) {
+            value += immediate;
+        }
+        else {
+            break;
+        }
+        if(run - slot >= 2 && value >= -16 && value <= 15) {
+            last = run;
+            *constant = value;
+        }
+    }
+    return last;
+}
+
+/**
+ * @brief Find the rewrites of the current version of the program
+ */
+static exit_t collect_peephole_rewrites(linemetadata_t *tokenized_lines[], size_t num_slots, const bool label_targets[], const bool pinned_slots[],
+    slot_rewrite_t rewrites[], peephole_stats_t *stats, FILE *report) {
+    char text[MAX_OPTIMIZED_LINE_LENGTH];
+    for(size_t slot = 1; slot < num_slots; slot++) {
+        linemetadata_t *line_metadata = tokenized_lines[slot];
+        if(!is_instruction(line_metadata)) {
+            continue;
+        }
+        linemetadata_t *previous = is_instruction(tokenized_lines[slot - 1]) ? tokenized_lines[slot - 1] : NULL;
+        linemetadata_t *following = tokenized_lines[slot + 1];
+        char **tokens = line_metadata->tokens;
+        opcode_t opcode = compute_opcode_type(tokens[0]);
+        const char *label = label_operand(line_metadata);
+        bool allow_removals = !pinned_slots[slot];
+        exit_t result = success();
+
+        if(is_branch(opcode) && label) {
+            long offset;
+            if((result = label_offset(label, slot, line_metadata->line_number, &offset)).code) {
+                return result;
+            }
+            const char *final_label;
+            if(offset == 0) {
+                if(!allow_removals) {
+                    continue;
+                }
+                result = rewrite_line(line_metadata, NULL, "branch to the next instruction", &rewrites[slot], stats, report);
+            }
+            else if(strcmp(final_label = thread_branch(tokenized_lines, num_slots, slot), label) != 0) {
+                snprintf(text, MAX_OPTIMIZED_LINE_LENGTH, "%s %s", tokens[0], final_label);
+                result = rewrite_line(line_metadata, text, "branch threading", &rewrites[slot], stats, report);
+            }
+            else if(branch_condition_codes(opcode) != 7 && offset == 1 && is_instruction(following) && !label_targets[slot + 1]
+                && !pinned_slots[slot + 1] && branch_condition_codes(compute_opcode_type(following->tokens[0])) == 7
+                && is_branch(compute_opcode_type(following->tokens[0])) && label_operand(following)) {
+                //the target of the unconditional branch must be within range of the inverted one
+                if((result = label_offset(label_operand(following), slot, line_metadata->line_number, &offset)).code) {
+                    return result;
+                }
+                if(offset < -256 || offset > 255) {
+                    continue;
+                }
+                snprintf(text, MAX_OPTIMIZED_LINE_LENGTH, "%s %s", br_mnemonics[7 & ~branch_condition_codes(opcode)], label_operand(following));
+                if((result = rewrite_line(line_metadata, text, "inverted branch over an unconditional branch", &rewrites[slot], stats, report)).code) {
+                    return result;
+                }
+                slot++;
+                result = rewrite_line(following, NULL, "unconditional branch folded into the previous branch", &rewrites[slot], stats, report);
+            }
+            else {
+                continue;
+            }
+        }
+        else if(opcode == AND && line_metadata->num_tokens == 4 && is_zero(tokens[3]) && updates_register(line_metadata, AND, parse_register(tokens[1]), 4)
+            && parse_register(tokens[1]) != -1) {
+            int16_t constant = 0;
+            size_t last = constant_run(tokenized_lines, num_slots, slot, label_targets, pinned_slots, &constant);
+            if(last == slot) {
+                continue;
+            }
+            snprintf(text, MAX_OPTIMIZED_LINE_LENGTH, "ADD %s,%s,#%d", tokens[1], tokens[1], constant);
+            result = rewrite_line(tokenized_lines[slot + 1], text, "constant folded", &rewrites[slot + 1], stats, report);
+            for(size_t folded = slot + 2; !result.code && folded <= last; folded++) {
+                result = rewrite_line(tokenized_lines[folded], NULL, "constant folded", &rewrites[folded], stats, report);
+            }
+            slot = last;
+        }
+        else if(opcode == ADD && line_metadata->num_tokens >= 4 && allow_removals && parse_register(tokens[1]) != -1
+            && parse_register(tokens[1]) == parse_register(tokens[2]) && is_zero(tokens[3])) {
+            if(previous && !label_targets[slot] && condition_codes_register(previous) == parse_register(tokens[1])) {
+                result = rewrite_line(line_metadata, NULL, "condition codes already set by the previous instruction", &rewrites[slot], stats, report);
+            }
+            else if(condition_codes_register(following) != -1) {
+                result = rewrite_line(line_metadata, NULL, "condition codes overwritten by the next instruction", &rewrites[slot], stats, report);
+            }
+            else {
+                continue;
+            }
+        }
+        else if(opcode == LD && label && previous && !label_targets[slot] && line_metadata->num_tokens >= 3 && label_operand(previous)
+            && strcmp(label_operand(previous), label) == 0) {
+            opcode_t previous_opcode = compute_opcode_type(previous->tokens[0]);
+            int source_register = parse_register(previous->tokens[1]);
+            int destination_register = parse_register(tokens[1]);
+            if((previous_opcode != LD && previous_opcode != ST) || source_register == -1 || destination_register == -1) {
+                continue;
+            }
+            if(source_register == destination_register && allow_removals && (previous_opcode == LD || condition_codes_register(following) != -1)) {
+                result = rewrite_line(line_metadata, NULL, "value already in register", &rewrites[slot], stats, report);
+            }
+            else {
+                snprintf(text, MAX_OPTIMIZED_LINE_LENGTH, "ADD R%d,R%d,#0", destination_register, source_register);
+                result = rewrite_line(line_metadata, text, "value already in register, memory read saved", &rewrites[slot], stats, report);
+            }
+        }
+        else {
+            continue;
+        }
+
+        if(result.code) {
+            return result;
+        }
+        //the next line depends on this one, it is reconsidered in the next pass
+        slot++;
+    }
+    return success();
+}
+
+/**
+ * @brief Mark the words spanned by PC-relative offsets given as numbers and the words they point to, which must not
+ * be removed
+ *
+ * @param tokenized_lines
+ * @param num_slots
+ * @param pinned_slots array with `num_slots` elements
+ */
+static void pin_numeric_offset_spans(linemetadata_t *tokenized_lines[], long num_slots, bool pinned_slots[]) {
+    for(long slot = 0; slot < num_slots; slot++) {
+        int num_bits;
+        int operand = pc_relative_operand(tokenized_lines[slot], &num_bits);
+        long offset;
+        if(operand == -1 || !numeric_offset(tokenized_lines[slot]->tokens[operand], &offset)) {
+            continue;
+        }
+        long target = slot + 1 + offset;
+        long first = target < slot + 1 ? target : slot + 1;
+        long last = target < slot + 1 ? slot + 1 : target + 1;
+        //removing the target word would make the offset point to the word after it
+        for(long pinned = first < 0 ? 0 : first; pinned < last && pinned < num_slots; pinned++) {
+            pinned_slots[pinned] = true;
+        }
+    }
+}
+
+/**
+ * @brief Apply peephole optimizations until no more rewrites are found
+ *
+ * Must be run after the lexical analysis and before the syntax analysis
+ *
+ * @param tokenized_lines
+ * @param options
+ * @return exit_t
+ */
+exit_t peephole_optimize(linemetadata_t *tokenized_lines[], const options_t *options) {
+    peephole_stats_t stats = { 0 };
+
+    int num_rewrites;
+    do {
+        exit_t result;
+        if((result = compute_segments(tokenized_lines)).code) {
+            return result;
+        }
+        size_t num_slots = count_slots(tokenized_lines);
+        slot_rewrite_t *rewrites = calloc(num_slots, sizeof(slot_rewrite_t));
+        size_t *slot_map = malloc((num_slots + 1) * sizeof(size_t));
+        bool *label_targets = calloc(num_slots + 1, sizeof(bool));
+        bool *pinned_slots = calloc(num_slots, sizeof(bool));
+        if(!rewrites || !slot_map || !label_targets || !pinned_slots) {
+            free(rewrites);
+            free(slot_map);
+            free(label_targets);
+            free(pinned_slots);
+            return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+        }
+        for(node_t *node = next(true); node; node = next(false)) {
+            if(node->val <= num_slots) {
+                label_targets[node->val] = true;
+            }
+        }
+        pin_numeric_offset_spans(tokenized_lines, num_slots, pinned_slots);
+
+        int previous_total = stats.num_rewritten + stats.num_removed;
+        result = collect_peephole_rewrites(tokenized_lines, num_slots, label_targets, pinned_slots, rewrites, &stats, options->report);
+        num_rewrites = stats.num_rewritten + stats.num_removed - previous_total;
+        if(!result.code && num_rewrites > 0) {
+            compute_slot_map(rewrites, num_slots, slot_map);
+            result = apply_slot_rewrites(tokenized_lines, rewrites, slot_map);
+        }
+        free_slot_rewrites(rewrites, num_slots);
+        free(slot_map);
+        free(label_targets);
+        free(pinned_slots);
+        if(result.code) {
+            return result;
+        }
+    } while(num_rewrites > 0);
+
+    if(options->report && stats.num_rewritten + stats.num_removed > 0) {
+        fprintf(options->report, "peephole: %d instructions rewritten, %d instructions removed (-%d words)\n", stats.num_rewritten, stats.num_removed, stats.num_removed);
+    }
+    return success();
+}
@@ -0,0 +1,227 @@
+/**
+ * @file relaxation.c
+ * @brief Rewriting of instructions whose label is out of the range of their PC offset
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * PC-relative instructions can only reach labels within the range of their PCoffset9 (BR, LD, ST, LDI, STI, LEA)
+ * or PCoffset11 (JSR) field. When a label is out of range, the instruction is replaced with the shortest sequence
+ * reaching the whole address space through a pointer word (.FILL LABEL) placed next to the sequence:
+ *
+ * | instruction  | relaxed form                                  | words | instructions | memory reads |
+ * |--------------|-----------------------------------------------|-------|--------------|--------------|
+ * | BRcc L       | BR!cc #3; LD Rn,#1; JMP Rn; .FILL L           | +3    | +2 if taken  | +1 if taken  |
+ * | BR L         | LD Rn,#1; JMP Rn; .FILL L                     | +2    | +1           | +1           |
+ * | JSR L        | LD R7,#1; BR #1; .FILL L; JSRR R7             | +3    | +2           | +1           |
+ * | LD Rd,L      | LDI Rd,#1; BR #1; .FILL L                     | +2    | +1           | +1           |
+ * | ST Rs,L      | STI Rs,#1; BR #1; .FILL L                     | +2    | +1           | +1           |
+ * | LEA Rd,L     | LD Rd,#1; BR #1; .FILL L                      | +2    | +1           | +1           |
+ * | LDI Rd,L     | LDI Rd,#1; BR #1; .FILL L; LDR Rd,Rd,#0       | +3    | +2           | +1           |
+ * | STI Rs,L     | LDI Rn,#2; STR Rs,Rn,#0; BR #1; .FILL L       | +3    | +2           | +1           |
+ *
+ * Branches need a scratch register (Rn) provided by the user, as the LC3 has no absolute jump.
+ *
+ * Relaxing an instruction makes the program longer, which may push other labels out of range, so the pass is
+ * repeated until no more instructions need to be relaxed. Instructions are never shrunk back, so the
+ * process is guaranteed to finish.
+ */
+
+#include "../include/lc3.h"
+
+#define MAX_RELAXED_LINES 4
+#define MAX_RELAXED_LINE_LENGTH 100
+
+typedef struct relaxation {
+    char lines[MAX_RELAXED_LINES][MAX_RELAXED_LINE_LENGTH];
+    int num_lines;
+    int extra_instructions; /**< additional instructions executed */
+    int extra_reads; /**< additional memory reads */
+    bool only_when_taken; /**< costs are only paid when the branch is taken */
+} relaxation_t;
+
+// indexed by condition codes (nzp)
+static const char *branch_mnemonics[] = { NULL, "BRp", "BRz", "BRzp", "BRn", "BRnp", "BRnz", "BRnzp" };
+
+static exit_t missing_scratch_register(const linemetadata_t *line_metadata, long offset) {
+    return failure(EXIT_FAILURE, "ERROR (line %d): Value of offset %ld is outside the range [-256, 255] and relaxing %s requires a scratch register (--relax=Rn)", line_metadata->line_number, offset, line_metadata->tokens[0]);
+}
+
+/**
+ * @brief Work out the relaxed form of an instruction whose label is out of range
+ */
+static exit_t relax_instruction(const linemetadata_t *line_metadata, const options_t *options, long offset, relaxation_t *relaxation) {
+    char **tokens = line_metadata->tokens;
+    int scratch_register = options->relax_register;
+    opcode_t opcode = compute_opcode_type(tokens[0]);
+    char (*lines)[MAX_RELAXED_LINE_LENGTH] = relaxation->lines;
+    relaxation->extra_instructions = 1;
+    relaxation->extra_reads = 1;
+    relaxation->only_when_taken = false;
+
+    switch(opcode) {
+    case JSR:
+        snprintf(lines[0], MAX_RELAXED_LINE_LENGTH, "LD R7,#1");
+        snprintf(lines[1], MAX_RELAXED_LINE_LENGTH, "BRnzp #1");
+        snprintf(lines[2], MAX_RELAXED_LINE_LENGTH, ".FILL %s", tokens[1]);
+        snprintf(lines[3], MAX_RELAXED_LINE_LENGTH, "JSRR R7");
+        relaxation->num_lines = 4;
+        relaxation->extra_instructions = 2;
+        break;
+    case LD: case ST: case LEA: case LDI:
+        snprintf(lines[0], MAX_RELAXED_LINE_LENGTH, "%s %s,#1", opcode == LD ? "LDI" : (opcode == ST ? "STI" : (opcode == LEA ? "LD" : "LDI")), tokens[1]);
+        snprintf(lines[1], MAX_RELAXED_LINE_LENGTH, "BRnzp #1");
+        snprintf(lines[2], MAX_RELAXED_LINE_LENGTH, ".FILL %s", tokens[2]);
+        relaxation->num_lines = 3;
+        if(opcode == LDI) {
+            snprintf(lines[3], MAX_RELAXED_LINE_LENGTH, "LDR %s,%s,#0", tokens[1], tokens[1]);
+            relaxation->num_lines = 4;
+            relaxation->extra_instructions = 2;
+        }
+        break;
+    case STI:
+        if(scratch_register == -1 || scratch_register == parse_register(tokens[1])) {
+            return missing_scratch_register(line_metadata, offset);
+        }
+        snprintf(lines[0], MAX_RELAXED_LINE_LENGTH, "LDI R%d,#2", scratch_register);
+        snprintf(lines[1], MAX_RELAXED_LINE_LENGTH, "STR %s,R%d,#0", tokens[1], scratch_register);
+        snprintf(lines[2], MAX_RELAXED_LINE_LENGTH, "BRnzp #1");
+        snprintf(lines[3], MAX_RELAXED_LINE_LENGTH, ".FILL %s", tokens[2]);
+        relaxation->num_lines = 4;
+        relaxation->extra_instructions = 2;
+        break;
+    default: {
+        //branches
+        if(scratch_register == -1) {
+            return missing_scratch_register(line_metadata, offset);
+        }
+        int condition_codes = branch_condition_codes(opcode);
+        int num_lines = 0;
+        if(condition_codes != 7) {
+            //skip the jump when the condition does not hold
+            snprintf(lines[num_lines++], MAX_RELAXED_LINE_LENGTH, "%s #3", branch_mnemonics[7 - condition_codes]);
+            relaxation->extra_instructions = 2;
+            relaxation->only_when_taken = true;
+        }
+        snprintf(lines[num_lines++], MAX_RELAXED_LINE_LENGTH, "LD R%d,#1", scratch_register);
+        snprintf(lines[num_lines++], MAX_RELAXED_LINE_LENGTH, "JMP R%d", scratch_register);
+        snprintf(lines[num_lines++], MAX_RELAXED_LINE_LENGTH, ".FILL %s", tokens[1]);
+        relaxation->num_lines = num_lines;
+        break;
+    }
+    }
+    return success();
+}
+
+static void report_relaxation(FILE *report, const linemetadata_t *line_metadata, long offset, const relaxation_t *relaxation) {
+    if(!report) {
+        return;
+    }
+    fprintf(report, "relax (line %d): ", line_metadata->line_number);
+    print_line_tokens(report, line_metadata);
+    fprintf(report, " (offset %ld) ->", offset);
+    for(int i = 0; i < relaxation->num_lines; i++) {
+        fprintf(report, "%s %s", i == 0 ? "" : ";", relaxation->lines[i]);
+    }
+    fprintf(report, " [+%d words, +%d instructions, +%d memory reads%s]\n", relaxation->num_lines - 1, relaxation->extra_instructions,
+        relaxation->extra_reads, relaxation->only_when_taken ? " when taken" : "");
+}
+
+/**
+ * @brief Collect the rewrites of the instructions whose label is out of range in the current layout of the program
+ *
+ * @return exit_t
+ */
+static exit_t collect_relaxations(linemetadata_t *tokenized_lines[], size_t num_slots, const options_t *options, slot_rewrite_t rewrites[], int *num_relaxed, int *extra_words) {
+    for(size_t slot = 1; slot < num_slots; slot++) {
+        linemetadata_t *line_metadata = tokenized_lines[slot];
+        int num_bits;
+        int operand = pc_relative_operand(line_metadata, &num_bits);
+        long offset;
+        if(operand == -1 || numeric_offset(line_metadata->tokens[operand], &offset) || !lookup(line_metadata->tokens[operand])) {
+            //offsets given as numbers and undefined labels are validated by the parser
+            continue;
+        }
+        exit_t result = label_offset(line_metadata->tokens[operand], slot, line_metadata->line_number, &offset);
+        if(result.code) {
+            return result;
+        }
+        if(offset >= -(1 << (num_bits - 1)) && offset < (1 << (num_bits - 1))) {
+            continue;
+        }
+
+        relaxation_t relaxation;
+        if((result = relax_instruction(line_metadata, options, offset, &relaxation)).code) {
+            return result;
+        }
+        report_relaxation(options->report, line_metadata, offset, &relaxation);
+
+        rewrites[slot].rewritten = true;
+        rewrites[slot].lines = malloc(relaxation.num_lines * sizeof(linemetadata_t *));
+        if(!rewrites[slot].lines) {
+            return failure(EXIT_FAILURE, "ERROR (line %d): Out of memory error", line_metadata->line_number);
+        }
+        for(int i = 0; i < relaxation.num_lines; i++) {
+            if(!(rewrites[slot].lines[i] = new_line(relaxation.lines[i], line_metadata->line_number))) {
+                return failure(EXIT_FAILURE, "ERROR (line %d): Out of memory error", line_metadata->line_number);
+            }
+            rewrites[slot].num_lines++;
+        }
+        (*num_relaxed)++;
+        *extra_words += relaxation.num_lines - 1;
+    }
+    return success();
+}
+
+/**
+ * @brief Relax the instructions whose label is out of the range of their PC offset, until reaching a fixed point
+ *
+ * Must be run after the lexical analysis and before the syntax analysis
+ *
+ * @param tokenized_lines
+ * @param options
+ * @return exit_t
+ */
+exit_t relax(linemetadata_t *tokenized_lines[], const options_t *options) {
+    int total_relaxed = 0;
+    int total_extra_words = 0;
+    for(int pass = 1;; pass++) {
+        exit_t result;
+        //the layout of the segments is needed to work out offsets between segments
+        if((result = compute_segments(tokenized_lines)).code) {
+            return result;
+        }
+        size_t num_slots = count_slots(tokenized_lines);
+        slot_rewrite_t *rewrites = calloc(num_slots, sizeof(slot_rewrite_t));
+        size_t *slot_map = malloc((num_slots + 1) * sizeof(size_t));
+        if(!rewrites || !slot_map) {
+            free(rewrites);
+            free(slot_map);
+            return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+        }
+
+        int num_relaxed = 0;
+        result = collect_relaxations(tokenized_lines, num_slots, options, rewrites, &num_relaxed, &total_extra_words);
+        if(!result.code && num_relaxed > 0) {
+            compute_slot_map(rewrites, num_slots, slot_map);
+            if(!(result = check_numeric_offsets(tokenized_lines, slot_map)).code) {
+                result = apply_slot_rewrites(tokenized_lines, rewrites, slot_map);
+            }
+        }
+        free_slot_rewrites(rewrites, num_slots);
+        free(slot_map);
+        if(result.code) {
+            return result;
+        }
+
+        total_relaxed += num_relaxed;
+        if(num_relaxed == 0) {
+            if(options->report && total_relaxed > 0) {
+                fprintf(options->report, "relax: %d instructions relaxed in %d passes, +%d words\n", total_relaxed, pass - 1, total_extra_words);
+            }
+            return success();
+        }
+    }
+}
@@ -0,0 +1,170 @@
+/**
+ * @file segments.c
+ * @brief bookkeeping of the segments (.ORIG/.END blocks) a program is made of
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * The lexer stores every word of the program in `tokenized_lines` one after the other, regardless of the segment it
+ * belongs to, and the .ORIG line of each segment occupies the slot preceding the first word of the segment.
+ * The symbol table stores slots, not memory addresses, so the memory address corresponding to a slot is given by
+ * the origin of the segment containing that slot.
+ *
+ * Segments must not overlap. Overlaps are detected by marking the addresses occupied by each segment in a bitmap
+ * representing the whole address space.
+ */
+
+#include "../include/lc3.h"
+
+static segment_t *segments = NULL;
+static size_t num_segments = 0;
+static size_t segments_capacity = 0;
+static uint64_t occupancy[ADDRESS_SPACE_CARDINALITY / 64];
+
+void clear_segments() {
+    free(segments);
+    segments = NULL;
+    num_segments = 0;
+    segments_capacity = 0;
+}
+
+size_t get_num_segments() {
+    return num_segments;
+}
+
+const segment_t *get_segment(size_t i) {
+    return i < num_segments ? &segments[i] : NULL;
+}
+
+static exit_t add_segment(linemetadata_t *line_metadata, int orig_slot) {
+    if(num_segments == segments_capacity) {
+        segments_capacity = segments_capacity ? 2 * segments_capacity : 8;
+        segment_t *resized_segments = realloc(segments, segments_capacity * sizeof(segment_t));
+        if(!resized_segments) {
+            return failure(EXIT_FAILURE, "ERROR (line %d): Out of memory error", line_metadata->line_number);
+        }
+        segments = resized_segments;
+    }
+    segments[num_segments++] = (segment_t) {
+        .origin = line_metadata->machine_instruction,
+        .orig_slot = orig_slot,
+        .num_words = 0,
+        .line_number = line_metadata->line_number
+    };
+    return success();
+}
+
+/**
+ * @brief Find the segment a slot belongs to
+ *
+ * A label found right before .END gets the slot of the .ORIG line of the next segment, that's why
+ * the slot of a .ORIG line is considered to be part of the previous segment.
+ */
+static const segment_t *find_segment(int slot) {
+    if(num_segments == 0) {
+        return NULL;
+    }
+    //binary search of the last segment whose .ORIG line precedes the slot
+    size_t low = 0, high = num_segments;
+    while(high - low > 1) {
+        size_t mid = low + (high - low) / 2;
+        if(segments[mid].orig_slot < slot) {
+            low = mid;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return &segments[low];
+}
+
+/**
+ * @brief Memory address of the word stored in the given slot of `tokenized_lines`
+ *
+ * If no segments have been computed, the program is assumed to consist of a single segment whose .ORIG line is
+ * in the first slot
+ *
+ * @param slot
+ * @param address_origin address given by the first .ORIG directive
+ * @return memaddr_t
+ */
+memaddr_t slot_address(int slot, memaddr_t address_origin) {
+    const segment_t *segment = find_segment(slot);
+    if(!segment) {
+        return slot - 1 + address_origin;
+    }
+    return segment->origin + slot - segment->orig_slot - 1;
+}
+
+/**
+ * @brief Difference between the distance in memory of two slots and their distance in `tokenized_lines`
+ *
+ * The result is always 0 for slots in the same segment.
+ */
+long segment_displacement(int from_slot, int to_slot) {
+    const segment_t *from_segment = find_segment(from_slot);
+    const segment_t *to_segment = find_segment(to_slot);
+    if(from_segment == to_segment) {
+        return 0;
+    }
+    return ((long)to_segment->origin - to_segment->orig_slot) - ((long)from_segment->origin - from_segment->orig_slot);
+}
+
+/**
+ * @brief Validate that no segment overlaps with another one or exceeds the address space
+ */
+static exit_t check_segments_layout() {
+    memset(occupancy, 0, sizeof(occupancy));
+    for(size_t i = 0; i < num_segments; i++) {
+        const segment_t *segment = &segments[i];
+        if((long)segment->origin + segment->num_words > ADDRESS_SPACE_CARDINALITY) {
+            return failure(EXIT_FAILURE, "ERROR (line %d): Segment starting at x%.4X exceeds the address space", segment->line_number, segment->origin);
+        }
+        for(long address = segment->origin; address < (long)segment->origin + segment->num_words; address++) {
+            uint64_t mask = (uint64_t)1 << (address % 64);
+            if(occupancy[address / 64] & mask) {
+                return failure(EXIT_FAILURE, "ERROR (line %d): Segment starting at x%.4X overlaps with a previous segment at address x%.4lX", segment->line_number, segment->origin, address);
+            }
+            occupancy[address / 64] |= mask;
+        }
+    }
+    return success();
+}
+
+/**
+ * @brief Identify the segments of the program and validate their layout in memory
+ *
+ * Each .ORIG line found in `tokenized_lines` starts a new segment, the first line being necessarily a .ORIG line
+ *
+ * @param tokenized_lines
+ * @return exit_t
+ */
+exit_t compute_segments(linemetadata_t *tokenized_lines[]) {
+    clear_segments();
+    if(!tokenized_lines[0]) {
+        return failure(EXIT_FAILURE, "ERROR: Program without instructions%s", "");
+    }
+    exit_t result;
+    int slot = 0;
+    linemetadata_t *line_metadata;
+    while((line_metadata = tokenized_lines[slot])) {
+        if(slot == 0 || (line_metadata->tokens && compute_line_type(line_metadata->tokens[0]) == ORIG_DIRECTIVE)) {
+            if((result = parse_orig(line_metadata)).code) {
+                return result;
+            }
+            if(num_segments > 0) {
+                segments[num_segments - 1].num_words = slot - segments[num_segments - 1].orig_slot - 1;
+            }
+            if((result = add_segment(line_metadata, slot)).code) {
+                return result;
+            }
+        }
+        slot++;
+    }
+    if(num_segments > 0) {
+        segments[num_segments - 1].num_words = slot - segments[num_segments - 1].orig_slot - 1;
+    }
+    return check_segments_layout();
+}
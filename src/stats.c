@@ -0,0 +1,98 @@
+/**
+ * @file stats.c
+ * @brief Time spent in each phase of the assembly and counters of the work done (--stats=json)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * Counters are plain increments done unconditionally by the lexer and the symbol table, as they cost less than
+ * checking whether they are needed. The clock is only read when the statistics have been requested.
+ *
+ * Allocations are not counted here but by the allocation tracker (memtrack.h): the count of a file is the
+ * difference of its counter before and after the assembly. lc3as enables the tracker for --stats=json; when it
+ * is disabled, the allocations are reported as null.
+ *
+ * The statistics of each file are written as a JSON object on a single line, so that the output of a batch of
+ * files can be processed line by line.
+ */
+
+#include <time.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#include "../include/lc3.h"
+
+stats_t assembly_stats;
+static uint64_t calls_at_start; /**< memtrack_calls() when the statistics were reset */
+
+static const char *phase_names[NUM_PHASES] = {
+    "lexical_analysis", "dce", "peephole", "relaxation", "syntax_analysis", "reports", "debug_info", "symbol_table",
+    "object_file"
+};
+
+const char *phase_name(phase_t phase) {
+    return phase_names[phase];
+}
+
+uint64_t monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void reset_stats() {
+    memset(&assembly_stats, 0, sizeof(assembly_stats));
+    reset_dict_stats();
+    calls_at_start = memtrack_calls();
+}
+
+/**
+ * @brief Set the allocations made since the statistics were reset
+ */
+void count_allocations() {
+    assembly_stats.allocations = memtrack_calls() - calls_at_start;
+}
+
+/**
+ * @brief Add the size of the given file to the bytes written
+ */
+void add_written_bytes(const char *file_name) {
+    struct stat file_stat;
+    if(stat(file_name, &file_stat) == 0) {
+        assembly_stats.bytes_written += file_stat.st_size;
+    }
+}
+
+/**
+ * @brief Write the statistics of the assembly of a file as a JSON object on a single line
+ *
+ * Files that could not be assembled are reported as well, with the error that stopped the assembly
+ */
+void write_stats_json(FILE *stream, const char *assembly_file_name, const exit_t *result) {
+    assembly_stats.dict = get_dict_stats();
+
+    fprintf(stream, "{\"file\": ");
+    print_json_string(stream, assembly_file_name);
+    if(result->code) {
+        fprintf(stream, ", \"error\": ");
+        print_json_string(stream, result->desc ? result->desc : "");
+    }
+    fprintf(stream, ", \"total_ns\": %" PRIu64 ", \"phases_ns\": {", assembly_stats.total_ns);
+    for(int phase = 0; phase < NUM_PHASES; phase++) {
+        fprintf(stream, "%s\"%s\": %" PRIu64, phase ? ", " : "", phase_names[phase], assembly_stats.phase_ns[phase]);
+    }
+    fprintf(stream, "}, \"counters\": {\"lines\": %zu, \"tokens\": %zu, \"labels\": %zu, \"words\": %zu, "
+            "\"bytes_written\": %zu, \"allocations\": ", assembly_stats.lines, assembly_stats.tokens, assembly_stats.dict.keys, assembly_stats.words,
+            assembly_stats.bytes_written);
+    if(memtrack_enabled()) {
+        fprintf(stream, "%" PRIu64 ", ", assembly_stats.allocations);
+    }
+    else {
+        fprintf(stream, "null, ");
+    }
+    fprintf(stream, "\"lookups\": %" PRIu64 ", \"lookup_probes\": %" PRIu64 ", \"probes_per_lookup\": %.2f, "
+            "\"buckets\": %zu, \"used_buckets\": %zu, \"longest_chain\": %zu}}\n", assembly_stats.dict.lookups,
+            assembly_stats.dict.probes, assembly_stats.dict.lookups ? (double)assembly_stats.dict.probes / assembly_stats.dict.lookups : 0.0,
+            assembly_stats.dict.buckets, assembly_stats.dict.used_buckets, assembly_stats.dict.longest_chain);
+}
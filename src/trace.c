@@ -0,0 +1,135 @@
+/**
+ * @file trace.c
+ * @brief Chrome trace-event output of a batch of assemblies (--trace)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * Workers are processes (see batch.c), so each one has its own buffer of events with a single writer: recording
+ * an event is a store in the buffer, without any lock or system call. When the buffer is full it is written to
+ * the file of the worker, so long batches lose no event and keep a bounded amount of memory.
+ *
+ * Events are written one per line, each one preceded by a comma, so that the files of the workers can be
+ * concatenated after the metadata events that open the array of the trace.
+ *
+ * Names of events are not copied: they must remain valid until tracing stops (names of phases and file names
+ * given on the command line).
+ */
+
+#include <inttypes.h>
+#include "../include/lc3.h"
+#include "../include/trace.h"
+
+typedef struct {
+    const char *category;
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} trace_event_t;
+
+static trace_event_t events[TRACE_BUFFER_CAPACITY];
+static size_t num_events;
+static FILE *worker_file;
+static int worker_id;
+
+static void worker_file_name(char *file_name, size_t size, const char *trace_file_name, int worker) {
+    snprintf(file_name, size, "%s.%d", trace_file_name, worker);
+}
+
+/**
+ * @brief Start recording the events of the given worker, which are written to <trace_file_name>.<worker>
+ */
+exit_t trace_start(const char *trace_file_name, int worker) {
+    char file_name[strlen(trace_file_name) + 12];
+    worker_file_name(file_name, sizeof(file_name), trace_file_name, worker);
+    worker_file = fopen(file_name, "w");
+    if(!worker_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", file_name);
+    }
+    worker_id = worker;
+    num_events = 0;
+    return success();
+}
+
+bool tracing() {
+    return worker_file != NULL;
+}
+
+static void write_events() {
+    for(size_t i = 0; i < num_events; i++) {
+        //trace-event timestamps are in microseconds
+        fprintf(worker_file, ",{\"name\": ");
+        print_json_string(worker_file, events[i].name);
+        fprintf(worker_file, ", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d}\n",
+                events[i].category, events[i].start_ns / 1000.0, (events[i].end_ns - events[i].start_ns) / 1000.0, worker_id);
+    }
+    num_events = 0;
+}
+
+/**
+ * @brief Record an event spanning from `start_ns` to `end_ns` (monotonic clock) in the worker
+ */
+void trace_span(const char *category, const char *name, uint64_t start_ns, uint64_t end_ns) {
+    if(!worker_file) {
+        return;
+    }
+    if(num_events == TRACE_BUFFER_CAPACITY) {
+        write_events();
+    }
+    events[num_events++] = (trace_event_t) { .category = category, .name = name, .start_ns = start_ns, .end_ns = end_ns };
+}
+
+/**
+ * @brief Write the events still buffered and close the file of the worker
+ */
+exit_t trace_stop() {
+    if(!worker_file) {
+        return success();
+    }
+    write_events();
+    int write_error = ferror(worker_file);
+    write_error |= fclose(worker_file);
+    worker_file = NULL;
+    if(write_error) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't write the trace of worker %d", worker_id);
+    }
+    return success();
+}
+
+/**
+ * @brief Gather the events written by the workers in the trace file and remove the files of the workers
+ *
+ * Workers whose file is missing (e.g. because they could not create it) are skipped
+ */
+exit_t trace_merge(const char *trace_file_name, int num_workers) {
+    FILE *trace_file = fopen(trace_file_name, "w");
+    if(!trace_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't open file (%s)", trace_file_name);
+    }
+    fprintf(trace_file, "{\"traceEvents\": [\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"lc3as\"}}\n");
+    char file_name[strlen(trace_file_name) + 12];
+    char buffer[BUFSIZ];
+    for(int worker = 0; worker < num_workers; worker++) {
+        fprintf(trace_file, ",{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"worker %d\"}}\n", worker, worker);
+        worker_file_name(file_name, sizeof(file_name), trace_file_name, worker);
+        FILE *events_file = fopen(file_name, "r");
+        if(!events_file) {
+            continue;
+        }
+        size_t num_bytes;
+        while((num_bytes = fread(buffer, 1, sizeof(buffer), events_file)) > 0) {
+            fwrite(buffer, 1, num_bytes, trace_file);
+        }
+        fclose(events_file);
+        remove(file_name);
+    }
+    fprintf(trace_file, "]}\n");
+    int write_error = ferror(trace_file);
+    write_error |= fclose(trace_file);
+    if(write_error) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't write file (%s)", trace_file_name);
+    }
+    return success();
+}
@@ -47,6 +47,8 @@ exit_t do_exit(int exit_code, char *format, ...) {
     char *err = NULL;
     if(format) {
         err = malloc(errdesc_length * sizeof(char));
+        //callers may release the description with free
+        memtrack_account(MEM_DIAGNOSTICS, errdesc_length * sizeof(char));
         va_list ap;
         va_start(ap, format);
         int result = vsnprintf(err, errdesc_length, format, ap);
@@ -63,8 +65,10 @@ exit_t success() {
 }
 
 void free_err(exit_t err) {
-    if(err.desc)
+    if(err.desc) {
+        memtrack_account(MEM_DIAGNOSTICS, -(long)(ERR_DESC_LENGTH * sizeof(char)));
         free(err.desc);
+    }
 }
 
 /**
@@ -112,8 +116,8 @@ bool strtolong(char *str, long *num, int base) {
  * 
  * The string passed as argument corresponds to a single line of the asm file.
  * 
- * If the line is a .STRINGZ directive, the line is split into 2 tokens (ignoring the specified delimiters):
- * - one corresponding to the keyword .STRINGZ  
+ * If the line is a .STRINGZ (or .STRINGP) directive, the line is split into 2 tokens (ignoring the specified delimiters):
+ * - one corresponding to the keyword .STRINGZ (or .STRINGP)
  * - another corresponding to the rest of the line
  * 
  * The second token will later on be parsed in order to process the content of the characters in between the
@@ -125,7 +129,7 @@ bool strtolong(char *str, long *num, int base) {
  * @return char** 
  */
 char **split_tokens(char *str, int *num_tokens, const char *delimiters) {    
-    char **tokens = malloc(MAX_NUM_TOKENS * sizeof(char *));
+    char **tokens = tracked_malloc(MAX_NUM_TOKENS * sizeof(char *), MEM_TOKENS);
     if(tokens == NULL) {
         seterrdesc("out of memory\n");
         return NULL;
@@ -134,7 +138,7 @@ char **split_tokens(char *str, int *num_tokens, const char *delimiters) {
     *num_tokens = 0;
     char *pch = strtok(str, delimiters);
     while(pch != NULL) {
-        if(strcmp(pch, ".STRINGZ") == 0) {
+        if(strcmp(pch, ".STRINGZ") == 0 || strcmp(pch, ".STRINGP") == 0) {
             tokens[(*num_tokens)++] = pch;
             tokens[(*num_tokens)++] = (pch+strlen(".STRINGZ")+1);
             break;
@@ -144,14 +148,14 @@ char **split_tokens(char *str, int *num_tokens, const char *delimiters) {
     }
 
     if(*num_tokens == 0) {
-        free(tokens);
+        tracked_free(tokens);
         return NULL;
     }
 
-    char **resized_tokens = realloc(tokens, *num_tokens * sizeof(char *));
+    char **resized_tokens = tracked_realloc(tokens, *num_tokens * sizeof(char *), MEM_TOKENS);
     if(resized_tokens == NULL) {
         seterrdesc("out of memory\n");
-        free(tokens);
+        tracked_free(tokens);
         return NULL;
     }
 
@@ -0,0 +1,633 @@
+/**
+ * @file vm.c
+ * @brief Virtual machine that runs LC3 object files (lc3vm)
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * Implementation notes
+ * ====================
+ *
+ * vm_run keeps the registers, the PC and the condition codes in local variables, so that the compiler can keep
+ * them in machine registers, and only writes them back to vm_t around the slow paths (devices, service routines)
+ * and when it stops. The condition codes are kept as the last value written to a register (`result`), which is
+ * cheaper than computing N, Z and P after every instruction that sets them: they are only computed by BR and
+ * when the PSR is written back.
+ *
+ * With GCC and Clang, instructions are dispatched with a computed goto (a table of label addresses, a GNU
+ * extension): every handler ends with its own indirect jump, whose target the CPU predicts separately, instead
+ * of jumping back to a single switch. Other compilers use the switch.
+ *
+ * The loop does not dispatch on the opcode of the word in memory but on its decoded instruction (vm_decoded_t),
+ * whose handler is already specialized for the addressing mode (ADD and AND with a register or an immediate, JSR
+ * and JSRR, JMP and JMPT, BR always taken or never taken), and whose operands need no shifting, masking nor
+ * sign extension. Words are decoded by the VM_DO_DECODE handler (0, so vm_init leaves the whole memory undecoded) the
+ * first time they are fetched. Stores check the bit of their page in `decoded_pages` and only touch `decoded`
+ * when the page holds decoded instructions, which data pages seldom do.
+ */
+
+#include "../include/lc3.h"
+#include "../include/vm.h"
+
+#if defined(__GNUC__)
+#define COMPUTED_GOTO
+#endif
+
+#define SIGN_EXTEND(value, num_bits) ((int16_t)((uint16_t)(value) << (16 - (num_bits))) >> (16 - (num_bits)))
+#define DR(instruction) (((instruction) >> 9) & 7)
+#define SR1(instruction) (((instruction) >> 6) & 7)
+#define PAGE_BITS 12 // the MPR has a bit for each 4K page
+#define ALL_PAGES 0xFFFF
+#define DEVICE_READY 0x8000
+#define MCR_RUN 0x8000
+#define CONDITION_CODES (VM_PSR_N | VM_PSR_Z | VM_PSR_P)
+#define IN_PROMPT "\nInput a character> " // same prompt as lc3os.asm
+#define DECODED_PAGE(address) ((address) / VM_DECODED_PAGE_SIZE)
+#define DECODED_PAGE_BIT(address) (UINT64_C(1) << DECODED_PAGE(address) % 64)
+
+
+typedef enum {
+    TRAP_GETC = 0x20,
+    TRAP_OUT,
+    TRAP_PUTS,
+    TRAP_IN,
+    TRAP_PUTSP,
+    TRAP_HALT
+} trap_vector_t;
+
+static int read_stdin(void __attribute__((unused)) *context) {
+    //prompts are shown before the machine waits for input
+    fflush(stdout);
+    return getchar();
+}
+
+static void write_stdout(int c, void __attribute__((unused)) *context) {
+    putchar(c);
+}
+
+/**
+ * @brief Reset the machine: memory and registers cleared, supervisor mode, Z set, standard input and output
+ */
+void vm_init(vm_t *vm) {
+    memset(vm, 0, sizeof(*vm));
+    vm->psr = VM_PSR_SUPERVISOR | VM_PSR_Z;
+    vm->mpr = ALL_PAGES; //until an operating system restricts it
+    vm->io = (vm_io_t){ read_stdin, write_stdout, NULL };
+    vm->pending_char = EOF;
+}
+
+static uint16_t image_word(const unsigned char *bytes, size_t index) {
+    return bytes[2 * index] << 8 | bytes[2 * index + 1];
+}
+
+/**
+ * @brief Discard the decoded instruction at `address`, if any, so that it is decoded again when it is run
+ */
+static inline void invalidate_decoded(vm_t *vm, uint16_t address) {
+    if(vm->decoded_pages[DECODED_PAGE(address) / 64] & DECODED_PAGE_BIT(address) && vm->decoded[address].handler != VM_DO_DECODE) {
+        vm->decoded[address].handler = VM_DO_DECODE;
+        vm->code_writes++;
+    }
+}
+
+/**
+ * @brief Write a word of memory from outside the machine (no access control, devices are not involved)
+ */
+void vm_write_memory(vm_t *vm, uint16_t address, uint16_t value) {
+    vm->memory[address] = value;
+    invalidate_decoded(vm, address);
+}
+
+static void decode(vm_t *vm, uint16_t address) {
+    uint16_t instruction = vm->memory[address];
+    uint16_t next_pc = address + 1;
+    vm_decoded_t *decoded = &vm->decoded[address];
+    static const uint8_t handlers[16] = {
+        VM_DO_BR, VM_DO_ADD_REGISTER, VM_DO_LD, VM_DO_ST, VM_DO_JSRR, VM_DO_AND_REGISTER, VM_DO_LDR, VM_DO_STR,
+        VM_DO_RTI, VM_DO_NOT, VM_DO_LDI, VM_DO_STI, VM_DO_JMP, VM_DO_RESERVED, VM_DO_LEA, VM_DO_TRAP
+    };
+
+    decoded->handler = handlers[instruction >> 12];
+    decoded->dr = DR(instruction);
+    decoded->sr1 = SR1(instruction);
+    decoded->sr2 = instruction & 7;
+    decoded->operand = 0;
+    switch(decoded->handler) {
+    case VM_DO_BR:
+        decoded->handler = decoded->dr == 7 ? VM_DO_BR_ALWAYS : decoded->dr == 0 ? VM_DO_BR_NEVER : VM_DO_BR;
+        decoded->operand = next_pc + SIGN_EXTEND(instruction, 9);
+        break;
+    case VM_DO_ADD_REGISTER:
+    case VM_DO_AND_REGISTER:
+        if(instruction & 0x20) {
+            decoded->handler = decoded->handler == VM_DO_ADD_REGISTER ? VM_DO_ADD_IMMEDIATE : VM_DO_AND_IMMEDIATE;
+            decoded->operand = SIGN_EXTEND(instruction, 5);
+        }
+        break;
+    case VM_DO_LD:
+    case VM_DO_ST:
+    case VM_DO_LDI:
+    case VM_DO_STI:
+    case VM_DO_LEA:
+        decoded->operand = next_pc + SIGN_EXTEND(instruction, 9);
+        break;
+    case VM_DO_JSRR:
+        if(instruction & 0x800) {
+            decoded->handler = VM_DO_JSR;
+            decoded->operand = next_pc + SIGN_EXTEND(instruction, 11);
+        }
+        break;
+    case VM_DO_LDR:
+    case VM_DO_STR:
+        decoded->operand = SIGN_EXTEND(instruction, 6);
+        break;
+    case VM_DO_JMP:
+        if((instruction & 0x3f) == 1) { //JMPT and RTT return to user mode
+            decoded->handler = VM_DO_JMPT;
+        }
+        break;
+    case VM_DO_TRAP:
+        decoded->operand = instruction & 0xff;
+        break;
+    }
+    vm->decoded_pages[DECODED_PAGE(address) / 64] |= DECODED_PAGE_BIT(address);
+}
+
+/**
+ * @brief Decoded instruction at `address`, decoded now if it was not
+ */
+const vm_decoded_t *vm_decoded_instruction(vm_t *vm, uint16_t address) {
+    if(vm->decoded[address].handler == VM_DO_DECODE) {
+        decode(vm, address);
+    }
+    return &vm->decoded[address];
+}
+
+static exit_t load_segment(vm_t *vm, const unsigned char *bytes, size_t first_word, size_t num_words, uint16_t origin) {
+    if(origin + num_words > VM_ADDRESS_SPACE) {
+        return failure(EXIT_FAILURE, "ERROR: Segment at x%04X does not fit in memory (%zu words)", origin, num_words);
+    }
+    for(size_t i = 0; i < num_words; i++) {
+        vm_write_memory(vm, origin + i, image_word(bytes, first_word + i));
+    }
+    return success();
+}
+
+/**
+ * @brief Copy an object image (classic or segmented format, see lc3.h) into the memory of the machine
+ *
+ * @param origin address of the first segment
+ * @return exit_t
+ */
+exit_t vm_load_image(vm_t *vm, const unsigned char *bytes, size_t size, uint16_t *origin) {
+    size_t num_words = size / 2;
+    if(num_words == 0 || size % 2) {
+        return failure(EXIT_FAILURE, "ERROR: Invalid object (%zu bytes)", size);
+    }
+    if(num_words < 3 || image_word(bytes, 0) != SEGMENTED_OBJ_MAGIC1 || image_word(bytes, 1) != SEGMENTED_OBJ_MAGIC2) {
+        *origin = image_word(bytes, 0);
+        return load_segment(vm, bytes, 1, num_words - 1, *origin);
+    }
+
+    size_t num_segments = image_word(bytes, 2);
+    size_t first_word = 3 + 2 * num_segments;
+    if(num_segments == 0 || first_word > num_words) {
+        return failure(EXIT_FAILURE, "ERROR: Invalid segmented object (%zu segments)", num_segments);
+    }
+    *origin = image_word(bytes, 3);
+    for(size_t segment = 0; segment < num_segments; segment++) {
+        size_t segment_words = image_word(bytes, 4 + 2 * segment);
+        if(first_word + segment_words > num_words) {
+            return failure(EXIT_FAILURE, "ERROR: Invalid segmented object (segment %zu is truncated)", segment);
+        }
+        exit_t result = load_segment(vm, bytes, first_word, segment_words, image_word(bytes, 3 + 2 * segment));
+        if(result.code) {
+            return result;
+        }
+        first_word += segment_words;
+    }
+    return success();
+}
+
+exit_t vm_load_object(vm_t *vm, const char *file_name, uint16_t *origin) {
+    FILE *object_file = fopen(file_name, "rb");
+    if(!object_file) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read file (%s)", file_name);
+    }
+    //an object never exceeds the address space and its header
+    static unsigned char bytes[2 * (VM_ADDRESS_SPACE + 3 + 2 * MAX_NUM_SEGMENTS) + 1];
+    size_t size = fread(bytes, 1, sizeof(bytes), object_file);
+    bool read_error = ferror(object_file);
+    fclose(object_file);
+    if(read_error || size == sizeof(bytes)) {
+        return failure(EXIT_FAILURE, "ERROR: Couldn't read object (%s)", file_name);
+    }
+    return vm_load_image(vm, bytes, size, origin);
+}
+
+const char *vm_status_description(vm_status_t status) {
+    static const char *descriptions[] = {
+        "running", "halted", "instruction limit reached", "input exhausted", "illegal opcode", "privilege mode violation",
+        "access control violation", "trap vector without service routine"
+    };
+    return descriptions[status];
+}
+
+static int16_t condition_codes_value(uint16_t psr) {
+    return psr & VM_PSR_N ? -1 : psr & VM_PSR_Z ? 0 : 1;
+}
+
+static uint16_t condition_codes(int16_t value) {
+    return value < 0 ? VM_PSR_N : value == 0 ? VM_PSR_Z : VM_PSR_P;
+}
+
+static uint16_t accessible_pages(const vm_t *vm) {
+    return vm->psr & VM_PSR_SUPERVISOR ? ALL_PAGES : vm->mpr;
+}
+
+static int read_input(vm_t *vm) {
+    int c = vm->pending_char;
+    vm->pending_char = EOF;
+    return c != EOF ? c : vm->io.read_char(vm->io.context);
+}
+
+static vm_status_t read_device(vm_t *vm, uint16_t address, uint16_t *value) {
+    switch(address) {
+    case VM_KBSR:
+        if(vm->pending_char == EOF && (vm->pending_char = vm->io.read_char(vm->io.context)) == EOF) {
+            return VM_INPUT_EXHAUSTED;
+        }
+        *value = DEVICE_READY;
+        break;
+    case VM_KBDR: {
+        int c = read_input(vm);
+        *value = c == EOF ? 0 : (uint8_t)c;
+        break;
+    }
+    case VM_DSR:
+        *value = DEVICE_READY;
+        break;
+    case VM_MPR:
+        *value = vm->mpr;
+        break;
+    case VM_PSR:
+        *value = vm->psr;
+        break;
+    case VM_MCR:
+        *value = MCR_RUN;
+        break;
+    default: //other device registers (e.g. the timer) behave as memory
+        *value = vm->memory[address];
+    }
+    return VM_RUNNING;
+}
+
+static vm_status_t write_device(vm_t *vm, uint16_t address, uint16_t value) {
+    switch(address) {
+    case VM_DDR:
+        vm->io.write_char((uint8_t)value, vm->io.context);
+        break;
+    case VM_MPR:
+        vm->mpr = value;
+        break;
+    case VM_PSR:
+        vm->psr = value;
+        break;
+    case VM_MCR:
+        if(!(value & MCR_RUN)) {
+            return VM_HALTED;
+        }
+        break;
+    default:
+        vm_write_memory(vm, address, value);
+    }
+    return VM_RUNNING;
+}
+
+static void write_string(vm_t *vm, const char *str) {
+    for(; *str; str++) {
+        vm->io.write_char(*str, vm->io.context);
+    }
+}
+
+/**
+ * @brief Service routines of the machine, run when the trap vector table has none for the vector
+ *
+ * They behave as the ones of lc3os.asm, except that only GETC and IN set the condition codes (according to R0)
+ */
+static vm_status_t run_service_routine(vm_t *vm, uint8_t vector) {
+    uint16_t *registers = vm->registers;
+    int c;
+    switch(vector) {
+    case TRAP_GETC:
+    case TRAP_IN:
+        if(vector == TRAP_IN) {
+            write_string(vm, IN_PROMPT);
+        }
+        if((c = read_input(vm)) == EOF) {
+            return VM_INPUT_EXHAUSTED;
+        }
+        registers[0] = (uint8_t)c;
+        if(vector == TRAP_IN) {
+            vm->io.write_char(c, vm->io.context);
+            vm->io.write_char('\n', vm->io.context);
+        }
+        vm->psr = (vm->psr & ~CONDITION_CODES) | condition_codes(registers[0]);
+        break;
+    case TRAP_OUT:
+        vm->io.write_char((uint8_t)registers[0], vm->io.context);
+        break;
+    case TRAP_PUTS:
+        for(uint16_t address = registers[0]; vm->memory[address]; address++) {
+            vm->io.write_char((uint8_t)vm->memory[address], vm->io.context);
+        }
+        break;
+    case TRAP_PUTSP:
+        for(uint16_t address = registers[0]; vm->memory[address] & 0xff; address++) {
+            vm->io.write_char(vm->memory[address] & 0xff, vm->io.context);
+            if(!(vm->memory[address] >> 8)) {
+                break;
+            }
+            vm->io.write_char(vm->memory[address] >> 8, vm->io.context);
+        }
+        break;
+    case TRAP_HALT:
+        return VM_HALTED;
+    default:
+        return VM_INVALID_TRAP;
+    }
+    return VM_RUNNING;
+}
+
+#ifdef COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic" // labels as values
+#endif
+
+/**
+ * @brief Run the machine from its PC until it halts, fails or executes `max_instructions` instructions
+ *
+ * @param max_instructions VM_UNLIMITED to run until the program halts
+ * @return vm_status_t VM_HALTED if the program halted; if it failed, the PC is the address of the instruction
+ */
+vm_status_t vm_run(vm_t *vm, uint64_t max_instructions) {
+    uint16_t *memory = vm->memory;
+    vm_decoded_t *decoded_memory = vm->decoded;
+    const vm_decoded_t *decoded;
+    uint16_t registers[VM_NUM_REGISTERS];
+    uint16_t pc, access;
+    int16_t result; //value that the condition codes describe
+    uint64_t remaining = max_instructions;
+    vm_status_t status;
+
+#define LOAD_STATE()                                          \
+    do {                                                      \
+        memcpy(registers, vm->registers, sizeof(registers)); \
+        pc = vm->pc;                                          \
+        result = condition_codes_value(vm->psr);              \
+        access = accessible_pages(vm);                        \
+    } while(0)
+#define SAVE_STATE()                                                                \
+    do {                                                                            \
+        memcpy(vm->registers, registers, sizeof(registers));                       \
+        vm->pc = pc;                                                                \
+        vm->psr = (vm->psr & ~CONDITION_CODES) | condition_codes(result);           \
+    } while(0)
+#define CHECK_ACCESS(address)                        \
+    if(!((access >> ((address) >> PAGE_BITS)) & 1)) { \
+        status = VM_ACCESS_VIOLATION;                 \
+        goto fault;                                   \
+    }
+#define READ(target, address)                                      \
+    do {                                                           \
+        uint16_t address_ = (address);                             \
+        CHECK_ACCESS(address_);                                    \
+        if(address_ < VM_DEVICES_START) {                          \
+            target = memory[address_];                             \
+        }                                                          \
+        else {                                                     \
+            uint16_t value_;                                       \
+            SAVE_STATE();                                          \
+            if((status = read_device(vm, address_, &value_))) {    \
+                goto saved_fault;                                  \
+            }                                                      \
+            LOAD_STATE();                                          \
+            target = value_;                                       \
+        }                                                          \
+    } while(0)
+#define WRITE(address, value)                                        \
+    do {                                                             \
+        uint16_t address_ = (address), value_ = (value);             \
+        CHECK_ACCESS(address_);                                      \
+        if(address_ < VM_DEVICES_START) {                            \
+            memory[address_] = value_;                               \
+            invalidate_decoded(vm, address_);                        \
+        }                                                            \
+        else {                                                       \
+            SAVE_STATE();                                            \
+            if((status = write_device(vm, address_, value_))) {      \
+                goto saved_stop;                                     \
+            }                                                        \
+            LOAD_STATE();                                            \
+        }                                                            \
+    } while(0)
+
+#ifdef COMPUTED_GOTO
+    //in the order of vm_handler_t
+    static void *const handlers[VM_NUM_HANDLERS] = {
+        &&op_decode, &&op_br, &&op_br_always, &&op_br_never, &&op_add_register, &&op_add_immediate, &&op_ld,
+        &&op_st, &&op_jsr, &&op_jsrr, &&op_and_register, &&op_and_immediate, &&op_ldr, &&op_str, &&op_rti,
+        &&op_not, &&op_ldi, &&op_sti, &&op_jmp, &&op_jmpt, &&op_reserved, &&op_lea, &&op_trap
+    };
+#define DISPATCH()                                  \
+    do {                                            \
+        if(!remaining) {                            \
+            goto limit_reached;                     \
+        }                                           \
+        remaining--;                                \
+        decoded = &decoded_memory[pc++];            \
+        goto *handlers[decoded->handler];           \
+    } while(0)
+#define EXECUTE_DECODED() goto *handlers[decoded->handler]
+#define HANDLER(name, handler) op_##name:
+#else
+#define DISPATCH() continue
+#define EXECUTE_DECODED() goto execute_decoded
+#define HANDLER(name, handler) case handler:
+#endif
+
+    LOAD_STATE();
+#ifdef COMPUTED_GOTO
+    DISPATCH();
+#else
+    for(;;) {
+        if(!remaining) {
+            goto limit_reached;
+        }
+        remaining--;
+        decoded = &decoded_memory[pc++];
+execute_decoded:
+        switch(decoded->handler) {
+#endif
+
+    HANDLER(decode, VM_DO_DECODE) {
+        decode(vm, pc - 1);
+        EXECUTE_DECODED();
+    }
+    HANDLER(br, VM_DO_BR) {
+        if(decoded->dr & condition_codes(result)) {
+            pc = decoded->operand;
+        }
+        DISPATCH();
+    }
+    HANDLER(br_always, VM_DO_BR_ALWAYS) {
+        pc = decoded->operand;
+        DISPATCH();
+    }
+    HANDLER(br_never, VM_DO_BR_NEVER) {
+        DISPATCH();
+    }
+    HANDLER(add_register, VM_DO_ADD_REGISTER) {
+        result = registers[decoded->dr] = registers[decoded->sr1] + registers[decoded->sr2];
+        DISPATCH();
+    }
+    HANDLER(add_immediate, VM_DO_ADD_IMMEDIATE) {
+        result = registers[decoded->dr] = registers[decoded->sr1] + decoded->operand;
+        DISPATCH();
+    }
+    HANDLER(ld, VM_DO_LD) {
+        READ(registers[decoded->dr], decoded->operand);
+        result = registers[decoded->dr];
+        DISPATCH();
+    }
+    HANDLER(st, VM_DO_ST) {
+        WRITE(decoded->operand, registers[decoded->dr]);
+        DISPATCH();
+    }
+    HANDLER(jsr, VM_DO_JSR) {
+        registers[7] = pc;
+        pc = decoded->operand;
+        DISPATCH();
+    }
+    HANDLER(jsrr, VM_DO_JSRR) {
+        uint16_t target = registers[decoded->sr1];
+        registers[7] = pc;
+        pc = target;
+        DISPATCH();
+    }
+    HANDLER(and_register, VM_DO_AND_REGISTER) {
+        result = registers[decoded->dr] = registers[decoded->sr1] & registers[decoded->sr2];
+        DISPATCH();
+    }
+    HANDLER(and_immediate, VM_DO_AND_IMMEDIATE) {
+        result = registers[decoded->dr] = registers[decoded->sr1] & decoded->operand;
+        DISPATCH();
+    }
+    HANDLER(ldr, VM_DO_LDR) {
+        READ(registers[decoded->dr], registers[decoded->sr1] + decoded->operand);
+        result = registers[decoded->dr];
+        DISPATCH();
+    }
+    HANDLER(str, VM_DO_STR) {
+        WRITE(registers[decoded->sr1] + decoded->operand, registers[decoded->dr]);
+        DISPATCH();
+    }
+    HANDLER(rti, VM_DO_RTI) {
+        if(!(vm->psr & VM_PSR_SUPERVISOR)) {
+            status = VM_PRIVILEGE_VIOLATION;
+            goto fault;
+        }
+        uint16_t saved_pc, saved_psr;
+        READ(saved_pc, registers[6]);
+        READ(saved_psr, registers[6] + 1);
+        registers[6] += 2;
+        pc = saved_pc;
+        vm->psr = saved_psr;
+        result = condition_codes_value(saved_psr);
+        access = accessible_pages(vm);
+        DISPATCH();
+    }
+    HANDLER(not, VM_DO_NOT) {
+        result = registers[decoded->dr] = ~registers[decoded->sr1];
+        DISPATCH();
+    }
+    HANDLER(ldi, VM_DO_LDI) {
+        uint16_t pointer;
+        READ(pointer, decoded->operand);
+        READ(registers[decoded->dr], pointer);
+        result = registers[decoded->dr];
+        DISPATCH();
+    }
+    HANDLER(sti, VM_DO_STI) {
+        uint16_t pointer;
+        READ(pointer, decoded->operand);
+        WRITE(pointer, registers[decoded->dr]);
+        DISPATCH();
+    }
+    HANDLER(jmp, VM_DO_JMP) {
+        pc = registers[decoded->sr1];
+        DISPATCH();
+    }
+    HANDLER(jmpt, VM_DO_JMPT) {
+        pc = registers[decoded->sr1];
+        vm->psr &= ~VM_PSR_SUPERVISOR;
+        access = accessible_pages(vm);
+        DISPATCH();
+    }
+    HANDLER(reserved, VM_DO_RESERVED) {
+        status = VM_ILLEGAL_OPCODE;
+        goto fault;
+    }
+    HANDLER(lea, VM_DO_LEA) {
+        result = registers[decoded->dr] = decoded->operand;
+        DISPATCH();
+    }
+    HANDLER(trap, VM_DO_TRAP) {
+        uint8_t vector = decoded->operand;
+        registers[7] = pc;
+        if(memory[vector]) {
+            pc = memory[vector];
+            vm->psr |= VM_PSR_SUPERVISOR;
+            access = ALL_PAGES;
+            DISPATCH();
+        }
+        SAVE_STATE();
+        if((status = run_service_routine(vm, vector))) {
+            if(status == VM_HALTED) {
+                goto saved_stop;
+            }
+            goto saved_fault;
+        }
+        LOAD_STATE();
+        DISPATCH();
+    }
+
+#ifndef COMPUTED_GOTO
+        }
+    }
+#endif
+
+limit_reached:
+    SAVE_STATE();
+    status = VM_LIMIT_REACHED;
+    goto saved_stop;
+fault:
+    SAVE_STATE();
+saved_fault:
+    vm->pc--; //address of the faulting instruction, so that it can be run again
+saved_stop:
+    vm->instructions += max_instructions - remaining;
+    return status;
+
+#undef LOAD_STATE
+#undef SAVE_STATE
+#undef CHECK_ACCESS
+#undef READ
+#undef WRITE
+#undef DISPATCH
+#undef EXECUTE_DECODED
+#undef HANDLER
+}
+
+#ifdef COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
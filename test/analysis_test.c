@@ -0,0 +1,90 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+
+static int setup(void **state) {
+    clearerrdesc();
+    initialize();
+    return 0;
+}
+
+static int teardown(void **state) {
+    initialize();
+    return 0;
+}
+
+static void analyze_with_report(const char *asm_file_name, int memory_access_cycles, char *report, size_t report_size) {
+    FILE *report_file = tmpfile();
+    options_t options = { .relax_register = -1, .analyze = true, .memory_access_cycles = memory_access_cycles, .analysis_json = report_file };
+    exit_t result = assemble_with_options(asm_file_name, &options);
+    assert_int_equal(result.code, 0);
+    rewind(report_file);
+    size_t read = fread(report, 1, report_size - 1, report_file);
+    report[read] = '\0';
+    fclose(report_file);
+}
+
+static void test_analyze_subroutines_t23(void  __attribute__((unused)) **state) {
+    static char report[10000];
+    analyze_with_report("./test/testfiles/t23.asm", 1, report, sizeof(report));
+    assert_non_null(strstr(report, "\"cost_model\": {\"cycles_per_instruction\": 1, \"cycles_per_memory_access\": 1}"));
+
+    //entry point of the program, calls are counted as one instruction
+    const char *main_routine = strstr(report, "\"name\": \"x3000\"");
+    assert_non_null(main_routine);
+    assert_non_null(strstr(main_routine, "\"best\": {\"instructions\": 5, \"cycles\": 13},\n      \"worst\": {\"instructions\": 5, \"cycles\": 13},\n      \"calls\": [\"SUM\", \"ABS\"]"));
+    assert_non_null(strstr(main_routine, "{\"address\": \"x3003\", \"line\": 6, \"instructions\": 2, \"cycles\": 6, \"loop_depth\": 0, \"successors\": [], \"exit\": \"halt\"}"));
+
+    //loop counted once in the best/worst case, its iterations reported separately
+    const char *sum = strstr(report, "\"name\": \"SUM\"");
+    assert_non_null(sum);
+    assert_non_null(strstr(sum, "\"loop_free\": false,\n      \"best\": {\"instructions\": 5, \"cycles\": 10},\n      \"worst\": {\"instructions\": 5, \"cycles\": 10}"));
+    assert_non_null(strstr(sum, "{\"header\": \"x3006\", \"line\": 9, \"depth\": 1, \"blocks\": 1, \"iteration\": {\"best\": {\"instructions\": 3, \"cycles\": 6}, \"worst\": {\"instructions\": 3, \"cycles\": 6}}}"));
+    assert_non_null(strstr(sum, "{\"address\": \"x3006\", \"line\": 9, \"instructions\": 3, \"cycles\": 6, \"loop_depth\": 1, \"successors\": [\"x3006\", \"x3009\"]}"));
+
+    //best and worst cases differ in loop-free code with branches
+    const char *abs_routine = strstr(report, "\"name\": \"ABS\"");
+    assert_non_null(abs_routine);
+    assert_non_null(strstr(abs_routine, "\"loop_free\": true,\n      \"best\": {\"instructions\": 3, \"cycles\": 6},\n      \"worst\": {\"instructions\": 5, \"cycles\": 10}"));
+    assert_null(strstr(report, "\"name\": \"POSITIVE\""));
+}
+
+static void test_analyze_memory_access_cost_t23(void  __attribute__((unused)) **state) {
+    static char report[10000];
+    analyze_with_report("./test/testfiles/t23.asm", 3, report, sizeof(report));
+    assert_non_null(strstr(report, "\"cycles_per_memory_access\": 3}"));
+    //LD, JSR, JSR, ST, HALT: 5 instructions with 5 fetches and 3 data accesses
+    assert_non_null(strstr(report, "\"best\": {\"instructions\": 5, \"cycles\": 29}"));
+}
+
+static void test_analyze_nested_loops_2048(void  __attribute__((unused)) **state) {
+    static char report[100000];
+    analyze_with_report("./test/testfiles/2048.asm", 1, report, sizeof(report));
+    const char *main_routine = strstr(report, "\"name\": \"MAIN\"");
+    assert_non_null(main_routine);
+    assert_non_null(strstr(main_routine, "\"depth\": 2"));
+    assert_non_null(strstr(report, "\"name\": \"DISPLAY_BOARD\""));
+    assert_int_equal(report[strlen(report) - 2], '}');
+}
+
+static void test_analyze_branch_out_of_code_t28(void  __attribute__((unused)) **state) {
+    static char report[10000];
+    analyze_with_report("./test/testfiles/t28.asm", 1, report, sizeof(report));
+    //BRz DATA ends a path of the subroutine, the path falling through goes on to HALT
+    assert_non_null(strstr(report, "{\"address\": \"x3000\", \"line\": 3, \"instructions\": 2, \"cycles\": 4, \"loop_depth\": 0, \"successors\": [\"x3002\"], \"exit\": \"data\"}"));
+    assert_non_null(strstr(report, "{\"address\": \"x3002\", \"line\": 5, \"instructions\": 2, \"cycles\": 5, \"loop_depth\": 0, \"successors\": [], \"exit\": \"halt\"}"));
+    assert_non_null(strstr(report, "\"best\": {\"instructions\": 2, \"cycles\": 4},\n      \"worst\": {\"instructions\": 4, \"cycles\": 9}"));
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_analyze_subroutines_t23, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_analyze_memory_access_cost_t23, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_analyze_nested_loops_2048, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_analyze_branch_out_of_code_t28, setup, teardown)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,202 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <inttypes.h>
+#include <sys/wait.h>
+#include "../include/lc3.h"
+#include "../include/aot.h"
+
+// compiler command of the generated programs, set by the Makefile
+#ifndef AOT_CC
+#define AOT_CC "cc -O1"
+#endif
+#define MAX_OUTPUT 100000
+
+typedef struct {
+    const char *input;
+    char output[MAX_OUTPUT];
+    size_t output_length;
+} console_t;
+
+static vm_t vm;
+static console_t console;
+static char output[MAX_OUTPUT], errors[1000];
+static uint64_t native_instructions, interpreted_instructions;
+
+static int read_console(void *context) {
+    console_t *c = context;
+    return *c->input ? *c->input++ : EOF;
+}
+
+static void write_console(int ch, void *context) {
+    console_t *c = context;
+    if(c->output_length < sizeof(c->output) - 1) {
+        c->output[c->output_length++] = ch;
+        c->output[c->output_length] = '\0';
+    }
+}
+
+/**
+ * @brief Run the object file in the interpreter, as lc3vm does
+ */
+static vm_status_t interpret(const char *object_file, const char *os_file, const char *input, uint64_t limit) {
+    uint16_t origin;
+    vm_init(&vm);
+    console = (console_t){ .input = input };
+    vm.io = (vm_io_t){ read_console, write_console, &console };
+    exit_t result = os_file ? vm_load_object(&vm, os_file, &origin) : success();
+    assert_int_equal(result.code, 0);
+    result = vm_load_object(&vm, object_file, &origin);
+    assert_int_equal(result.code, 0);
+    vm.pc = os_file ? VM_OS_START : origin;
+    return vm_run(&vm, limit);
+}
+
+static void read_file(const char *file_name, char *buffer, size_t size) {
+    FILE *file = fopen(file_name, "r");
+    assert_non_null(file);
+    buffer[fread(buffer, 1, size - 1, file)] = '\0';
+    fclose(file);
+}
+
+static void translate(const char *object_file, const char *os_file, const char *name) {
+    char file_name[100], command[1000];
+    snprintf(file_name, sizeof(file_name), "./out/aot_%s.c", name);
+    FILE *program = fopen(file_name, "w");
+    assert_non_null(program);
+    aot_stats_t stats;
+    exit_t result = aot_translate(object_file, os_file, program, &stats);
+    fclose(program);
+    assert_int_equal(result.code, 0);
+    assert_true(stats.blocks > 0 && stats.instructions >= stats.blocks);
+    snprintf(command, sizeof(command), "%s -Iinclude %s src/vm.c src/util.c src/memtrack.c -o ./out/aot_%s", AOT_CC,
+             file_name, name);
+    assert_int_equal(system(command), 0);
+}
+
+/**
+ * @brief Run the translated program with `input` and its --stats; fills output, errors and the counts
+ *
+ * @return int exit status of the program
+ */
+static int run_translated(const char *name, const char *input, const char *options) {
+    char file_name[100], command[1000];
+    snprintf(file_name, sizeof(file_name), "./out/aot_%s.in", name);
+    FILE *input_file = fopen(file_name, "w");
+    assert_non_null(input_file);
+    fputs(input, input_file);
+    fclose(input_file);
+    snprintf(command, sizeof(command), "./out/aot_%s --stats %s < ./out/aot_%s.in > ./out/aot_%s.out 2> ./out/aot_%s.err",
+             name, options, name, name, name);
+    int status = system(command);
+    assert_true(WIFEXITED(status));
+    snprintf(file_name, sizeof(file_name), "./out/aot_%s.out", name);
+    read_file(file_name, output, sizeof(output));
+    snprintf(file_name, sizeof(file_name), "./out/aot_%s.err", name);
+    read_file(file_name, errors, sizeof(errors));
+    const char *counts = strchr(errors, ')');
+    assert_non_null(counts);
+    assert_int_equal(sscanf(counts, ")\n%" SCNu64 " native, %" SCNu64 " interpreted", &native_instructions,
+                            &interpreted_instructions), 2);
+    return WEXITSTATUS(status);
+}
+
+/**
+ * @brief Whether the translated program behaved as the interpreter: output, errors, status and instructions
+ */
+static void assert_same_run(vm_status_t status, int exit_status) {
+    char expected_errors[1000] = "";
+    uint64_t instructions;
+    assert_string_equal(output, console.output);
+    assert_int_equal(exit_status, status == VM_HALTED ? EXIT_SUCCESS : EXIT_FAILURE);
+    if(status != VM_HALTED) {
+        snprintf(expected_errors, sizeof(expected_errors), "ERROR: %s at x%04X\n", vm_status_description(status), vm.pc);
+    }
+    assert_memory_equal(errors, expected_errors, strlen(expected_errors));
+    assert_int_equal(sscanf(errors + strlen(expected_errors), "%" SCNu64 " instructions", &instructions), 1);
+    assert_int_equal(instructions, vm.instructions);
+    assert_int_equal(native_instructions + interpreted_instructions, vm.instructions);
+}
+
+static void test_lcrng(void  __attribute__((unused)) **state) {
+    exit_t result = assemble("./test/testfiles/lcrng.asm");
+    assert_int_equal(result.code, 0);
+    translate("./test/testfiles/lcrng.obj", NULL, "lcrng");
+    vm_status_t status = interpret("./test/testfiles/lcrng.obj", NULL, "", VM_UNLIMITED);
+    assert_same_run(status, run_translated("lcrng", "", ""));
+    assert_int_equal(status, VM_HALTED);
+    assert_true(native_instructions > 100 * interpreted_instructions);
+}
+
+static void test_instruction_limit(void  __attribute__((unused)) **state) {
+    for(uint64_t limit = 0; limit < 3000; limit += 299) {
+        char options[100];
+        snprintf(options, sizeof(options), "-n %" PRIu64, limit);
+        vm_status_t status = interpret("./test/testfiles/lcrng.obj", NULL, "", limit);
+        assert_same_run(status, run_translated("lcrng", "", options));
+        assert_int_equal(status, VM_LIMIT_REACHED);
+    }
+}
+
+static void test_operating_system(void  __attribute__((unused)) **state) {
+    //the service routines of lc3os return with RTI to addresses the translated code dispatches on
+    translate("./test/testfiles/lcrng.obj", "./test/testfiles/lc3os.obj", "lc3os_lcrng");
+    vm_status_t status = interpret("./test/testfiles/lcrng.obj", "./test/testfiles/lc3os.obj", "", VM_UNLIMITED);
+    assert_same_run(status, run_translated("lc3os_lcrng", "", ""));
+    assert_int_equal(status, VM_HALTED);
+    assert_true(native_instructions > interpreted_instructions);
+}
+
+static void test_2048_replay(void  __attribute__((unused)) **state) {
+    //no ANSI terminal, a key for the random seed, moves until the input is exhausted
+    const char *replay = "nxwasdwwddssaawdsawasdddwwsaasddwsawdsawdswasdwasd";
+    exit_t result = assemble("./test/testfiles/2048.asm");
+    assert_int_equal(result.code, 0);
+    translate("./test/testfiles/2048.obj", NULL, "2048");
+    vm_status_t status = interpret("./test/testfiles/2048.obj", NULL, replay, VM_UNLIMITED);
+    assert_same_run(status, run_translated("2048", replay, ""));
+    assert_int_equal(status, VM_INPUT_EXHAUSTED);
+    assert_true(native_instructions > 10 * interpreted_instructions);
+}
+
+static void test_self_modifying_code(void  __attribute__((unused)) **state) {
+    //x3003 ADD R1,R1,#1 is replaced by ADD R1,R1,#2 (x300C) in a loop run 3 times, then '0' + R1 is printed
+    const uint16_t program[] = { 0x3000, 0x56E0, 0x16E3, 0x5260, 0x1261, 0x2007, 0x31FD, 0x16FF, 0x03FB,
+                                 0x2004, 0x1001, 0xF021, 0xF025, 0x1262, 0x0030 };
+    FILE *object = fopen("./out/aot_self_modifying.obj", "wb");
+    assert_non_null(object);
+    for(size_t i = 0; i < sizeof(program) / sizeof(program[0]); i++) {
+        fputc(program[i] >> 8, object);
+        fputc(program[i] & 0xff, object);
+    }
+    fclose(object);
+    translate("./out/aot_self_modifying.obj", NULL, "self_modifying");
+    vm_status_t status = interpret("./out/aot_self_modifying.obj", NULL, "", VM_UNLIMITED);
+    assert_same_run(status, run_translated("self_modifying", "", ""));
+    assert_string_equal(output, "5");
+    assert_true(interpreted_instructions > 1);
+}
+
+static void test_invalid_objects(void  __attribute__((unused)) **state) {
+    aot_stats_t stats;
+    exit_t result = aot_translate("./test/testfiles/missing.obj", NULL, stdout, &stats);
+    assert_true(result.code);
+    free_err(result);
+    result = aot_translate("./test/testfiles/lcrng.obj", "./test/testfiles/missing.obj", stdout, &stats);
+    assert_true(result.code);
+    free_err(result);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_lcrng),
+        cmocka_unit_test(test_instruction_limit),
+        cmocka_unit_test(test_operating_system),
+        cmocka_unit_test(test_2048_replay),
+        cmocka_unit_test(test_self_modifying_code),
+        cmocka_unit_test(test_invalid_objects),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,192 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+#include "../include/archive.h"
+
+#define ARCHIVE_FILE_NAME "./test/testfiles/test.lib"
+
+static int setup(void **state) {
+    clearerrdesc();
+    initialize();
+    assemble("./test/testfiles/t2.asm");
+    initialize();
+    assemble("./test/testfiles/abs.asm");
+    initialize();
+    assemble("./test/testfiles/or.asm");
+    initialize();
+    return 0;
+}
+
+static int teardown(void **state) {
+    initialize();
+    remove(ARCHIVE_FILE_NAME);
+    return 0;
+}
+
+static void test_archive_lookup(void  __attribute__((unused)) **state) {
+    const char *object_file_names[] = { "./test/testfiles/t2.obj", "./test/testfiles/abs.obj" };
+    exit_t result = archive_create(ARCHIVE_FILE_NAME, object_file_names, 2);
+    assert_int_equal(result.code, 0);
+
+    archive_t archive;
+    result = archive_open(ARCHIVE_FILE_NAME, &archive);
+    assert_int_equal(result.code, 0);
+    assert_int_equal(archive.header->num_members, 2);
+    assert_int_equal(archive.header->num_symbols, 5);
+
+    const archive_symbol_t *symbol = archive_lookup(&archive, "LABEL");
+    assert_non_null(symbol);
+    assert_int_equal(symbol->address, 0x3003);
+    assert_string_equal(archive_member_name(&archive, symbol->member), "t2.obj");
+
+    symbol = archive_lookup(&archive, "RESULT_DEST");
+    assert_non_null(symbol);
+    assert_string_equal(archive_member_name(&archive, symbol->member), "abs.obj");
+
+    assert_null(archive_lookup(&archive, "MISSING"));
+    archive_close(&archive);
+}
+
+static void test_archive_member_contents(void  __attribute__((unused)) **state) {
+    const char *object_file_names[] = { "./test/testfiles/t2.obj", "./test/testfiles/abs.obj" };
+    exit_t result = archive_create(ARCHIVE_FILE_NAME, object_file_names, 2);
+    assert_int_equal(result.code, 0);
+
+    archive_t archive;
+    result = archive_open(ARCHIVE_FILE_NAME, &archive);
+    assert_int_equal(result.code, 0);
+
+    FILE *obj_file = fopen("./test/testfiles/abs.expected.obj", "rb");
+    unsigned char expected[512];
+    size_t expected_size = fread(expected, 1, sizeof(expected), obj_file);
+    fclose(obj_file);
+
+    const archive_member_t *member = &archive.members[1];
+    assert_int_equal(member->obj_size, expected_size);
+    assert_int_equal(memcmp(archive.base + member->obj_offset, expected, expected_size), 0);
+    archive_close(&archive);
+}
+
+static void test_archive_select_members(void  __attribute__((unused)) **state) {
+    const char *object_file_names[] = { "./test/testfiles/t2.obj", "./test/testfiles/abs.obj" };
+    exit_t result = archive_create(ARCHIVE_FILE_NAME, object_file_names, 2);
+    assert_int_equal(result.code, 0);
+
+    archive_t archive;
+    result = archive_open(ARCHIVE_FILE_NAME, &archive);
+    assert_int_equal(result.code, 0);
+
+    bool selected_members[2];
+    const char *undefined_symbols[] = { "NEG", "OPERAND" };
+    result = archive_select_members(&archive, undefined_symbols, 2, selected_members);
+    assert_int_equal(result.code, 0);
+    assert_false(selected_members[0]);
+    assert_true(selected_members[1]);
+
+    const char *missing_symbols[] = { "NEG", "MISSING" };
+    result = archive_select_members(&archive, missing_symbols, 2, selected_members);
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR: Undefined symbol ('MISSING')");
+    free(result.desc);
+    archive_close(&archive);
+}
+
+static void test_archive_duplicate_symbol(void  __attribute__((unused)) **state) {
+    //RESULT_DEST and OPERAND are labels of both modules: the first definition is indexed
+    const char *object_file_names[] = { "./test/testfiles/abs.obj", "./test/testfiles/or.obj" };
+    exit_t result = archive_create(ARCHIVE_FILE_NAME, object_file_names, 2);
+    assert_int_equal(result.code, 0);
+
+    archive_t archive;
+    result = archive_open(ARCHIVE_FILE_NAME, &archive);
+    assert_int_equal(result.code, 0);
+    assert_int_equal(archive.header->num_symbols, 6);
+    const archive_symbol_t *symbol = archive_lookup(&archive, "RESULT_DEST");
+    assert_non_null(symbol);
+    assert_int_equal(symbol->address, 0x3009);
+    assert_string_equal(archive_member_name(&archive, symbol->member), "abs.obj");
+    symbol = archive_lookup(&archive, "OPERAND2");
+    assert_non_null(symbol);
+    assert_string_equal(archive_member_name(&archive, symbol->member), "or.obj");
+    archive_close(&archive);
+}
+
+static void test_archive_invalid_file(void  __attribute__((unused)) **state) {
+    archive_t archive;
+    exit_t result = archive_open("./test/testfiles/t2.expected.sym", &archive);
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR: Invalid archive (./test/testfiles/t2.expected.sym)");
+    free(result.desc);
+}
+
+/**
+ * @brief Write a copy of the archive of t2 and abs with the header and member table changed by `corrupt`,
+ * truncated to `size` bytes if it is not 0, and check that it is rejected
+ */
+static void assert_corrupt_archive_rejected(void (*corrupt)(unsigned char *archive), size_t size) {
+    const char *object_file_names[] = { "./test/testfiles/t2.obj", "./test/testfiles/abs.obj" };
+    exit_t result = archive_create(ARCHIVE_FILE_NAME, object_file_names, 2);
+    assert_int_equal(result.code, 0);
+    unsigned char content[4096];
+    FILE *file = fopen(ARCHIVE_FILE_NAME, "rb");
+    size_t content_size = fread(content, 1, sizeof(content), file);
+    fclose(file);
+    assert_true(content_size < sizeof(content));
+    if(corrupt) {
+        corrupt(content);
+    }
+    file = fopen(ARCHIVE_FILE_NAME, "wb");
+    fwrite(content, 1, size ? size : content_size, file);
+    fclose(file);
+
+    archive_t archive;
+    result = archive_open(ARCHIVE_FILE_NAME, &archive);
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR: Invalid archive (" ARCHIVE_FILE_NAME ")");
+    free(result.desc);
+}
+
+static void no_buckets(unsigned char *archive) {
+    ((archive_header_t *)archive)->num_buckets = 0;
+}
+
+static void odd_buckets(unsigned char *archive) {
+    ((archive_header_t *)archive)->num_buckets = 3;
+}
+
+static void symbols_past_end(unsigned char *archive) {
+    ((archive_header_t *)archive)->num_symbols = 1000;
+}
+
+static void members_past_end(unsigned char *archive) {
+    ((archive_header_t *)archive)->members_offset = UINT32_MAX - 3;
+}
+
+static void member_past_end(unsigned char *archive) {
+    const archive_header_t *header = (const archive_header_t *)archive;
+    ((archive_member_t *)(archive + header->members_offset))[1].sym_size = 100000;
+}
+
+static void test_archive_corrupt_file(void  __attribute__((unused)) **state) {
+    assert_corrupt_archive_rejected(NULL, sizeof(archive_header_t) + 4);
+    assert_corrupt_archive_rejected(no_buckets, 0);
+    assert_corrupt_archive_rejected(odd_buckets, 0);
+    assert_corrupt_archive_rejected(symbols_past_end, 0);
+    assert_corrupt_archive_rejected(members_past_end, 0);
+    assert_corrupt_archive_rejected(member_past_end, 0);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_archive_lookup, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_archive_member_contents, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_archive_select_members, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_archive_duplicate_symbol, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_archive_invalid_file, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_archive_corrupt_file, setup, teardown)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -3,8 +3,11 @@
 #include <setjmp.h>
 #include <cmocka.h>
 #include <stdbool.h>
+#include <inttypes.h>
 #include "../include/lc3.h"
 #include "../include/dict.h"
+#include "../include/objdiff.h"
+#include "../include/vm.h"
 
 static int setup(void **state) {
     clearerrdesc();
@@ -32,25 +35,11 @@ static void run_assemble_test(char *asm_file_name, char *expected_obj_file_name,
     }
     assert_int_equal(result.code, 0);
 
-    FILE *expected_obj_file = fopen(expected_obj_file_name, "r");
-    FILE *actual_obj_file = fopen(actual_obj_file_name, "r");
-
-    char buf_expected[2];
-    char buf_actual[2];
-    size_t num_lines = 1;
-
-    size_t read;
-    while((read = fread(buf_expected, 1, 2, expected_obj_file)) == 2) {
-        read = fread(buf_actual, 1, 2, actual_obj_file);
-        // printf("line checked: %zu\n", num_lines);
-        assert_int_equal(read, 2);
-        assert_true(buf_expected[0] == buf_actual[0] && buf_expected[1] == buf_actual[1]);
-        num_lines++;
-    }
-
-    assert_int_equal(read, fread(buf_actual, 1, 2, actual_obj_file));
-    fclose(expected_obj_file);
-    fclose(actual_obj_file);
+    //differing words are printed with their address, label and instructions
+    size_t num_differences;
+    exit_t diff_result = diff_objects(expected_obj_file_name, actual_obj_file_name, DEFAULT_MAX_REPORTED_DIFFERENCES, stdout, &num_differences);
+    assert_int_equal(diff_result.code, 0);
+    assert_int_equal(num_differences, 0);
 }
 
 static void test_symbol_table_t2(void  __attribute__((unused)) **state) {
@@ -210,7 +199,328 @@ static void test_assemble_2048_asm(void  __attribute__((unused)) **state) {
     run_assemble_test("./test/testfiles/2048.asm", "./test/testfiles/2048.expected.obj", "./test/testfiles/2048.obj");
 }
 
+static void test_assemble_several_segments_t13(void  __attribute__((unused)) **state) {
+    run_assemble_test("./test/testfiles/t13.asm", "./test/testfiles/t13.expected.obj", "./test/testfiles/t13.obj");
+    assert_symbol_table("BACK", 0x3003);
+    assert_symbol_table("PTR", 0x3004);
+    assert_symbol_table("VALUE", 0x3080);
+    assert_symbol_table("MSG", 0x3082);
+    assert_symbol_table("TABLE", 0xC000);
+    assert_symbol_table("END_TABLE", 0xC003);
+}
+
+static void test_assemble_overlapping_segments_t14(void  __attribute__((unused)) **state) {
+    exit_t result = assemble("./test/testfiles/t14.asm");
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR (line 10): Segment starting at x3002 overlaps with a previous segment at address x3002");
+    free(result.desc);
+}
+
+static void test_assemble_segment_exceeding_address_space_t15(void  __attribute__((unused)) **state) {
+    exit_t result = assemble("./test/testfiles/t15.asm");
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR (line 4): Segment starting at xFFFF exceeds the address space");
+    free(result.desc);
+}
+
+static void test_assemble_labels_on_orig_lines_t24(void  __attribute__((unused)) **state) {
+    exit_t result = assemble("./test/testfiles/t24.asm");
+    assert_int_equal(result.code, 0);
+    assert_symbol_table("DATA1", 0x3000);
+    assert_symbol_table("DATA2", 0x3080);
+
+    FILE *obj_file = fopen("./test/testfiles/t24.obj", "rb");
+    unsigned char bytes[40];
+    size_t num_bytes = fread(bytes, 1, sizeof(bytes), obj_file);
+    fclose(obj_file);
+    const unsigned char expected[] = {
+        0x4c, 0x33, 0x53, 0x47, 0x00, 0x02,             //segmented object with 2 segments
+        0x30, 0x00, 0x00, 0x03, 0x30, 0x80, 0x00, 0x01,
+        0x22, 0x7f, 0xe1, 0xfe, 0xf0, 0x25,             //LD R1,DATA2 / LEA R0,DATA1 / HALT
+        0x00, 0x07
+    };
+    assert_int_equal(num_bytes, sizeof(expected));
+    assert_memory_equal(bytes, expected, sizeof(expected));
+}
+
+static void test_assemble_ambiguous_classic_image_t25(void  __attribute__((unused)) **state) {
+    exit_t result = assemble("./test/testfiles/t25.asm");
+    assert_int_equal(result.code, 0);
+
+    //origin x4C33 followed by x5347 is the segmented object magic: the image is written as one segment
+    FILE *obj_file = fopen("./test/testfiles/t25.obj", "rb");
+    unsigned char bytes[30];
+    size_t num_bytes = fread(bytes, 1, sizeof(bytes), obj_file);
+    fclose(obj_file);
+    const unsigned char expected[] = {
+        0x4c, 0x33, 0x53, 0x47, 0x00, 0x01, 0x4c, 0x33, 0x00, 0x02,
+        0x53, 0x47, 0xf0, 0x25
+    };
+    assert_int_equal(num_bytes, sizeof(expected));
+    assert_memory_equal(bytes, expected, sizeof(expected));
+}
+
+/**
+ * @brief Assemble the program reporting the memory saved by .STRINGP and return the last line of the report
+ */
+static void assemble_with_stringp_report(const char *asm_file_name, char *summary, size_t summary_size) {
+    char report[5000] = { 0 };
+    FILE *report_file = tmpfile();
+    options_t options = { .optimize = false, .relax = false, .relax_register = -1, .stringp_report = true, .report = report_file };
+    exit_t result = assemble_with_options(asm_file_name, &options);
+    assert_int_equal(result.code, 0);
+    rewind(report_file);
+    fread(report, 1, sizeof(report) - 1, report_file);
+    fclose(report_file);
+    const char *last_line = strstr(report, "stringp: ");
+    assert_non_null(last_line);
+    snprintf(summary, summary_size, "%s", last_line);
+}
+
+typedef struct {
+    const char *input;
+    char output[20000];
+    size_t output_length;
+} console_t;
+
+static int read_console(void *context) {
+    console_t *console = context;
+    return *console->input ? *console->input++ : EOF;
+}
+
+static void write_console(int ch, void *context) {
+    console_t *console = context;
+    if(console->output_length < sizeof(console->output) - 1) {
+        console->output[console->output_length++] = ch;
+    }
+}
+
+/**
+ * @brief Run an object file with the traps of the machine, or with lc3os if `with_os`, until it halts or its input
+ * is exhausted
+ *
+ * @return uint64_t instructions executed
+ */
+static uint64_t run_object(const char *obj_file_name, bool with_os, console_t *console) {
+    static vm_t vm;
+    uint16_t origin;
+    vm_init(&vm);
+    vm.io = (vm_io_t){ read_console, write_console, console };
+    exit_t result = with_os ? vm_load_object(&vm, "./test/testfiles/lc3os.obj", &origin) : success();
+    assert_int_equal(result.code, 0);
+    result = vm_load_object(&vm, obj_file_name, &origin);
+    assert_int_equal(result.code, 0);
+    vm.pc = with_os ? VM_OS_START : origin;
+    vm_status_t status = vm_run(&vm, VM_UNLIMITED);
+    assert_true(status == VM_HALTED || status == VM_INPUT_EXHAUSTED);
+    return vm.instructions;
+}
+
+static void test_stringp_savings(void  __attribute__((unused)) **state) {
+    //the messages of days_week.asm and 2048.asm packed by .STRINGP and printed by PUTSP
+    const char *programs[][3] = {
+        { "days_week", "6", "stringp: 42 words instead of 70, 28 words saved\n" },
+        //no ANSI terminal, a key for the random seed, moves until the input is exhausted
+        { "2048", "nxwasdwwddssaawdsawasdddwwsaasddwsawdsawdswasdwasd", "stringp: 311 words instead of 563, 252 words saved\n" }
+    };
+    //instructions run by the original and the packed program with the traps of the machine, then with lc3os,
+    //whose PUTSP shifts each high byte down one bit at a time
+    const uint64_t expected[][4] = { { 34, 34, 157, 427 }, { 574385, 574385, 742543, 1092078 } };
+    for(size_t i = 0; i < sizeof(programs) / sizeof(programs[0]); i++) {
+        char file_name[100], stringp_file_name[100], summary[100];
+        snprintf(file_name, sizeof(file_name), "./test/testfiles/%s.asm", programs[i][0]);
+        snprintf(stringp_file_name, sizeof(stringp_file_name), "./test/testfiles/%s_stringp.asm", programs[i][0]);
+        assemble_with_stringp_report(stringp_file_name, summary, sizeof(summary));
+        assert_string_equal(summary, programs[i][2]);
+        initialize();
+        assert_int_equal(assemble(file_name).code, 0);
+
+        for(int with_os = 0; with_os < 2; with_os++) {
+            static console_t console, stringp_console;
+            console = (console_t){ .input = programs[i][1] };
+            stringp_console = (console_t){ .input = programs[i][1] };
+            snprintf(file_name, sizeof(file_name), "./test/testfiles/%s.obj", programs[i][0]);
+            snprintf(stringp_file_name, sizeof(stringp_file_name), "./test/testfiles/%s_stringp.obj", programs[i][0]);
+            assert_int_equal(run_object(file_name, with_os, &console), expected[i][2 * with_os]);
+            assert_int_equal(run_object(stringp_file_name, with_os, &stringp_console), expected[i][2 * with_os + 1]);
+            assert_int_equal(stringp_console.output_length, console.output_length);
+            assert_memory_equal(stringp_console.output, console.output, console.output_length);
+        }
+    }
+}
+
+static void write_lookup_table_program(const char *asm_file_name, size_t num_words) {
+    FILE *asm_file = fopen(asm_file_name, "w");
+    fprintf(asm_file, "    .ORIG x0000\n");
+    for(size_t i = 0; i < num_words; i++) {
+        //each word contains its own address
+        fprintf(asm_file, "L%zu .FILL L%zu\n", i, i);
+    }
+    fprintf(asm_file, "    .END\n");
+    fclose(asm_file);
+}
+
+static void test_assemble_full_address_space(void  __attribute__((unused)) **state) {
+    write_lookup_table_program("./test/testfiles/full_address_space.asm", ADDRESS_SPACE_CARDINALITY);
+    exit_t result = assemble("./test/testfiles/full_address_space.asm");
+    assert_int_equal(result.code, 0);
+    assert_symbol_table("L0", 0x0000);
+    assert_symbol_table("L65535", 0xFFFF);
+
+    FILE *obj_file = fopen("./test/testfiles/full_address_space.obj", "r");
+    unsigned char buf[2];
+    size_t num_words = 0;
+    bool words_match_addresses = true;
+    while(fread(buf, 1, 2, obj_file) == 2) {
+        //first word is the origin
+        uint16_t expected_word = num_words == 0 ? 0 : num_words - 1;
+        words_match_addresses = words_match_addresses && buf[0] == (expected_word >> 8) && buf[1] == (expected_word & 0xFF);
+        num_words++;
+    }
+    fclose(obj_file);
+    assert_true(words_match_addresses);
+    assert_int_equal(num_words, ADDRESS_SPACE_CARDINALITY + 1);
+    remove("./test/testfiles/full_address_space.asm");
+}
+
+static void test_assemble_beyond_address_space(void  __attribute__((unused)) **state) {
+    write_lookup_table_program("./test/testfiles/beyond_address_space.asm", ADDRESS_SPACE_CARDINALITY + 1);
+    exit_t result = assemble("./test/testfiles/beyond_address_space.asm");
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR (line 1): Segment starting at x0000 exceeds the address space");
+    free(result.desc);
+    remove("./test/testfiles/beyond_address_space.asm");
+}
+
+static void test_assemble_stringp_t21(void  __attribute__((unused)) **state) {
+    char report[500] = { 0 };
+    FILE *report_file = tmpfile();
+    options_t options = { .optimize = false, .relax = false, .relax_register = -1, .stringp_report = true, .report = report_file };
+    exit_t result = assemble_with_options("./test/testfiles/t21.asm", &options);
+    assert_int_equal(result.code, 0);
+    rewind(report_file);
+    fread(report, 1, sizeof(report) - 1, report_file);
+    fclose(report_file);
+    assert_string_equal(report,
+        "stringp (line 6): 6 characters in 4 words instead of 7, 3 words saved\n"
+        "stringp (line 7): 3 characters in 3 words instead of 4, 1 words saved\n"
+        "stringp: 7 words instead of 11, 4 words saved\n");
+
+    FILE *obj_file = fopen("./test/testfiles/t21.obj", "rb");
+    unsigned char bytes[30];
+    size_t num_bytes = fread(bytes, 1, sizeof(bytes), obj_file);
+    fclose(obj_file);
+    const unsigned char expected[] = {
+        0x30, 0x00, 0xe0, 0x02, 0xf0, 0x24, 0xf0, 0x25,
+        0x65, 0x48, 0x6c, 0x6c, 0x0a, 0x6f, 0x00, 0x00, //"Hello\n"
+        0x62, 0x61, 0x00, 0x63, 0x00, 0x00,             //"abc"
+        0x30, 0x07
+    };
+    assert_int_equal(num_bytes, sizeof(expected));
+    assert_memory_equal(bytes, expected, sizeof(expected));
+    assert_symbol_table("AFTER", 0x3007);
+}
+
+static void test_assemble_with_stats_t13(void  __attribute__((unused)) **state) {
+    char report[1000] = { 0 };
+    FILE *report_file = tmpfile();
+    options_t options = { .relax_register = -1, .stats = true, .stats_json = report_file };
+    uint64_t calls = memtrack_calls();
+    exit_t result = assemble_with_options("./test/testfiles/t13.asm", &options);
+    assert_int_equal(result.code, 0);
+    rewind(report_file);
+    fread(report, 1, sizeof(report) - 1, report_file);
+    fclose(report_file);
+
+    //one JSON object on a single line
+    const char *prefix = "{\"file\": \"./test/testfiles/t13.asm\", \"total_ns\": ";
+    assert_int_equal(strncmp(report, prefix, strlen(prefix)), 0);
+    assert_non_null(strstr(report, "\"labels\": 6, \"words\": 13, "));
+    assert_int_equal(strchr(report, '\n'), report + strlen(report) - 1);
+
+    //the allocations are the ones the tracker counted during the assembly
+    char allocations[100];
+    snprintf(allocations, sizeof(allocations), "\"allocations\": %" PRIu64 ", ", assembly_stats.allocations);
+    assert_non_null(strstr(report, allocations));
+    assert_true(assembly_stats.allocations > assembly_stats.lines);
+    assert_true(assembly_stats.allocations <= memtrack_calls() - calls);
+
+    assert_int_equal(assembly_stats.lines, 24);
+    assert_int_equal(assembly_stats.words, 13);
+    assert_int_equal(assembly_stats.dict.keys, 6);
+    assert_true(assembly_stats.dict.lookups >= 6);
+    assert_true(assembly_stats.phase_ns[PHASE_LEXICAL_ANALYSIS] > 0 && assembly_stats.phase_ns[PHASE_OBJECT_FILE] > 0);
+    assert_int_equal(assembly_stats.phase_ns[PHASE_DCE], 0);
+    assert_true(assembly_stats.total_ns >= assembly_stats.phase_ns[PHASE_LEXICAL_ANALYSIS] + assembly_stats.phase_ns[PHASE_SYNTAX_ANALYSIS]);
+    //segmented object file: 3 header words, 2 words per segment and the 13 words of the program
+    assert_true(assembly_stats.bytes_written > 2 * (3 + 2 * 3 + 13));
+}
+
+static void test_assemble_files_with_trace(void  __attribute__((unused)) **state) {
+    const char *trace_file_name = "./test/testfiles/batch_trace.json";
+    const char *assembly_file_names[] = { "./test/testfiles/t1.asm", "./test/testfiles/t2.asm", "./test/testfiles/t13.asm" };
+    options_t options = { .relax_register = -1, .report = NULL };
+    batch_options_t batch_options = { .num_workers = 2, .trace_file_name = trace_file_name };
+    assert_int_equal(assemble_files(assembly_file_names, 3, &options, &batch_options), 0);
+
+    char trace[20000] = { 0 };
+    FILE *trace_file = fopen(trace_file_name, "r");
+    assert_non_null(trace_file);
+    fread(trace, 1, sizeof(trace) - 1, trace_file);
+    fclose(trace_file);
+    remove(trace_file_name);
+
+    const char *prefix = "{\"traceEvents\": [\n";
+    assert_int_equal(strncmp(trace, prefix, strlen(prefix)), 0);
+    assert_int_equal(strcmp(trace + strlen(trace) - strlen("]}\n"), "]}\n"), 0);
+    //a span for each file and for the phases that ran, in one of the two workers
+    for(int i = 0; i < 3; i++) {
+        char file_span[100];
+        sprintf(file_span, "{\"name\": \"%s\", \"cat\": \"file\", \"ph\": \"X\"", assembly_file_names[i]);
+        assert_non_null(strstr(trace, file_span));
+    }
+    assert_non_null(strstr(trace, "{\"name\": \"syntax_analysis\", \"cat\": \"phase\""));
+    assert_non_null(strstr(trace, "\"args\": {\"name\": \"worker 1\"}"));
+    assert_null(strstr(trace, "\"phase\", \"ph\": \"X\", \"ts\": 0"));
+    //files of the workers are removed once merged
+    assert_null(fopen("./test/testfiles/batch_trace.json.0", "r"));
+}
+
+static void test_assemble_files_with_latency(void  __attribute__((unused)) **state) {
+    const char *assembly_file_names[] = { "./test/testfiles/t1.asm", "./test/testfiles/t6.asm", "./test/testfiles/t13.asm" };
+    char report[5000] = { 0 };
+    FILE *report_file = tmpfile();
+    options_t options = { .relax_register = -1, .report = report_file };
+    for(int num_workers = 1; num_workers <= 2; num_workers++) {
+        rewind(report_file);
+        batch_options_t batch_options = { .num_workers = num_workers, .latency = true, .num_slowest_files = 2 };
+        //t6 has a wrong .ORIG address: failed files are part of the report as well
+        assert_int_equal(assemble_files(assembly_file_names, 3, &options, &batch_options), EXIT_FAILURE);
+        fflush(report_file);
+        rewind(report_file);
+        memset(report, 0, sizeof(report));
+        fread(report, 1, sizeof(report) - 1, report_file);
+
+        assert_non_null(strstr(report, "latency (us)"));
+        assert_non_null(strstr(report, "\nfile                        3 "));
+        assert_non_null(strstr(report, "\nlexical_analysis            3 "));
+        assert_non_null(strstr(report, "\nobject_file                 2 "));
+        assert_null(strstr(report, "\ndce "));
+        //only the 2 slowest files are named
+        char *slowest = strstr(report, "slowest files (us)\n");
+        assert_non_null(slowest);
+        int num_named = 0;
+        for(int i = 0; i < 3; i++) {
+            num_named += strstr(slowest, assembly_file_names[i]) != NULL;
+        }
+        assert_int_equal(num_named, 2);
+    }
+    fclose(report_file);
+}
+
 int main(int argc, char const *argv[]) {
+    //as lc3as --stats=json does, so that the statistics count the allocations
+    memtrack_enable();
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_symbol_table_t2, setup, teardown),
         cmocka_unit_test_setup_teardown(test_symbol_table_t3, setup, teardown),
@@ -234,7 +544,19 @@ int main(int argc, char const *argv[]) {
         cmocka_unit_test_setup_teardown(test_assemble_lcrng_asm, setup, teardown),
         cmocka_unit_test_setup_teardown(test_assemble_charcounter_asm, setup, teardown),
         cmocka_unit_test_setup_teardown(test_assemble_lc3os_asm, setup, teardown),
-        cmocka_unit_test_setup_teardown(test_assemble_2048_asm, setup, teardown)
+        cmocka_unit_test_setup_teardown(test_assemble_2048_asm, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_several_segments_t13, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_overlapping_segments_t14, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_segment_exceeding_address_space_t15, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_labels_on_orig_lines_t24, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_ambiguous_classic_image_t25, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_full_address_space, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_beyond_address_space, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_stringp_t21, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_stringp_savings, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_with_stats_t13, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_files_with_trace, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_assemble_files_with_latency, setup, teardown)
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
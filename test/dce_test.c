@@ -0,0 +1,117 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+
+static int setup(void **state) {
+    clearerrdesc();
+    initialize();
+    return 0;
+}
+
+static int teardown(void **state) {
+    initialize();
+    return 0;
+}
+
+static size_t read_object_file(const char *obj_file_name, uint16_t words[], size_t max_words) {
+    FILE *obj_file = fopen(obj_file_name, "rb");
+    assert_non_null(obj_file);
+    unsigned char bytes[2];
+    size_t num_words = 0;
+    while(num_words < max_words && fread(bytes, 1, 2, obj_file) == 2) {
+        words[num_words++] = bytes[0] << 8 | bytes[1];
+    }
+    fclose(obj_file);
+    return num_words;
+}
+
+static void assemble_with_report(const char *asm_file_name, char *report, size_t report_size) {
+    FILE *report_file = tmpfile();
+    options_t options = { .dce = true, .optimize = false, .relax = false, .relax_register = -1, .report = report_file };
+    exit_t result = assemble_with_options(asm_file_name, &options);
+    assert_int_equal(result.code, 0);
+    rewind(report_file);
+    size_t read = fread(report, 1, report_size - 1, report_file);
+    report[read] = '\0';
+    fclose(report_file);
+}
+
+static void test_dce_t22(void  __attribute__((unused)) **state) {
+    char report[1000];
+    assemble_with_report("./test/testfiles/t22.asm", report, sizeof(report));
+    assert_string_equal(report,
+        "dce (lines 8-9): 2 words removed (unreachable code)\n"
+        "dce (lines 12-13): 2 words removed (unreachable code)\n"
+        "dce (line 14): 1 words removed (unreachable code)\n"
+        "dce (line 18): 1 words removed (unreferenced data)\n"
+        "dce: 6 words removed\n");
+
+    uint16_t words[20];
+    size_t num_words = read_object_file("./test/testfiles/t22.obj", words, 20);
+    const uint16_t expected[] = { 0x3000, 0xe009, 0xf022, 0x4802, 0x2203, 0xc040, 0x2403, 0xc1c0, 0x3008, 0xf025, 0x0003, 0x0068, 0x0069, 0x0000 };
+    assert_int_equal(num_words, sizeof(expected) / sizeof(expected[0]));
+    for(size_t i = 0; i < num_words; i++) {
+        assert_int_equal(words[i], expected[i]);
+    }
+
+    //labels of removed code are dropped from the symbol table, the rest are moved
+    assert_null(lookup("UNUSED"));
+    assert_null(lookup("DEAD"));
+    assert_null(lookup("DEAD2"));
+    assert_null(lookup("SPARE"));
+    assert_int_equal(lookup("PRINT")->val, 0x3005);
+    assert_int_equal(lookup("DONE")->val, 0x3008);
+    assert_int_equal(lookup("MSG")->val, 0x300a);
+}
+
+static void test_dce_unreferenced_data_2048(void  __attribute__((unused)) **state) {
+    char report[500];
+    assemble_with_report("./test/testfiles/2048.asm", report, sizeof(report));
+    assert_string_equal(report,
+        "dce (line 721): 1 words removed (unreferenced data)\n"
+        "dce: 1 words removed\n");
+    assert_null(lookup("RAND_M"));
+}
+
+static void test_dce_without_removals_lcrng(void  __attribute__((unused)) **state) {
+    char report[500];
+    assemble_with_report("./test/testfiles/lcrng.asm", report, sizeof(report));
+    assert_string_equal(report, "");
+
+    static uint16_t actual[ADDRESS_SPACE_CARDINALITY], expected[ADDRESS_SPACE_CARDINALITY];
+    size_t num_words = read_object_file("./test/testfiles/lcrng.obj", actual, ADDRESS_SPACE_CARDINALITY);
+    assert_int_equal(num_words, read_object_file("./test/testfiles/lcrng.expected.obj", expected, ADDRESS_SPACE_CARDINALITY));
+    assert_memory_equal(actual, expected, num_words * sizeof(uint16_t));
+}
+
+static void test_dce_array_elements_t27(void  __attribute__((unused)) **state) {
+    char report[500];
+    assemble_with_report("./test/testfiles/t27.asm", report, sizeof(report));
+    //SECOND and THIRD are read through the address of ARR; the array ends at the next instructions
+    assert_string_equal(report,
+        "dce (line 10): 1 words removed (unreachable code)\n"
+        "dce (line 11): 1 words removed (unreferenced data)\n"
+        "dce: 2 words removed\n");
+
+    uint16_t words[20];
+    size_t num_words = read_object_file("./test/testfiles/t27.obj", words, 20);
+    const uint16_t expected[] = { 0x3000, 0xe003, 0x6201, 0x6402, 0xf025, 0x0001, 0x0002, 0x0003 };
+    assert_int_equal(num_words, sizeof(expected) / sizeof(expected[0]));
+    for(size_t i = 0; i < num_words; i++) {
+        assert_int_equal(words[i], expected[i]);
+    }
+    assert_int_equal(lookup("THIRD")->val, 0x3006);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_dce_t22, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_dce_unreferenced_data_2048, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_dce_without_removals_lcrng, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_dce_array_elements_t27, setup, teardown)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,167 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+#include "../include/debuginfo.h"
+
+static int setup(void **state) {
+    clearerrdesc();
+    initialize();
+    return 0;
+}
+
+static int teardown(void **state) {
+    initialize();
+    remove("./test/testfiles/t13.dbg");
+    remove("./test/testfiles/lc3os.dbg");
+    return 0;
+}
+
+static void assemble_with_debug_info(const char *asm_file_name, const char *debug_file_name, debuginfo_t *debuginfo) {
+    options_t options = { .relax_register = -1, .debug_info = true };
+    exit_t result = assemble_with_options(asm_file_name, &options);
+    assert_int_equal(result.code, 0);
+    result = debuginfo_open(debug_file_name, debuginfo);
+    assert_int_equal(result.code, 0);
+}
+
+static void assert_location(const debuginfo_t *debuginfo, memaddr_t address, uint32_t line, uint32_t column) {
+    debuginfo_location_t location;
+    assert_true(debuginfo_lookup(debuginfo, address, &location));
+    assert_int_equal(location.line, line);
+    assert_int_equal(location.column, column);
+}
+
+static void test_debuginfo_segments_t13(void  __attribute__((unused)) **state) {
+    debuginfo_t debuginfo;
+    assemble_with_debug_info("./test/testfiles/t13.asm", "./test/testfiles/t13.dbg", &debuginfo);
+    assert_string_equal(debuginfo_source_name(&debuginfo), "./test/testfiles/t13.asm");
+
+    assert_location(&debuginfo, 0x3000, 5, 5);
+    assert_location(&debuginfo, 0x3003, 8, 6);
+    assert_location(&debuginfo, 0x3004, 9, 5);
+    assert_location(&debuginfo, 0x3080, 15, 7);
+    assert_location(&debuginfo, 0x3081, 16, 5);
+    //words generated by a directive share its location
+    assert_location(&debuginfo, 0x3082, 17, 5);
+    assert_location(&debuginfo, 0x3084, 17, 5);
+    assert_location(&debuginfo, 0xC002, 22, 5);
+
+    //gaps between segments
+    debuginfo_location_t location;
+    assert_false(debuginfo_lookup(&debuginfo, 0x2FFF, &location));
+    assert_false(debuginfo_lookup(&debuginfo, 0x3005, &location));
+    assert_false(debuginfo_lookup(&debuginfo, 0x3085, &location));
+    assert_false(debuginfo_lookup(&debuginfo, 0xC003, &location));
+    assert_false(debuginfo_lookup(&debuginfo, 0xFFFF, &location));
+
+    assert_null(debuginfo_scope(&debuginfo, 0x3000));
+    assert_string_equal(debuginfo_scope(&debuginfo, 0x3003), "BACK");
+    assert_string_equal(debuginfo_scope(&debuginfo, 0x3004), "PTR");
+    assert_null(debuginfo_scope(&debuginfo, 0x3005));
+    assert_string_equal(debuginfo_scope(&debuginfo, 0x3081), "VALUE");
+    assert_string_equal(debuginfo_scope(&debuginfo, 0x3084), "MSG");
+    assert_string_equal(debuginfo_scope(&debuginfo, 0xC002), "TABLE");
+    assert_null(debuginfo_scope(&debuginfo, 0xC003));
+    debuginfo_close(&debuginfo);
+}
+
+static void test_debuginfo_checkpoints_lc3os(void  __attribute__((unused)) **state) {
+    debuginfo_t debuginfo;
+    assemble_with_debug_info("./test/testfiles/lc3os.asm", "./test/testfiles/lc3os.dbg", &debuginfo);
+    assert_true(debuginfo.header->num_checkpoints > 1);
+    //compact encoding: a few bytes per row
+    assert_true(debuginfo.header->rows_size < 4 * debuginfo.header->num_rows);
+
+    //single segment starting at x0000: the mapped addresses are contiguous and their lines grow with them
+    uint32_t previous_line = 0;
+    uint32_t num_mapped = 0;
+    for(uint32_t address = 0; address < ADDRESS_SPACE_CARDINALITY; address++) {
+        debuginfo_location_t location;
+        if(!debuginfo_lookup(&debuginfo, address, &location)) {
+            continue;
+        }
+        assert_int_equal(address, num_mapped++);
+        assert_true(location.line >= previous_line);
+        previous_line = location.line;
+    }
+    assert_true(num_mapped > 512);
+
+    //every label is the scope of its own address (the symbol table contains addresses once assembled)
+    for(node_t *node = next(true); node; node = next(false)) {
+        const char *scope = debuginfo_scope(&debuginfo, node->val);
+        if(scope) {
+            assert_int_equal(lookup(scope)->val, node->val);
+        }
+    }
+    debuginfo_close(&debuginfo);
+}
+
+static void test_debuginfo_invalid_file(void  __attribute__((unused)) **state) {
+    debuginfo_t debuginfo;
+    exit_t result = debuginfo_open("./test/testfiles/t13.asm", &debuginfo);
+    assert_int_equal(result.code, EXIT_FAILURE);
+    assert_string_equal(result.desc, "ERROR: Invalid debug file (./test/testfiles/t13.asm)");
+    free(result.desc);
+}
+
+/**
+ * @brief Overwrite a 32-bit word of a debug file and check that it is refused
+ */
+static void assert_corrupt_word(const char *debug_file_name, long offset, uint32_t value) {
+    FILE *file = fopen(debug_file_name, "r+b");
+    assert_non_null(file);
+    uint32_t original;
+    assert_int_equal(fseek(file, offset, SEEK_SET), 0);
+    assert_int_equal(fread(&original, sizeof(original), 1, file), 1);
+    assert_int_equal(fseek(file, offset, SEEK_SET), 0);
+    assert_int_equal(fwrite(&value, sizeof(value), 1, file), 1);
+    fclose(file);
+
+    debuginfo_t debuginfo;
+    exit_t result = debuginfo_open(debug_file_name, &debuginfo);
+    assert_int_equal(result.code, EXIT_FAILURE);
+    assert_string_equal(result.desc, "ERROR: Invalid debug file (./test/testfiles/t13.dbg)");
+    free(result.desc);
+
+    file = fopen(debug_file_name, "r+b");
+    assert_non_null(file);
+    assert_int_equal(fseek(file, offset, SEEK_SET), 0);
+    assert_int_equal(fwrite(&original, sizeof(original), 1, file), 1);
+    fclose(file);
+}
+
+static void test_debuginfo_corrupt_file(void  __attribute__((unused)) **state) {
+    debuginfo_t debuginfo;
+    assemble_with_debug_info("./test/testfiles/t13.asm", "./test/testfiles/t13.dbg", &debuginfo);
+    debuginfo_header_t header = *debuginfo.header;
+    debuginfo_close(&debuginfo);
+    assert_true(header.num_checkpoints > 0 && header.num_scopes > 0);
+
+    const char *debug_file_name = "./test/testfiles/t13.dbg";
+    assert_corrupt_word(debug_file_name, header.checkpoints_offset + offsetof(debuginfo_checkpoint_t, row_offset),
+                        header.rows_size);
+    assert_corrupt_word(debug_file_name, header.scopes_offset + offsetof(debuginfo_scope_t, name_offset),
+                        header.strings_size);
+    assert_corrupt_word(debug_file_name, offsetof(debuginfo_header_t, source_name_offset), header.strings_size);
+    assert_corrupt_word(debug_file_name, offsetof(debuginfo_header_t, scopes_offset), header.scopes_offset + 2);
+    //the strings table no longer ends with a terminator
+    assert_corrupt_word(debug_file_name, offsetof(debuginfo_header_t, strings_size), header.strings_size - 1);
+
+    //restored, the file is read again
+    exit_t result = debuginfo_open(debug_file_name, &debuginfo);
+    assert_int_equal(result.code, 0);
+    debuginfo_close(&debuginfo);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_debuginfo_segments_t13, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_debuginfo_checkpoints_lc3os, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_debuginfo_invalid_file, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_debuginfo_corrupt_file, setup, teardown)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
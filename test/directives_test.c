@@ -9,8 +9,8 @@
 static int setup(void **state) {
     clearerrdesc();
     initialize();
-    linemetadata_t **tokenized_lines = malloc(ADDRESS_SPACE_CARDINALITY * sizeof(linemetadata_t *));
-    for(size_t i = 0; i < ADDRESS_SPACE_CARDINALITY; i++) {
+    linemetadata_t **tokenized_lines = malloc(TOKENIZED_LINES_CAPACITY * sizeof(linemetadata_t *));
+    for(size_t i = 0; i < TOKENIZED_LINES_CAPACITY; i++) {
         //setting sentinel values
         tokenized_lines[i] = NULL;
     }
@@ -64,7 +64,7 @@ static void test_parse_fill_immediate_too_small(void  __attribute__((unused)) **
 }
 
 static void test_parse_stringz_with_escape_sequences(void  __attribute__((unused)) **state) {
-    memaddr_t instruction_offset = 0;
+    size_t instruction_offset = 0;
     linemetadata_t **tokenized_lines = *state;
     char str[] = {'"', 'a', '\\', 'n', '"', '\0'};   
     char *tokens[] = { ".STRINGZ", str };
@@ -97,7 +97,7 @@ static void test_parse_stringz_with_escape_sequences(void  __attribute__((unused
 }
 
 static void test_parse_stringz_char_outside_quotation_marks(void  __attribute__((unused)) **state) {
-    memaddr_t instruction_offset = 1;
+    size_t instruction_offset = 1;
     linemetadata_t **tokenized_lines = *state;
     char *tokens[] = { ".STRINGZ", "  a \"string content\"" };
     linemetadata_t line_metadata = {.tokens = tokens, .num_tokens = 2, .line_number = 1 };
@@ -108,7 +108,7 @@ static void test_parse_stringz_char_outside_quotation_marks(void  __attribute__(
 }
 
 static void test_parse_stringz_missing_quotation_marks(void  __attribute__((unused)) **state) {
-    memaddr_t instruction_offset = 1;
+    size_t instruction_offset = 1;
     linemetadata_t **tokenized_lines = *state;
     char str[] = {'"', 'h', '\0'};   
     char *tokens[] = { ".STRINGZ", str };
@@ -119,6 +119,50 @@ static void test_parse_stringz_missing_quotation_marks(void  __attribute__((unus
     free(result.desc);
 }
 
+static void test_parse_stringp_packs_two_characters_per_word(void  __attribute__((unused)) **state) {
+    size_t instruction_offset = 0;
+    linemetadata_t **tokenized_lines = *state;
+    linemetadata_t *line_metadata = new_line(".STRINGP \"abc\\n\"", 1);
+    exit_t result = parse_stringp(line_metadata, tokenized_lines, &instruction_offset);
+    assert_int_equal(result.code, 0);
+    assert_int_equal(instruction_offset, 3);
+
+    //the directive line keeps the slot of the first word
+    assert_ptr_equal(tokenized_lines[0], line_metadata);
+    assert_int_equal(0x6261, tokenized_lines[0]->machine_instruction);
+    assert_null(tokenized_lines[1]->tokens);
+    assert_int_equal(0x0a63, tokenized_lines[1]->machine_instruction);
+    assert_int_equal(0, tokenized_lines[2]->machine_instruction);
+    assert_null(tokenized_lines[3]);
+}
+
+static void test_parse_stringp_odd_length(void  __attribute__((unused)) **state) {
+    size_t instruction_offset = 0;
+    linemetadata_t **tokenized_lines = *state;
+    linemetadata_t *line_metadata = new_line(".STRINGP \"abc\"", 1);
+    exit_t result = parse_stringp(line_metadata, tokenized_lines, &instruction_offset);
+    assert_int_equal(result.code, 0);
+    assert_int_equal(instruction_offset, 3);
+
+    assert_int_equal(0x6261, tokenized_lines[0]->machine_instruction);
+    //x00 in bits [15:8] of the last character word
+    assert_int_equal(0x0063, tokenized_lines[1]->machine_instruction);
+    assert_int_equal(0, tokenized_lines[2]->machine_instruction);
+    assert_null(tokenized_lines[3]);
+}
+
+static void test_parse_stringp_missing_quotation_marks(void  __attribute__((unused)) **state) {
+    size_t instruction_offset = 0;
+    linemetadata_t **tokenized_lines = *state;
+    char str[] = {'"', 'h', '\0'};
+    char *tokens[] = { ".STRINGP", str };
+    linemetadata_t line_metadata = {.line = ".STRINGP \"h", .tokens = tokens, .num_tokens = 2, .line_number = 1 };
+    exit_t result = parse_stringp(&line_metadata, tokenized_lines, &instruction_offset);
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR (line 1): Bad string ('.STRINGP \"h')");
+    free(result.desc);
+}
+
 int main(int argc, char const *argv[]) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_parse_fill_success, setup, teardown),
@@ -126,7 +170,10 @@ int main(int argc, char const *argv[]) {
         cmocka_unit_test_setup_teardown(test_parse_fill_immediate_too_small, setup, teardown),
         cmocka_unit_test_setup_teardown(test_parse_stringz_char_outside_quotation_marks, setup, teardown),
         cmocka_unit_test_setup_teardown(test_parse_stringz_missing_quotation_marks, setup, teardown),
-        cmocka_unit_test_setup_teardown(test_parse_stringz_with_escape_sequences, setup, teardown)
+        cmocka_unit_test_setup_teardown(test_parse_stringz_with_escape_sequences, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_parse_stringp_packs_two_characters_per_word, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_parse_stringp_odd_length, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_parse_stringp_missing_quotation_marks, setup, teardown)
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -0,0 +1,86 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/histogram.h"
+
+static histogram_t histogram;
+
+static int setup(void **state) {
+    histogram_init(&histogram);
+    return 0;
+}
+
+static void test_empty_histogram(void  __attribute__((unused)) **state) {
+    assert_int_equal(histogram.total_count, 0);
+    assert_int_equal(histogram_percentile(&histogram, 50), 0);
+    assert_int_equal(histogram_percentile(&histogram, 100), 0);
+}
+
+static void test_small_values_are_exact(void  __attribute__((unused)) **state) {
+    for(uint64_t value = 1; value <= 100; value++) {
+        histogram_record(&histogram, value);
+    }
+    assert_int_equal(histogram.total_count, 100);
+    assert_int_equal(histogram.min, 1);
+    assert_int_equal(histogram.max, 100);
+    assert_int_equal(histogram_percentile(&histogram, 50), 50);
+    assert_int_equal(histogram_percentile(&histogram, 90), 90);
+    assert_int_equal(histogram_percentile(&histogram, 99), 99);
+    assert_int_equal(histogram_percentile(&histogram, 99.9), 100);
+    assert_int_equal(histogram_percentile(&histogram, 0), 1);
+}
+
+static void test_relative_error_is_bounded(void  __attribute__((unused)) **state) {
+    //1000 values from 1us to 1s, growing by 1.4% each
+    uint64_t values[1000];
+    double value = 1000;
+    for(int i = 0; i < 1000; i++) {
+        values[i] = (uint64_t)value;
+        histogram_record(&histogram, values[i]);
+        value *= 1.014;
+    }
+    const double percentiles[] = { 1, 25, 50, 90, 99, 99.9 };
+    for(size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); i++) {
+        uint64_t expected = values[(int)(percentiles[i] * 10 + 0.5) - 1];
+        uint64_t actual = histogram_percentile(&histogram, percentiles[i]);
+        assert_true(actual >= expected);
+        assert_true(actual - expected <= expected * 2 / HISTOGRAM_SUB_BUCKETS);
+    }
+    assert_int_equal(histogram_percentile(&histogram, 100), values[999]);
+}
+
+static void test_largest_values_are_capped(void  __attribute__((unused)) **state) {
+    histogram_record(&histogram, 10);
+    histogram_record(&histogram, UINT64_MAX);
+    assert_int_equal(histogram.max, UINT64_MAX);
+    assert_int_equal(histogram_percentile(&histogram, 50), 10);
+    assert_true(histogram_percentile(&histogram, 100) >= (UINT64_C(1) << (HISTOGRAM_MAX_BITS - 1)));
+}
+
+static void test_merge(void  __attribute__((unused)) **state) {
+    histogram_t other;
+    histogram_init(&other);
+    for(uint64_t value = 1; value <= 50; value++) {
+        histogram_record(&histogram, value);
+        histogram_record(&other, value + 50);
+    }
+    histogram_merge(&histogram, &other);
+    assert_int_equal(histogram.total_count, 100);
+    assert_int_equal(histogram.min, 1);
+    assert_int_equal(histogram.max, 100);
+    assert_int_equal(histogram_percentile(&histogram, 50), 50);
+    assert_int_equal(histogram_percentile(&histogram, 75), 75);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_empty_histogram, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_small_values_are_exact, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_relative_error_is_bounded, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_largest_values_are_capped, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_merge, setup, NULL)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,273 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+#include "../include/jit.h"
+
+#define MAX_RANDOM_INSTRUCTIONS 20000
+#define NUM_RANDOM_PROGRAMS 300
+
+typedef struct {
+    const char *input;
+    char output[4000];
+    size_t output_length;
+} console_t;
+
+//the same program runs on `interpreted` with vm_run and on `jitted` with jit_run
+static vm_t interpreted, jitted;
+static console_t interpreted_console, jitted_console;
+static jit_t jit;
+static uint32_t random_state;
+
+static int read_console(void *context) {
+    console_t *c = context;
+    return *c->input ? *c->input++ : EOF;
+}
+
+static void write_console(int ch, void *context) {
+    console_t *c = context;
+    if(c->output_length < sizeof(c->output) - 1) {
+        c->output[c->output_length++] = ch;
+        c->output[c->output_length] = '\0';
+    }
+}
+
+static void init_machines(const char *input, unsigned threshold, bool step) {
+    vm_init(&interpreted);
+    vm_init(&jitted);
+    interpreted_console = (console_t){ .input = input };
+    jitted_console = (console_t){ .input = input };
+    interpreted.io = (vm_io_t){ read_console, write_console, &interpreted_console };
+    jitted.io = (vm_io_t){ read_console, write_console, &jitted_console };
+    jit_release(&jit);
+    exit_t result = jit_init(&jit, threshold);
+    assert_int_equal(result.code, 0);
+    jit.step = step;
+}
+
+static void load_object(const char *object_file, uint16_t *origin) {
+    exit_t result = vm_load_object(&interpreted, object_file, origin);
+    assert_int_equal(result.code, 0);
+    result = vm_load_object(&jitted, object_file, origin);
+    assert_int_equal(result.code, 0);
+}
+
+static void load_words(const uint16_t words[], size_t num_words) {
+    unsigned char bytes[200];
+    uint16_t origin;
+    for(size_t i = 0; i < num_words; i++) {
+        bytes[2 * i] = words[i] >> 8;
+        bytes[2 * i + 1] = words[i] & 0xff;
+    }
+    exit_t result = vm_load_image(&interpreted, bytes, 2 * num_words, &origin);
+    assert_int_equal(result.code, 0);
+    result = vm_load_image(&jitted, bytes, 2 * num_words, &origin);
+    assert_int_equal(result.code, 0);
+    interpreted.pc = jitted.pc = origin;
+}
+
+static void assert_same_state() {
+    assert_memory_equal(jitted.registers, interpreted.registers, sizeof(interpreted.registers));
+    assert_int_equal(jitted.pc, interpreted.pc);
+    assert_int_equal(jitted.psr, interpreted.psr);
+    assert_int_equal(jitted.mpr, interpreted.mpr);
+    assert_int_equal(jitted.instructions, interpreted.instructions);
+    assert_memory_equal(jitted.memory, interpreted.memory, sizeof(interpreted.memory));
+    assert_string_equal(jitted_console.output, interpreted_console.output);
+}
+
+/**
+ * @brief Run the JIT one block at a time (jit.step) and the interpreter for as many instructions, comparing the
+ * machines after every block
+ */
+static vm_status_t run_block_by_block(uint64_t max_instructions) {
+    vm_status_t jitted_status, interpreted_status;
+    do {
+        uint64_t before = jitted.instructions;
+        jitted_status = jit_run(&jit, &jitted, max_instructions - before);
+        interpreted_status = vm_run(&interpreted, jitted.instructions - before);
+        assert_int_equal(jitted_status, interpreted_status);
+        assert_same_state();
+    } while(jitted_status == VM_LIMIT_REACHED && jitted.instructions < max_instructions);
+    return jitted_status;
+}
+
+/**
+ * @brief Run both machines in slices of increasing length, comparing them after every slice
+ */
+static vm_status_t run_in_slices(uint64_t max_instructions) {
+    static const uint64_t slices[] = { 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 377, 610, 987, 1597 };
+    vm_status_t jitted_status, interpreted_status;
+    size_t slice = 0;
+    do {
+        jitted_status = jit_run(&jit, &jitted, slices[slice]);
+        interpreted_status = vm_run(&interpreted, slices[slice]);
+        assert_int_equal(jitted_status, interpreted_status);
+        assert_same_state();
+        slice = (slice + 1) % (sizeof(slices) / sizeof(slices[0]));
+    } while(jitted_status == VM_LIMIT_REACHED && jitted.instructions < max_instructions);
+    return jitted_status;
+}
+
+static uint32_t next_random() {
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 8;
+}
+
+/**
+ * @brief Random instruction that does not stop the machine on its own, except a few HALT
+ */
+static uint16_t random_instruction() {
+    static const int opcodes[] = { 0, 0, 1, 1, 1, 2, 3, 4, 4, 5, 5, 6, 6, 7, 7, 9, 10, 11, 12, 14, 15 };
+    int opcode = opcodes[next_random() % (sizeof(opcodes) / sizeof(opcodes[0]))];
+    uint16_t fields = next_random() & 0x0FFF;
+    switch(opcode) {
+    case 4: //JSR with a short offset, JSRR
+        return fields & 0x800 ? 0x4800 | (fields & 0x1F) : 0x4000 | (fields & 0x1C0);
+    case 9:
+        return 0x903F | (fields & 0xFC0);
+    case 12: //JMP, RET and JMPT
+        return 0xC000 | (fields & 0x1C0) | (next_random() % 8 == 0);
+    case 15:
+        return next_random() % 4 == 0 ? 0xF025 : 0xF021;
+    default: //short branches stay in the program
+        return opcode == 0 ? (fields & 0xE00) | (fields & 0x1F) | (fields & 0x100 ? 0x1E0 : 0) : opcode << 12 | fields;
+    }
+}
+
+static void load_random_program(uint32_t seed) {
+    uint16_t words[1 + 96];
+    random_state = seed;
+    words[0] = 0x3000;
+    for(int i = 1; i <= 64; i++) {
+        words[i] = random_instruction();
+    }
+    for(int i = 65; i <= 96; i++) {
+        words[i] = next_random();
+    }
+    load_words(words, 97);
+    for(int r = 0; r < VM_NUM_REGISTERS; r++) {
+        interpreted.registers[r] = jitted.registers[r] = 0x3000 + next_random() % 0x100;
+    }
+}
+
+static void test_lcrng_after_every_block(void  __attribute__((unused)) **state) {
+    uint16_t origin;
+    init_machines("", 1, true);
+    exit_t result = assemble("./test/testfiles/lcrng.asm");
+    assert_int_equal(result.code, 0);
+    load_object("./test/testfiles/lcrng.obj", &origin);
+    interpreted.pc = jitted.pc = origin;
+    assert_int_equal(run_block_by_block(VM_UNLIMITED), VM_HALTED);
+    assert_true(jit.stats.native_instructions > jit.stats.interpreted_instructions);
+}
+
+static void test_operating_system_after_every_block(void  __attribute__((unused)) **state) {
+    uint16_t origin;
+    init_machines("", 1, true);
+    load_object("./test/testfiles/lc3os.obj", &origin);
+    load_object("./test/testfiles/lcrng.obj", &origin);
+    interpreted.pc = jitted.pc = VM_OS_START;
+    assert_int_equal(run_block_by_block(VM_UNLIMITED), VM_HALTED);
+    assert_true(jit.stats.native_instructions > 0);
+}
+
+static void test_chained_blocks(void  __attribute__((unused)) **state) {
+    uint16_t origin;
+    init_machines("", 2, false);
+    load_object("./test/testfiles/lc3os.obj", &origin);
+    load_object("./test/testfiles/lcrng.obj", &origin);
+    interpreted.pc = jitted.pc = VM_OS_START;
+    assert_int_equal(run_in_slices(VM_UNLIMITED), VM_HALTED);
+
+    //without slices, the program runs in translated code and jit_run only sees traps and untranslated branches
+    init_machines("", 2, false);
+    load_object("./test/testfiles/lcrng.obj", &origin);
+    interpreted.pc = jitted.pc = origin;
+    assert_int_equal(jit_run(&jit, &jitted, VM_UNLIMITED), VM_HALTED);
+    assert_int_equal(vm_run(&interpreted, VM_UNLIMITED), VM_HALTED);
+    assert_same_state();
+    assert_true(jit.stats.native_instructions > 10 * jit.stats.interpreted_instructions);
+}
+
+static void test_instruction_limit(void  __attribute__((unused)) **state) {
+    //ADD R1,R1,#1; BRnzp #-2
+    const uint16_t program[] = { 0x3000, 0x1261, 0x0FFE };
+    init_machines("", 1, false);
+    load_words(program, 3);
+    assert_int_equal(jit_run(&jit, &jitted, 100001), VM_LIMIT_REACHED);
+    assert_int_equal(jitted.registers[1], 50001);
+    assert_int_equal(jitted.pc, 0x3001);
+    assert_int_equal(jit_run(&jit, &jitted, 1), VM_LIMIT_REACHED);
+    assert_int_equal(jitted.pc, 0x3000);
+    assert_int_equal(jitted.instructions, 100002);
+    assert_true(jit.stats.native_instructions > 99000);
+}
+
+static void test_self_modifying_code(void  __attribute__((unused)) **state) {
+    //x3000: ADD R1,R1,#1; LD R0,#4; ST R0,#-3 (x3000 becomes ADD R1,R1,#2); ADD R3,R3,#-1; BRp #-5; HALT; x1262
+    const uint16_t program[] = { 0x3000, 0x1261, 0x2004, 0x31FD, 0x16FF, 0x03FB, 0xF025, 0x1262 };
+    for(int step = 0; step < 2; step++) {
+        init_machines("", 1, step);
+        load_words(program, 8);
+        interpreted.registers[3] = jitted.registers[3] = 3;
+        assert_int_equal(step ? run_block_by_block(VM_UNLIMITED) : run_in_slices(VM_UNLIMITED), VM_HALTED);
+        assert_int_equal(jitted.registers[1], 5);
+        assert_true(jit.stats.flushes > 0);
+    }
+}
+
+static void test_access_violation(void  __attribute__((unused)) **state) {
+    //LEA R0,#2; JMPT R0; HALT; LD R1,#-4 (x3000); LDR R2,R1,#0 (xE002 is not accessible); HALT
+    const uint16_t program[] = { 0x3000, 0xE002, 0xC001, 0xF025, 0x23FC, 0x6440, 0xF025 };
+    init_machines("", 1, true);
+    load_words(program, 7);
+    interpreted.mpr = jitted.mpr = 0x0008;
+    assert_int_equal(run_block_by_block(VM_UNLIMITED), VM_ACCESS_VIOLATION);
+    assert_int_equal(jitted.pc, 0x3004);
+}
+
+static void test_random_programs(void  __attribute__((unused)) **state) {
+    uint64_t native_instructions = 0;
+    for(uint32_t seed = 1; seed <= NUM_RANDOM_PROGRAMS; seed++) {
+        //block by block, chained in slices, and in user mode with a few accessible pages
+        int mode = seed % 3;
+        init_machines("abc", 1 + seed % 3, mode == 0);
+        load_random_program(seed);
+        if(mode == 2) {
+            interpreted.psr = jitted.psr = VM_PSR_Z;
+            interpreted.mpr = jitted.mpr = 0x0018;
+        }
+        if(mode == 0) {
+            run_block_by_block(MAX_RANDOM_INSTRUCTIONS);
+        }
+        else {
+            run_in_slices(MAX_RANDOM_INSTRUCTIONS);
+        }
+        native_instructions += jit.stats.native_instructions;
+    }
+    assert_true(native_instructions > 0);
+}
+
+static void test_release(void  __attribute__((unused)) **state) {
+    jit_release(&jit);
+    assert_null(jit.code);
+    jit_release(&jit);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_lcrng_after_every_block),
+        cmocka_unit_test(test_operating_system_after_every_block),
+        cmocka_unit_test(test_chained_blocks),
+        cmocka_unit_test(test_instruction_limit),
+        cmocka_unit_test(test_self_modifying_code),
+        cmocka_unit_test(test_access_violation),
+        cmocka_unit_test(test_random_programs),
+        cmocka_unit_test(test_release),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,126 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3gen.h"
+
+#define GENERATED_FILE "./out/generated"
+
+static int setup(void **state) {
+    clearerrdesc();
+    initialize();
+    return 0;
+}
+
+static int teardown(void **state) {
+    initialize();
+    remove(GENERATED_FILE ".asm");
+    remove(GENERATED_FILE ".obj");
+    remove(GENERATED_FILE ".sym");
+    return 0;
+}
+
+static size_t generate_file(const generator_options_t *options) {
+    FILE *asm_file = fopen(GENERATED_FILE ".asm", "w");
+    assert_non_null(asm_file);
+    size_t num_words;
+    exit_t result = generate_program(asm_file, options, &num_words);
+    fclose(asm_file);
+    assert_int_equal(result.code, 0);
+    return num_words;
+}
+
+static size_t generate_in_memory(const generator_options_t *options, char *program, size_t program_size) {
+    FILE *asm_file = tmpfile();
+    size_t num_words;
+    exit_t result = generate_program(asm_file, options, &num_words);
+    assert_int_equal(result.code, 0);
+    rewind(asm_file);
+    size_t read = fread(program, 1, program_size - 1, asm_file);
+    program[read] = '\0';
+    fclose(asm_file);
+    return read;
+}
+
+static void test_generated_programs_assemble(void  __attribute__((unused)) **state) {
+    generator_options_t workloads[] = {
+        GENERATOR_DEFAULT_OPTIONS,
+        { .num_lines = 3000, .seed = 2, .label_density = 1, .forward_ratio = 1, .data_ratio = 0, .comment_ratio = 0, .branch_distance = 255 },
+        { .num_lines = 3000, .seed = 3, .label_density = 0.01, .forward_ratio = 0, .data_ratio = 0.5, .comment_ratio = 0.5, .branch_distance = 1 },
+        //does not fit in the address space: the program is truncated
+        { .num_lines = 30000, .seed = 4, .label_density = 0.2, .forward_ratio = 0.5, .data_ratio = 0.9, .comment_ratio = 0, .branch_distance = 64 },
+    };
+    for(size_t i = 0; i < sizeof(workloads) / sizeof(workloads[0]); i++) {
+        size_t num_words = generate_file(&workloads[i]);
+        assert_true(num_words > 0 && num_words <= ADDRESS_SPACE_CARDINALITY);
+        initialize();
+        exit_t result = assemble(GENERATED_FILE ".asm");
+        assert_int_equal(result.code, 0);
+
+        FILE *obj_file = fopen(GENERATED_FILE ".obj", "rb");
+        assert_non_null(obj_file);
+        fseek(obj_file, 0, SEEK_END);
+        //.ORIG + words
+        assert_int_equal(ftell(obj_file), 2 * (num_words + 1));
+        fclose(obj_file);
+    }
+}
+
+static void test_same_seed_same_program(void  __attribute__((unused)) **state) {
+    static char first[100000], second[100000];
+    generator_options_t options = GENERATOR_DEFAULT_OPTIONS;
+    generate_in_memory(&options, first, sizeof(first));
+    generate_in_memory(&options, second, sizeof(second));
+    assert_string_equal(first, second);
+
+    options.seed++;
+    generate_in_memory(&options, second, sizeof(second));
+    assert_true(strcmp(first, second) != 0);
+}
+
+static void test_colliding_labels(void  __attribute__((unused)) **state) {
+    generator_options_t options = GENERATOR_DEFAULT_OPTIONS;
+    options.num_lines = 5000;
+    options.label_density = 1;
+    options.collide = true;
+    generate_file(&options);
+    exit_t result = assemble(GENERATED_FILE ".asm");
+    assert_int_equal(result.code, 0);
+
+    //the symbol table has grown beyond its initial size and all labels are still in the same list
+    size_t num_labels = 0;
+    unsigned bucket = 0;
+    for(node_t *np = next(true); np; np = next(false)) {
+        if(num_labels++ == 0) {
+            bucket = hash(np->key);
+        }
+        assert_int_equal(hash(np->key), bucket);
+    }
+    assert_true(num_labels > DICTSIZE);
+}
+
+static void test_invalid_options(void  __attribute__((unused)) **state) {
+    generator_options_t options = GENERATOR_DEFAULT_OPTIONS;
+    size_t num_words;
+    options.data_ratio = 1.5;
+    exit_t result = generate_program(stdout, &options, &num_words);
+    assert_int_equal(result.code, 1);
+    free(result.desc);
+
+    options.data_ratio = 0.5;
+    options.branch_distance = 256;
+    result = generate_program(stdout, &options, &num_words);
+    assert_int_equal(result.code, 1);
+    free(result.desc);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_generated_programs_assemble, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_same_seed_same_program, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_colliding_labels, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_invalid_options, setup, teardown)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
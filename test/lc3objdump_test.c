@@ -0,0 +1,162 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdlib.h>
+#include "../include/lc3objdump.h"
+
+#define FORMAT_TEST_BYTES 1001 // odd, so that the last line holds a single byte
+
+static const char *symbols[ADDRESS_SPACE_SIZE];
+static char output[16 * MAX_DISASSEMBLED_LINE];
+
+static int setup(void **state) {
+    build_decode_table();
+    memset(symbols, 0, sizeof(symbols));
+    return 0;
+}
+
+/**
+ * @brief Instruction of the only line disassembled from `word` at x3000
+ */
+static const char *disassemble(uint16_t word) {
+    size_t length = disassemble_words(&word, 1, 0x3000, symbols, output);
+    output[length - 1] = '\0';
+    return output + strlen("x3000  0000  ") + 16 + 1;
+}
+
+static void test_operate_instructions(void  __attribute__((unused)) **state) {
+    assert_string_equal(disassemble(0x1042), "ADD R0,R1,R2");
+    assert_string_equal(disassemble(0x1021), "ADD R0,R0,#1");
+    assert_string_equal(disassemble(0x1E3F), "ADD R7,R0,#-1");
+    assert_string_equal(disassemble(0x5B60), "AND R5,R5,#0");
+    assert_string_equal(disassemble(0x5042), "AND R0,R1,R2");
+    assert_string_equal(disassemble(0x907F), "NOT R0,R1");
+    assert_string_equal(disassemble(0x6A81), "LDR R5,R2,#1");
+    assert_string_equal(disassemble(0x7FA0), "STR R7,R6,#-32");
+}
+
+static void test_control_instructions(void  __attribute__((unused)) **state) {
+    assert_string_equal(disassemble(0xC040), "JMP R1");
+    assert_string_equal(disassemble(0xC1C0), "RET");
+    assert_string_equal(disassemble(0xC041), "JMPT R1");
+    assert_string_equal(disassemble(0xC1C1), "RTT");
+    assert_string_equal(disassemble(0x4080), "JSRR R2");
+    assert_string_equal(disassemble(0x8000), "RTI");
+}
+
+static void test_trap_aliases(void  __attribute__((unused)) **state) {
+    assert_string_equal(disassemble(0xF020), "GETC");
+    assert_string_equal(disassemble(0xF021), "OUT");
+    assert_string_equal(disassemble(0xF022), "PUTS");
+    assert_string_equal(disassemble(0xF023), "IN");
+    assert_string_equal(disassemble(0xF024), "PUTSP");
+    assert_string_equal(disassemble(0xF025), "HALT");
+    assert_string_equal(disassemble(0xF026), "TRAP x26");
+    assert_string_equal(disassemble(0xF0FF), "TRAP xFF");
+}
+
+static void test_pc_relative_offsets(void  __attribute__((unused)) **state) {
+    assert_string_equal(disassemble(0x0E05), "BRnzp #5");
+    assert_string_equal(disassemble(0x03FF), "BRp #-1");
+    assert_string_equal(disassemble(0x2202), "LD R1,#2");
+    assert_string_equal(disassemble(0xB1FE), "STI R0,#-2");
+    assert_string_equal(disassemble(0xE080), "LEA R0,#128");
+    assert_string_equal(disassemble(0x4FFF), "JSR #-1");
+    assert_string_equal(disassemble(0x4C00), "JSR #-1024");
+}
+
+static void test_labels(void  __attribute__((unused)) **state) {
+    symbols[0x3000] = "LOOP";
+    symbols[0x3003] = "DATA";
+    uint16_t words[] = { 0x2202, 0x0FFE, 0xF025, 0x0007 };
+    size_t length = disassemble_words(words, 4, 0x3000, symbols, output);
+    output[length] = '\0';
+    assert_string_equal(output, "x3000  2202  LOOP             LD R1,DATA\n"
+                                "x3001  0FFE                   BRnzp LOOP\n"
+                                "x3002  F025                   HALT\n"
+                                "x3003  0007  DATA             .FILL x0007\n");
+}
+
+static void test_targets_wrap_around(void  __attribute__((unused)) **state) {
+    symbols[0x0000] = "START";
+    uint16_t word = 0x0E00;
+    size_t length = disassemble_words(&word, 1, 0xFFFF, symbols, output);
+    output[length] = '\0';
+    assert_string_equal(output, "xFFFF  0E00                   BRnzp START\n");
+}
+
+static void test_invalid_words(void  __attribute__((unused)) **state) {
+    assert_string_equal(disassemble(0x0000), ".FILL x0000");
+    assert_string_equal(disassemble(0x1008), ".FILL x1008");
+    assert_string_equal(disassemble(0x903E), ".FILL x903E");
+    assert_string_equal(disassemble(0xC002), ".FILL xC002");
+    assert_string_equal(disassemble(0xC240), ".FILL xC240");
+    assert_string_equal(disassemble(0x4001), ".FILL x4001");
+    assert_string_equal(disassemble(0x8001), ".FILL x8001");
+    assert_string_equal(disassemble(0xD000), ".FILL xD000");
+    assert_string_equal(disassemble(0xF125), ".FILL xF125");
+}
+
+/**
+ * @brief Every kernel supported by the CPU formats any number of bytes as the scalar code
+ */
+static void test_format_kernels(int output_mode) {
+    static unsigned char bytes[FORMAT_TEST_BYTES];
+    static char expected[FORMAT_TEST_BYTES * 9 + FORMAT_OUTPUT_SLACK], actual[FORMAT_TEST_BYTES * 9 + FORMAT_OUTPUT_SLACK];
+    srand(45);
+    for(int i = 0; i < FORMAT_TEST_BYTES; i++) {
+        bytes[i] = rand();
+    }
+    for(format_kernel_t kernel = SSE2_KERNEL; kernel < NUM_FORMAT_KERNELS; kernel++) {
+        if(!format_kernel_supported(kernel)) {
+            continue;
+        }
+        for(size_t num_bytes = 0; num_bytes <= FORMAT_TEST_BYTES; num_bytes += num_bytes < 80 ? 1 : 73) {
+            select_format(output_mode, SCALAR_KERNEL);
+            size_t expected_length = format_words(bytes, num_bytes, expected);
+            select_format(output_mode, kernel);
+            size_t length = format_words(bytes, num_bytes, actual);
+            assert_int_equal(length, expected_length);
+            assert_memory_equal(actual, expected, length);
+        }
+    }
+}
+
+static void test_format_hex_kernels(void  __attribute__((unused)) **state) {
+    test_format_kernels(HEX_OUTPUT_MODE);
+}
+
+static void test_format_bin_kernels(void  __attribute__((unused)) **state) {
+    test_format_kernels(BIN_OUTPUT_MODE);
+}
+
+static void test_format_text(void  __attribute__((unused)) **state) {
+    unsigned char bytes[] = { 0x30, 0x00, 0xf0, 0x25, 0x0c };
+    char text[64];
+    select_format(HEX_OUTPUT_MODE, fastest_format_kernel());
+    size_t length = format_words(bytes, sizeof(bytes), text);
+    text[length] = '\0';
+    assert_string_equal(text, "30 00 \nf0 25 \n0c \n");
+    select_format(DEC_OUTPUT_MODE, fastest_format_kernel());
+    length = format_words(bytes, 2, text);
+    text[length] = '\0';
+    assert_string_equal(text, "048 000 \n");
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_operate_instructions, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_control_instructions, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_trap_aliases, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_pc_relative_offsets, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_labels, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_targets_wrap_around, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_invalid_words, setup, NULL),
+        cmocka_unit_test(test_format_text),
+        cmocka_unit_test(test_format_hex_kernels),
+        cmocka_unit_test(test_format_bin_kernels)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
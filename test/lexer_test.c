@@ -11,8 +11,8 @@
 static int setup(void **state) {
     clearerrdesc();
     initialize();
-    linemetadata_t **tokenized_lines = malloc(ADDRESS_SPACE_CARDINALITY * sizeof(linemetadata_t *));
-    for(size_t i = 0; i < ADDRESS_SPACE_CARDINALITY; i++) {
+    linemetadata_t **tokenized_lines = malloc(TOKENIZED_LINES_CAPACITY * sizeof(linemetadata_t *));
+    for(size_t i = 0; i < TOKENIZED_LINES_CAPACITY; i++) {
         //setting sentinel values
         tokenized_lines[i] = NULL;
     }
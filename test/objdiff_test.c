@@ -0,0 +1,127 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include <sys/stat.h>
+#include "../include/lc3.h"
+#include "../include/objdiff.h"
+
+#define OBJDIFF_DIR "./test/testfiles/objdiff"
+#define EXPECTED_OBJ OBJDIFF_DIR "/prog.expected.obj"
+#define ACTUAL_OBJ OBJDIFF_DIR "/prog.obj"
+
+static const uint16_t program[] = { 0x3000, 0x1021, 0x0FFE, 0xF025, 0x0007 };
+
+static void write_object(const char *file_name, const uint16_t words[], size_t num_words) {
+    FILE *obj_file = fopen(file_name, "wb");
+    assert_non_null(obj_file);
+    for(size_t i = 0; i < num_words; i++) {
+        fputc(words[i] >> 8, obj_file);
+        fputc(words[i] & 0xff, obj_file);
+    }
+    fclose(obj_file);
+}
+
+static void write_symbols(const char *file_name) {
+    FILE *sym_file = fopen(file_name, "w");
+    assert_non_null(sym_file);
+    fprintf(sym_file, "// Symbol table\n// Scope level 0:\n//\tSymbol Name       Page Address\n//\t----------------  ------------\n");
+    fprintf(sym_file, "//\tLOOP              3000\n//\tDATA              3003\n");
+    fclose(sym_file);
+}
+
+static int setup(void **state) {
+    mkdir(OBJDIFF_DIR, 0755);
+    write_object(EXPECTED_OBJ, program, 5);
+    write_symbols(OBJDIFF_DIR "/prog.sym");
+    remove(OBJDIFF_DIR "/prog.expected.sym");
+    return 0;
+}
+
+static size_t diff_with_report(const char *expected, const char *actual, size_t max_reported, char *report, size_t report_size) {
+    FILE *report_file = tmpfile();
+    size_t num_differences;
+    exit_t result = diff_objects(expected, actual, max_reported, report_file, &num_differences);
+    assert_int_equal(result.code, 0);
+    rewind(report_file);
+    size_t read = fread(report, 1, report_size - 1, report_file);
+    report[read] = '\0';
+    fclose(report_file);
+    return num_differences;
+}
+
+static void test_identical_objects(void  __attribute__((unused)) **state) {
+    char report[1000];
+    write_object(ACTUAL_OBJ, program, 5);
+    assert_int_equal(diff_with_report(EXPECTED_OBJ, ACTUAL_OBJ, 10, report, sizeof(report)), 0);
+    assert_string_equal(report, "");
+}
+
+static void test_differing_words(void  __attribute__((unused)) **state) {
+    char report[1000];
+    const uint16_t actual[] = { 0x3000, 0x1022, 0x0FFE, 0xF025, 0x0008 };
+    write_object(ACTUAL_OBJ, actual, 5);
+    assert_int_equal(diff_with_report(EXPECTED_OBJ, ACTUAL_OBJ, 10, report, sizeof(report)), 2);
+    assert_string_equal(report, EXPECTED_OBJ " " ACTUAL_OBJ ": 2 words differ\n"
+                                "  x3000 LOOP         expected 1021 ADD R0,R0,#1             actual 1022 ADD R0,R0,#2\n"
+                                "  x3003 DATA         expected 0007 .FILL x0007              actual 0008 .FILL x0008\n");
+}
+
+static void test_labels_and_targets(void  __attribute__((unused)) **state) {
+    char report[1000];
+    const uint16_t actual[] = { 0x3000, 0x1021, 0x0FFD, 0xF025, 0x0007 };
+    write_object(ACTUAL_OBJ, actual, 5);
+    assert_int_equal(diff_with_report(EXPECTED_OBJ, ACTUAL_OBJ, 10, report, sizeof(report)), 1);
+    //the expected object has no .sym file, so the labels of the actual one are used
+    assert_non_null(strstr(report, ": 1 word differs\n"));
+    assert_non_null(strstr(report, "  x3001 LOOP+1       expected 0FFE BRnzp LOOP               actual 0FFD BRnzp #-3\n"));
+}
+
+static void test_missing_words(void  __attribute__((unused)) **state) {
+    char report[1000];
+    write_object(ACTUAL_OBJ, program, 3);
+    assert_int_equal(diff_with_report(EXPECTED_OBJ, ACTUAL_OBJ, 1, report, sizeof(report)), 2);
+    assert_non_null(strstr(report, "  x3002 LOOP+2       expected F025 HALT                     actual -    (missing)\n"));
+    assert_non_null(strstr(report, "  ... 1 more\n  size: expected 10 bytes, actual 6 bytes\n"));
+}
+
+static void test_segmented_objects(void  __attribute__((unused)) **state) {
+    char report[1000];
+    const uint16_t expected[] = { SEGMENTED_OBJ_MAGIC1, SEGMENTED_OBJ_MAGIC2, 2, 0x3000, 1, 0x4000, 2, 0xF025, 0x1021, 0x1042 };
+    const uint16_t actual[] = { SEGMENTED_OBJ_MAGIC1, SEGMENTED_OBJ_MAGIC2, 2, 0x3000, 1, 0x4001, 2, 0xF025, 0x1021, 0x1043 };
+    write_object(EXPECTED_OBJ, expected, 10);
+    write_object(ACTUAL_OBJ, actual, 10);
+    remove(OBJDIFF_DIR "/prog.sym");
+    assert_int_equal(diff_with_report(EXPECTED_OBJ, ACTUAL_OBJ, 10, report, sizeof(report)), 2);
+    assert_non_null(strstr(report, "  header word 5      expected 4000 (header)                 actual 4001 (header)\n"));
+    assert_non_null(strstr(report, "  x4001              expected 1042 ADD R0,R1,R2             actual 1043 ADD R0,R1,R3\n"));
+}
+
+static void test_directories(void  __attribute__((unused)) **state) {
+    write_object(ACTUAL_OBJ, program, 5);
+    write_object(OBJDIFF_DIR "/other.expected.obj", program, 5);
+    FILE *report_file = tmpfile();
+    size_t num_differing_files;
+    exit_t result = diff_directories(OBJDIFF_DIR, OBJDIFF_DIR, 10, report_file, &num_differing_files);
+    assert_int_equal(result.code, 0);
+    assert_int_equal(num_differing_files, 1);
+    char report[1000];
+    rewind(report_file);
+    report[fread(report, 1, sizeof(report) - 1, report_file)] = '\0';
+    fclose(report_file);
+    assert_string_equal(report, OBJDIFF_DIR "/other.obj: missing\n2 pairs compared, 1 differs\n");
+    remove(OBJDIFF_DIR "/other.expected.obj");
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_identical_objects, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_differing_words, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_labels_and_targets, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_missing_words, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_segmented_objects, setup, NULL),
+        cmocka_unit_test_setup_teardown(test_directories, setup, NULL)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,178 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+#include "../include/vm.h"
+
+static int setup(void **state) {
+    clearerrdesc();
+    initialize();
+    return 0;
+}
+
+static int teardown(void **state) {
+    initialize();
+    return 0;
+}
+
+static size_t read_object_file(const char *obj_file_name, uint16_t words[], size_t max_words) {
+    FILE *obj_file = fopen(obj_file_name, "rb");
+    assert_non_null(obj_file);
+    unsigned char bytes[2];
+    size_t num_words = 0;
+    while(num_words < max_words && fread(bytes, 1, 2, obj_file) == 2) {
+        words[num_words++] = bytes[0] << 8 | bytes[1];
+    }
+    fclose(obj_file);
+    return num_words;
+}
+
+static void assemble_with_report(const char *asm_file_name, char *report, size_t report_size) {
+    FILE *report_file = tmpfile();
+    options_t options = { .optimize = true, .relax = false, .relax_register = -1, .report = report_file };
+    exit_t result = assemble_with_options(asm_file_name, &options);
+    assert_int_equal(result.code, 0);
+    rewind(report_file);
+    size_t read = fread(report, 1, report_size - 1, report_file);
+    report[read] = '\0';
+    fclose(report_file);
+}
+
+static void test_peephole_t19(void  __attribute__((unused)) **state) {
+    char report[2000];
+    assemble_with_report("./test/testfiles/t19.asm", report, sizeof(report));
+    assert_non_null(strstr(report, "peephole (line 4): LD R2,VALUE -> ADD R2,R1,#0 (value already in register, memory read saved)\n"));
+    assert_non_null(strstr(report, "peephole (line 5): ADD R2,R2,#0 -> removed (condition codes already set by the previous instruction)\n"));
+    assert_non_null(strstr(report, "peephole (line 8): LD R2,SAVED -> removed (value already in register)\n"));
+    assert_non_null(strstr(report, "peephole (line 10): BR NEXT -> removed (branch to the next instruction)\n"));
+    assert_non_null(strstr(report, "peephole (line 11): ADD R3,R3,#0 -> removed (condition codes overwritten by the next instruction)\n"));
+    assert_non_null(strstr(report, "peephole (line 14): BRp SECOND -> BRp LAST (branch threading)\n"));
+    assert_non_null(strstr(report, "peephole: 2 instructions rewritten, 5 instructions removed (-5 words)\n"));
+    assert_null(strstr(report, "line 6"));
+    assert_null(strstr(report, "line 13"));
+
+    uint16_t words[20];
+    size_t num_words = read_object_file("./test/testfiles/t19.obj", words, 20);
+    const uint16_t expected[] = { 0x3000, 0x2209, 0x1460, 0x0404, 0x3407, 0x14a1, 0x5920, 0x1920, 0x0201, 0xf025, 0xf025, 0x0007, 0x0000 };
+    assert_int_equal(num_words, sizeof(expected) / sizeof(expected[0]));
+    for(size_t i = 0; i < num_words; i++) {
+        assert_int_equal(words[i], expected[i]);
+    }
+
+    //labels are moved along with the instructions
+    assert_int_equal(lookup("NEXT")->val, 0x3005);
+    assert_int_equal(lookup("FIRST")->val, 0x3007);
+    assert_int_equal(lookup("LAST")->val, 0x3009);
+    assert_int_equal(lookup("SAVED")->val, 0x300b);
+}
+
+static void test_peephole_numeric_offset_t20(void  __attribute__((unused)) **state) {
+    char report[500];
+    assemble_with_report("./test/testfiles/t20.asm", report, sizeof(report));
+    //BR NEXT is spanned by BRz #1
+    assert_string_equal(report, "");
+
+    uint16_t words[10];
+    size_t num_words = read_object_file("./test/testfiles/t20.obj", words, 10);
+    assert_int_equal(num_words, 4);
+    assert_int_equal(words[1], 0x0401);
+    assert_int_equal(words[2], 0x0e00);
+}
+
+static void test_peephole_numeric_offset_target_t26(void  __attribute__((unused)) **state) {
+    char report[500];
+    assemble_with_report("./test/testfiles/t26.asm", report, sizeof(report));
+    //BR NEXT is the target of BRz #1
+    assert_string_equal(report, "");
+
+    uint16_t words[10];
+    size_t num_words = read_object_file("./test/testfiles/t26.obj", words, 10);
+    assert_int_equal(num_words, 5);
+    assert_int_equal(words[3], 0x0e00);
+}
+
+static void test_peephole_2048(void  __attribute__((unused)) **state) {
+    char report[500];
+    assemble_with_report("./test/testfiles/2048.asm", report, sizeof(report));
+    assert_string_equal(report,
+        "peephole (line 53): BRp IS_DEAD -> BRnz LOOP (inverted branch over an unconditional branch)\n"
+        "peephole (line 54): BRnzp LOOP -> removed (unconditional branch folded into the previous branch)\n"
+        "peephole: 1 instructions rewritten, 1 instructions removed (-1 words)\n");
+
+    static uint16_t actual[ADDRESS_SPACE_CARDINALITY], expected[ADDRESS_SPACE_CARDINALITY];
+    size_t num_words = read_object_file("./test/testfiles/2048.obj", actual, ADDRESS_SPACE_CARDINALITY);
+    assert_int_equal(num_words + 1, read_object_file("./test/testfiles/2048.expected.obj", expected, ADDRESS_SPACE_CARDINALITY));
+}
+
+typedef struct {
+    const char *input;
+    char output[20000];
+    size_t output_length;
+} console_t;
+
+static int read_console(void *context) {
+    console_t *console = context;
+    return *console->input ? *console->input++ : EOF;
+}
+
+static void write_console(int ch, void *context) {
+    console_t *console = context;
+    if(console->output_length < sizeof(console->output) - 1) {
+        console->output[console->output_length++] = ch;
+    }
+}
+
+/**
+ * @brief Assemble the program, optimized or not, run it to the end and return the number of instructions executed
+ */
+static uint64_t run_program(const char *asm_file_name, const char *obj_file_name, bool optimize, console_t *console) {
+    options_t options = { .optimize = optimize, .relax = false, .relax_register = -1 };
+    initialize();
+    exit_t result = assemble_with_options(asm_file_name, &options);
+    assert_int_equal(result.code, 0);
+
+    static vm_t vm;
+    uint16_t origin;
+    vm_init(&vm);
+    vm.io = (vm_io_t){ read_console, write_console, console };
+    result = vm_load_object(&vm, obj_file_name, &origin);
+    assert_int_equal(result.code, 0);
+    vm.pc = origin;
+    vm_status_t status = vm_run(&vm, VM_UNLIMITED);
+    assert_true(status == VM_HALTED || status == VM_INPUT_EXHAUSTED);
+    return vm.instructions;
+}
+
+static void test_peephole_executed_instructions(void  __attribute__((unused)) **state) {
+    //same output, fewer instructions run: a branch per iteration of lcrng and of the main loop of 2048, the
+    //negation of a constant in fib
+    const char *programs[][3] = {
+        { "./test/testfiles/lcrng.asm", "./test/testfiles/lcrng.obj", "" },
+        { "./test/testfiles/fib.asm", "./test/testfiles/fib.obj", "" },
+        //no ANSI terminal, a key for the random seed, moves until the input is exhausted
+        { "./test/testfiles/2048.asm", "./test/testfiles/2048.obj", "nxwasdwwddssaawdsawasdddwwsaasddwsawdsawdswasdwasd" }
+    };
+    const uint64_t expected[][2] = { { 84240, 84230 }, { 43, 41 }, { 574385, 574340 } };
+    for(size_t i = 0; i < sizeof(programs) / sizeof(programs[0]); i++) {
+        static console_t console, optimized_console;
+        console = (console_t){ .input = programs[i][2] };
+        optimized_console = (console_t){ .input = programs[i][2] };
+        assert_int_equal(run_program(programs[i][0], programs[i][1], false, &console), expected[i][0]);
+        assert_int_equal(run_program(programs[i][0], programs[i][1], true, &optimized_console), expected[i][1]);
+        assert_int_equal(optimized_console.output_length, console.output_length);
+        assert_memory_equal(optimized_console.output, console.output, console.output_length);
+    }
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_peephole_t19, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_peephole_numeric_offset_t20, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_peephole_numeric_offset_target_t26, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_peephole_2048, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_peephole_executed_instructions, setup, teardown)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,112 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+
+static int setup(void **state) {
+    clearerrdesc();
+    initialize();
+    return 0;
+}
+
+static int teardown(void **state) {
+    initialize();
+    return 0;
+}
+
+static size_t read_object_file(const char *obj_file_name, uint16_t words[], size_t max_words) {
+    FILE *obj_file = fopen(obj_file_name, "rb");
+    assert_non_null(obj_file);
+    unsigned char bytes[2];
+    size_t num_words = 0;
+    while(num_words < max_words && fread(bytes, 1, 2, obj_file) == 2) {
+        words[num_words++] = bytes[0] << 8 | bytes[1];
+    }
+    fclose(obj_file);
+    return num_words;
+}
+
+static void assert_words(const uint16_t actual[], const uint16_t expected[], size_t num_words) {
+    for(size_t i = 0; i < num_words; i++) {
+        assert_int_equal(actual[i], expected[i]);
+    }
+}
+
+static void test_relax_all_instructions_t16(void  __attribute__((unused)) **state) {
+    options_t options = { .relax = true, .relax_register = 6, .report = NULL };
+    exit_t result = assemble_with_options("./test/testfiles/t16.asm", &options);
+    assert_int_equal(result.code, 0);
+
+    uint16_t words[2000];
+    size_t num_words = read_object_file("./test/testfiles/t16.obj", words, 2000);
+    //origin + 25 words of relaxed instructions + BR + HALT + .BLKW 1100 + FAR + SUB
+    assert_int_equal(num_words, 1 + 25 + 2 + 1100 + 2);
+    const uint16_t expected[] = {
+        0x3000,
+        0xa201, 0x0e01, 0x3467,             //LD R1,FAR
+        0x0a03, 0x2c01, 0xc180, 0x3467,     //BRz FAR
+        0x2e01, 0x0e01, 0x3468, 0x41c0,     //JSR SUB
+        0x2401, 0x0e01, 0x3467,             //LEA R2,FAR
+        0xb201, 0x0e01, 0x3467,             //ST R1,FAR
+        0xa601, 0x0e01, 0x3467, 0x66c0,     //LDI R3,FAR
+        0xac02, 0x7780, 0x0e01, 0x3467,     //STI R3,FAR
+        0x0fe6,                             //BR START is still in range
+        0xf025
+    };
+    assert_words(words, expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_relax_branch_without_scratch_register_t16(void  __attribute__((unused)) **state) {
+    options_t options = { .relax = true, .relax_register = -1, .report = NULL };
+    exit_t result = assemble_with_options("./test/testfiles/t16.asm", &options);
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR (line 5): Value of offset 1107 is outside the range [-256, 255] and relaxing BRz requires a scratch register (--relax=Rn)");
+    free(result.desc);
+}
+
+static void test_relax_fixed_point_t17(void  __attribute__((unused)) **state) {
+    char report[1000] = { 0 };
+    FILE *report_file = tmpfile();
+    options_t options = { .relax = true, .relax_register = 6, .report = report_file };
+    exit_t result = assemble_with_options("./test/testfiles/t17.asm", &options);
+    assert_int_equal(result.code, 0);
+
+    rewind(report_file);
+    fread(report, 1, sizeof(report) - 1, report_file);
+    fclose(report_file);
+    assert_non_null(strstr(report, "relax (line 4): LD R1,FAR (offset 555) -> LDI R1,#1; BRnzp #1; .FILL FAR [+2 words, +1 instructions, +1 memory reads]\n"));
+    assert_non_null(strstr(report, "relax: 2 instructions relaxed in 2 passes, +5 words\n"));
+
+    uint16_t words[10];
+    read_object_file("./test/testfiles/t17.obj", words, 10);
+    const uint16_t expected[] = { 0x3000, 0x0a03, 0x2c01, 0xc180, 0x3105, 0xa201, 0x0e01, 0x3232 };
+    assert_words(words, expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+static void test_relax_numeric_offset_t18(void  __attribute__((unused)) **state) {
+    options_t options = { .relax = true, .relax_register = 6, .report = NULL };
+    exit_t result = assemble_with_options("./test/testfiles/t18.asm", &options);
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR (line 3): Offset #2 cannot be preserved when rewriting the program, use a label instead");
+    free(result.desc);
+}
+
+static void test_no_relaxation_by_default_t16(void  __attribute__((unused)) **state) {
+    exit_t result = assemble("./test/testfiles/t16.asm");
+    assert_int_equal(result.code, 1);
+    assert_string_equal(result.desc, "ERROR (line 4): Value of offset 1108 is outside the range [-256, 255]");
+    free(result.desc);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_relax_all_instructions_t16, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_relax_branch_without_scratch_register_t16, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_relax_fixed_point_t17, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_relax_numeric_offset_t18, setup, teardown),
+        cmocka_unit_test_setup_teardown(test_no_relaxation_by_default_t16, setup, teardown)
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,35 @@
+;
+;   days_week.asm with the names of the days packed by .STRINGP and printed by PUTSP:
+;   each name takes 6 words instead of 10
+;
+
+        .ORIG x3000
+        GETC            ; R0 <- ASCII value of input char
+        LD R1,ASCII
+        NOT R1,R1       
+        ADD R1,R1,#1
+        ADD R1,R0,R1    ; convert ASCII to binary: R1 <- R0 - x0030
+
+        ; the address of the corresponding day is DAYS + i*6
+        LEA R0, DAYS
+        ADD R1,R1,#0    ; to be able to use condition codes
+LOOP    BRz OUTPUT
+        ADD R0,R0,#6    ; go to next day
+        ADD R1,R1,#-1   ; decrement loop variable
+        BR LOOP
+
+OUTPUT  PUTSP
+        HALT
+
+
+ASCII	.FILL	x0030
+DAYS    .STRINGP    "Sunday   "
+        .STRINGP    "Monday   "
+        .STRINGP    "Tuesday  "
+        .STRINGP    "Wednesday"
+        .STRINGP    "Thursday "
+        .STRINGP    "Friday   "
+        .STRINGP    "Saturday "
+    
+
+        .END
\ No newline at end of file
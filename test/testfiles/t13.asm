@@ -0,0 +1,24 @@
+;
+;   program made of several segments
+;
+    .ORIG x3000
+    LD R1,VALUE
+    LEA R0,MSG
+    PUTS
+BACK HALT
+PTR .FILL TABLE
+    .END
+
+this text is ignored by the assembler
+
+    .ORIG x3080
+VALUE .FILL #42
+    BR BACK
+MSG .STRINGZ "ok"
+    .END
+
+    .ORIG xC000
+TABLE .FILL PTR
+    .BLKW 2
+END_TABLE
+    .END
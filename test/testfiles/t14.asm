@@ -0,0 +1,12 @@
+;
+;   overlapping segments
+;
+    .ORIG x3000
+    ADD R0,R0,#1
+    ADD R0,R0,#1
+    HALT
+    .END
+
+    .ORIG x3002
+    HALT
+    .END
@@ -0,0 +1,7 @@
+;
+;   segment exceeding the address space
+;
+    .ORIG xFFFF
+    ADD R0,R0,#1
+    HALT
+    .END
@@ -0,0 +1,16 @@
+; relaxation of every PC-relative instruction whose label is out of range
+; assemble with --relax=R6
+    .ORIG x3000
+START   LD R1,FAR
+        BRz FAR
+        JSR SUB
+        LEA R2,FAR
+        ST R1,FAR
+        LDI R3,FAR
+        STI R3,FAR
+        BR START
+        HALT
+        .BLKW 1100
+FAR     .FILL x1234
+SUB     RET
+        .END
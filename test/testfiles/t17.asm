@@ -0,0 +1,9 @@
+; relaxing LD pushes TARGET out of the range of BRz, which is relaxed in a second pass
+    .ORIG x3000
+        BRz TARGET
+        LD R1,FAR
+        .BLKW 254
+TARGET  ADD R1,R1,#1
+        .BLKW 300
+FAR     .FILL x1234
+        .END
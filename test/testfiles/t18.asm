@@ -0,0 +1,9 @@
+; the numeric offset of BRz spans the relaxed LD
+    .ORIG x3000
+        BRz #2
+        LD R1,FAR
+        ADD R1,R1,#1
+        HALT
+        .BLKW 300
+FAR     .FILL x1234
+        .END
@@ -0,0 +1,20 @@
+; patterns rewritten by the peephole optimizer (-O)
+    .ORIG x3000
+        LD R1,VALUE
+        LD R2,VALUE         ; replaced with a copy of R1
+        ADD R2,R2,#0        ; removed, condition codes already set from R2 by the copy
+        BRz FIRST           ; not threaded, BRp is not taken when z is set
+        ST R2,SAVED
+        LD R2,SAVED         ; removed, ADD overwrites the condition codes
+        ADD R2,R2,#1
+        BR NEXT             ; removed, branch to the next instruction
+NEXT    ADD R3,R3,#0        ; removed, AND overwrites the condition codes
+        AND R4,R4,#0
+LOOP    ADD R4,R4,#0        ; kept, label LOOP may be reached with other condition codes
+FIRST   BRp SECOND          ; threaded to LAST
+        HALT
+SECOND  BRnzp LAST
+LAST    HALT
+VALUE   .FILL #7
+SAVED   .BLKW 1
+        .END
@@ -0,0 +1,6 @@
+; words spanned by an offset given as a number are not removed
+    .ORIG x3000
+        BRz #1
+        BR NEXT
+NEXT    HALT
+        .END
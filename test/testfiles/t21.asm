@@ -0,0 +1,9 @@
+; .STRINGP packs two characters per word, as expected by PUTSP
+    .ORIG x3000
+        LEA R0,MSG
+        PUTSP
+        HALT
+MSG     .STRINGP "Hello\n"
+AFTER   .STRINGP "abc"
+        .FILL AFTER
+        .END
@@ -0,0 +1,20 @@
+; code and data removed by --dce
+    .ORIG x3000
+        LEA R0,MSG
+        PUTS
+        JSR PRINT
+        LD R1,HANDLER
+        JMP R1              ; DONE is reached through its address in HANDLER
+UNUSED  ADD R2,R2,#1        ; removed, JMP does not fall through
+        RET
+PRINT   LD R2,COUNT
+        RET
+DEAD    AND R3,R3,#0        ; removed, DEAD is never referenced
+        BR DEAD2
+DEAD2   HALT                ; removed, only referenced from removed code
+HANDLER .FILL DONE
+DONE    HALT
+COUNT   .FILL #3
+SPARE   .FILL #9            ; removed, never referenced
+MSG     .STRINGZ "hi"
+        .END
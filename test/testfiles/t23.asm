@@ -0,0 +1,20 @@
+; subroutines analyzed by --analyze
+    .ORIG x3000
+        LD R1,COUNT
+        JSR SUM
+        JSR ABS
+        ST R0,RESULT
+        HALT
+SUM     AND R0,R0,#0        ; R1 + (R1 - 1) + ... + 1
+LOOP    ADD R0,R0,R1
+        ADD R1,R1,#-1
+        BRp LOOP
+        RET
+ABS     ADD R0,R0,#0
+        BRzp POSITIVE
+        NOT R0,R0
+        ADD R0,R0,#1
+POSITIVE RET
+COUNT   .FILL #5
+RESULT  .BLKW 1
+        .END
@@ -0,0 +1,12 @@
+;
+;   labels on .ORIG lines name the first word of their segment
+;
+DATA1 .ORIG x3000
+    LD R1,DATA2
+    LEA R0,DATA1
+    HALT
+    .END
+
+DATA2 .ORIG x3080
+    .FILL #7
+    .END
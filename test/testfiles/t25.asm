@@ -0,0 +1,7 @@
+;
+;   single segment whose classic image would start with the segmented object magic
+;
+    .ORIG x4C33
+    .FILL x5347
+    HALT
+    .END
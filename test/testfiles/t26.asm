@@ -0,0 +1,7 @@
+; the word a forward offset given as a number points to is not removed
+    .ORIG x3000
+        BRz #1
+        HALT
+        BR NEXT
+NEXT    HALT
+        .END
@@ -0,0 +1,12 @@
+; the elements of an array whose address is taken are kept, even with labels of their own
+    .ORIG x3000
+        LEA R0,ARR
+        LDR R1,R0,#1
+        LDR R2,R0,#2
+        HALT
+ARR     .FILL #1
+SECOND  .FILL #2
+THIRD   .FILL #3
+DEAD    ADD R0,R0,#1
+AFTER   .FILL #4
+        .END
@@ -0,0 +1,8 @@
+; a conditional branch leaving the code still falls through to the next instruction
+    .ORIG x3000
+        ADD R0,R0,#0
+        BRz DATA
+        ADD R0,R0,#1
+        HALT
+DATA    .FILL #0
+        .END
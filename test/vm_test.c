@@ -0,0 +1,291 @@
+#include <stddef.h>
+#include <stdarg.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdbool.h>
+#include "../include/lc3.h"
+#include "../include/vm.h"
+
+typedef struct {
+    const char *input;
+    char output[1000];
+    size_t output_length;
+} console_t;
+
+static vm_t vm;
+static console_t console;
+
+static int read_console(void *context) {
+    console_t *c = context;
+    return *c->input ? *c->input++ : EOF;
+}
+
+static void write_console(int ch, void *context) {
+    console_t *c = context;
+    if(c->output_length < sizeof(c->output) - 1) {
+        c->output[c->output_length++] = ch;
+        c->output[c->output_length] = '\0';
+    }
+}
+
+static void init_vm(const char *input) {
+    vm_init(&vm);
+    console = (console_t){ .input = input };
+    vm.io = (vm_io_t){ read_console, write_console, &console };
+}
+
+static void load_words(const uint16_t words[], size_t num_words) {
+    unsigned char bytes[200];
+    uint16_t origin;
+    for(size_t i = 0; i < num_words; i++) {
+        bytes[2 * i] = words[i] >> 8;
+        bytes[2 * i + 1] = words[i] & 0xff;
+    }
+    exit_t result = vm_load_image(&vm, bytes, 2 * num_words, &origin);
+    assert_int_equal(result.code, 0);
+    vm.pc = origin;
+}
+
+static void load_assembled(const char *assembly_file, const char *object_file) {
+    uint16_t origin;
+    exit_t result = assemble(assembly_file);
+    assert_int_equal(result.code, 0);
+    result = vm_load_object(&vm, object_file, &origin);
+    assert_int_equal(result.code, 0);
+    vm.pc = origin;
+}
+
+static void test_arithmetic_and_condition_codes(void  __attribute__((unused)) **state) {
+    //ADD R1,R1,#5; NOT R2,R1; AND R3,R2,#-16; ADD R4,R1,R2; LEA R5,#-5; BRn #1; ADD R6,R6,#1; HALT
+    const uint16_t program[] = { 0x3000, 0x1265, 0x947F, 0x56B0, 0x1842, 0xEBFB, 0x0801, 0x1DA1, 0xF025 };
+    init_vm("");
+    load_words(program, 9);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_int_equal(vm.registers[1], 5);
+    assert_int_equal(vm.registers[2], 0xFFFA);
+    assert_int_equal(vm.registers[3], 0xFFF0);
+    assert_int_equal(vm.registers[4], 0xFFFF);
+    assert_int_equal(vm.registers[5], 0x3000);
+    //LEA sets the condition codes: x3000 is positive, so BRn is not taken
+    assert_int_equal(vm.registers[6], 1);
+    assert_int_equal(vm.instructions, 8);
+    assert_string_equal(console.output, "");
+}
+
+/**
+ * @brief Output of lcrng.asm: x(n) = 7 * x(n-1) mod 32767 from x(0) = 10, one number per line
+ */
+static void lcrng_output(char *output) {
+    long x = 10;
+    output[0] = '\0';
+    for(int i = 0; i < 10; i++) {
+        x = 7 * x % 32767;
+        sprintf(output + strlen(output), "%ld\n", x);
+    }
+}
+
+static void test_lcrng(void  __attribute__((unused)) **state) {
+    char expected[200];
+    init_vm("");
+    load_assembled("./test/testfiles/lcrng.asm", "./test/testfiles/lcrng.obj");
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    lcrng_output(expected);
+    assert_string_equal(console.output, expected);
+}
+
+static void test_charcounter(void  __attribute__((unused)) **state) {
+    //the file the program counts in is a string at x4000 ending with EOT
+    const uint16_t file[] = { 0x4000, 'h', 'e', 'l', 'l', 'o', 0x04 };
+    init_vm("l");
+    load_words(file, 7);
+    load_assembled("./test/testfiles/charcounter.asm", "./test/testfiles/charcounter.obj");
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_string_equal(console.output, "2");
+    assert_int_equal(vm.registers[0], '2');
+}
+
+static void test_service_routines_of_the_machine(void  __attribute__((unused)) **state) {
+    //IN; OUT; LEA R0,#4; PUTS; LEA R0,#5; PUTSP; HALT; "hi\0"; "ok!\0"
+    const uint16_t program[] = { 0x3000, 0xF023, 0xF021, 0xE004, 0xF022, 0xE005, 0xF024, 0xF025,
+                                 'h', 'i', 0, 'o' | 'k' << 8, '!', 0 };
+    init_vm("x");
+    load_words(program, 14);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_string_equal(console.output, "\nInput a character> x\nxhiok!");
+    assert_int_equal(vm.registers[7], 0x3007);
+    //the machine halts on the instruction after HALT
+    assert_int_equal(vm.pc, 0x3007);
+}
+
+static void test_input_exhausted(void  __attribute__((unused)) **state) {
+    //GETC; HALT
+    const uint16_t program[] = { 0x3000, 0xF020, 0xF025 };
+    init_vm("");
+    load_words(program, 3);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_INPUT_EXHAUSTED);
+    assert_int_equal(vm.pc, 0x3000);
+    //the GETC is run again when there is input
+    console.input = "a";
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_int_equal(vm.registers[0], 'a');
+}
+
+static void test_operating_system(void  __attribute__((unused)) **state) {
+    char expected[200];
+    uint16_t origin;
+    init_vm("");
+    exit_t result = vm_load_object(&vm, "./test/testfiles/lc3os.obj", &origin);
+    assert_int_equal(result.code, 0);
+    load_assembled("./test/testfiles/lcrng.asm", "./test/testfiles/lcrng.obj");
+    vm.pc = VM_OS_START;
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    //the service routines of the operating system write the same output, and HALT clears the run bit of the MCR
+    lcrng_output(expected);
+    assert_string_equal(console.output, expected);
+    assert_int_equal(vm.mpr, 0x0FF8);
+}
+
+static void test_privilege(void  __attribute__((unused)) **state) {
+    //LEA R0,#2; JMPT R0; HALT; RTI
+    const uint16_t program[] = { 0x3000, 0xE002, 0xC001, 0xF025, 0x8000 };
+    init_vm("");
+    load_words(program, 5);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_PRIVILEGE_VIOLATION);
+    assert_int_equal(vm.pc, 0x3003);
+    assert_int_equal(vm.psr & VM_PSR_SUPERVISOR, 0);
+}
+
+static void test_rti_in_supervisor_mode(void  __attribute__((unused)) **state) {
+    //LD R6,#2; RTI; HALT; x4000: PC x3002 and PSR of user mode with P set
+    const uint16_t program[] = { 0x3000, 0x2C02, 0x8000, 0xF025, 0x4000 };
+    const uint16_t stack[] = { 0x4000, 0x3002, 0x0001 };
+    init_vm("");
+    load_words(stack, 3);
+    load_words(program, 5);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_int_equal(vm.registers[6], 0x4002);
+    assert_int_equal(vm.psr, VM_PSR_P);
+}
+
+static void test_access_violation(void  __attribute__((unused)) **state) {
+    //LEA R0,#2; JMPT R0; HALT; LD R1,#-4 (x3000 is accessible); LDI R2,#1 (xFE00 is not); HALT; xFE00
+    const uint16_t program[] = { 0x3000, 0xE002, 0xC001, 0xF025, 0x23FC, 0xA401, 0xF025, 0xFE00 };
+    init_vm("");
+    load_words(program, 8);
+    vm.mpr = 0x0008;
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_ACCESS_VIOLATION);
+    assert_int_equal(vm.pc, 0x3004);
+    assert_int_equal(vm.registers[1], 0xE002);
+}
+
+static void test_illegal_opcode_and_invalid_trap(void  __attribute__((unused)) **state) {
+    const uint16_t illegal[] = { 0x3000, 0x1021, 0xD000 };
+    init_vm("");
+    load_words(illegal, 3);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_ILLEGAL_OPCODE);
+    assert_int_equal(vm.pc, 0x3001);
+
+    const uint16_t invalid_trap[] = { 0x3000, 0xF0FF };
+    init_vm("");
+    load_words(invalid_trap, 2);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_INVALID_TRAP);
+    assert_int_equal(vm.pc, 0x3000);
+}
+
+static void test_devices(void  __attribute__((unused)) **state) {
+    //LDI R1,KBSR; LDI R0,KBDR; STI R0,DDR; AND R0,R0,#0; STI R0,MCR (halts); HALT; KBSR; KBDR; DDR; MCR
+    const uint16_t program[] = { 0x3000, 0xA205, 0xA005, 0xB005, 0x5020, 0xB004, 0xF025,
+                                 0xFE00, 0xFE02, 0xFE06, 0xFFFE };
+    init_vm("q");
+    load_words(program, 11);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_int_equal(vm.registers[1], 0x8000);
+    assert_string_equal(console.output, "q");
+    assert_int_equal(vm.pc, 0x3005);
+}
+
+static void test_instruction_limit(void  __attribute__((unused)) **state) {
+    //ADD R1,R1,#1; BRnzp #-2
+    const uint16_t program[] = { 0x3000, 0x1261, 0x0FFE };
+    init_vm("");
+    load_words(program, 3);
+    assert_int_equal(vm_run(&vm, 101), VM_LIMIT_REACHED);
+    assert_int_equal(vm.registers[1], 51);
+    assert_int_equal(vm.pc, 0x3001);
+    assert_int_equal(vm_run(&vm, 1), VM_LIMIT_REACHED);
+    assert_int_equal(vm.registers[1], 51);
+    assert_int_equal(vm.pc, 0x3000);
+    assert_int_equal(vm.instructions, 102);
+}
+
+static void test_segmented_object(void  __attribute__((unused)) **state) {
+    //x3000: LD R0,#127 (x3080); HALT   x3080: 42
+    const uint16_t segmented[] = { SEGMENTED_OBJ_MAGIC1, SEGMENTED_OBJ_MAGIC2, 2, 0x3000, 2, 0x3080, 1,
+                                   0x207F, 0xF025, 42 };
+    init_vm("");
+    load_words(segmented, 10);
+    assert_int_equal(vm.pc, 0x3000);
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_int_equal(vm.registers[0], 42);
+}
+
+static void test_self_modifying_code(void  __attribute__((unused)) **state) {
+    //x3000: ADD R1,R1,#1; LD R0,#4; ST R0,#-3 (x3000 becomes ADD R1,R1,#2); ADD R3,R3,#-1; BRp #-5; HALT; x1262
+    const uint16_t program[] = { 0x3000, 0x1261, 0x2004, 0x31FD, 0x16FF, 0x03FB, 0xF025, 0x1262 };
+    init_vm("");
+    load_words(program, 8);
+    vm.registers[3] = 2;
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    //the first iteration adds 1 and the second one runs the stored instruction
+    assert_int_equal(vm.registers[1], 3);
+
+    //memory written from outside the machine discards the decoded instructions too
+    vm_write_memory(&vm, 0x3000, 0x1263);
+    vm_write_memory(&vm, 0x3002, 0x0000);
+    vm.registers[1] = 0;
+    vm.registers[3] = 1;
+    vm.pc = 0x3000;
+    assert_int_equal(vm_run(&vm, VM_UNLIMITED), VM_HALTED);
+    assert_int_equal(vm.registers[1], 3);
+    assert_int_equal(vm.memory[0x3000], 0x1263);
+}
+
+static void test_invalid_objects(void  __attribute__((unused)) **state) {
+    uint16_t origin;
+    const unsigned char odd[] = { 0x30, 0x00, 0x12 };
+    init_vm("");
+    exit_t result = vm_load_image(&vm, odd, sizeof(odd), &origin);
+    assert_true(result.code);
+    free_err(result);
+
+    const unsigned char overflowing[] = { 0xFF, 0xFF, 0x12, 0x34, 0x56, 0x78 };
+    result = vm_load_image(&vm, overflowing, sizeof(overflowing), &origin);
+    assert_true(result.code);
+    free_err(result);
+
+    result = vm_load_object(&vm, "./test/testfiles/missing.obj", &origin);
+    assert_true(result.code);
+    free_err(result);
+}
+
+int main(int argc, char const *argv[]) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_arithmetic_and_condition_codes),
+        cmocka_unit_test(test_lcrng),
+        cmocka_unit_test(test_charcounter),
+        cmocka_unit_test(test_service_routines_of_the_machine),
+        cmocka_unit_test(test_input_exhausted),
+        cmocka_unit_test(test_operating_system),
+        cmocka_unit_test(test_privilege),
+        cmocka_unit_test(test_rti_in_supervisor_mode),
+        cmocka_unit_test(test_access_violation),
+        cmocka_unit_test(test_illegal_opcode_and_invalid_trap),
+        cmocka_unit_test(test_devices),
+        cmocka_unit_test(test_instruction_limit),
+        cmocka_unit_test(test_segmented_object),
+        cmocka_unit_test(test_self_modifying_code),
+        cmocka_unit_test(test_invalid_objects),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,81 @@
+/*
+    Translates an object file generated by the LC3 assembler to a C program (see aot.h)
+
+    Usage:
+
+    lc3aot [--os os.obj] [-o program.c] program.obj
+
+    --os    translate an operating system with the program (e.g. test/testfiles/lc3os.asm assembled): the
+            program starts at its entry point (x0200) in supervisor mode, as with lc3vm --os
+    -o      write the C program to a file instead of standard output
+
+    The labels of the .sym file next to each object are used as entry points of indirect jumps. The program
+    includes aot_runtime.h and is linked with the interpreter; it takes the options -n and --stats of lc3vm.
+
+    Example:
+
+    franciscoalvarez@franciscos lc3asm % ./lc3aot -o lcrng.c test/testfiles/lcrng.obj
+    lcrng.c: 9 blocks, 31 instructions
+    franciscoalvarez@franciscos lc3asm % cc -O2 -Iinclude lcrng.c src/vm.c src/util.c src/memtrack.c -o lcrng
+    franciscoalvarez@franciscos lc3asm % ./lcrng --stats
+    70
+    490
+    3430
+    ...
+    7721
+    84240 instructions in 0.000 s (1021.5 MIPS)
+    84180 native, 60 interpreted
+
+*/
+
+#include "../include/aot.h"
+
+static void print_usage(const char *program_name) {
+    fprintf(stderr, "USAGE %s [--os os.obj] [-o program.c] program.obj\n", program_name);
+}
+
+#ifdef FAB_MAIN
+int main(int argc, char const *argv[]) {
+    const char *os_file = NULL, *output_file = NULL;
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        if(strcmp(argv[arg], "--os") == 0 && arg + 1 < argc) {
+            os_file = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "-o") == 0 && arg + 1 < argc) {
+            output_file = argv[++arg];
+        }
+        else {
+            print_usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if(argc - arg != 1) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *output = output_file ? fopen(output_file, "w") : stdout;
+    if(!output) {
+        fprintf(stderr, "ERROR: Couldn't write file (%s)\n", output_file);
+        exit(EXIT_FAILURE);
+    }
+    aot_stats_t stats;
+    exit_t result = aot_translate(argv[arg], os_file, output, &stats);
+    if(output_file) {
+        fclose(output);
+    }
+    if(result.code) {
+        fprintf(stderr, "%s\n", result.desc);
+        free_err(result);
+        if(output_file) {
+            remove(output_file);
+        }
+        exit(EXIT_FAILURE);
+    }
+    if(output_file) {
+        fprintf(stderr, "%s: %zu blocks, %zu instructions\n", output_file, stats.blocks, stats.instructions);
+    }
+    return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,80 @@
+/*
+    Packs modules generated by the LC3 assembler (.obj + .sym) into a static library archive
+    with a prebuilt symbol index, and queries existing archives
+
+    Usage:
+
+    lc3ar c archive.lib module1.obj module2.obj ...    create archive out of the given modules
+    lc3ar t archive.lib                                 list members and their global symbols
+    lc3ar s archive.lib SYMBOL1 SYMBOL2 ...             print the members needed to resolve the given symbols
+
+    Example:
+
+    franciscoalvarez@franciscos lc3asm % ./lc3ar s stdlib.lib MULTIPLY PRINT_NUMBER
+    mult.obj
+    io.obj
+
+*/
+
+#include "../include/archive.h"
+
+static void print_usage(const char *program_name) {
+    printf("USAGE %s c archive module.obj...\n", program_name);
+    printf("      %s t archive\n", program_name);
+    printf("      %s s archive symbol...\n", program_name);
+}
+
+static exit_t list_archive(const archive_t *archive) {
+    for(uint32_t member = 0; member < archive->header->num_members; member++) {
+        printf("%s\n", archive_member_name(archive, member));
+        for(uint32_t i = 0; i < archive->header->num_symbols; i++) {
+            if(archive->symbols[i].member == member) {
+                printf("\t%-20s %.4x\n", archive->strings + archive->symbols[i].name_offset, archive->symbols[i].address);
+            }
+        }
+    }
+    return success();
+}
+
+static exit_t select_members(const archive_t *archive, const char *symbols[], size_t num_symbols) {
+    //num_members was checked against the size of the archive by archive_open
+    bool *selected_members = calloc(archive->header->num_members + 1, sizeof(bool));
+    if(!selected_members) {
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error%s", "");
+    }
+    exit_t result = archive_select_members(archive, symbols, num_symbols, selected_members);
+    for(uint32_t member = 0; !result.code && member < archive->header->num_members; member++) {
+        if(selected_members[member]) {
+            printf("%s\n", archive_member_name(archive, member));
+        }
+    }
+    free(selected_members);
+    return result;
+}
+
+#ifdef FAB_MAIN
+int main(int argc, char const *argv[]) {
+    if(argc < 3 || strlen(argv[1]) != 1 || !strchr("cts", argv[1][0])) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    exit_t result;
+    if(argv[1][0] == 'c') {
+        result = archive_create(argv[2], argv + 3, argc - 3);
+    }
+    else {
+        archive_t archive;
+        if(!(result = archive_open(argv[2], &archive)).code) {
+            result = argv[1][0] == 't' ? list_archive(&archive) : select_members(&archive, argv + 3, argc - 3);
+            archive_close(&archive);
+        }
+    }
+
+    if(result.code) {
+        printf("%s\n", result.desc);
+        free_err(result);
+    }
+    return result.code;
+}
+#endif
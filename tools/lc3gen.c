@@ -0,0 +1,417 @@
+/*
+    Generates synthetic LC3 assembly programs to test how the assembler scales
+
+    The programs are valid (they assemble without errors) but are not meant to be run: instructions, data and
+    comments are mixed according to the given ratios, and every PC-relative instruction refers to a label within
+    the given distance. The same seed and parameters always produce the same program.
+
+    Usage:
+
+    lc3gen [-n lines] [-s seed] [-l label_density] [-f forward_ratio] [-d data_ratio] [-c comment_ratio]
+           [-b branch_distance] [--collide] [-o file.asm]
+
+    Example:
+
+    franciscoalvarez@franciscos lc3asm % ./lc3gen -n 50000 -s 7 --collide -o collide.asm
+
+    With --collide, all labels have the same hash value (they are built out of blocks "AO" and "B0", which
+    contribute the same value to the hash function of dict.c), so they are stored in a single bucket of the symbol
+    table regardless of its size.
+*/
+
+#include "../include/lc3gen.h"
+
+#define DEFAULT_ORIGIN 0x3000
+#define MAX_STRING_LENGTH 24
+#define MAX_BLOCK_WORDS 16
+
+typedef enum {
+    ITEM_COMMENT,
+    ITEM_OPERATE, // ADD, AND, NOT
+    ITEM_PC_RELATIVE, // LD, ST, LDI, STI, LEA, BR, JSR
+    ITEM_BASE_OFFSET, // LDR, STR
+    ITEM_STRINGZ,
+    ITEM_BLKW,
+    ITEM_FILL
+} itemtype_t;
+
+/**
+ * Line of the generated program, planned before writing it so that references can point to labels defined later
+ */
+typedef struct {
+    itemtype_t type;
+    uint16_t num_words;
+    uint32_t address; // relative to the origin
+    long label; // index of the label defined by the line, -1 if none
+} item_t;
+
+static uint64_t next_random(uint64_t *state) {
+    //xorshift64*
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static size_t random_below(uint64_t *state, size_t limit) {
+    return next_random(state) % limit;
+}
+
+static double random_ratio(uint64_t *state) {
+    return (next_random(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * @brief Name of the `label`-th label of the program
+ *
+ * When labels must collide, every name has the same length and is made of blocks "AO"/"B0" (one block per bit of
+ * the label index): 'A' * 31 + 'O' == 'B' * 31 + '0', so all names have the same hash value
+ */
+static void label_name(size_t label, size_t num_labels, bool collide, char *name, size_t name_size) {
+    if(!collide) {
+        snprintf(name, name_size, "L%zu", label);
+        return;
+    }
+    int num_bits = 1;
+    while(num_bits < 32 && (num_labels - 1) >> num_bits) {
+        num_bits++;
+    }
+    size_t length = 0;
+    name[length++] = 'C';
+    for(int bit = num_bits - 1; bit >= 0 && length + 3 <= name_size; bit--) {
+        name[length++] = (label >> bit) & 1 ? 'B' : 'A';
+        name[length++] = (label >> bit) & 1 ? '0' : 'O';
+    }
+    name[length] = '\0';
+}
+
+/**
+ * @brief Pick a label whose address is within `distance` words of the PC (the address following `address`)
+ *
+ * Returns -1 if there is no label in range in either direction
+ */
+static long pick_target(const uint32_t label_addresses[], size_t num_labels, uint32_t address, int distance,
+                        double forward_ratio, uint64_t *state) {
+    uint32_t pc = address + 1;
+    //first label at or after the PC
+    size_t low = 0, high = num_labels;
+    while(low < high) {
+        size_t middle = low + (high - low) / 2;
+        if(label_addresses[middle] < pc) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    size_t forward_end = low;
+    while(forward_end < num_labels && label_addresses[forward_end] <= pc + distance) {
+        forward_end++;
+    }
+    size_t backward_start = low;
+    while(backward_start > 0 && label_addresses[backward_start - 1] + distance + 1 > pc) {
+        backward_start--;
+    }
+    size_t num_forward = forward_end - low;
+    size_t num_backward = low - backward_start;
+    bool forward = random_ratio(state) < forward_ratio;
+    if((forward && num_forward) || !num_backward) {
+        return num_forward ? (long)(low + random_below(state, num_forward)) : -1;
+    }
+    return (long)(backward_start + random_below(state, num_backward));
+}
+
+static void write_operate(FILE *asm_file, uint64_t *state) {
+    int dr = random_below(state, 8), sr1 = random_below(state, 8), sr2 = random_below(state, 8);
+    switch(random_below(state, 3)) {
+    case 0:
+        fprintf(asm_file, "ADD R%d,R%d,#%d\n", dr, sr1, (int)random_below(state, 32) - 16);
+        break;
+    case 1:
+        fprintf(asm_file, "AND R%d,R%d,R%d\n", dr, sr1, sr2);
+        break;
+    default:
+        fprintf(asm_file, "NOT R%d,R%d\n", dr, sr1);
+        break;
+    }
+}
+
+static void write_string(FILE *asm_file, size_t length, uint64_t *state) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ 0123456789";
+    fprintf(asm_file, ".STRINGZ \"");
+    for(size_t i = 0; i < length; i++) {
+        fputc(alphabet[random_below(state, sizeof(alphabet) - 1)], asm_file);
+    }
+    fprintf(asm_file, "\"\n");
+}
+
+/**
+ * @brief Decide the type, size and label of every line of the program
+ *
+ * Lines that would not fit in the address space are turned into comments
+ */
+static size_t plan_program(item_t items[], const generator_options_t *options, uint64_t *state) {
+    size_t num_labels = 0;
+    uint32_t address = 0;
+    for(size_t i = 0; i < options->num_lines; i++) {
+        item_t *item = &items[i];
+        item->label = -1;
+        item->num_words = 1;
+        if(random_ratio(state) < options->comment_ratio) {
+            item->type = ITEM_COMMENT;
+        }
+        else if(random_ratio(state) < options->data_ratio) {
+            size_t kind = random_below(state, 10);
+            if(kind < 4) {
+                item->type = ITEM_STRINGZ;
+                item->num_words = 2 + random_below(state, MAX_STRING_LENGTH); //final '\0' included
+            }
+            else if(kind < 7) {
+                item->type = ITEM_BLKW;
+                item->num_words = 1 + random_below(state, MAX_BLOCK_WORDS);
+            }
+            else {
+                item->type = ITEM_FILL;
+            }
+        }
+        else {
+            size_t kind = random_below(state, 20);
+            item->type = kind < 8 ? ITEM_PC_RELATIVE : (kind < 11 ? ITEM_BASE_OFFSET : ITEM_OPERATE);
+        }
+
+        if(item->type != ITEM_COMMENT && address + item->num_words > ADDRESS_SPACE_CARDINALITY) {
+            item->type = ITEM_COMMENT;
+        }
+        if(item->type == ITEM_COMMENT) {
+            item->num_words = 0;
+        }
+        else if(random_ratio(state) < options->label_density) {
+            item->label = num_labels++;
+        }
+        item->address = address;
+        address += item->num_words;
+    }
+    return num_labels;
+}
+
+static exit_t validate_options(const generator_options_t *options) {
+    double ratios[] = { options->label_density, options->forward_ratio, options->data_ratio, options->comment_ratio };
+    for(size_t i = 0; i < sizeof(ratios) / sizeof(ratios[0]); i++) {
+        if(!(ratios[i] >= 0 && ratios[i] <= 1)) {
+            return failure(EXIT_FAILURE, "ERROR: Ratios must be between 0 and 1 (%g)", ratios[i]);
+        }
+    }
+    if(options->branch_distance < 1 || options->branch_distance > GENERATOR_MAX_BRANCH_DISTANCE) {
+        return failure(EXIT_FAILURE, "ERROR: Branch distance must be between 1 and %d", GENERATOR_MAX_BRANCH_DISTANCE);
+    }
+    return success();
+}
+
+/**
+ * @brief Write a synthetic program generated according to `options`
+ *
+ * The number of words of the resulting program is stored in `num_words`. The program starts at x3000 unless it
+ * does not fit, in which case it starts at x0000
+ */
+exit_t generate_program(FILE *asm_file, const generator_options_t *options, size_t *num_words) {
+    exit_t result = validate_options(options);
+    if(result.code) {
+        return result;
+    }
+    item_t *items = malloc((options->num_lines + 1) * sizeof(item_t));
+    if(!items) {
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when generating %zu lines", options->num_lines);
+    }
+    uint64_t state = options->seed ^ 0x9E3779B97F4A7C15ULL;
+    state = state ? state : 1;
+    size_t num_labels = plan_program(items, options, &state);
+
+    uint32_t *label_addresses = malloc((num_labels + 1) * sizeof(uint32_t));
+    if(!label_addresses) {
+        free(items);
+        return failure(EXIT_FAILURE, "ERROR: Out of memory error when generating %zu labels", num_labels);
+    }
+    *num_words = 0;
+    for(size_t i = 0; i < options->num_lines; i++) {
+        if(items[i].label >= 0) {
+            label_addresses[items[i].label] = items[i].address;
+        }
+        *num_words += items[i].num_words;
+    }
+    uint32_t origin = *num_words + DEFAULT_ORIGIN <= ADDRESS_SPACE_CARDINALITY ? DEFAULT_ORIGIN : 0;
+
+    fprintf(asm_file, "; generated by lc3gen -n %zu -s %" PRIu64 " -l %g -f %g -d %g -c %g -b %d%s\n",
+            options->num_lines, options->seed, options->label_density, options->forward_ratio, options->data_ratio,
+            options->comment_ratio, options->branch_distance, options->collide ? " --collide" : "");
+    fprintf(asm_file, "    .ORIG x%.4X\n", origin);
+    char name[40];
+    for(size_t i = 0; i < options->num_lines; i++) {
+        item_t *item = &items[i];
+        if(item->type == ITEM_COMMENT) {
+            fprintf(asm_file, "; line %zu: nothing to see here\n", i + 1);
+            continue;
+        }
+        if(item->label >= 0) {
+            label_name(item->label, num_labels, options->collide, name, sizeof(name));
+            fprintf(asm_file, "%s", name);
+        }
+        fprintf(asm_file, "    ");
+
+        long target = -1;
+        if(item->type == ITEM_PC_RELATIVE) {
+            target = pick_target(label_addresses, num_labels, item->address, options->branch_distance,
+                                 options->forward_ratio, &state);
+        }
+        else if(item->type == ITEM_FILL && num_labels) {
+            target = random_below(&state, num_labels);
+        }
+        if(target >= 0) {
+            label_name(target, num_labels, options->collide, name, sizeof(name));
+        }
+
+        switch(item->type) {
+        case ITEM_PC_RELATIVE: {
+            static const char *pc_relative_opcodes[] = { "LD", "ST", "LDI", "STI", "LEA", "BRz", "BRnp", "BRnzp", "JSR" };
+            const char *opcode = pc_relative_opcodes[random_below(&state, sizeof(pc_relative_opcodes) / sizeof(pc_relative_opcodes[0]))];
+            if(target < 0) {
+                //no label in range
+                write_operate(asm_file, &state);
+            }
+            else if(opcode[0] == 'B' || opcode[0] == 'J') {
+                fprintf(asm_file, "%s %s\n", opcode, name);
+            }
+            else {
+                fprintf(asm_file, "%s R%d,%s\n", opcode, (int)random_below(&state, 8), name);
+            }
+            break;
+        }
+        case ITEM_BASE_OFFSET:
+            fprintf(asm_file, "%s R%d,R%d,#%d\n", random_below(&state, 2) ? "LDR" : "STR", (int)random_below(&state, 8),
+                    (int)random_below(&state, 8), (int)random_below(&state, 64) - 32);
+            break;
+        case ITEM_STRINGZ:
+            write_string(asm_file, item->num_words - 1, &state);
+            break;
+        case ITEM_BLKW:
+            fprintf(asm_file, ".BLKW #%d\n", item->num_words);
+            break;
+        case ITEM_FILL:
+            if(target >= 0) {
+                fprintf(asm_file, ".FILL %s\n", name);
+            }
+            else {
+                fprintf(asm_file, ".FILL x%.4X\n", (unsigned)random_below(&state, ADDRESS_SPACE_CARDINALITY));
+            }
+            break;
+        default:
+            write_operate(asm_file, &state);
+            break;
+        }
+    }
+    fprintf(asm_file, "    .END\n");
+
+    free(label_addresses);
+    free(items);
+    return ferror(asm_file) ? failure(EXIT_FAILURE, "ERROR: Couldn't write the program (error %d)", errno) : success();
+}
+
+#ifdef FAB_MAIN
+static void print_usage(const char *program_name) {
+    printf("USAGE %s [-n lines] [-s seed] [-l label_density] [-f forward_ratio] [-d data_ratio] [-c comment_ratio]\n", program_name);
+    printf("      [-b branch_distance] [--collide] [-o file.asm]\n");
+    printf("      -n  number of lines (default 1000)\n");
+    printf("      -s  seed of the random generator (default 1)\n");
+    printf("      -l  share of lines that define a label (default 0.2)\n");
+    printf("      -f  share of references to labels defined later (default 0.5)\n");
+    printf("      -d  share of lines that are .STRINGZ, .BLKW or .FILL (default 0.1)\n");
+    printf("      -c  share of lines that are comments (default 0.1)\n");
+    printf("      -b  maximum distance in words of PC-relative references, up to %d (default 64)\n", GENERATOR_MAX_BRANCH_DISTANCE);
+    printf("      --collide  all labels hash to the same bucket of the symbol table\n");
+    printf("      -o  output file (default standard output)\n");
+}
+
+static bool parse_ratio(const char *arg, double *ratio) {
+    char *end;
+    *ratio = strtod(arg, &end);
+    return *end == '\0' && end != arg;
+}
+
+static bool parse_count(const char *arg, uint64_t *count) {
+    char *end;
+    errno = 0;
+    *count = strtoull(arg, &end, 10);
+    return *end == '\0' && end != arg && arg[0] != '-' && !errno;
+}
+
+int main(int argc, char const *argv[]) {
+    generator_options_t options = GENERATOR_DEFAULT_OPTIONS;
+    const char *output_file_name = NULL;
+    bool valid = true;
+    for(int i = 1; i < argc && valid; i++) {
+        uint64_t count;
+        if(strcmp(argv[i], "--collide") == 0) {
+            options.collide = true;
+        }
+        else if(i + 1 == argc || strlen(argv[i]) != 2 || argv[i][0] != '-') {
+            valid = false;
+        }
+        else {
+            const char *arg = argv[++i];
+            switch(argv[i - 1][1]) {
+            case 'n':
+                valid = parse_count(arg, &count);
+                options.num_lines = count;
+                break;
+            case 's':
+                valid = parse_count(arg, &options.seed);
+                break;
+            case 'l':
+                valid = parse_ratio(arg, &options.label_density);
+                break;
+            case 'f':
+                valid = parse_ratio(arg, &options.forward_ratio);
+                break;
+            case 'd':
+                valid = parse_ratio(arg, &options.data_ratio);
+                break;
+            case 'c':
+                valid = parse_ratio(arg, &options.comment_ratio);
+                break;
+            case 'b':
+                valid = parse_count(arg, &count) && count <= GENERATOR_MAX_BRANCH_DISTANCE;
+                options.branch_distance = (int)count;
+                break;
+            case 'o':
+                output_file_name = arg;
+                break;
+            default:
+                valid = false;
+                break;
+            }
+        }
+    }
+    if(!valid) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    FILE *asm_file = output_file_name ? fopen(output_file_name, "w") : stdout;
+    if(!asm_file) {
+        printf("ERROR: Could not create %s\n", output_file_name);
+        exit(EXIT_FAILURE);
+    }
+    size_t num_words;
+    exit_t result = generate_program(asm_file, &options, &num_words);
+    if(output_file_name) {
+        fclose(asm_file);
+    }
+    if(result.code) {
+        printf("%s\n", result.desc);
+        free_err(result);
+    }
+    else {
+        fprintf(stderr, "%zu lines, %zu words\n", options.num_lines, num_words);
+    }
+    return result.code;
+}
+#endif
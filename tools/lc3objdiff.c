@@ -0,0 +1,65 @@
+/*
+    Compares object files generated by the LC3 assembler and reports their differing words with their address,
+    nearest label and decoded instruction (see objdiff.h)
+
+    Usage:
+
+    lc3objdiff [-n max_reported] expected.obj actual.obj       compare two objects
+    lc3objdiff [-n max_reported] -r expected_dir actual_dir    compare the objects of two directories
+
+    The exit status is 0 if the objects are identical, 1 if they differ and 2 on error, as for diff.
+
+    Example:
+
+    franciscoalvarez@franciscos lc3asm % ./lc3objdiff -r test/testfiles test/testfiles
+    test/testfiles/t1.expected.obj test/testfiles/t1.obj: 1 word differs
+      x3001 LOOP+1       expected 1021 ADD R0,R0,#1             actual 1022 ADD R0,R0,#2
+    12 pairs compared, 1 differs
+
+*/
+
+#include "../include/objdiff.h"
+
+#define EXIT_DIFFERENT 1
+#define EXIT_TROUBLE 2
+
+static void print_usage(const char *program_name) {
+    printf("USAGE %s [-n max_reported] expected.obj actual.obj\n", program_name);
+    printf("      %s [-n max_reported] -r expected_dir actual_dir\n", program_name);
+}
+
+#ifdef FAB_MAIN
+int main(int argc, char const *argv[]) {
+    size_t max_reported = DEFAULT_MAX_REPORTED_DIFFERENCES;
+    bool directories = false;
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        long value;
+        if(strcmp(argv[arg], "-r") == 0) {
+            directories = true;
+        }
+        else if(strcmp(argv[arg], "-n") == 0 && arg + 1 < argc && strtolong((char *)argv[arg + 1], &value, 10) && value >= 0) {
+            max_reported = value;
+            arg++;
+        }
+        else {
+            print_usage(argv[0]);
+            exit(EXIT_TROUBLE);
+        }
+    }
+    if(argc - arg != 2) {
+        print_usage(argv[0]);
+        exit(EXIT_TROUBLE);
+    }
+
+    size_t num_differences;
+    exit_t result = directories ? diff_directories(argv[arg], argv[arg + 1], max_reported, stdout, &num_differences)
+                                : diff_objects(argv[arg], argv[arg + 1], max_reported, stdout, &num_differences);
+    if(result.code) {
+        printf("%s\n", result.desc);
+        free_err(result);
+        return EXIT_TROUBLE;
+    }
+    return num_differences ? EXIT_DIFFERENT : EXIT_SUCCESS;
+}
+#endif
@@ -1,6 +1,7 @@
 /*
     Prints the binary content of an object file generated by the LC3 assembler to stdout
-    Each LC3 word (16 bits) is printed in a different line in the specified format (binary or hexadecimal)
+    Each LC3 word (16 bits) is printed in a different line in the specified format (binary, hexadecimal or
+    disassembled, see lc3objdump.h)
 
     Example:
 
@@ -24,6 +25,12 @@
     1111000000100101
     0011000000001100
 
+    franciscoalvarez@franciscos lc3asm % ./out/lc3objdump ../lc3practice/test.obj asm
+    x3000  2002                   LD R0,#2
+    ...
+
+    In asm mode, labels are read from the symbol table given as third argument or, by default, from the .sym file
+    next to the object file. Object files made of several segments are disassembled segment by segment.
 */
 
 #include <stdio.h>
@@ -31,10 +38,41 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
-#define BUF_SIZE 2
-#define DEC_OUTPUT_MODE 0
-#define BIN_OUTPUT_MODE 1
-#define HEX_OUTPUT_MODE 2
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "../include/lc3objdump.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define X86_KERNELS
+#include <immintrin.h>
+#endif
+#define WORD_SIZE 2
+// segmented object format, see lc3.h
+#define SEGMENTED_OBJ_MAGIC1 0x4C33
+#define SEGMENTED_OBJ_MAGIC2 0x5347
+// words disassembled between two writes of the output buffer
+#define DISASSEMBLED_WORDS_PER_WRITE 1024
+// bytes read at once; an even number, so that a word is never split between two reads
+#define INPUT_BUF_SIZE (32 * 1024)
+#define MAX_BYTE_TEXT 8 // "01010101" in binary mode
+// each word of the input becomes at most two formatted bytes and a new line
+#define OUTPUT_BUF_SIZE (INPUT_BUF_SIZE / WORD_SIZE * (WORD_SIZE * MAX_BYTE_TEXT + 1) + FORMAT_OUTPUT_SLACK)
+
+/*
+    The text of every byte in the output mode is computed once, so formatting a word is two copies of a fixed
+    number of characters into the output buffer, which is written with a single call for every INPUT_BUF_SIZE
+    bytes of input
+*/
+typedef struct {
+    char text[UCHAR_MAX + 1][MAX_BYTE_TEXT + 1];
+    size_t length; /**< same for all bytes */
+} byte_table_t;
+
+static byte_table_t byte_table;
+/** formats the longest prefix of whole blocks of `bytes` it handles, returns the number of bytes formatted */
+static size_t (*format_blocks)(const unsigned char *bytes, size_t num_bytes, char **next);
+static unsigned char input_buf[INPUT_BUF_SIZE];
+static char output_buf[OUTPUT_BUF_SIZE];
 
 
 void error_exit(const char *format, const char *text) {
@@ -43,64 +81,335 @@ void error_exit(const char *format, const char *text) {
     exit(EXIT_FAILURE);
 }
 
-int print_hex(unsigned char byte) {
-    return printf("%.2x ", byte);
+static void build_byte_table(int output_mode) {
+    for(int byte = 0; byte <= UCHAR_MAX; byte++) {
+        char *text = byte_table.text[byte];
+        if(output_mode == BIN_OUTPUT_MODE) {
+            for(int i = 0; i < CHAR_BIT; i++) {
+                text[i] = '0' + ((byte >> (CHAR_BIT - 1 - i)) & 1);
+            }
+            text[CHAR_BIT] = '\0';
+        }
+        else if(output_mode == HEX_OUTPUT_MODE) {
+            snprintf(text, sizeof(byte_table.text[byte]), "%.2x ", byte);
+        }
+        else {
+            snprintf(text, sizeof(byte_table.text[byte]), "%.3d ", byte);
+        }
+    }
+    byte_table.length = strlen(byte_table.text[0]);
 }
 
-int print_bin(unsigned char byte) {
-    int ret = 0;
-    int i = CHAR_BIT;
-    while(i--) {
-        int printf_ret = 0;
-        if((printf_ret = printf("%d", ((byte >> i) & 1))) < 0) {
-            return printf_ret;
+static char *format_bytes(const unsigned char *bytes, size_t num_bytes, char *next) {
+    size_t length = byte_table.length;
+    for(size_t i = 0; i < num_bytes; i++) {
+        memcpy(next, byte_table.text[bytes[i]], length);
+        next += length;
+        if(i % WORD_SIZE == WORD_SIZE - 1 || i == num_bytes - 1) {
+            *next++ = '\n';
         }
-        ret += printf_ret;
     }
-    return ret;
+    return next;
 }
 
-int print_dec(unsigned char byte) {
-    return printf("%.3d ", byte);
+/*
+    Vector kernels of the hex and bin modes, which expand a block of bytes at once instead of copying the text of
+    each byte. They are compiled for their instruction set whatever the flags of the build and only called when
+    the CPU supports it (format_kernel_supported).
+*/
+#ifdef X86_KERNELS
+#define SSE2_TARGET __attribute__((target("sse2")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define SSE2_HEX_BLOCK 16
+#define AVX2_HEX_BLOCK 32
+#define AVX2_BIN_BLOCK 8
+
+SSE2_TARGET static inline __m128i hex_digits_sse2(__m128i nibbles) {
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
 }
 
-void read_file(char *filename, int output_mode) {
+/**
+ * @brief Hex digits of 16 bytes are computed at once, then each word is written with a single 8-byte store
+ * ("hh hh \n" and a byte overwritten by the next word)
+ */
+SSE2_TARGET static size_t format_hex_sse2(const unsigned char *bytes, size_t num_bytes, char **next) {
+    char *output = *next;
+    size_t i = 0;
+    for(; i + SSE2_HEX_BLOCK <= num_bytes; i += SSE2_HEX_BLOCK) {
+        __m128i input = _mm_loadu_si128((const __m128i *)(bytes + i));
+        __m128i high = hex_digits_sse2(_mm_and_si128(_mm_srli_epi16(input, 4), _mm_set1_epi8(0xf)));
+        __m128i low = hex_digits_sse2(_mm_and_si128(input, _mm_set1_epi8(0xf)));
+        uint16_t digits[SSE2_HEX_BLOCK]; //both digits of each byte, as they are written
+        _mm_storeu_si128((__m128i *)digits, _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128((__m128i *)(digits + SSE2_HEX_BLOCK / 2), _mm_unpackhi_epi8(high, low));
+        for(int word = 0; word < SSE2_HEX_BLOCK / WORD_SIZE; word++) {
+            uint64_t line = digits[2 * word] | (uint64_t)' ' << 16 | (uint64_t)digits[2 * word + 1] << 24 | (uint64_t)' ' << 40
+                            | (uint64_t)'\n' << 48;
+            memcpy(output, &line, sizeof(line));
+            output += 7;
+        }
+    }
+    *next = output;
+    return i;
+}
 
-    //***** VARIABLES INITIALISATION
-    FILE *inputFile;
-    size_t numRead;
-    // 0 <= buf[i] <= 255
-    unsigned char buf[BUF_SIZE];
+/**
+ * @brief A word per instruction: its two bytes are spread over 8 lanes each, which become '1' where their bit is set
+ */
+SSE2_TARGET static size_t format_bin_sse2(const unsigned char *bytes, size_t num_bytes, char **next) {
+    const __m128i bit_mask = _mm_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+    char *output = *next;
+    size_t i = 0;
+    for(; i + WORD_SIZE <= num_bytes; i += WORD_SIZE) {
+        __m128i word = _mm_cvtsi32_si128(bytes[i] | bytes[i + 1] << 8);
+        word = _mm_unpacklo_epi8(word, word);
+        word = _mm_unpacklo_epi16(word, word);
+        word = _mm_unpacklo_epi32(word, word);
+        __m128i bits = _mm_cmpeq_epi8(_mm_and_si128(word, bit_mask), bit_mask);
+        _mm_storeu_si128((__m128i *)output, _mm_sub_epi8(_mm_set1_epi8('0'), bits));
+        output[2 * CHAR_BIT] = '\n';
+        output += 2 * CHAR_BIT + 1;
+    }
+    *next = output;
+    return i;
+}
+
+AVX2_TARGET static inline __m256i hex_digits_avx2(__m256i nibbles) {
+    __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(nibbles, _mm256_set1_epi8(9)), _mm256_set1_epi8('a' - '0' - 10));
+    return _mm256_add_epi8(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')), letters);
+}
 
-    int (*print_f) (unsigned char);
-    if(output_mode == BIN_OUTPUT_MODE) {
-        print_f = print_bin;
+/**
+ * @brief Write the 28 characters of the 4 words whose 16 digits are in `digits`, 4 bytes more are overwritten
+ */
+AVX2_TARGET static inline void store_hex_lines(char *output, __m128i digits) {
+    //position of the digit of each character of the lines (-1 for the separators) and the separators
+    const __m128i first_positions = _mm_setr_epi8(0, 1, -1, 2, 3, -1, -1, 4, 5, -1, 6, 7, -1, -1, 8, 9);
+    const __m128i first_separators = _mm_setr_epi8(0, 0, ' ', 0, 0, ' ', '\n', 0, 0, ' ', 0, 0, ' ', '\n', 0, 0);
+    const __m128i last_positions = _mm_setr_epi8(-1, 10, 11, -1, -1, 12, 13, -1, 14, 15, -1, -1, -1, -1, -1, -1);
+    const __m128i last_separators = _mm_setr_epi8(' ', 0, 0, ' ', '\n', 0, 0, ' ', 0, 0, ' ', '\n', 0, 0, 0, 0);
+    _mm_storeu_si128((__m128i *)output, _mm_or_si128(_mm_shuffle_epi8(digits, first_positions), first_separators));
+    _mm_storeu_si128((__m128i *)(output + 16), _mm_or_si128(_mm_shuffle_epi8(digits, last_positions), last_separators));
+}
+
+/**
+ * @brief Hex digits of 32 bytes are computed at once, then shuffled with the separators into the lines of 4 words
+ * at a time
+ */
+AVX2_TARGET static size_t format_hex_avx2(const unsigned char *bytes, size_t num_bytes, char **next) {
+    char *output = *next;
+    size_t i = 0;
+    for(; i + AVX2_HEX_BLOCK <= num_bytes; i += AVX2_HEX_BLOCK) {
+        __m256i input = _mm256_loadu_si256((const __m256i *)(bytes + i));
+        __m256i high = hex_digits_avx2(_mm256_and_si256(_mm256_srli_epi16(input, 4), _mm256_set1_epi8(0xf)));
+        __m256i low = hex_digits_avx2(_mm256_and_si256(input, _mm256_set1_epi8(0xf)));
+        //unpacking works within each half: bytes 0-7 and 16-23, then bytes 8-15 and 24-31
+        __m256i first_digits = _mm256_unpacklo_epi8(high, low);
+        __m256i last_digits = _mm256_unpackhi_epi8(high, low);
+        store_hex_lines(output, _mm256_castsi256_si128(first_digits));
+        store_hex_lines(output + 28, _mm256_castsi256_si128(last_digits));
+        store_hex_lines(output + 56, _mm256_extracti128_si256(first_digits, 1));
+        store_hex_lines(output + 84, _mm256_extracti128_si256(last_digits, 1));
+        output += 112;
     }
-    else if(output_mode == HEX_OUTPUT_MODE) {
-        print_f = print_hex;
+    *next = output;
+    return i;
+}
+
+/**
+ * @brief Same as format_bin_sse2 for 2 words per instruction, spread with a shuffle
+ */
+AVX2_TARGET static size_t format_bin_avx2(const unsigned char *bytes, size_t num_bytes, char **next) {
+    const __m256i bit_mask = _mm256_setr_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1,
+                                              -128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+    const __m256i first_words = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                 2, 2, 2, 2, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3);
+    const __m256i last_words = _mm256_add_epi8(first_words, _mm256_set1_epi8(4));
+    char *output = *next;
+    size_t i = 0;
+    for(; i + AVX2_BIN_BLOCK <= num_bytes; i += AVX2_BIN_BLOCK) {
+        int64_t block;
+        memcpy(&block, bytes + i, sizeof(block));
+        __m256i input = _mm256_set1_epi64x(block);
+        for(int half = 0; half < 2; half++) {
+            __m256i words = _mm256_shuffle_epi8(input, half ? last_words : first_words);
+            __m256i bits = _mm256_cmpeq_epi8(_mm256_and_si256(words, bit_mask), bit_mask);
+            __m256i text = _mm256_sub_epi8(_mm256_set1_epi8('0'), bits);
+            _mm_storeu_si128((__m128i *)output, _mm256_castsi256_si128(text));
+            output[2 * CHAR_BIT] = '\n';
+            _mm_storeu_si128((__m128i *)(output + 2 * CHAR_BIT + 1), _mm256_extracti128_si256(text, 1));
+            output[4 * CHAR_BIT + 1] = '\n';
+            output += 2 * (2 * CHAR_BIT + 1);
+        }
     }
-    else {
-        print_f = print_dec;
+    *next = output;
+    return i;
+}
+#endif
+
+bool format_kernel_supported(format_kernel_t kernel) {
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if(kernel == SSE2_KERNEL) {
+        return __builtin_cpu_supports("sse2");
     }
+    if(kernel == AVX2_KERNEL) {
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+    return kernel == SCALAR_KERNEL;
+}
+
+format_kernel_t fastest_format_kernel() {
+    format_kernel_t kernel = NUM_FORMAT_KERNELS - 1;
+    while(!format_kernel_supported(kernel)) {
+        kernel--;
+    }
+    return kernel;
+}
+
+const char *format_kernel_name(format_kernel_t kernel) {
+    static const char *names[NUM_FORMAT_KERNELS] = { "scalar", "sse2", "avx2" };
+    return names[kernel];
+}
 
-    inputFile = fopen(filename, "rb"); //open binary file in read-only mode
+/**
+ * @brief Prepare format_words for the given mode, using `kernel` if it has a version of the mode
+ *
+ * The kernel must be supported by the CPU. The decimal mode is always formatted by the scalar code.
+ */
+void select_format(int output_mode, format_kernel_t kernel) {
+    build_byte_table(output_mode);
+    format_blocks = NULL;
+#ifdef X86_KERNELS
+    if(kernel == SSE2_KERNEL) {
+        format_blocks = output_mode == HEX_OUTPUT_MODE ? format_hex_sse2 : output_mode == BIN_OUTPUT_MODE ? format_bin_sse2 : NULL;
+    }
+    else if(kernel == AVX2_KERNEL) {
+        format_blocks = output_mode == HEX_OUTPUT_MODE ? format_hex_avx2 : output_mode == BIN_OUTPUT_MODE ? format_bin_avx2 : NULL;
+    }
+#endif
+}
+
+/**
+ * @brief Format the given bytes a word per line, the last line holding a single byte if their number is odd
+ *
+ * @param output buffer with FORMAT_OUTPUT_SLACK characters more than the text written
+ * @return size_t number of characters written to `output`
+ */
+size_t format_words(const unsigned char *bytes, size_t num_bytes, char *output) {
+    char *next = output;
+    //kernels format whole blocks of words, the rest is formatted a byte at a time
+    size_t num_formatted = format_blocks ? format_blocks(bytes, num_bytes, &next) : 0;
+    return format_bytes(bytes + num_formatted, num_bytes - num_formatted, next) - output;
+}
+
+static int write_all(const char *buf, size_t size) {
+    while(size > 0) {
+        ssize_t written = write(STDOUT_FILENO, buf, size);
+        if(written < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += written;
+        size -= written;
+    }
+    return 0;
+}
+
+static size_t load_words(const char *filename, uint16_t **words) {
+    FILE *inputFile = fopen(filename, "rb");
     if(inputFile == NULL) {
         error_exit("error %d while opening file %s", filename);
     }
-
-    //***** LOGIC TO READ FILE
-    /* Read data until we encounter end of input or an error */
-    while((numRead = fread(buf, 1, BUF_SIZE, inputFile)) > 0) {
-        if(numRead < BUF_SIZE && !feof(inputFile)) {
+    size_t capacity = INPUT_BUF_SIZE / WORD_SIZE, num_words = 0, numRead;
+    *words = malloc(capacity * sizeof(uint16_t));
+    while((numRead = fread(input_buf, 1, INPUT_BUF_SIZE, inputFile)) > 0) {
+        if(numRead < INPUT_BUF_SIZE && !feof(inputFile)) {
             error_exit("error %d while reading file '%s'", filename);
         }
+        if(num_words + numRead / WORD_SIZE > capacity) {
+            capacity *= 2;
+            *words = realloc(*words, capacity * sizeof(uint16_t));
+        }
+        //words are big-endian; a trailing odd byte is not a word
+        for(size_t i = 0; i + 1 < numRead; i += WORD_SIZE) {
+            (*words)[num_words++] = input_buf[i] << 8 | input_buf[i + 1];
+        }
+    }
+    if(ferror(inputFile)) {
+        error_exit("error %d while reading file '%s'", filename);
+    }
+    fclose(inputFile);
+    return num_words;
+}
+static void disassemble_segment(const uint16_t words[], size_t num_words, uint16_t origin, const char *const symbols[]) {
+    static char asm_output_buf[DISASSEMBLED_WORDS_PER_WRITE * MAX_DISASSEMBLED_LINE];
+    for(size_t i = 0; i < num_words; i += DISASSEMBLED_WORDS_PER_WRITE) {
+        size_t count = num_words - i < DISASSEMBLED_WORDS_PER_WRITE ? num_words - i : DISASSEMBLED_WORDS_PER_WRITE;
+        if(write_all(asm_output_buf, disassemble_words(words + i, count, origin + i, symbols, asm_output_buf))) {
+            error_exit("error %d while writing '%s'", "");
+        }
+    }
+}
 
-        for(size_t i = 0; i < numRead; i++) {
-            if(print_f(buf[i]) < 0 && ferror(stdout)) {
-                error_exit("error %d while writing '%s'", "");
+void disassemble_file(char *filename, const char *symbol_file_name) {
+    build_decode_table();
+    static const char *symbols[ADDRESS_SPACE_SIZE];
+    char default_symbol_file_name[strlen(filename) + strlen(".sym") + 1];
+    if(!symbol_file_name) {
+        //file.obj -> file.sym
+        strcpy(default_symbol_file_name, filename);
+        char *extension = strrchr(default_symbol_file_name, '.');
+        strcpy(extension && strcmp(extension, ".obj") == 0 ? extension : default_symbol_file_name + strlen(default_symbol_file_name), ".sym");
+        symbol_file_name = default_symbol_file_name;
+    }
+    char *names = load_symbol_table(symbol_file_name, symbols);
+
+    uint16_t *words;
+    size_t num_words = load_words(filename, &words);
+    if(num_words >= 3 && words[0] == SEGMENTED_OBJ_MAGIC1 && words[1] == SEGMENTED_OBJ_MAGIC2) {
+        size_t num_segments = words[2];
+        size_t next_word = 3 + 2 * num_segments;
+        for(size_t i = 0; i < num_segments && 3 + 2 * i + 1 < num_words; i++) {
+            uint16_t origin = words[3 + 2 * i];
+            size_t segment_words = words[3 + 2 * i + 1];
+            if(next_word + segment_words > num_words) {
+                segment_words = next_word < num_words ? num_words - next_word : 0;
             }
+            disassemble_segment(words + next_word, segment_words, origin, symbols);
+            next_word += segment_words;
+        }
+    }
+    else if(num_words > 0) {
+        //classic format: origin followed by the words
+        disassemble_segment(words + 1, num_words - 1, words[0], symbols);
+    }
+    free(words);
+    free(names);
+    exit(EXIT_SUCCESS);
+}
+
+void read_file(char *filename, int output_mode) {
+    select_format(output_mode, fastest_format_kernel());
+
+    FILE *inputFile = fopen(filename, "rb"); //open binary file in read-only mode
+    if(inputFile == NULL) {
+        error_exit("error %d while opening file %s", filename);
+    }
+
+    //fread only returns fewer bytes than requested at the end of the file or on error
+    size_t numRead;
+    while((numRead = fread(input_buf, 1, INPUT_BUF_SIZE, inputFile)) > 0) {
+        if(numRead < INPUT_BUF_SIZE && !feof(inputFile)) {
+            error_exit("error %d while reading file '%s'", filename);
+        }
+        if(write_all(output_buf, format_words(input_buf, numRead, output_buf))) {
+            error_exit("error %d while writing '%s'", "");
         }
-        printf("\n");
     }
 
     if(ferror(inputFile)) {
@@ -114,8 +423,9 @@ void read_file(char *filename, int output_mode) {
 
 #ifdef FAB_MAIN
 int main(int argc, char *argv[]) {
-    if(argc < 2  || (argc >= 3 && (strcmp(argv[2], "bin") != 0 && strcmp(argv[2], "hex") != 0))) {
-        printf("USAGE %s filename [output_mode], output_mode=bin/hex\n", argv[0]);
+    if(argc < 2  || (argc >= 3 && (strcmp(argv[2], "bin") != 0 && strcmp(argv[2], "hex") != 0 && strcmp(argv[2], "asm") != 0))
+        || (argc >= 4 && strcmp(argv[2], "asm") != 0)) {
+        printf("USAGE %s filename [output_mode] [symbol_table], output_mode=bin/hex/asm\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
@@ -124,12 +434,17 @@ int main(int argc, char *argv[]) {
         if(strcmp(argv[2], "bin") == 0) {
             output_mode = BIN_OUTPUT_MODE;
         }
+        else if(strcmp(argv[2], "asm") == 0) {
+            output_mode = ASM_OUTPUT_MODE;
+        }
         else {
             output_mode = HEX_OUTPUT_MODE;
         }
     }
 
+    if(output_mode == ASM_OUTPUT_MODE) {
+        disassemble_file(argv[1], argc >= 4 ? argv[3] : NULL);
+    }
     read_file(argv[1], output_mode);
 }
 #endif
-
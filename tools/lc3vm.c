@@ -0,0 +1,121 @@
+/*
+    Runs an object file generated by the LC3 assembler (see vm.h)
+
+    Usage:
+
+    lc3vm [-n max_instructions] [--os os.obj] [--jit] [--stats] program.obj
+
+    -n      stop after running max_instructions instructions
+    --os    load an operating system (e.g. test/testfiles/lc3os.asm assembled) and start at its entry point
+            (x0200) in supervisor mode; without it the program starts at its origin and the machine runs the
+            service routines of the traps itself
+    --jit   translate the blocks that run often to x86-64 code (see jit.h); falls back to the interpreter where
+            the JIT is not supported
+    --stats print the number of instructions executed and the speed of the machine to stderr, and with --jit
+            how many of them ran in translated code
+
+    The program reads standard input and writes standard output. The exit status is 0 if the program halted
+    and 1 otherwise.
+
+    Example:
+
+    franciscoalvarez@franciscos lc3asm % ./lc3as test/testfiles/lcrng.asm && ./lc3vm --stats test/testfiles/lcrng.obj
+    70
+    490
+    3430
+    ...
+    7721
+    84240 instructions in 0.000 s (348.2 MIPS)
+
+*/
+
+#include <inttypes.h>
+#include <time.h>
+#include "../include/jit.h"
+
+static void print_usage(const char *program_name) {
+    fprintf(stderr, "USAGE %s [-n max_instructions] [--os os.obj] [--jit] [--stats] program.obj\n", program_name);
+}
+
+static bool load(vm_t *vm, const char *file_name, uint16_t *origin) {
+    exit_t result = vm_load_object(vm, file_name, origin);
+    if(result.code) {
+        fprintf(stderr, "%s\n", result.desc);
+        free_err(result);
+        return false;
+    }
+    return true;
+}
+
+#ifdef FAB_MAIN
+int main(int argc, char const *argv[]) {
+    uint64_t max_instructions = VM_UNLIMITED;
+    const char *os_file = NULL;
+    bool stats = false, use_jit = false;
+    int arg = 1;
+    for(; arg < argc && argv[arg][0] == '-'; arg++) {
+        long value;
+        if(strcmp(argv[arg], "--stats") == 0) {
+            stats = true;
+        }
+        else if(strcmp(argv[arg], "--jit") == 0) {
+            use_jit = true;
+        }
+        else if(strcmp(argv[arg], "--os") == 0 && arg + 1 < argc) {
+            os_file = argv[++arg];
+        }
+        else if(strcmp(argv[arg], "-n") == 0 && arg + 1 < argc && strtolong((char *)argv[arg + 1], &value, 10) && value >= 0) {
+            max_instructions = value;
+            arg++;
+        }
+        else {
+            print_usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if(argc - arg != 1) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    static vm_t vm;
+    uint16_t origin, os_origin;
+    vm_init(&vm);
+    if((os_file && !load(&vm, os_file, &os_origin)) || !load(&vm, argv[arg], &origin)) {
+        exit(EXIT_FAILURE);
+    }
+    vm.pc = os_file ? VM_OS_START : origin;
+
+    static jit_t jit;
+    if(use_jit) {
+        exit_t result = jit_init(&jit, JIT_DEFAULT_THRESHOLD);
+        if(result.code) {
+            fprintf(stderr, "%s, running the interpreter\n", result.desc);
+            free_err(result);
+            use_jit = false;
+        }
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    vm_status_t status = use_jit ? jit_run(&jit, &vm, max_instructions) : vm_run(&vm, max_instructions);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fflush(stdout);
+
+    if(status != VM_HALTED) {
+        fprintf(stderr, "ERROR: %s at x%04X\n", vm_status_description(status), vm.pc);
+    }
+    if(stats) {
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        fprintf(stderr, "%" PRIu64 " instructions in %.3f s (%.1f MIPS)\n", vm.instructions, seconds,
+                seconds > 0 ? vm.instructions / seconds / 1e6 : 0.0);
+        if(use_jit) {
+            fprintf(stderr, "%" PRIu64 " native, %" PRIu64 " interpreted, %" PRIu64 " blocks compiled, %" PRIu64
+                    " flushes\n", jit.stats.native_instructions, jit.stats.interpreted_instructions,
+                    jit.stats.blocks_compiled, jit.stats.flushes);
+        }
+    }
+    jit_release(&jit);
+    return status == VM_HALTED ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif